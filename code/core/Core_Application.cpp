@@ -7,6 +7,7 @@
 //
 
 #include "Core_Application.hpp"
+#include "Core_JobSystem.hpp"
 
 #include "GLWindow.hpp"
 #include "VulkanRenderer.hpp"
@@ -14,11 +15,52 @@
 const int WIDTH = 1000;
 const int HEIGHT = 750;
 
+// how long an idle loop sleeps before asking the renderer again, for changes nothing wakes it for
+const double IDLE_WAIT_SECONDS = 0.25;
+
 using namespace std::chrono_literals;
 
+//---------------------------------------------------------------------------
+// FramePacing
+//---------------------------------------------------------------------------
+Core_Application::FramePacing::FramePacing()
+ : m_TargetFrameRate(0.0f)
+ , m_FramesInFlight(2)
+ , m_PresentMode(IRenderer::PRESENT_MODE_LOW_LATENCY)
+ , m_LowLatency(false)
+ , m_RenderOnDemand(false)
+{
+}
+
+Core_Application::FramePacing Core_Application::FramePacing::Interactive()
+{
+    // the cpu never gets ahead of the gpu, so nothing queued is older than the last input read
+    FramePacing pacing;
+    pacing.m_FramesInFlight = 1;
+    pacing.m_PresentMode = IRenderer::PRESENT_MODE_LOW_LATENCY;
+    pacing.m_LowLatency = true;
+    pacing.m_RenderOnDemand = true;
+    return pacing;
+}
+
+Core_Application::FramePacing Core_Application::FramePacing::Throughput()
+{
+    // the deepest queue and never waiting on the display, tearing does not matter if nobody is watching
+    FramePacing pacing;
+    pacing.m_FramesInFlight = 3;
+    pacing.m_PresentMode = IRenderer::PRESENT_MODE_IMMEDIATE;
+    pacing.m_LowLatency = false;
+    pacing.m_RenderOnDemand = false;
+    return pacing;
+}
+
+//---------------------------------------------------------------------------
+// Core_Application
+//---------------------------------------------------------------------------
 Core_Application::Core_Application(WindowType aWindowType, RenderType aRenderType)
  : m_Window(nullptr)
  , m_Renderer(nullptr)
+ , m_JobSystem(nullptr)
  , m_WindowType(aWindowType)
  , m_RenderType(aRenderType)
  , m_Initialized(false)
@@ -29,18 +71,29 @@ Core_Application::~Core_Application()
 {
     Core_SafeDelete(m_Window);
     Core_SafeDelete(m_Renderer);
+    
+    // last, the renderer holds on to it until it goes
+    Core_SafeDelete(m_JobSystem);
 }
     
 bool Core_Application::Init()
 {
     bool success = true;
     
+    // first, the renderer picks it up during init
+    m_JobSystem = new Core_JobSystem();
+    
     m_Window = CreateWindow();
     success &= m_Window ? m_Window->Init() : false;
     
     if(success)
     {
         m_Renderer = CreateRenderer();
+        
+        // the present mode is read when the swapchain is made during init
+        if(m_Renderer)
+            ApplyFramePacing();
+        
         success &= m_Renderer ? m_Renderer->Init() : false;
     }
 
@@ -71,13 +124,37 @@ void Core_Application::Update()
     
     while (!m_Window->ShouldCloseWindow())
     {
+        if(m_FramePacing.m_RenderOnDemand && !m_Renderer->NeedsRedraw())
         {
-            //Core_ScopedTimer timer("Poll Event", TimeDenom::MilliSeconds);
-            m_Window->PollEvents();
+            // the same frame again would only burn power, wait for the window or a redraw request
+            m_Window->WaitEvents(IDLE_WAIT_SECONDS);
+            m_Window->Update();
+            
+            // an idle second is not a slow one
+            counter = 0;
+            time_start = clock::now();
+            continue;
         }
         
-        m_Window->Update();
-        m_Renderer->Update();
+        m_FramePacer.WaitForNextFrame();
+        
+        if(m_FramePacing.m_LowLatency)
+        {
+            // the wait for a free frame happens before the input is read, not between it and recording
+            const bool begun = m_Renderer->BeginFrame();
+            
+            PollInput();
+            
+            if(begun)
+                m_Renderer->EndFrame();
+        }
+        else
+        {
+            PollInput();
+            
+            if(m_Renderer->BeginFrame())
+                m_Renderer->EndFrame();
+        }
         
         ++counter;
         
@@ -85,7 +162,14 @@ void Core_Application::Update()
         const auto delta_time =  now - time_start;
         if(delta_time >= timestep)
         {
-            std::cout << "Current FPS:" << counter << std::endl;
+            IRenderer::LatencyStats latency;
+            
+            if(m_Renderer->TakeLatencyStats(latency))
+                std::cout << "Current FPS:" << counter << ", input latency " << latency.m_AverageMilliseconds << "ms (worst " << latency.m_WorstMilliseconds << "ms)" << std::endl;
+            else
+                std::cout << "Current FPS:" << counter << std::endl;
+            
+            m_Renderer->ReportStats();
             
             counter = 0;
             time_start = now;
@@ -95,6 +179,32 @@ void Core_Application::Update()
     m_Renderer->WaitForSafeShutdown();
 }
 
+void Core_Application::PollInput()
+{
+    {
+        //Core_ScopedTimer timer("Poll Event", TimeDenom::MilliSeconds);
+        m_Window->PollEvents();
+    }
+    
+    m_Window->Update();
+    m_Renderer->OnInputSampled();
+}
+
+void Core_Application::SetFramePacing(const FramePacing& aPacing)
+{
+    m_FramePacing = aPacing;
+    
+    if(m_Renderer)
+        ApplyFramePacing();
+}
+
+void Core_Application::ApplyFramePacing()
+{
+    m_FramePacer.SetTargetFrameRate(m_FramePacing.m_TargetFrameRate);
+    m_Renderer->SetFramesInFlight(m_FramePacing.m_FramesInFlight);
+    m_Renderer->SetPresentMode(m_FramePacing.m_PresentMode);
+}
+
 bool Core_Application::Run()
 {
     bool initSuccess = Init();
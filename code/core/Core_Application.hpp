@@ -10,28 +10,57 @@
 #define Core_Application_hpp
 
 #include "Core_Utils.hpp"
+#include "Core_FramePacer.hpp"
+#include "IRenderer.hpp"
 
 class IWindow;
-class IRenderer;
+class Core_JobSystem;
 
 class Core_Application
 {
 public:
+    // how the main loop trades latency against throughput
+    struct FramePacing
+    {
+        FramePacing();
+        
+        // the newest input on screen soonest, for anything someone is interacting with
+        static FramePacing Interactive();
+        // as many frames as the gpu can manage, for renders nobody is steering
+        static FramePacing Throughput();
+        
+        float                   m_TargetFrameRate;  // 0 runs as fast as the present mode allows
+        uint32_t                m_FramesInFlight;
+        IRenderer::PresentMode  m_PresentMode;
+        bool                    m_LowLatency;       // input is read after the wait for a free frame, just before recording
+        bool                    m_RenderOnDemand;   // sleep on window events while nothing on screen would change
+    };
+    
     Core_Application(WindowType aWindowType, RenderType aRenderType);
     virtual ~Core_Application();
     
     virtual bool Run();
     
+    // before Run or while running, takes effect from the next frame
+    void SetFramePacing(const FramePacing& aPacing);
+
 private:
     virtual bool Init();
     virtual void Update();
     virtual void Shutdown();
     
+    void ApplyFramePacing();
+    void PollInput();
+    
     IWindow* CreateWindow();
     IRenderer* CreateRenderer();
     
     IWindow* m_Window;
     IRenderer* m_Renderer;
+    Core_JobSystem* m_JobSystem;
+    
+    FramePacing     m_FramePacing;
+    Core_FramePacer m_FramePacer;
     
     WindowType m_WindowType;
     RenderType m_RenderType;
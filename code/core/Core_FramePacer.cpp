@@ -0,0 +1,50 @@
+//
+//  Core_FramePacer.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Core_FramePacer.hpp"
+
+#include <thread>
+
+// how early the sleep gives up and starts spinning, about what the os oversleeps by
+const std::chrono::microseconds SPIN_THRESHOLD(1500);
+
+Core_FramePacer::Core_FramePacer()
+: m_TargetFrameRate(0.0f)
+, m_Period(Clock::duration::zero())
+, m_NextDeadline(Clock::now())
+{
+}
+
+void Core_FramePacer::SetTargetFrameRate(float aFramesPerSecond)
+{
+    m_TargetFrameRate = aFramesPerSecond > 0.0f ? aFramesPerSecond : 0.0f;
+    m_Period = m_TargetFrameRate > 0.0f ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_TargetFrameRate)) : Clock::duration::zero();
+    m_NextDeadline = Clock::now();
+}
+
+void Core_FramePacer::WaitForNextFrame()
+{
+    if(m_Period == Clock::duration::zero())
+        return;
+    
+    Clock::time_point now = Clock::now();
+    
+    // more than a frame behind, start again from now rather than rushing to catch up
+    if(now - m_NextDeadline > m_Period)
+        m_NextDeadline = now;
+    
+    if(m_NextDeadline - now > SPIN_THRESHOLD)
+        std::this_thread::sleep_for(m_NextDeadline - now - SPIN_THRESHOLD);
+    
+    while (Clock::now() < m_NextDeadline)
+    {
+        std::this_thread::yield();
+    }
+    
+    m_NextDeadline += m_Period;
+}
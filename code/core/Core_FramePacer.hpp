@@ -0,0 +1,38 @@
+//
+//  Core_FramePacer.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_FramePacer_hpp
+#define Core_FramePacer_hpp
+
+#include <chrono>
+
+// Holds the main loop to a target frame rate. The os sleep overshoots by a millisecond
+// or more, which is a big slice of a frame at high rates, so the wait sleeps until it is
+// close to the deadline and spins the rest of the way.
+class Core_FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    Core_FramePacer();
+    
+    // 0 or less runs as fast as the renderer lets it
+    void SetTargetFrameRate(float aFramesPerSecond);
+    float GetTargetFrameRate() const { return m_TargetFrameRate; }
+    
+    // blocks until the next frame is due. deadlines move on by whole periods, so one late
+    // frame does not push back the ones after it, but a long stall does not cause a burst
+    void WaitForNextFrame();
+
+private:
+    float               m_TargetFrameRate;
+    Clock::duration     m_Period;
+    Clock::time_point   m_NextDeadline;
+};
+
+#endif /* Core_FramePacer_hpp */
@@ -0,0 +1,193 @@
+//
+//  Core_JobBenchmarks.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Core_JobBenchmarks.hpp"
+#include "Core_JobSystem.hpp"
+#include "Core_ThreadPool.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    
+    // empty jobs, all the time goes on starting, stealing and finishing them. started and
+    // waited on a batch at a time, about what a frame fans out for one system
+    const uint32_t EMPTY_JOB_BATCH = 1000;
+    const uint32_t EMPTY_JOB_BATCHES = 100;
+    const uint32_t EMPTY_JOB_COUNT = EMPTY_JOB_BATCH * EMPTY_JOB_BATCHES;
+    
+    // each link only starts once the one before has finished, so nothing overlaps
+    const uint32_t CHAIN_LENGTH = 10000;
+    
+    const uint32_t PARALLEL_FOR_COUNT = 1 << 22;
+    const uint32_t GRAIN_SIZES[] = { 256, 4096, 65536 };
+    const int PARALLEL_FOR_RUNS = 20;
+    
+    template<typename Func>
+    double TimeMilliseconds(Func&& aFunc)
+    {
+        const Clock::time_point start = Clock::now();
+        aFunc();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    
+    inline double NanosecondsEach(double aMilliseconds, uint32_t aCount)
+    {
+        return aMilliseconds * 1000000.0 / aCount;
+    }
+    
+    void RunEmptyJobBenchmark(Core_JobSystem& aJobs, Core_ThreadPool& aPool)
+    {
+        // started from the calling thread, the way per frame fan outs are
+        const double flatTime = TimeMilliseconds([&]()
+        {
+            for (uint32_t batch = 0; batch < EMPTY_JOB_BATCHES; ++batch)
+            {
+                Core_JobCounter counter;
+                
+                for (uint32_t i = 0; i < EMPTY_JOB_BATCH; ++i)
+                {
+                    aJobs.Run([]() {}, &counter);
+                }
+                
+                aJobs.Wait(counter);
+            }
+        });
+        
+        // started from inside other jobs, so they land in every worker's deque
+        const uint32_t spawnerCount = aJobs.GetWorkerCount() + 1;
+        const uint32_t jobsPerSpawner = EMPTY_JOB_BATCH / spawnerCount;
+        
+        const double nestedTime = TimeMilliseconds([&]()
+        {
+            for (uint32_t batch = 0; batch < EMPTY_JOB_BATCHES; ++batch)
+            {
+                Core_JobCounter counter;
+                
+                for (uint32_t spawner = 0; spawner < spawnerCount; ++spawner)
+                {
+                    aJobs.Run([&aJobs, &counter, jobsPerSpawner]()
+                    {
+                        for (uint32_t i = 0; i < jobsPerSpawner; ++i)
+                        {
+                            aJobs.Run([]() {}, &counter);
+                        }
+                    }, &counter);
+                }
+                
+                aJobs.Wait(counter);
+            }
+        });
+        
+        std::vector<std::future<void>> futures;
+        futures.reserve(EMPTY_JOB_BATCH);
+        
+        const double poolTime = TimeMilliseconds([&]()
+        {
+            for (uint32_t batch = 0; batch < EMPTY_JOB_BATCHES; ++batch)
+            {
+                for (uint32_t i = 0; i < EMPTY_JOB_BATCH; ++i)
+                {
+                    futures.push_back(aPool.Submit([]() {}));
+                }
+                
+                for (std::future<void>& future : futures)
+                {
+                    future.wait();
+                }
+                
+                futures.clear();
+            }
+        });
+        
+        std::cout << "    " << EMPTY_JOB_COUNT << " empty jobs in batches of " << EMPTY_JOB_BATCH << std::endl
+                  << "        job system        " << NanosecondsEach(flatTime, EMPTY_JOB_COUNT) << " ns each" << std::endl
+                  << "        job system nested " << NanosecondsEach(nestedTime, EMPTY_JOB_BATCHES * spawnerCount * (jobsPerSpawner + 1)) << " ns each" << std::endl
+                  << "        thread pool       " << NanosecondsEach(poolTime, EMPTY_JOB_COUNT) << " ns each" << std::endl;
+    }
+    
+    void RunChainBenchmark(Core_JobSystem& aJobs)
+    {
+        std::vector<Core_JobCounter> links(CHAIN_LENGTH);
+        
+        const double chainTime = TimeMilliseconds([&]()
+        {
+            aJobs.Run([]() {}, &links[0]);
+            
+            for (uint32_t i = 1; i < CHAIN_LENGTH; ++i)
+            {
+                aJobs.RunAfter(links[i - 1], []() {}, &links[i]);
+            }
+            
+            aJobs.Wait(links[CHAIN_LENGTH - 1]);
+        });
+        
+        std::cout << "    " << CHAIN_LENGTH << " dependent jobs in a chain" << std::endl
+                  << "        job system        " << NanosecondsEach(chainTime, CHAIN_LENGTH) << " ns each" << std::endl;
+    }
+    
+    void RunParallelForBenchmark(Core_JobSystem& aJobs)
+    {
+        std::vector<float> values(PARALLEL_FOR_COUNT, 1.0f);
+        float* data = values.data();
+        
+        auto Scale = [data](uint32_t aBegin, uint32_t anEnd)
+        {
+            for (uint32_t i = aBegin; i < anEnd; ++i)
+            {
+                data[i] = data[i] * 0.5f + 1.0f;
+            }
+        };
+        
+        // one range is run straight on the caller, the same loop as every other grain with no jobs at all
+        const double serialTime = TimeMilliseconds([&]()
+        {
+            for (int run = 0; run < PARALLEL_FOR_RUNS; ++run)
+            {
+                aJobs.ParallelFor(PARALLEL_FOR_COUNT, PARALLEL_FOR_COUNT, Scale);
+            }
+        }) / PARALLEL_FOR_RUNS;
+        
+        std::cout << "    parallel for over " << PARALLEL_FOR_COUNT << " floats" << std::endl
+                  << "        one range         " << serialTime << " ms" << std::endl;
+        
+        for (uint32_t grainSize : GRAIN_SIZES)
+        {
+            const double parallelTime = TimeMilliseconds([&]()
+            {
+                for (int run = 0; run < PARALLEL_FOR_RUNS; ++run)
+                {
+                    aJobs.ParallelFor(PARALLEL_FOR_COUNT, grainSize, Scale);
+                }
+            }) / PARALLEL_FOR_RUNS;
+            
+            std::cout << "        grain " << std::setw(5) << grainSize << "       " << parallelTime << " ms, " << serialTime / parallelTime << "x" << std::endl;
+        }
+    }
+}
+
+namespace Core_JobBenchmarks
+{
+    void RunJobSystemBenchmarks()
+    {
+        Core_JobSystem jobs;
+        
+        // the same number of threads doing the work, the pool has no caller helping out
+        Core_ThreadPool pool(jobs.GetWorkerCount() + 1);
+        
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Core_JobSystem " << jobs.GetWorkerCount() << " workers plus the caller" << std::endl;
+        
+        RunEmptyJobBenchmark(jobs, pool);
+        RunChainBenchmark(jobs);
+        RunParallelForBenchmark(jobs);
+    }
+}
@@ -0,0 +1,19 @@
+//
+//  Core_JobBenchmarks.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_JobBenchmarks_hpp
+#define Core_JobBenchmarks_hpp
+
+// Scheduling overhead of Core_JobSystem against Core_ThreadPool, printed to stdout. Build
+// with RUN_JOB_BENCHMARKS defined and main runs these instead of opening a window.
+namespace Core_JobBenchmarks
+{
+    void RunJobSystemBenchmarks();
+}
+
+#endif /* Core_JobBenchmarks_hpp */
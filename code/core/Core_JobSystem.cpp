@@ -0,0 +1,449 @@
+//
+//  Core_JobSystem.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Core_JobSystem.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // per worker, both how many jobs its deque holds and how many it can have outstanding before allocating
+    const uint32_t MAX_JOBS_PER_WORKER = 4096;
+    const uint32_t JOB_MASK = MAX_JOBS_PER_WORKER - 1;
+    
+    // slots tried in the job ring before falling back to the heap
+    const uint32_t ALLOCATE_ATTEMPTS = 16;
+    
+    // empty looks for work before a worker goes to sleep, another job is usually only a moment away
+    const uint32_t IDLE_SPINS = 64;
+    
+    const size_t CACHE_LINE_SIZE = 64;
+    
+    static_assert((MAX_JOBS_PER_WORKER & JOB_MASK) == 0, "MAX_JOBS_PER_WORKER must be a power of two");
+    
+    thread_local const Core_JobSystem* ourCurrentSystem = nullptr;
+    thread_local uint32_t ourCurrentWorker = 0;
+    thread_local uint32_t ourStealSeed = 1;
+    
+    inline uint32_t NextRandom(uint32_t& ioState)
+    {
+        // xorshift, only has to spread the thieves out
+        ioState ^= ioState << 13;
+        ioState ^= ioState >> 17;
+        ioState ^= ioState << 5;
+        return ioState;
+    }
+}
+
+//---------------------------------------------------------------------------
+// Worker
+//---------------------------------------------------------------------------
+// The deque is Chase-Lev with a fixed buffer. Only the owner moves the bottom, thieves race
+// each other and the owner for the top with a compare exchange.
+struct Core_JobSystem::Worker
+{
+    Worker(uint32_t anIndex)
+    : m_Top(0)
+    , m_Bottom(0)
+    , m_Jobs(new Job[MAX_JOBS_PER_WORKER])
+    , m_NextJob(0)
+    , m_Random(anIndex * 2654435761u + 1)
+    {
+        for (uint32_t i = 0; i < MAX_JOBS_PER_WORKER; ++i)
+        {
+            m_Queue[i].store(nullptr, std::memory_order_relaxed);
+            m_Jobs[i].m_InUse.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    // owner only, false when full
+    bool Push(Job* aJob)
+    {
+        const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_Top.load(std::memory_order_acquire);
+        
+        if(bottom - top >= static_cast<int64_t>(MAX_JOBS_PER_WORKER))
+            return false;
+        
+        m_Queue[bottom & JOB_MASK].store(aJob, std::memory_order_relaxed);
+        m_Bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // owner only, newest first
+    Job* Pop()
+    {
+        const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(bottom, std::memory_order_relaxed);
+        
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        int64_t top = m_Top.load(std::memory_order_relaxed);
+        
+        if(top > bottom)
+        {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        
+        Job* job = m_Queue[bottom & JOB_MASK].load(std::memory_order_relaxed);
+        
+        // the last one, a thief may be after it too
+        if(top == bottom)
+        {
+            if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        
+        return job;
+    }
+    
+    // any thread, oldest first, null when empty or someone else got there first
+    Job* Steal()
+    {
+        int64_t top = m_Top.load(std::memory_order_acquire);
+        
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+        
+        if(top >= bottom)
+            return nullptr;
+        
+        Job* job = m_Queue[top & JOB_MASK].load(std::memory_order_relaxed);
+        
+        if(!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        
+        return job;
+    }
+    
+    bool IsEmpty() const
+    {
+        return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed);
+    }
+    
+    // thieves hammer the top, keep it off the line the owner writes
+    std::atomic<int64_t>        m_Top;
+    char                        m_TopPadding[CACHE_LINE_SIZE];
+    std::atomic<int64_t>        m_Bottom;
+    char                        m_BottomPadding[CACHE_LINE_SIZE];
+    
+    std::atomic<Job*>           m_Queue[MAX_JOBS_PER_WORKER];
+    
+    // ring of job storage, a slot is free again once its job has run wherever that was
+    std::unique_ptr<Job[]>      m_Jobs;
+    uint32_t                    m_NextJob;
+    uint32_t                    m_Random;
+};
+
+//---------------------------------------------------------------------------
+// Core_JobSystem
+//---------------------------------------------------------------------------
+Core_JobSystem* Core_JobSystem::ourInstance = nullptr;
+
+Core_JobSystem::Core_JobSystem(unsigned int aWorkerCount)
+: m_InjectedCount(0)
+, m_DeferredCount(0)
+, m_SleepingCount(0)
+, m_Stopping(false)
+{
+    const unsigned int workerCount = aWorkerCount > 0 ? aWorkerCount : std::max(1u, std::thread::hardware_concurrency()) - 1;
+    
+    m_Workers.reserve(workerCount + 1);
+    
+    for (unsigned int i = 0; i <= workerCount; ++i)
+    {
+        m_Workers.emplace_back(new Worker(i));
+    }
+    
+    ourCurrentSystem = this;
+    ourCurrentWorker = 0;
+    
+    if(!ourInstance)
+        ourInstance = this;
+    
+    m_Threads.reserve(workerCount);
+    
+    for (unsigned int i = 1; i <= workerCount; ++i)
+    {
+        m_Threads.emplace_back(&Core_JobSystem::WorkerLoop, this, i);
+    }
+}
+
+Core_JobSystem::~Core_JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SleepLock);
+        m_Stopping = true;
+    }
+    
+    m_WakeUp.notify_all();
+    
+    // workers drain every queue before they exit
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+    
+    // only what waits on a counter that never finished is left
+    for (auto& deferred : m_DeferredJobs)
+    {
+        for (Job* job : deferred.second)
+        {
+            job->m_Destroy(job->m_Storage);
+            
+            if(job->m_OnHeap)
+                delete job;
+        }
+    }
+    
+    if(ourCurrentSystem == this)
+        ourCurrentSystem = nullptr;
+    
+    if(ourInstance == this)
+        ourInstance = nullptr;
+}
+
+void Core_JobSystem::Wait(Core_JobCounter& aCounter)
+{
+    Worker* worker = GetCurrentWorker();
+    
+    while (!aCounter.IsDone())
+    {
+        Job* job = FindJob(worker);
+        
+        if(job)
+            Execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+Core_JobSystem::Job* Core_JobSystem::AllocateJob(Core_JobCounter* aCounter)
+{
+    Worker* worker = GetCurrentWorker();
+    Job* job = nullptr;
+    
+    if(worker)
+    {
+        for (uint32_t attempt = 0; attempt < ALLOCATE_ATTEMPTS && !job; ++attempt)
+        {
+            Job& candidate = worker->m_Jobs[worker->m_NextJob++ & JOB_MASK];
+            
+            if(!candidate.m_InUse.load(std::memory_order_acquire))
+                job = &candidate;
+        }
+    }
+    
+    // not a worker, or this one has thousands outstanding
+    if(!job)
+    {
+        job = new Job();
+        job->m_OnHeap = true;
+    }
+    else
+    {
+        job->m_OnHeap = false;
+    }
+    
+    job->m_InUse.store(true, std::memory_order_relaxed);
+    job->m_Counter = aCounter;
+    
+    if(aCounter)
+        aCounter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+    
+    return job;
+}
+
+void Core_JobSystem::Schedule(Job* aJob, Core_JobCounter* aDependency)
+{
+    if(aDependency)
+    {
+        // counted before looking at the dependency, pairs with the check in Execute
+        m_DeferredCount.fetch_add(1);
+        
+        {
+            std::lock_guard<std::mutex> lock(m_DeferredLock);
+            
+            if(aDependency->m_Pending.load() != 0)
+            {
+                m_DeferredJobs[aDependency].push_back(aJob);
+                return;
+            }
+        }
+        
+        m_DeferredCount.fetch_sub(1);
+    }
+    
+    Push(aJob);
+}
+
+void Core_JobSystem::Push(Job* aJob)
+{
+    Worker* worker = GetCurrentWorker();
+    
+    if(!worker || !worker->Push(aJob))
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedLock);
+        m_InjectedJobs.push_back(aJob);
+        m_InjectedCount.fetch_add(1);
+    }
+    
+    WakeWorker();
+}
+
+void Core_JobSystem::Execute(Job* aJob)
+{
+    aJob->m_Invoke(aJob->m_Storage);
+    aJob->m_Destroy(aJob->m_Storage);
+    
+    Core_JobCounter* counter = aJob->m_Counter;
+    
+    if(aJob->m_OnHeap)
+        delete aJob;
+    else
+        aJob->m_InUse.store(false, std::memory_order_release);
+    
+    // a waiter may destroy the counter the moment it reads done, it is not touched after this
+    if(counter && counter->m_Pending.fetch_sub(1) == 1 && m_DeferredCount.load() > 0)
+        ReleaseDeferred(counter);
+}
+
+void Core_JobSystem::ReleaseDeferred(const Core_JobCounter* aDependency)
+{
+    std::vector<Job*> released;
+    
+    {
+        std::lock_guard<std::mutex> lock(m_DeferredLock);
+        
+        // aDependency may be gone already, only a counter with jobs held back on it is sure to be alive.
+        // that can be a new one in the same place, so it is still checked
+        auto deferred = m_DeferredJobs.find(aDependency);
+        
+        if(deferred == m_DeferredJobs.end() || deferred->first->m_Pending.load() != 0)
+            return;
+        
+        released.swap(deferred->second);
+        m_DeferredJobs.erase(deferred);
+        m_DeferredCount.fetch_sub(static_cast<uint32_t>(released.size()));
+    }
+    
+    for (Job* job : released)
+    {
+        Push(job);
+    }
+}
+
+Core_JobSystem::Worker* Core_JobSystem::GetCurrentWorker() const
+{
+    return ourCurrentSystem == this ? m_Workers[ourCurrentWorker].get() : nullptr;
+}
+
+Core_JobSystem::Job* Core_JobSystem::FindJob(Worker* aWorker)
+{
+    Job* job = aWorker ? aWorker->Pop() : nullptr;
+    
+    if(!job && m_InjectedCount.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedLock);
+        
+        if(!m_InjectedJobs.empty())
+        {
+            job = m_InjectedJobs.front();
+            m_InjectedJobs.pop_front();
+            m_InjectedCount.fetch_sub(1);
+        }
+    }
+    
+    if(job)
+        return job;
+    
+    // start at a random victim so the thieves spread out
+    const uint32_t workerCount = static_cast<uint32_t>(m_Workers.size());
+    const uint32_t first = NextRandom(aWorker ? aWorker->m_Random : ourStealSeed) % workerCount;
+    
+    for (uint32_t i = 0; i < workerCount && !job; ++i)
+    {
+        Worker* victim = m_Workers[(first + i) % workerCount].get();
+        
+        if(victim != aWorker)
+            job = victim->Steal();
+    }
+    
+    return job;
+}
+
+bool Core_JobSystem::HasQueuedJobs() const
+{
+    if(m_InjectedCount.load() > 0)
+        return true;
+    
+    for (const std::unique_ptr<Worker>& worker : m_Workers)
+    {
+        if(!worker->IsEmpty())
+            return true;
+    }
+    
+    return false;
+}
+
+void Core_JobSystem::WakeWorker()
+{
+    // a sleeper counts itself before it looks at the queues, so either it sees this job or this sees it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    
+    if(m_SleepingCount.load() == 0)
+        return;
+    
+    std::lock_guard<std::mutex> lock(m_SleepLock);
+    m_WakeUp.notify_one();
+}
+
+void Core_JobSystem::WorkerLoop(uint32_t anIndex)
+{
+    ourCurrentSystem = this;
+    ourCurrentWorker = anIndex;
+    
+    Worker* worker = m_Workers[anIndex].get();
+    uint32_t idleSpins = 0;
+    
+    while (true)
+    {
+        Job* job = FindJob(worker);
+        
+        if(job)
+        {
+            Execute(job);
+            idleSpins = 0;
+            continue;
+        }
+        
+        if(m_Stopping)
+            break;
+        
+        if(++idleSpins < IDLE_SPINS)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        idleSpins = 0;
+        
+        std::unique_lock<std::mutex> lock(m_SleepLock);
+        m_SleepingCount.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        
+        if(!m_Stopping && !HasQueuedJobs())
+            m_WakeUp.wait(lock);
+        
+        m_SleepingCount.fetch_sub(1);
+    }
+}
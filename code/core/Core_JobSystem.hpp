@@ -0,0 +1,185 @@
+//
+//  Core_JobSystem.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_JobSystem_hpp
+#define Core_JobSystem_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Core_JobSystem;
+
+// Counts the jobs started against it that have not finished yet. Wait on it, or start
+// jobs after it, to depend on all of them at once.
+class Core_JobCounter
+{
+public:
+    Core_JobCounter() : m_Pending(0) {}
+    
+    bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class Core_JobSystem;
+    
+    std::atomic<uint32_t> m_Pending;
+};
+
+// Fine grained jobs for everything the engine fans out across cores, culling, sorting,
+// batching and recording. One worker thread per core besides the one that made it, which
+// joins in whenever it waits. Core_ThreadPool stays the place for long blocking work like
+// driver compiles and file loads, which would hold a worker hostage here.
+//
+// Every worker owns a fixed size lock-free deque. It pushes and pops its own jobs at the
+// bottom, newest first while they are still in cache, and idle workers steal the oldest
+// from the top of someone else's, which for split ranges are the biggest pieces. Jobs
+// started from any other thread go through one locked queue.
+//
+// A job's callable is stored inline, so starting one never allocates unless the starting
+// thread already has thousands of its own jobs outstanding.
+class Core_JobSystem
+{
+public:
+    // captures larger than this do not fit in a job, capture by reference or pointer instead
+    static const size_t JOB_STORAGE_SIZE = 64;
+    
+    // zero workers means one per hardware thread, less the one calling Wait
+    Core_JobSystem(unsigned int aWorkerCount = 0);
+    ~Core_JobSystem();
+    
+    // the engine wide one, made by the application before anything else
+    static Core_JobSystem* GetInstance() { return ourInstance; }
+    
+    unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_Workers.size() - 1); }
+    
+    // aCounter, when given, counts the job from now until it has finished
+    template<typename Task>
+    void Run(Task&& aTask, Core_JobCounter* aCounter = nullptr)
+    {
+        Schedule(CreateJob(std::forward<Task>(aTask), aCounter), nullptr);
+    }
+    
+    // held back until aDependency is done, aDependency has to outlive that
+    template<typename Task>
+    void RunAfter(Core_JobCounter& aDependency, Task&& aTask, Core_JobCounter* aCounter = nullptr)
+    {
+        Schedule(CreateJob(std::forward<Task>(aTask), aCounter), &aDependency);
+    }
+    
+    // runs other jobs until aCounter is done instead of sleeping
+    void Wait(Core_JobCounter& aCounter);
+    
+    // aFunction(begin, end) over [0, aCount) in ranges of about aGrainSize, returns once all have run.
+    // The range is halved recursively so whoever steals takes the bigger half with them.
+    template<typename Function>
+    void ParallelFor(uint32_t aCount, uint32_t aGrainSize, const Function& aFunction)
+    {
+        if(aCount == 0)
+            return;
+        
+        Core_JobCounter counter;
+        SplitRange(counter, 0, aCount, aGrainSize > 0 ? aGrainSize : 1, &aFunction);
+        Wait(counter);
+    }
+
+private:
+    struct Job
+    {
+        void                (*m_Invoke)(void*);
+        void                (*m_Destroy)(void*);
+        Core_JobCounter*    m_Counter;
+        std::atomic<bool>   m_InUse;
+        bool                m_OnHeap;
+        
+        alignas(std::max_align_t) unsigned char m_Storage[JOB_STORAGE_SIZE];
+    };
+    
+    struct Worker;
+    
+    typedef std::unordered_map<const Core_JobCounter*, std::vector<Job*>> DeferredJobMap;
+    
+    template<typename Task>
+    Job* CreateJob(Task&& aTask, Core_JobCounter* aCounter)
+    {
+        typedef typename std::decay<Task>::type TaskType;
+        
+        static_assert(sizeof(TaskType) <= JOB_STORAGE_SIZE, "job captures too much, capture by reference or pointer");
+        static_assert(alignof(TaskType) <= alignof(std::max_align_t), "job capture is over aligned");
+        
+        Job* job = AllocateJob(aCounter);
+        
+        new (job->m_Storage) TaskType(std::forward<Task>(aTask));
+        job->m_Invoke = [](void* aStorage) { (*static_cast<TaskType*>(aStorage))(); };
+        job->m_Destroy = [](void* aStorage) { static_cast<TaskType*>(aStorage)->~TaskType(); };
+        
+        return job;
+    }
+    
+    template<typename Function>
+    void SplitRange(Core_JobCounter& aCounter, uint32_t aBegin, uint32_t anEnd, uint32_t aGrainSize, const Function* aFunction)
+    {
+        while (anEnd - aBegin > aGrainSize)
+        {
+            const uint32_t middle = aBegin + (anEnd - aBegin) / 2;
+            
+            Run([this, &aCounter, middle, anEnd, aGrainSize, aFunction]()
+            {
+                SplitRange(aCounter, middle, anEnd, aGrainSize, aFunction);
+            }, &aCounter);
+            
+            anEnd = middle;
+        }
+        
+        (*aFunction)(aBegin, anEnd);
+    }
+    
+    Job* AllocateJob(Core_JobCounter* aCounter);
+    void Schedule(Job* aJob, Core_JobCounter* aDependency);
+    void Push(Job* aJob);
+    void Execute(Job* aJob);
+    void ReleaseDeferred(const Core_JobCounter* aDependency);
+    
+    Worker* GetCurrentWorker() const;
+    Job* FindJob(Worker* aWorker);
+    bool HasQueuedJobs() const;
+    void WakeWorker();
+    void WorkerLoop(uint32_t anIndex);
+    
+    static Core_JobSystem* ourInstance;
+    
+    // index 0 belongs to the thread that made the system, it has no thread of its own
+    std::vector<std::unique_ptr<Worker>>    m_Workers;
+    std::vector<std::thread>                m_Threads;
+    
+    // jobs started from threads that are not workers
+    std::mutex                  m_InjectedLock;
+    std::deque<Job*>            m_InjectedJobs;
+    std::atomic<uint32_t>       m_InjectedCount;
+    
+    // jobs waiting on a counter, counted before the counter is checked so a finishing job cannot miss one
+    std::mutex                  m_DeferredLock;
+    DeferredJobMap              m_DeferredJobs;
+    std::atomic<uint32_t>       m_DeferredCount;
+    
+    std::mutex                  m_SleepLock;
+    std::condition_variable     m_WakeUp;
+    std::atomic<uint32_t>       m_SleepingCount;
+    std::atomic<bool>           m_Stopping;
+};
+
+#endif /* Core_JobSystem_hpp */
@@ -0,0 +1,18 @@
+//
+//  Core_Math.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_Math_hpp
+#define Core_Math_hpp
+
+// every file has to see glm with the same settings, include glm through here
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#endif /* Core_Math_hpp */
@@ -0,0 +1,134 @@
+//
+//  Core_RadixSort.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Core_RadixSort.hpp"
+#include "Core_JobSystem.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    const uint32_t RADIX_BITS = 8;
+    const uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+    const uint32_t PASS_COUNT = 64 / RADIX_BITS;
+    
+    // below this many keys per worker a pass is over before the workers wake up
+    const size_t MIN_KEYS_PER_JOB = 16 * 1024;
+    
+    typedef std::array<size_t, RADIX_SIZE> Histogram;
+    
+    inline uint32_t GetDigit(uint64_t aKey, uint32_t aPass)
+    {
+        return static_cast<uint32_t>(aKey >> (aPass * RADIX_BITS)) & (RADIX_SIZE - 1);
+    }
+    
+    // runs aJob(0 .. aJobCount - 1), job 0 on the calling thread
+    template<typename Job>
+    void RunJobs(Core_JobSystem* aJobs, size_t aJobCount, const Job& aJob)
+    {
+        Core_JobCounter jobs;
+        
+        for (size_t job = 1; job < aJobCount; ++job)
+        {
+            aJobs->Run([&aJob, job]() { aJob(job); }, &jobs);
+        }
+        
+        aJob(0);
+        
+        if(aJobCount > 1)
+            aJobs->Wait(jobs);
+    }
+}
+
+namespace Core_RadixSort
+{
+    void Sort(std::vector<Core_SortKey>& ioItems, std::vector<Core_SortKey>& aScratch, Core_JobSystem* aJobs)
+    {
+        const size_t itemCount = ioItems.size();
+        
+        if(itemCount < 2)
+            return;
+        
+        // a byte only needs a pass if some key differs from the first one there
+        uint64_t changedBits = 0;
+        
+        for (const Core_SortKey& item : ioItems)
+        {
+            changedBits |= item.m_Key ^ ioItems[0].m_Key;
+        }
+        
+        if(changedBits == 0)
+            return;
+        
+        aScratch.resize(itemCount);
+        
+        const size_t maxJobs = aJobs ? aJobs->GetWorkerCount() + 1 : 1;
+        const size_t jobCount = std::max<size_t>(1, std::min(maxJobs, itemCount / MIN_KEYS_PER_JOB));
+        const size_t jobSize = (itemCount + jobCount - 1) / jobCount;
+        
+        std::vector<Histogram> histograms(jobCount);
+        
+        Core_SortKey* source = ioItems.data();
+        Core_SortKey* dest = aScratch.data();
+        
+        for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+        {
+            if(GetDigit(changedBits, pass) == 0)
+                continue;
+            
+            auto CountJob = [&](size_t aJob)
+            {
+                Histogram& histogram = histograms[aJob];
+                histogram.fill(0);
+                
+                const size_t end = std::min(itemCount, (aJob + 1) * jobSize);
+                
+                for (size_t i = aJob * jobSize; i < end; ++i)
+                {
+                    ++histogram[GetDigit(source[i].m_Key, pass)];
+                }
+            };
+            
+            RunJobs(aJobs, jobCount, CountJob);
+            
+            // turn the counts into where each job writes each digit, digit major so equal keys keep their order
+            size_t offset = 0;
+            
+            for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+            {
+                for (Histogram& histogram : histograms)
+                {
+                    const size_t count = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += count;
+                }
+            }
+            
+            auto ScatterJob = [&](size_t aJob)
+            {
+                Histogram& offsets = histograms[aJob];
+                
+                const size_t end = std::min(itemCount, (aJob + 1) * jobSize);
+                
+                for (size_t i = aJob * jobSize; i < end; ++i)
+                {
+                    dest[offsets[GetDigit(source[i].m_Key, pass)]++] = source[i];
+                }
+            };
+            
+            RunJobs(aJobs, jobCount, ScatterJob);
+            
+            std::swap(source, dest);
+        }
+        
+        // an odd number of passes leaves the result in the scratch buffer
+        if(source != ioItems.data())
+            ioItems.swap(aScratch);
+    }
+}
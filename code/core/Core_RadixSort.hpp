@@ -0,0 +1,35 @@
+//
+//  Core_RadixSort.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_RadixSort_hpp
+#define Core_RadixSort_hpp
+
+#include <cstdint>
+#include <vector>
+
+class Core_JobSystem;
+
+struct Core_SortKey
+{
+    uint64_t m_Key;
+    uint32_t m_Value;
+};
+
+// LSD radix sort on 64 bit keys, one byte per pass. Stable, and bytes that are the
+// same in every key are skipped, so keys that only use their low bits sort in a
+// couple of passes.
+//
+// With a job system, large lists count and scatter each pass in per worker chunks. Every
+// chunk scatters to its own offsets so the result is identical to the serial sort.
+namespace Core_RadixSort
+{
+    // ascending by m_Key, aScratch is resized as needed and left holding garbage
+    void Sort(std::vector<Core_SortKey>& ioItems, std::vector<Core_SortKey>& aScratch, Core_JobSystem* aJobs = nullptr);
+}
+
+#endif /* Core_RadixSort_hpp */
@@ -0,0 +1,61 @@
+//
+//  Core_ThreadPool.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Core_ThreadPool.hpp"
+
+#include <algorithm>
+
+Core_ThreadPool::Core_ThreadPool(unsigned int aThreadCount)
+: m_Stopping(false)
+{
+    const unsigned int threadCount = aThreadCount > 0 ? aThreadCount : std::max(1u, std::thread::hardware_concurrency());
+    
+    m_Workers.reserve(threadCount);
+    
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        m_Workers.emplace_back(&Core_ThreadPool::WorkerLoop, this);
+    }
+}
+
+Core_ThreadPool::~Core_ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_TaskLock);
+        m_Stopping = true;
+    }
+    
+    m_TaskAdded.notify_all();
+    
+    // workers drain whatever is queued before they exit so no future is left broken
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void Core_ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        
+        {
+            std::unique_lock<std::mutex> lock(m_TaskLock);
+            m_TaskAdded.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            
+            if(m_Tasks.empty())
+                return;
+            
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        
+        task();
+    }
+}
@@ -0,0 +1,59 @@
+//
+//  Core_ThreadPool.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Core_ThreadPool_hpp
+#define Core_ThreadPool_hpp
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling from a single queue. Meant for long running
+// blocking work such as driver compiles and file loads, not fine grained jobs.
+class Core_ThreadPool
+{
+public:
+    // zero threads means one per hardware thread
+    Core_ThreadPool(unsigned int aThreadCount = 0);
+    ~Core_ThreadPool();
+    
+    template<typename Task>
+    auto Submit(Task&& aTask) -> std::future<decltype(aTask())>
+    {
+        typedef decltype(aTask()) ResultType;
+        
+        std::shared_ptr<std::packaged_task<ResultType()>> packagedTask = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Task>(aTask));
+        std::future<ResultType> result = packagedTask->get_future();
+        
+        {
+            std::lock_guard<std::mutex> lock(m_TaskLock);
+            m_Tasks.push([packagedTask]() { (*packagedTask)(); });
+        }
+        
+        m_TaskAdded.notify_one();
+        return result;
+    }
+    
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Workers.size()); }
+
+private:
+    void WorkerLoop();
+    
+    std::vector<std::thread>            m_Workers;
+    std::queue<std::function<void()>>   m_Tasks;
+    std::mutex                          m_TaskLock;
+    std::condition_variable             m_TaskAdded;
+    bool                                m_Stopping;
+};
+
+#endif /* Core_ThreadPool_hpp */
@@ -12,6 +12,8 @@
 
 IRenderer::IRenderer(IWindow* aWindow)
  : m_Window(aWindow)
+ , m_RedrawRequested(true)
+ , m_ContinuousUntil(0)
 {
 }
 
@@ -39,3 +41,70 @@ void IRenderer::WaitForSafeShutdown()
 {
     
 }
+
+bool IRenderer::BeginFrame()
+{
+    return true;
+}
+
+void IRenderer::EndFrame()
+{
+    Update();
+}
+
+void IRenderer::SetFramesInFlight(uint32_t aCount)
+{
+
+}
+
+void IRenderer::SetPresentMode(PresentMode aMode)
+{
+
+}
+
+void IRenderer::OnInputSampled()
+{
+
+}
+
+bool IRenderer::TakeLatencyStats(LatencyStats& outStats)
+{
+    return false;
+}
+
+void IRenderer::ReportStats()
+{
+
+}
+
+void IRenderer::RequestRedraw()
+{
+    m_RedrawRequested = true;
+    
+    if(m_Window)
+        m_Window->WakeUp();
+}
+
+void IRenderer::RequestContinuousRender(float aSeconds)
+{
+    const std::chrono::steady_clock::duration length = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(aSeconds));
+    const int64_t until = (std::chrono::steady_clock::now() + length).time_since_epoch().count();
+    
+    // only ever extends, a short request does not cut a longer one short
+    int64_t current = m_ContinuousUntil;
+    while (current < until && !m_ContinuousUntil.compare_exchange_weak(current, until))
+    {
+    }
+    
+    RequestRedraw();
+}
+
+bool IRenderer::NeedsRedraw()
+{
+    return m_RedrawRequested || std::chrono::steady_clock::now().time_since_epoch().count() < m_ContinuousUntil;
+}
+
+bool IRenderer::TakeRedrawRequest()
+{
+    return m_RedrawRequested.exchange(false);
+}
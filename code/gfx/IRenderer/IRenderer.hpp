@@ -9,11 +9,31 @@
 #ifndef IRenderer_hpp
 #define IRenderer_hpp
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 class IWindow;
 
 class IRenderer
 {
 public:
+    // in order of preference, the renderer falls back to vsync when a mode is not supported
+    enum PresentMode
+    {
+        PRESENT_MODE_VSYNC,         // every frame is shown for at least a refresh, the queue fills up when ahead
+        PRESENT_MODE_LOW_LATENCY,   // the newest finished frame is shown at the refresh, older ones are dropped
+        PRESENT_MODE_IMMEDIATE,     // shown as soon as it is done, may tear
+    };
+    
+    // from reading the input a frame is built from to the gpu finishing it, averaged since the last take
+    struct LatencyStats
+    {
+        uint32_t    m_Frames;
+        float       m_AverageMilliseconds;
+        float       m_WorstMilliseconds;
+    };
+    
     IRenderer(IWindow* aWindow);
     virtual ~IRenderer();
     
@@ -23,8 +43,39 @@ public:
     
     virtual void WaitForSafeShutdown();
     
+    // Update in two halves, so input can be read after the wait for a free frame and just before
+    // recording. EndFrame is only called when BeginFrame returns true
+    virtual bool BeginFrame();
+    virtual void EndFrame();
+    
+    // more frames in flight hide cpu and gpu spikes, fewer cut the time from input to screen
+    virtual void SetFramesInFlight(uint32_t aCount);
+    virtual void SetPresentMode(PresentMode aMode);
+    
+    // the input for the next frame has just been read
+    virtual void OnInputSampled();
+    virtual bool TakeLatencyStats(LatencyStats& outStats);
+    
+    // once a second along with the frame rate, anything worth printing that changed since the last time
+    virtual void ReportStats();
+    
+    // for rendering on demand, anything outside the renderer that changes what is on screen says so
+    // here. safe from any thread, a main loop sleeping in WaitEvents is woken
+    void RequestRedraw();
+    void RequestContinuousRender(float aSeconds);   // every frame until then, for transitions and the like
+    
+    // false when the next frame would look the same as the last one submitted
+    virtual bool NeedsRedraw();
+
 protected:
+    // a frame is being recorded, requests from now on need another one
+    bool TakeRedrawRequest();
+    
     IWindow* m_Window;
+
+private:
+    std::atomic<bool>       m_RedrawRequested;
+    std::atomic<int64_t>    m_ContinuousUntil;      // steady clock ticks
 };
 
 #endif /* IRenderer_hpp */
@@ -39,3 +39,11 @@ void IWindow::UnregisterWindowChangedCallback(int anID)
     if (it != m_WindowChangedCB.end())
         m_WindowChangedCB.erase(it);
 }
+
+void IWindow::NotifyWindowChanged(WindowEvent anEvent)
+{
+    for (CallbackIDMap::value_type& callback : m_WindowChangedCB)
+    {
+        callback.second(anEvent);
+    }
+}
@@ -20,6 +20,7 @@ public:
     {
         WE_INVALID,
         WE_SIZE,
+        WE_REFRESH,     // the contents were lost, uncovered or similar, and need drawing again
     };
     
     typedef std::function<void(WindowEvent)> WindowChangedCB;
@@ -37,6 +38,11 @@ public:
     virtual bool ShouldCloseWindow() const { return true; }
     virtual void PollEvents() {}
     
+    // PollEvents that sleeps until there is an event or the timeout passes
+    virtual void WaitEvents(double aTimeoutSeconds) { PollEvents(); }
+    // from any thread, makes a WaitEvents on the main thread return
+    virtual void WakeUp() {}
+    
     virtual const char** GetExtensionList(uint32_t* outExtensionCount);
     virtual const void* GetNativeWindow() const { return nullptr; }
     
@@ -46,6 +52,8 @@ public:
 protected:
     typedef std::map<int, WindowChangedCB> CallbackIDMap;
     
+    void NotifyWindowChanged(WindowEvent anEvent);
+    
     CallbackIDMap m_WindowChangedCB;
     int m_CallbackUniqueID;
     
@@ -0,0 +1,84 @@
+//
+//  Scene_Aabb.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_Aabb_hpp
+#define Scene_Aabb_hpp
+
+#include "Core_Math.hpp"
+
+#include <cfloat>
+
+// Axis aligned box. The default box is inverted so growing it by anything gives that thing.
+struct Scene_Aabb
+{
+    Scene_Aabb()
+    : m_Min(FLT_MAX)
+    , m_Max(-FLT_MAX)
+    {
+    }
+    
+    Scene_Aabb(const glm::vec3& aMin, const glm::vec3& aMax)
+    : m_Min(aMin)
+    , m_Max(aMax)
+    {
+    }
+    
+    bool IsValid() const { return m_Min.x <= m_Max.x && m_Min.y <= m_Max.y && m_Min.z <= m_Max.z; }
+    
+    glm::vec3 GetCenter() const { return (m_Min + m_Max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (m_Max - m_Min) * 0.5f; }
+    
+    float GetSurfaceArea() const
+    {
+        if(!IsValid())
+            return 0.0f;
+        
+        const glm::vec3 size = m_Max - m_Min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+    
+    void Grow(const glm::vec3& aPoint)
+    {
+        m_Min = glm::min(m_Min, aPoint);
+        m_Max = glm::max(m_Max, aPoint);
+    }
+    
+    void Grow(const Scene_Aabb& aBox)
+    {
+        m_Min = glm::min(m_Min, aBox.m_Min);
+        m_Max = glm::max(m_Max, aBox.m_Max);
+    }
+    
+    bool Overlaps(const Scene_Aabb& aBox) const
+    {
+        return m_Min.x <= aBox.m_Max.x && m_Max.x >= aBox.m_Min.x &&
+               m_Min.y <= aBox.m_Max.y && m_Max.y >= aBox.m_Min.y &&
+               m_Min.z <= aBox.m_Max.z && m_Max.z >= aBox.m_Min.z;
+    }
+    
+    // box around this box after aTransform, the corners are folded in through the absolute matrix
+    Scene_Aabb Transformed(const glm::mat4& aTransform) const
+    {
+        const glm::vec3 center = glm::vec3(aTransform * glm::vec4(GetCenter(), 1.0f));
+        const glm::vec3 extents = GetExtents();
+        
+        glm::vec3 newExtents(0.0f);
+        
+        for (int column = 0; column < 3; ++column)
+        {
+            newExtents += glm::abs(glm::vec3(aTransform[column])) * extents[column];
+        }
+        
+        return Scene_Aabb(center - newExtents, center + newExtents);
+    }
+    
+    glm::vec3 m_Min;
+    glm::vec3 m_Max;
+};
+
+#endif /* Scene_Aabb_hpp */
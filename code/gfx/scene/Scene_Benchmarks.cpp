@@ -0,0 +1,161 @@
+//
+//  Scene_Benchmarks.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Scene_Benchmarks.hpp"
+#include "Scene_Bvh.hpp"
+#include "Scene_Frustum.hpp"
+#include "Scene_FrustumCuller.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    typedef std::chrono::high_resolution_clock Clock;
+    
+    const uint32_t OBJECT_COUNTS[] = { 10000, 100000, 1000000 };
+    
+    const int FRUSTUM_QUERIES = 50;
+    const int RAY_QUERIES = 10000;
+    const int BOX_QUERIES = 1000;
+    
+    // fraction of the objects moved before each refit
+    const float MOVING_FRACTION = 0.1f;
+    
+    template<typename Func>
+    double TimeMilliseconds(Func&& aFunc)
+    {
+        const Clock::time_point start = Clock::now();
+        aFunc();
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    
+    void RunBvhBenchmark(uint32_t anObjectCount, std::mt19937& aRandom)
+    {
+        // keep the density the same whatever the count, roughly one object per 4x4x4 cell
+        const float worldSize = std::cbrt(static_cast<float>(anObjectCount)) * 4.0f;
+        
+        std::uniform_real_distribution<float> position(-worldSize * 0.5f, worldSize * 0.5f);
+        std::uniform_real_distribution<float> size(0.25f, 1.0f);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+        
+        std::vector<Scene_Aabb> bounds(anObjectCount);
+        
+        for (Scene_Aabb& box : bounds)
+        {
+            const glm::vec3 center(position(aRandom), position(aRandom), position(aRandom));
+            const glm::vec3 extents(size(aRandom), size(aRandom), size(aRandom));
+            box = Scene_Aabb(center - extents, center + extents);
+        }
+        
+        Scene_Bvh bvh;
+        const double buildTime = TimeMilliseconds([&]() { bvh.Build(bounds); });
+        
+        // a camera in the middle of the scene looking down x, like the renderer's
+        const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        const glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, worldSize * 0.5f);
+        const Scene_Frustum frustum(proj * view);
+        
+        std::vector<uint32_t> visible;
+        
+        const double bvhFrustumTime = TimeMilliseconds([&]()
+        {
+            for (int i = 0; i < FRUSTUM_QUERIES; ++i)
+            {
+                bvh.QueryFrustum(frustum, visible);
+            }
+        }) / FRUSTUM_QUERIES;
+        
+        const size_t bvhVisible = visible.size();
+        
+        Scene_FrustumCuller flatCuller;
+        flatCuller.Reserve(anObjectCount);
+        
+        for (const Scene_Aabb& box : bounds)
+        {
+            flatCuller.AddBox(box.m_Min, box.m_Max);
+        }
+        
+        const double flatFrustumTime = TimeMilliseconds([&]()
+        {
+            for (int i = 0; i < FRUSTUM_QUERIES; ++i)
+            {
+                flatCuller.Cull(frustum, visible);
+            }
+        }) / FRUSTUM_QUERIES;
+        
+        const size_t flatVisible = visible.size();
+        
+        uint32_t rayHits = 0;
+        
+        const double rayTime = TimeMilliseconds([&]()
+        {
+            for (int i = 0; i < RAY_QUERIES; ++i)
+            {
+                const glm::vec3 origin(position(aRandom), position(aRandom), position(aRandom));
+                const glm::vec3 rayDirection = glm::normalize(glm::vec3(direction(aRandom), direction(aRandom), direction(aRandom)) + glm::vec3(1e-4f));
+                
+                Scene_Bvh::RayHit hit;
+                
+                if(bvh.Raycast(origin, rayDirection, worldSize, hit))
+                    ++rayHits;
+            }
+        }) / RAY_QUERIES;
+        
+        size_t boxResults = 0;
+        
+        const double boxTime = TimeMilliseconds([&]()
+        {
+            for (int i = 0; i < BOX_QUERIES; ++i)
+            {
+                const glm::vec3 center(position(aRandom), position(aRandom), position(aRandom));
+                bvh.QueryBox(Scene_Aabb(center - glm::vec3(5.0f), center + glm::vec3(5.0f)), visible);
+                boxResults += visible.size();
+            }
+        }) / BOX_QUERIES;
+        
+        const float builtCost = bvh.GetSahCost();
+        const uint32_t movingCount = static_cast<uint32_t>(anObjectCount * MOVING_FRACTION);
+        
+        for (uint32_t i = 0; i < movingCount; ++i)
+        {
+            const uint32_t object = aRandom() % anObjectCount;
+            const glm::vec3 offset(direction(aRandom), direction(aRandom), direction(aRandom));
+            
+            bvh.SetBounds(object, Scene_Aabb(bounds[object].m_Min + offset, bounds[object].m_Max + offset));
+        }
+        
+        const double refitTime = TimeMilliseconds([&]() { bvh.Refit(); });
+        
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Scene_Bvh " << anObjectCount << " objects, " << bvh.GetNodeCount() << " nodes" << std::endl
+                  << "    build            " << buildTime << " ms, sah cost " << builtCost << std::endl
+                  << "    refit (" << movingCount << " moved) " << refitTime << " ms, sah cost " << bvh.GetSahCost() << std::endl
+                  << "    frustum bvh      " << bvhFrustumTime << " ms, " << bvhVisible << " visible" << std::endl
+                  << "    frustum flat     " << flatFrustumTime << " ms, " << flatVisible << " visible" << std::endl
+                  << "    raycast          " << rayTime * 1000.0 << " us, " << rayHits << "/" << RAY_QUERIES << " hit" << std::endl
+                  << "    box query        " << boxTime * 1000.0 << " us, " << boxResults / BOX_QUERIES << " found on average" << std::endl;
+    }
+}
+
+namespace Scene_Benchmarks
+{
+    void RunBvhBenchmarks()
+    {
+        // fixed seed so runs compare
+        std::mt19937 random(1234);
+        
+        for (uint32_t objectCount : OBJECT_COUNTS)
+        {
+            RunBvhBenchmark(objectCount, random);
+        }
+    }
+}
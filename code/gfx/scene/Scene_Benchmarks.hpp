@@ -0,0 +1,19 @@
+//
+//  Scene_Benchmarks.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_Benchmarks_hpp
+#define Scene_Benchmarks_hpp
+
+// Timings for the scene structures on random boxes, printed to stdout. Build with
+// RUN_SCENE_BENCHMARKS defined and main runs these instead of opening a window.
+namespace Scene_Benchmarks
+{
+    void RunBvhBenchmarks();
+}
+
+#endif /* Scene_Benchmarks_hpp */
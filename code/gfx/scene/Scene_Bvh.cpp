@@ -0,0 +1,550 @@
+//
+//  Scene_Bvh.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Scene_Bvh.hpp"
+#include "Scene_Frustum.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+    // cost of visiting a node relative to testing one object
+    const float TRAVERSAL_COST = 1.0f;
+    
+    // how far refitting may loosen the tree before a rebuild pays for itself
+    const float REBUILD_COST_RATIO = 1.5f;
+    
+    const uint32_t ALL_PLANES = (1 << Scene_Frustum::PLANE_COUNT) - 1;
+    
+    enum PlaneResult
+    {
+        PLANE_OUTSIDE,
+        PLANE_INSIDE,
+        PLANE_INTERSECTS,
+    };
+    
+    // clears the bit of every plane the box is fully inside, so children skip them
+    PlaneResult TestPlanes(const Scene_Frustum& aFrustum, const Scene_Aabb& aBox, uint32_t& ioPlaneMask)
+    {
+        const glm::vec3 center = aBox.GetCenter();
+        const glm::vec3 extents = aBox.GetExtents();
+        
+        for (int i = 0; i < Scene_Frustum::PLANE_COUNT; ++i)
+        {
+            const uint32_t planeBit = 1 << i;
+            
+            if((ioPlaneMask & planeBit) == 0)
+                continue;
+            
+            const glm::vec4& plane = aFrustum.m_Planes[i];
+            const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            const float reach = glm::dot(glm::abs(glm::vec3(plane)), extents);
+            
+            if(distance < -reach)
+                return PLANE_OUTSIDE;
+            
+            if(distance >= reach)
+                ioPlaneMask &= ~planeBit;
+        }
+        
+        return ioPlaneMask == 0 ? PLANE_INSIDE : PLANE_INTERSECTS;
+    }
+    
+    // slab test, the entry distance is clamped to zero for rays starting inside the box
+    bool IntersectRay(const Scene_Aabb& aBox, const glm::vec3& anOrigin, const glm::vec3& anInvDirection, float aMaxDistance, float& outDistance)
+    {
+        const glm::vec3 t0 = (aBox.m_Min - anOrigin) * anInvDirection;
+        const glm::vec3 t1 = (aBox.m_Max - anOrigin) * anInvDirection;
+        
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        
+        const float entry = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+        const float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, aMaxDistance));
+        
+        outDistance = entry;
+        return entry <= exit;
+    }
+    
+    bool Contains(const Scene_Aabb& anOuter, const Scene_Aabb& anInner)
+    {
+        return anOuter.m_Min.x <= anInner.m_Min.x && anOuter.m_Max.x >= anInner.m_Max.x &&
+               anOuter.m_Min.y <= anInner.m_Min.y && anOuter.m_Max.y >= anInner.m_Max.y &&
+               anOuter.m_Min.z <= anInner.m_Min.z && anOuter.m_Max.z >= anInner.m_Max.z;
+    }
+}
+
+Scene_Bvh::Scene_Bvh()
+: m_BuiltSahCost(0.0f)
+, m_Dirty(false)
+{
+}
+
+Scene_Bvh::~Scene_Bvh()
+{
+}
+
+void Scene_Bvh::Clear()
+{
+    m_Nodes.clear();
+    m_ObjectIndices.clear();
+    m_ObjectBounds.clear();
+    m_BuiltSahCost = 0.0f;
+    m_Dirty = false;
+}
+
+void Scene_Bvh::Build(const std::vector<Scene_Aabb>& someBounds)
+{
+    Clear();
+    
+    const uint32_t objectCount = static_cast<uint32_t>(someBounds.size());
+    
+    if(objectCount == 0)
+        return;
+    
+    m_ObjectBounds = someBounds;
+    
+    m_ObjectIndices.resize(objectCount);
+    std::iota(m_ObjectIndices.begin(), m_ObjectIndices.end(), 0);
+    
+    m_Centroids.resize(objectCount);
+    
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        m_Centroids[i] = someBounds[i].GetCenter();
+    }
+    
+    // a binary tree over n leaves never needs more than 2n - 1 nodes
+    m_Nodes.reserve(objectCount * 2 - 1);
+    m_Nodes.push_back(Node());
+    
+    std::vector<BuildTask> tasks;
+    tasks.push_back({ 0, 0, objectCount });
+    
+    while (!tasks.empty())
+    {
+        const BuildTask task = tasks.back();
+        tasks.pop_back();
+        
+        Scene_Aabb bounds;
+        
+        for (uint32_t i = task.m_Begin; i < task.m_End; ++i)
+        {
+            bounds.Grow(m_ObjectBounds[m_ObjectIndices[i]]);
+        }
+        
+        m_Nodes[task.m_Node].m_Bounds = bounds;
+        
+        uint32_t split = 0;
+        
+        if(!FindSplit(task.m_Begin, task.m_End, bounds, split))
+        {
+            m_Nodes[task.m_Node].m_First = task.m_Begin;
+            m_Nodes[task.m_Node].m_Count = task.m_End - task.m_Begin;
+            continue;
+        }
+        
+        const uint32_t leftChild = static_cast<uint32_t>(m_Nodes.size());
+        
+        m_Nodes[task.m_Node].m_First = leftChild;
+        m_Nodes[task.m_Node].m_Count = 0;
+        
+        m_Nodes.push_back(Node());
+        m_Nodes.push_back(Node());
+        
+        tasks.push_back({ leftChild, task.m_Begin, split });
+        tasks.push_back({ leftChild + 1, split, task.m_End });
+    }
+    
+    m_Centroids.clear();
+    
+    m_BuiltSahCost = GetSahCost();
+}
+
+bool Scene_Bvh::FindSplit(uint32_t aBegin, uint32_t anEnd, const Scene_Aabb& aBounds, uint32_t& outSplit)
+{
+    const uint32_t count = anEnd - aBegin;
+    
+    if(count <= 2)
+        return false;
+    
+    Scene_Aabb centroidBounds;
+    
+    for (uint32_t i = aBegin; i < anEnd; ++i)
+    {
+        centroidBounds.Grow(m_Centroids[m_ObjectIndices[i]]);
+    }
+    
+    const glm::vec3 centroidSize = centroidBounds.m_Max - centroidBounds.m_Min;
+    
+    int axis = 0;
+    
+    if(centroidSize.y > centroidSize[axis])
+        axis = 1;
+    
+    if(centroidSize.z > centroidSize[axis])
+        axis = 2;
+    
+    // every centroid in one spot, binning cannot separate them
+    if(centroidSize[axis] <= 0.0f)
+    {
+        if(count <= MAX_LEAF_SIZE)
+            return false;
+        
+        outSplit = aBegin + count / 2;
+        return true;
+    }
+    
+    struct Bin
+    {
+        Scene_Aabb  m_Bounds;
+        uint32_t    m_Count;
+    };
+    
+    Bin bins[SAH_BIN_COUNT] = {};
+    
+    const float binMin = centroidBounds.m_Min[axis];
+    const float binScale = SAH_BIN_COUNT / centroidSize[axis];
+    
+    auto GetBin = [&](uint32_t anObject)
+    {
+        const uint32_t bin = static_cast<uint32_t>((m_Centroids[anObject][axis] - binMin) * binScale);
+        return std::min(bin, SAH_BIN_COUNT - 1);
+    };
+    
+    for (uint32_t i = aBegin; i < anEnd; ++i)
+    {
+        const uint32_t object = m_ObjectIndices[i];
+        Bin& bin = bins[GetBin(object)];
+        
+        bin.m_Bounds.Grow(m_ObjectBounds[object]);
+        ++bin.m_Count;
+    }
+    
+    // sweep from the right to get the cost of everything past each plane, then from the left
+    float rightCost[SAH_BIN_COUNT] = {};
+    Scene_Aabb rightBounds;
+    uint32_t rightCount = 0;
+    
+    for (uint32_t plane = SAH_BIN_COUNT - 1; plane > 0; --plane)
+    {
+        rightBounds.Grow(bins[plane].m_Bounds);
+        rightCount += bins[plane].m_Count;
+        rightCost[plane] = rightBounds.GetSurfaceArea() * rightCount;
+    }
+    
+    Scene_Aabb leftBounds;
+    uint32_t leftCount = 0;
+    float bestCost = FLT_MAX;
+    uint32_t bestPlane = 0;
+    
+    for (uint32_t plane = 1; plane < SAH_BIN_COUNT; ++plane)
+    {
+        leftBounds.Grow(bins[plane - 1].m_Bounds);
+        leftCount += bins[plane - 1].m_Count;
+        
+        const float cost = leftBounds.GetSurfaceArea() * leftCount + rightCost[plane];
+        
+        if(leftCount > 0 && leftCount < count && cost < bestCost)
+        {
+            bestCost = cost;
+            bestPlane = plane;
+        }
+    }
+    
+    const float parentArea = aBounds.GetSurfaceArea();
+    const float splitCost = parentArea > 0.0f ? TRAVERSAL_COST + bestCost / parentArea : FLT_MAX;
+    const float leafCost = static_cast<float>(count);
+    
+    if(bestPlane == 0 || splitCost >= leafCost)
+    {
+        if(count <= MAX_LEAF_SIZE)
+            return false;
+        
+        // too big for a leaf but nothing better than a median cut
+        std::vector<uint32_t>::iterator begin = m_ObjectIndices.begin() + aBegin;
+        std::nth_element(begin, begin + count / 2, m_ObjectIndices.begin() + anEnd, [&](uint32_t a, uint32_t b)
+        {
+            return m_Centroids[a][axis] < m_Centroids[b][axis];
+        });
+        
+        outSplit = aBegin + count / 2;
+        return true;
+    }
+    
+    std::vector<uint32_t>::iterator middle = std::partition(m_ObjectIndices.begin() + aBegin, m_ObjectIndices.begin() + anEnd, [&](uint32_t anObject)
+    {
+        return GetBin(anObject) < bestPlane;
+    });
+    
+    outSplit = static_cast<uint32_t>(middle - m_ObjectIndices.begin());
+    return true;
+}
+
+void Scene_Bvh::SetBounds(uint32_t anObject, const Scene_Aabb& aBounds)
+{
+    m_ObjectBounds[anObject] = aBounds;
+    m_Dirty = true;
+}
+
+void Scene_Bvh::Refit()
+{
+    if(!m_Dirty)
+        return;
+    
+    // children always come after their parent, so one backwards pass is bottom up
+    for (size_t i = m_Nodes.size(); i-- > 0;)
+    {
+        Node& node = m_Nodes[i];
+        Scene_Aabb bounds;
+        
+        if(node.IsLeaf())
+        {
+            for (uint32_t object = node.m_First; object < node.m_First + node.m_Count; ++object)
+            {
+                bounds.Grow(m_ObjectBounds[m_ObjectIndices[object]]);
+            }
+        }
+        else
+        {
+            bounds = m_Nodes[node.m_First].m_Bounds;
+            bounds.Grow(m_Nodes[node.m_First + 1].m_Bounds);
+        }
+        
+        node.m_Bounds = bounds;
+    }
+    
+    m_Dirty = false;
+}
+
+bool Scene_Bvh::NeedsRebuild() const
+{
+    return !m_Nodes.empty() && GetSahCost() > m_BuiltSahCost * REBUILD_COST_RATIO;
+}
+
+float Scene_Bvh::GetSahCost() const
+{
+    if(m_Nodes.empty())
+        return 0.0f;
+    
+    const float rootArea = m_Nodes[0].m_Bounds.GetSurfaceArea();
+    
+    if(rootArea <= 0.0f)
+        return 0.0f;
+    
+    float cost = 0.0f;
+    
+    for (const Node& node : m_Nodes)
+    {
+        const float nodeCost = node.IsLeaf() ? static_cast<float>(node.m_Count) : TRAVERSAL_COST;
+        cost += node.m_Bounds.GetSurfaceArea() * nodeCost;
+    }
+    
+    return cost / rootArea;
+}
+
+void Scene_Bvh::AddSubtree(uint32_t aNode, std::vector<uint32_t>& outObjects) const
+{
+    // objects were partitioned in place, so a subtree owns one run of m_ObjectIndices
+    uint32_t first = aNode;
+    uint32_t last = aNode;
+    
+    while (!m_Nodes[first].IsLeaf())
+    {
+        first = m_Nodes[first].m_First;
+    }
+    
+    while (!m_Nodes[last].IsLeaf())
+    {
+        last = m_Nodes[last].m_First + 1;
+    }
+    
+    const uint32_t begin = m_Nodes[first].m_First;
+    const uint32_t end = m_Nodes[last].m_First + m_Nodes[last].m_Count;
+    
+    outObjects.insert(outObjects.end(), m_ObjectIndices.begin() + begin, m_ObjectIndices.begin() + end);
+}
+
+void Scene_Bvh::QueryFrustum(const Scene_Frustum& aFrustum, std::vector<uint32_t>& outObjects) const
+{
+    outObjects.clear();
+    
+    if(m_Nodes.empty())
+        return;
+    
+    struct StackEntry
+    {
+        uint32_t m_Node;
+        uint32_t m_PlaneMask;
+    };
+    
+    std::vector<StackEntry> stack;
+    stack.reserve(64);
+    stack.push_back({ 0, ALL_PLANES });
+    
+    while (!stack.empty())
+    {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+        
+        const Node& node = m_Nodes[entry.m_Node];
+        uint32_t planeMask = entry.m_PlaneMask;
+        
+        const PlaneResult result = TestPlanes(aFrustum, node.m_Bounds, planeMask);
+        
+        if(result == PLANE_OUTSIDE)
+            continue;
+        
+        if(result == PLANE_INSIDE)
+        {
+            AddSubtree(entry.m_Node, outObjects);
+            continue;
+        }
+        
+        if(!node.IsLeaf())
+        {
+            stack.push_back({ node.m_First + 1, planeMask });
+            stack.push_back({ node.m_First, planeMask });
+            continue;
+        }
+        
+        for (uint32_t i = node.m_First; i < node.m_First + node.m_Count; ++i)
+        {
+            const uint32_t object = m_ObjectIndices[i];
+            uint32_t objectMask = planeMask;
+            
+            if(TestPlanes(aFrustum, m_ObjectBounds[object], objectMask) != PLANE_OUTSIDE)
+                outObjects.push_back(object);
+        }
+    }
+}
+
+void Scene_Bvh::QueryBox(const Scene_Aabb& aBox, std::vector<uint32_t>& outObjects) const
+{
+    outObjects.clear();
+    
+    if(m_Nodes.empty())
+        return;
+    
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    
+    while (!stack.empty())
+    {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+        
+        const Node& node = m_Nodes[nodeIndex];
+        
+        if(!aBox.Overlaps(node.m_Bounds))
+            continue;
+        
+        if(Contains(aBox, node.m_Bounds))
+        {
+            AddSubtree(nodeIndex, outObjects);
+            continue;
+        }
+        
+        if(!node.IsLeaf())
+        {
+            stack.push_back(node.m_First + 1);
+            stack.push_back(node.m_First);
+            continue;
+        }
+        
+        for (uint32_t i = node.m_First; i < node.m_First + node.m_Count; ++i)
+        {
+            const uint32_t object = m_ObjectIndices[i];
+            
+            if(aBox.Overlaps(m_ObjectBounds[object]))
+                outObjects.push_back(object);
+        }
+    }
+}
+
+bool Scene_Bvh::Raycast(const glm::vec3& anOrigin, const glm::vec3& aDirection, float aMaxDistance, RayHit& outHit) const
+{
+    if(m_Nodes.empty())
+        return false;
+    
+    const glm::vec3 invDirection = glm::vec3(1.0f) / aDirection;
+    
+    outHit.m_Object = INVALID_INDEX;
+    outHit.m_Distance = aMaxDistance;
+    
+    float rootDistance = 0.0f;
+    
+    if(!IntersectRay(m_Nodes[0].m_Bounds, anOrigin, invDirection, outHit.m_Distance, rootDistance))
+        return false;
+    
+    struct StackEntry
+    {
+        uint32_t    m_Node;
+        float       m_Distance;
+    };
+    
+    std::vector<StackEntry> stack;
+    stack.reserve(64);
+    stack.push_back({ 0, rootDistance });
+    
+    while (!stack.empty())
+    {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+        
+        // something closer was found since this node was pushed
+        if(entry.m_Distance > outHit.m_Distance)
+            continue;
+        
+        const Node& node = m_Nodes[entry.m_Node];
+        
+        if(node.IsLeaf())
+        {
+            for (uint32_t i = node.m_First; i < node.m_First + node.m_Count; ++i)
+            {
+                const uint32_t object = m_ObjectIndices[i];
+                float distance = 0.0f;
+                
+                if(IntersectRay(m_ObjectBounds[object], anOrigin, invDirection, outHit.m_Distance, distance) && distance < outHit.m_Distance)
+                {
+                    outHit.m_Object = object;
+                    outHit.m_Distance = distance;
+                }
+            }
+            
+            continue;
+        }
+        
+        float leftDistance = 0.0f;
+        float rightDistance = 0.0f;
+        
+        const bool hitLeft = IntersectRay(m_Nodes[node.m_First].m_Bounds, anOrigin, invDirection, outHit.m_Distance, leftDistance);
+        const bool hitRight = IntersectRay(m_Nodes[node.m_First + 1].m_Bounds, anOrigin, invDirection, outHit.m_Distance, rightDistance);
+        
+        // push the far child first so the near one is popped next
+        if(hitLeft && hitRight)
+        {
+            const bool leftFirst = leftDistance <= rightDistance;
+            
+            stack.push_back({ leftFirst ? node.m_First + 1 : node.m_First, leftFirst ? rightDistance : leftDistance });
+            stack.push_back({ leftFirst ? node.m_First : node.m_First + 1, leftFirst ? leftDistance : rightDistance });
+        }
+        else if(hitLeft)
+        {
+            stack.push_back({ node.m_First, leftDistance });
+        }
+        else if(hitRight)
+        {
+            stack.push_back({ node.m_First + 1, rightDistance });
+        }
+    }
+    
+    return outHit.m_Object != INVALID_INDEX;
+}
@@ -0,0 +1,91 @@
+//
+//  Scene_Bvh.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_Bvh_hpp
+#define Scene_Bvh_hpp
+
+#include "Scene_Aabb.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct Scene_Frustum;
+
+// Bounding volume hierarchy over object boxes, object ids are their index in the list
+// given to Build. Built top down with binned SAH, which suits static geometry.
+//
+// Objects that move call SetBounds and the tree is refit once per frame, which keeps
+// the topology and only grows the boxes. Refitting slowly loosens the tree, so check
+// NeedsRebuild after big movements and Build again when it says so.
+class Scene_Bvh
+{
+public:
+    struct RayHit
+    {
+        uint32_t    m_Object;
+        float       m_Distance;
+    };
+    
+    Scene_Bvh();
+    ~Scene_Bvh();
+    
+    void Build(const std::vector<Scene_Aabb>& someBounds);
+    void Clear();
+    
+    void SetBounds(uint32_t anObject, const Scene_Aabb& aBounds);
+    void Refit();
+    bool NeedsRebuild() const;
+    
+    // whole subtrees inside or outside the frustum are taken or dropped without visiting them
+    void QueryFrustum(const Scene_Frustum& aFrustum, std::vector<uint32_t>& outObjects) const;
+    void QueryBox(const Scene_Aabb& aBox, std::vector<uint32_t>& outObjects) const;
+    
+    // closest object box along the ray, false if nothing is hit before aMaxDistance
+    bool Raycast(const glm::vec3& anOrigin, const glm::vec3& aDirection, float aMaxDistance, RayHit& outHit) const;
+    
+    uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_ObjectBounds.size()); }
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+    
+    // expected cost of a query relative to the root, lower is a tighter tree
+    float GetSahCost() const;
+
+private:
+    static const uint32_t SAH_BIN_COUNT = 12;
+    static const uint32_t MAX_LEAF_SIZE = 8;
+    static const uint32_t INVALID_INDEX = 0xffffffff;
+    
+    // leaves have a count and point into m_ObjectIndices, inner nodes point at the first of
+    // their two children which always sit next to each other, after the parent
+    struct Node
+    {
+        Scene_Aabb  m_Bounds;
+        uint32_t    m_First;
+        uint32_t    m_Count;
+        
+        bool IsLeaf() const { return m_Count > 0; }
+    };
+    
+    struct BuildTask
+    {
+        uint32_t m_Node;
+        uint32_t m_Begin;
+        uint32_t m_End;
+    };
+    
+    bool FindSplit(uint32_t aBegin, uint32_t anEnd, const Scene_Aabb& aBounds, uint32_t& outSplit);
+    void AddSubtree(uint32_t aNode, std::vector<uint32_t>& outObjects) const;
+    
+    std::vector<Node>           m_Nodes;
+    std::vector<uint32_t>       m_ObjectIndices;
+    std::vector<Scene_Aabb>     m_ObjectBounds;
+    std::vector<glm::vec3>      m_Centroids;
+    float                       m_BuiltSahCost;
+    bool                        m_Dirty;
+};
+
+#endif /* Scene_Bvh_hpp */
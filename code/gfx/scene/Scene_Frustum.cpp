@@ -0,0 +1,73 @@
+//
+//  Scene_Frustum.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Scene_Frustum.hpp"
+
+Scene_Frustum::Scene_Frustum()
+{
+    for (glm::vec4& plane : m_Planes)
+    {
+        plane = glm::vec4(0.0f);
+    }
+}
+
+Scene_Frustum::Scene_Frustum(const glm::mat4& aViewProj)
+{
+    Extract(aViewProj);
+}
+
+void Scene_Frustum::Extract(const glm::mat4& aViewProj)
+{
+    // glm is column major, pull out the rows
+    const glm::vec4 row0(aViewProj[0][0], aViewProj[1][0], aViewProj[2][0], aViewProj[3][0]);
+    const glm::vec4 row1(aViewProj[0][1], aViewProj[1][1], aViewProj[2][1], aViewProj[3][1]);
+    const glm::vec4 row2(aViewProj[0][2], aViewProj[1][2], aViewProj[2][2], aViewProj[3][2]);
+    const glm::vec4 row3(aViewProj[0][3], aViewProj[1][3], aViewProj[2][3], aViewProj[3][3]);
+    
+    m_Planes[PLANE_LEFT] = row3 + row0;
+    m_Planes[PLANE_RIGHT] = row3 - row0;
+    m_Planes[PLANE_BOTTOM] = row3 + row1;
+    m_Planes[PLANE_TOP] = row3 - row1;
+    
+    // depth is zero to one, so near is just the z row
+    m_Planes[PLANE_NEAR] = row2;
+    m_Planes[PLANE_FAR] = row3 - row2;
+    
+    for (glm::vec4& plane : m_Planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool Scene_Frustum::IntersectsSphere(const glm::vec3& aCenter, float aRadius) const
+{
+    for (const glm::vec4& plane : m_Planes)
+    {
+        if(glm::dot(glm::vec3(plane), aCenter) + plane.w < -aRadius)
+            return false;
+    }
+    
+    return true;
+}
+
+bool Scene_Frustum::IntersectsBox(const glm::vec3& aMin, const glm::vec3& aMax) const
+{
+    const glm::vec3 center = (aMin + aMax) * 0.5f;
+    const glm::vec3 extents = (aMax - aMin) * 0.5f;
+    
+    for (const glm::vec4& plane : m_Planes)
+    {
+        // projected half size of the box onto the plane normal
+        const float reach = glm::dot(glm::abs(glm::vec3(plane)), extents);
+        
+        if(glm::dot(glm::vec3(plane), center) + plane.w < -reach)
+            return false;
+    }
+    
+    return true;
+}
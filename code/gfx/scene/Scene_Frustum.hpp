@@ -0,0 +1,41 @@
+//
+//  Scene_Frustum.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_Frustum_hpp
+#define Scene_Frustum_hpp
+
+#include "Core_Math.hpp"
+
+// Six normalised planes pulled out of a view projection matrix, xyz points inwards
+// so anything with a negative distance to one of them is outside.
+struct Scene_Frustum
+{
+    enum Plane
+    {
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        
+        PLANE_COUNT
+    };
+    
+    Scene_Frustum();
+    explicit Scene_Frustum(const glm::mat4& aViewProj);
+    
+    void Extract(const glm::mat4& aViewProj);
+    
+    bool IntersectsSphere(const glm::vec3& aCenter, float aRadius) const;
+    bool IntersectsBox(const glm::vec3& aMin, const glm::vec3& aMax) const;
+    
+    glm::vec4 m_Planes[PLANE_COUNT];
+};
+
+#endif /* Scene_Frustum_hpp */
@@ -0,0 +1,320 @@
+//
+//  Scene_FrustumCuller.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Scene_FrustumCuller.hpp"
+#include "Scene_Frustum.hpp"
+
+#include "Core_JobSystem.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SCENE_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCENE_CULL_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCENE_CULL_NEON
+#endif
+
+namespace
+{
+    // padding lanes get this radius so they fail every plane and never need masking off
+    const float PADDING_RADIUS = -FLT_MAX;
+    
+    // one frustum plane, plus the absolute normal used to project the box extents
+    struct CullPlane
+    {
+        float m_X, m_Y, m_Z, m_W;
+        float m_AbsX, m_AbsY, m_AbsZ;
+    };
+    
+    void GetCullPlanes(const Scene_Frustum& aFrustum, CullPlane outPlanes[Scene_Frustum::PLANE_COUNT])
+    {
+        for (int i = 0; i < Scene_Frustum::PLANE_COUNT; ++i)
+        {
+            const glm::vec4& plane = aFrustum.m_Planes[i];
+            outPlanes[i] = { plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z) };
+        }
+    }
+    
+    uint32_t RoundUpToBlock(uint32_t aCount, uint32_t aBlockSize)
+    {
+        return (aCount + aBlockSize - 1) / aBlockSize * aBlockSize;
+    }
+    
+    // appends aBase + lane for every set bit of aMask
+    inline uint32_t WriteVisible(uint32_t aMask, uint32_t aBase, uint32_t* outVisible)
+    {
+        uint32_t count = 0;
+        
+        while (aMask)
+        {
+            outVisible[count++] = aBase + __builtin_ctz(aMask);
+            aMask &= aMask - 1;
+        }
+        
+        return count;
+    }
+}
+
+Scene_FrustumCuller::Scene_FrustumCuller()
+: m_Count(0)
+{
+}
+
+Scene_FrustumCuller::~Scene_FrustumCuller()
+{
+}
+
+uint32_t Scene_FrustumCuller::AddSphere(const glm::vec3& aCenter, float aRadius)
+{
+    Reserve(m_Count + 1);
+    
+    const uint32_t index = m_Count++;
+    SetSphere(index, aCenter, aRadius);
+    
+    return index;
+}
+
+uint32_t Scene_FrustumCuller::AddBox(const glm::vec3& aMin, const glm::vec3& aMax)
+{
+    Reserve(m_Count + 1);
+    
+    const uint32_t index = m_Count++;
+    SetBox(index, aMin, aMax);
+    
+    return index;
+}
+
+void Scene_FrustumCuller::SetSphere(uint32_t anIndex, const glm::vec3& aCenter, float aRadius)
+{
+    Set(anIndex, aCenter, glm::vec3(0.0f), aRadius);
+}
+
+void Scene_FrustumCuller::SetBox(uint32_t anIndex, const glm::vec3& aMin, const glm::vec3& aMax)
+{
+    Set(anIndex, (aMin + aMax) * 0.5f, (aMax - aMin) * 0.5f, 0.0f);
+}
+
+void Scene_FrustumCuller::Set(uint32_t anIndex, const glm::vec3& aCenter, const glm::vec3& anExtents, float aRadius)
+{
+    m_CenterX[anIndex] = aCenter.x;
+    m_CenterY[anIndex] = aCenter.y;
+    m_CenterZ[anIndex] = aCenter.z;
+    m_ExtentX[anIndex] = anExtents.x;
+    m_ExtentY[anIndex] = anExtents.y;
+    m_ExtentZ[anIndex] = anExtents.z;
+    m_Radius[anIndex] = aRadius;
+}
+
+void Scene_FrustumCuller::Reserve(uint32_t aCount)
+{
+    const size_t paddedCount = RoundUpToBlock(aCount, BLOCK_SIZE);
+    
+    if(paddedCount <= m_Radius.size())
+        return;
+    
+    m_CenterX.resize(paddedCount, 0.0f);
+    m_CenterY.resize(paddedCount, 0.0f);
+    m_CenterZ.resize(paddedCount, 0.0f);
+    m_ExtentX.resize(paddedCount, 0.0f);
+    m_ExtentY.resize(paddedCount, 0.0f);
+    m_ExtentZ.resize(paddedCount, 0.0f);
+    m_Radius.resize(paddedCount, PADDING_RADIUS);
+}
+
+void Scene_FrustumCuller::Clear()
+{
+    // back to padding so a shorter refill does not leave stale objects in the last block
+    std::fill(m_Radius.begin(), m_Radius.end(), PADDING_RADIUS);
+    m_Count = 0;
+}
+
+void Scene_FrustumCuller::Cull(const Scene_Frustum& aFrustum, std::vector<uint32_t>& outVisible, Core_JobSystem* aJobs) const
+{
+    outVisible.resize(m_Count);
+    
+    const uint32_t maxJobs = aJobs ? aJobs->GetWorkerCount() + 1 : 1;
+    const uint32_t jobCount = std::max(1u, std::min(maxJobs, m_Count / MIN_OBJECTS_PER_JOB));
+    
+    if(jobCount == 1)
+    {
+        outVisible.resize(CullRange(aFrustum, 0, m_Count, outVisible.data()));
+        return;
+    }
+    
+    // every job writes into its own slice of outVisible, the slices are packed together after
+    const uint32_t jobSize = RoundUpToBlock((m_Count + jobCount - 1) / jobCount, BLOCK_SIZE);
+    
+    std::vector<uint32_t> sliceCounts(jobCount, 0);
+    Core_JobCounter jobs;
+    
+    for (uint32_t job = 1; job < jobCount; ++job)
+    {
+        const uint32_t begin = std::min(job * jobSize, m_Count);
+        const uint32_t end = std::min(begin + jobSize, m_Count);
+        uint32_t* slice = outVisible.data() + begin;
+        uint32_t* sliceCount = &sliceCounts[job];
+        
+        aJobs->Run([this, &aFrustum, begin, end, slice, sliceCount]()
+        {
+            *sliceCount = CullRange(aFrustum, begin, end, slice);
+        }, &jobs);
+    }
+    
+    uint32_t visibleCount = CullRange(aFrustum, 0, std::min(jobSize, m_Count), outVisible.data());
+    
+    aJobs->Wait(jobs);
+    
+    for (uint32_t job = 1; job < jobCount; ++job)
+    {
+        const uint32_t sliceCount = sliceCounts[job];
+        const uint32_t begin = std::min(job * jobSize, m_Count);
+        
+        // always moves towards the front so the overlap is safe for std::copy
+        std::copy(outVisible.begin() + begin, outVisible.begin() + begin + sliceCount, outVisible.begin() + visibleCount);
+        visibleCount += sliceCount;
+    }
+    
+    outVisible.resize(visibleCount);
+}
+
+uint32_t Scene_FrustumCuller::CullRange(const Scene_Frustum& aFrustum, uint32_t aBegin, uint32_t anEnd, uint32_t* outVisible) const
+{
+    if(aBegin >= anEnd)
+        return 0;
+    
+    CullPlane planes[Scene_Frustum::PLANE_COUNT];
+    GetCullPlanes(aFrustum, planes);
+    
+    // aBegin is block aligned, the tail block is padded out with objects that always fail
+    const uint32_t end = RoundUpToBlock(anEnd, BLOCK_SIZE);
+    uint32_t visibleCount = 0;
+
+#if defined(SCENE_CULL_AVX)
+    const __m256 zero = _mm256_setzero_ps();
+    
+    for (uint32_t i = aBegin; i < end; i += 8)
+    {
+        const __m256 centerX = _mm256_loadu_ps(&m_CenterX[i]);
+        const __m256 centerY = _mm256_loadu_ps(&m_CenterY[i]);
+        const __m256 centerZ = _mm256_loadu_ps(&m_CenterZ[i]);
+        const __m256 extentX = _mm256_loadu_ps(&m_ExtentX[i]);
+        const __m256 extentY = _mm256_loadu_ps(&m_ExtentY[i]);
+        const __m256 extentZ = _mm256_loadu_ps(&m_ExtentZ[i]);
+        const __m256 radius = _mm256_loadu_ps(&m_Radius[i]);
+        
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        
+        for (const CullPlane& plane : planes)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_X), centerX), _mm256_set1_ps(plane.m_W));
+            distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_Y), centerY), distance);
+            distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_Z), centerZ), distance);
+            
+            __m256 reach = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_AbsX), extentX), radius);
+            reach = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_AbsY), extentY), reach);
+            reach = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.m_AbsZ), extentZ), reach);
+            
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+        }
+        
+        visibleCount += WriteVisible(_mm256_movemask_ps(visible), i, outVisible + visibleCount);
+    }
+#elif defined(SCENE_CULL_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    
+    for (uint32_t i = aBegin; i < end; i += 4)
+    {
+        const __m128 centerX = _mm_loadu_ps(&m_CenterX[i]);
+        const __m128 centerY = _mm_loadu_ps(&m_CenterY[i]);
+        const __m128 centerZ = _mm_loadu_ps(&m_CenterZ[i]);
+        const __m128 extentX = _mm_loadu_ps(&m_ExtentX[i]);
+        const __m128 extentY = _mm_loadu_ps(&m_ExtentY[i]);
+        const __m128 extentZ = _mm_loadu_ps(&m_ExtentZ[i]);
+        const __m128 radius = _mm_loadu_ps(&m_Radius[i]);
+        
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        
+        for (const CullPlane& plane : planes)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_X), centerX), _mm_set1_ps(plane.m_W));
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_Y), centerY), distance);
+            distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_Z), centerZ), distance);
+            
+            __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_AbsX), extentX), radius);
+            reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_AbsY), extentY), reach);
+            reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.m_AbsZ), extentZ), reach);
+            
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+        }
+        
+        visibleCount += WriteVisible(_mm_movemask_ps(visible), i, outVisible + visibleCount);
+    }
+#elif defined(SCENE_CULL_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const uint32_t laneBitsData[4] = { 1, 2, 4, 8 };
+    const uint32x4_t laneBits = vld1q_u32(laneBitsData);
+    
+    for (uint32_t i = aBegin; i < end; i += 4)
+    {
+        const float32x4_t centerX = vld1q_f32(&m_CenterX[i]);
+        const float32x4_t centerY = vld1q_f32(&m_CenterY[i]);
+        const float32x4_t centerZ = vld1q_f32(&m_CenterZ[i]);
+        const float32x4_t extentX = vld1q_f32(&m_ExtentX[i]);
+        const float32x4_t extentY = vld1q_f32(&m_ExtentY[i]);
+        const float32x4_t extentZ = vld1q_f32(&m_ExtentZ[i]);
+        const float32x4_t radius = vld1q_f32(&m_Radius[i]);
+        
+        uint32x4_t visible = vdupq_n_u32(0xffffffff);
+        
+        for (const CullPlane& plane : planes)
+        {
+            float32x4_t distance = vmlaq_n_f32(vdupq_n_f32(plane.m_W), centerX, plane.m_X);
+            distance = vmlaq_n_f32(distance, centerY, plane.m_Y);
+            distance = vmlaq_n_f32(distance, centerZ, plane.m_Z);
+            
+            float32x4_t reach = vmlaq_n_f32(radius, extentX, plane.m_AbsX);
+            reach = vmlaq_n_f32(reach, extentY, plane.m_AbsY);
+            reach = vmlaq_n_f32(reach, extentZ, plane.m_AbsZ);
+            
+            visible = vandq_u32(visible, vcgeq_f32(vaddq_f32(distance, reach), zero));
+        }
+        
+        // no movemask on neon, keep one bit per lane and sum them
+        const uint32x4_t bits = vandq_u32(visible, laneBits);
+        const uint32x2_t pairs = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+        const uint32_t mask = vget_lane_u32(pairs, 0) | vget_lane_u32(pairs, 1);
+        
+        visibleCount += WriteVisible(mask, i, outVisible + visibleCount);
+    }
+#else
+    for (uint32_t i = aBegin; i < end; ++i)
+    {
+        bool visible = true;
+        
+        for (const CullPlane& plane : planes)
+        {
+            const float distance = plane.m_X * m_CenterX[i] + plane.m_Y * m_CenterY[i] + plane.m_Z * m_CenterZ[i] + plane.m_W;
+            const float reach = plane.m_AbsX * m_ExtentX[i] + plane.m_AbsY * m_ExtentY[i] + plane.m_AbsZ * m_ExtentZ[i] + m_Radius[i];
+            
+            visible &= distance + reach >= 0.0f;
+        }
+        
+        if(visible)
+            outVisible[visibleCount++] = i;
+    }
+#endif
+    
+    return visibleCount;
+}
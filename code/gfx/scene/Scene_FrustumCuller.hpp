@@ -0,0 +1,68 @@
+//
+//  Scene_FrustumCuller.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_FrustumCuller_hpp
+#define Scene_FrustumCuller_hpp
+
+#include "Core_Math.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct Scene_Frustum;
+class Core_JobSystem;
+
+// Frustum culls a flat list of bounding volumes. The bounds are kept as structure of
+// arrays so one register holds the same component of 8 (AVX) or 4 (SSE / NEON)
+// objects, and the visible indices come out compacted in ascending order.
+//
+// Spheres and boxes share the storage, a box is a center with extents and a sphere a
+// center with a radius. The plane test adds both terms so either goes down one loop.
+class Scene_FrustumCuller
+{
+public:
+    Scene_FrustumCuller();
+    ~Scene_FrustumCuller();
+    
+    uint32_t AddSphere(const glm::vec3& aCenter, float aRadius);
+    uint32_t AddBox(const glm::vec3& aMin, const glm::vec3& aMax);
+    
+    void SetSphere(uint32_t anIndex, const glm::vec3& aCenter, float aRadius);
+    void SetBox(uint32_t anIndex, const glm::vec3& aMin, const glm::vec3& aMax);
+    
+    void Reserve(uint32_t aCount);
+    void Clear();
+    
+    uint32_t GetObjectCount() const { return m_Count; }
+    
+    // outVisible is overwritten. with a job system, large lists are split across its workers
+    void Cull(const Scene_Frustum& aFrustum, std::vector<uint32_t>& outVisible, Core_JobSystem* aJobs = nullptr) const;
+
+private:
+    // objects per simd block, the arrays are always padded to a whole block
+    static const uint32_t BLOCK_SIZE = 8;
+    
+    // below this many objects per worker the hand off costs more than it saves
+    static const uint32_t MIN_OBJECTS_PER_JOB = 64 * 1024;
+    
+    void Set(uint32_t anIndex, const glm::vec3& aCenter, const glm::vec3& anExtents, float aRadius);
+    
+    // writes the visible indices of [aBegin, anEnd) to outVisible, returns how many
+    uint32_t CullRange(const Scene_Frustum& aFrustum, uint32_t aBegin, uint32_t anEnd, uint32_t* outVisible) const;
+    
+    std::vector<float>  m_CenterX;
+    std::vector<float>  m_CenterY;
+    std::vector<float>  m_CenterZ;
+    std::vector<float>  m_ExtentX;
+    std::vector<float>  m_ExtentY;
+    std::vector<float>  m_ExtentZ;
+    std::vector<float>  m_Radius;
+    uint32_t            m_Count;
+};
+
+#endif /* Scene_FrustumCuller_hpp */
@@ -0,0 +1,385 @@
+//
+//  Scene_OcclusionCuller.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "Scene_OcclusionCuller.hpp"
+
+#include "Core_JobSystem.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    // cleared to the far plane, nothing drawn hides everything behind it
+    const float FAR_DEPTH = 1.0f;
+}
+
+bool Scene_OcclusionCuller::Stats::operator==(const Stats& other) const
+{
+    return m_Occluders == other.m_Occluders && m_Triangles == other.m_Triangles &&
+           m_Tested == other.m_Tested && m_Occluded == other.m_Occluded;
+}
+
+Scene_OcclusionCuller::Scene_OcclusionCuller()
+: m_TilesX(0)
+, m_TilesY(0)
+, m_ViewProj(1.0f)
+, m_Stats()
+{
+}
+
+Scene_OcclusionCuller::~Scene_OcclusionCuller()
+{
+}
+
+void Scene_OcclusionCuller::Init(uint32_t aWidth, uint32_t aHeight)
+{
+    m_TilesX = std::max(1u, (aWidth + TILE_WIDTH - 1) / TILE_WIDTH);
+    m_TilesY = std::max(1u, (aHeight + TILE_HEIGHT - 1) / TILE_HEIGHT);
+    
+    m_Depth.assign(m_TilesX * m_TilesY * TILE_PIXELS, FAR_DEPTH);
+    m_TileMaxDepth.assign(m_TilesX * m_TilesY, FAR_DEPTH);
+    m_RowBins.resize(m_TilesY);
+}
+
+uint32_t Scene_OcclusionCuller::AddOccluderMesh(const std::vector<glm::vec3>& somePositions, const std::vector<uint32_t>& someIndices)
+{
+    OccluderMesh mesh;
+    mesh.m_FirstPosition = static_cast<uint32_t>(m_MeshPositions.size());
+    mesh.m_PositionCount = static_cast<uint32_t>(somePositions.size());
+    mesh.m_FirstIndex = static_cast<uint32_t>(m_MeshIndices.size());
+    // whole triangles only
+    mesh.m_IndexCount = static_cast<uint32_t>(someIndices.size() / 3 * 3);
+    
+    m_MeshPositions.insert(m_MeshPositions.end(), somePositions.begin(), somePositions.end());
+    m_MeshIndices.insert(m_MeshIndices.end(), someIndices.begin(), someIndices.begin() + mesh.m_IndexCount);
+    m_Meshes.push_back(mesh);
+    
+    return static_cast<uint32_t>(m_Meshes.size() - 1);
+}
+
+void Scene_OcclusionCuller::ClearOccluders()
+{
+    m_Occluders.clear();
+}
+
+void Scene_OcclusionCuller::AddOccluder(uint32_t aMesh, const glm::mat4& aTransform)
+{
+    m_Occluders.push_back({ aMesh, aTransform });
+}
+
+void Scene_OcclusionCuller::Render(const glm::mat4& aViewProj, Core_JobSystem* aJobs)
+{
+    m_ViewProj = aViewProj;
+    
+    std::fill(m_Depth.begin(), m_Depth.end(), FAR_DEPTH);
+    std::fill(m_TileMaxDepth.begin(), m_TileMaxDepth.end(), FAR_DEPTH);
+    
+    SetupTriangles();
+    
+    m_Stats.m_Occluders = static_cast<uint32_t>(m_Occluders.size());
+    m_Stats.m_Triangles = static_cast<uint32_t>(m_Triangles.size());
+    
+    const uint32_t triangleCount = static_cast<uint32_t>(m_Triangles.size());
+    const uint32_t maxJobs = aJobs ? aJobs->GetWorkerCount() + 1 : 1;
+    const uint32_t jobCount = std::max(1u, std::min(std::min(maxJobs, m_TilesY), triangleCount / MIN_TRIANGLES_PER_JOB));
+    
+    // rows are dealt out in turn so a job does not end up with all of a tall occluder
+    Core_JobCounter jobs;
+    
+    for (uint32_t job = 1; job < jobCount; ++job)
+    {
+        aJobs->Run([this, job, jobCount]()
+        {
+            RasterizeRows(job, jobCount);
+        }, &jobs);
+    }
+    
+    RasterizeRows(0, jobCount);
+    
+    if(jobCount > 1)
+        aJobs->Wait(jobs);
+}
+
+void Scene_OcclusionCuller::SetupTriangles()
+{
+    m_Triangles.clear();
+    
+    for (std::vector<uint32_t>& bin : m_RowBins)
+    {
+        bin.clear();
+    }
+    
+    for (const Occluder& occluder : m_Occluders)
+    {
+        const OccluderMesh& mesh = m_Meshes[occluder.m_Mesh];
+        const glm::mat4 transform = m_ViewProj * occluder.m_Transform;
+        
+        m_ClipPositions.resize(mesh.m_PositionCount);
+        
+        for (uint32_t i = 0; i < mesh.m_PositionCount; ++i)
+        {
+            m_ClipPositions[i] = transform * glm::vec4(m_MeshPositions[mesh.m_FirstPosition + i], 1.0f);
+        }
+        
+        const uint32_t* indices = m_MeshIndices.data() + mesh.m_FirstIndex;
+        
+        for (uint32_t i = 0; i < mesh.m_IndexCount; i += 3)
+        {
+            Triangle triangle;
+            
+            if(!SetupTriangle(m_ClipPositions[indices[i]], m_ClipPositions[indices[i + 1]], m_ClipPositions[indices[i + 2]], triangle))
+                continue;
+            
+            const uint32_t index = static_cast<uint32_t>(m_Triangles.size());
+            m_Triangles.push_back(triangle);
+            
+            for (uint32_t row = triangle.m_MinY / TILE_HEIGHT; row <= triangle.m_MaxY / TILE_HEIGHT; ++row)
+            {
+                m_RowBins[row].push_back(index);
+            }
+        }
+    }
+}
+
+bool Scene_OcclusionCuller::SetupTriangle(const glm::vec4& aClip0, const glm::vec4& aClip1, const glm::vec4& aClip2, Triangle& outTriangle) const
+{
+    // crossing the near plane would need clipping, dropping the triangle only hides less
+    if(aClip0.z < 0.0f || aClip1.z < 0.0f || aClip2.z < 0.0f ||
+       aClip0.w <= 0.0f || aClip1.w <= 0.0f || aClip2.w <= 0.0f)
+        return false;
+    
+    const glm::vec2 pixels[3] = { ToPixels(aClip0), ToPixels(aClip1), ToPixels(aClip2) };
+    const float depths[3] = { aClip0.z / aClip0.w, aClip1.z / aClip1.w, aClip2.z / aClip2.w };
+    
+    // past the far plane the cleared buffer already says as much
+    if(std::min({ depths[0], depths[1], depths[2] }) >= FAR_DEPTH)
+        return false;
+    
+    const float minX = std::max(std::floor(std::min({ pixels[0].x, pixels[1].x, pixels[2].x })), 0.0f);
+    const float minY = std::max(std::floor(std::min({ pixels[0].y, pixels[1].y, pixels[2].y })), 0.0f);
+    const float maxX = std::min(std::floor(std::max({ pixels[0].x, pixels[1].x, pixels[2].x })), static_cast<float>(GetWidth() - 1));
+    const float maxY = std::min(std::floor(std::max({ pixels[0].y, pixels[1].y, pixels[2].y })), static_cast<float>(GetHeight() - 1));
+    
+    if(minX > maxX || minY > maxY)
+        return false;
+    
+    const float area = (pixels[1].x - pixels[0].x) * (pixels[2].y - pixels[0].y) - (pixels[1].y - pixels[0].y) * (pixels[2].x - pixels[0].x);
+    
+    if(std::abs(area) < FLT_EPSILON)
+        return false;
+    
+    // edge i runs from vertex i to the next, it is zero along that edge and equals the area at the vertex opposite
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec2& from = pixels[i];
+        const glm::vec2& to = pixels[(i + 1) % 3];
+        
+        outTriangle.m_EdgeA[i] = from.y - to.y;
+        outTriangle.m_EdgeB[i] = to.x - from.x;
+        outTriangle.m_EdgeC[i] = from.x * to.y - from.y * to.x;
+    }
+    
+    // a vertex's weight is the edge opposite it over the area, folded into one plane
+    outTriangle.m_DepthA = 0.0f;
+    outTriangle.m_DepthB = 0.0f;
+    outTriangle.m_DepthC = 0.0f;
+    
+    for (int i = 0; i < 3; ++i)
+    {
+        const int opposite = (i + 1) % 3;
+        
+        outTriangle.m_DepthA += depths[i] * outTriangle.m_EdgeA[opposite] / area;
+        outTriangle.m_DepthB += depths[i] * outTriangle.m_EdgeB[opposite] / area;
+        outTriangle.m_DepthC += depths[i] * outTriangle.m_EdgeC[opposite] / area;
+    }
+    
+    // both windings are drawn, flipping the edges makes the inside positive either way
+    if(area < 0.0f)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            outTriangle.m_EdgeA[i] = -outTriangle.m_EdgeA[i];
+            outTriangle.m_EdgeB[i] = -outTriangle.m_EdgeB[i];
+            outTriangle.m_EdgeC[i] = -outTriangle.m_EdgeC[i];
+        }
+    }
+    
+    outTriangle.m_MinX = static_cast<int32_t>(minX);
+    outTriangle.m_MinY = static_cast<int32_t>(minY);
+    outTriangle.m_MaxX = static_cast<int32_t>(maxX);
+    outTriangle.m_MaxY = static_cast<int32_t>(maxY);
+    
+    return true;
+}
+
+void Scene_OcclusionCuller::RasterizeRows(uint32_t aFirstRow, uint32_t aRowStep)
+{
+    for (uint32_t row = aFirstRow; row < m_TilesY; row += aRowStep)
+    {
+        for (uint32_t index : m_RowBins[row])
+        {
+            RasterizeInRow(m_Triangles[index], row);
+        }
+        
+        for (uint32_t tileX = 0; tileX < m_TilesX; ++tileX)
+        {
+            const uint32_t tile = row * m_TilesX + tileX;
+            const float* pixels = &m_Depth[tile * TILE_PIXELS];
+            
+            float maxDepth = pixels[0];
+            
+            for (uint32_t i = 1; i < TILE_PIXELS; ++i)
+            {
+                maxDepth = std::max(maxDepth, pixels[i]);
+            }
+            
+            m_TileMaxDepth[tile] = maxDepth;
+        }
+    }
+}
+
+void Scene_OcclusionCuller::RasterizeInRow(const Triangle& aTriangle, uint32_t aTileRow)
+{
+    const int32_t rowY = static_cast<int32_t>(aTileRow * TILE_HEIGHT);
+    const int32_t minY = std::max(aTriangle.m_MinY, rowY);
+    const int32_t maxY = std::min(aTriangle.m_MaxY, rowY + static_cast<int32_t>(TILE_HEIGHT) - 1);
+    const uint32_t firstTile = aTriangle.m_MinX / TILE_WIDTH;
+    const uint32_t lastTile = aTriangle.m_MaxX / TILE_WIDTH;
+    
+    for (uint32_t tileX = firstTile; tileX <= lastTile; ++tileX)
+    {
+        float* tile = &m_Depth[(aTileRow * m_TilesX + tileX) * TILE_PIXELS];
+        
+        // sampled at pixel centres
+        const float baseX = tileX * TILE_WIDTH + 0.5f;
+        
+        for (int32_t y = minY; y <= maxY; ++y)
+        {
+            float* pixels = tile + (y - rowY) * TILE_WIDTH;
+            const float centerY = y + 0.5f;
+            
+            const float edge0 = aTriangle.m_EdgeA[0] * baseX + aTriangle.m_EdgeB[0] * centerY + aTriangle.m_EdgeC[0];
+            const float edge1 = aTriangle.m_EdgeA[1] * baseX + aTriangle.m_EdgeB[1] * centerY + aTriangle.m_EdgeC[1];
+            const float edge2 = aTriangle.m_EdgeA[2] * baseX + aTriangle.m_EdgeB[2] * centerY + aTriangle.m_EdgeC[2];
+            const float depth = aTriangle.m_DepthA * baseX + aTriangle.m_DepthB * centerY + aTriangle.m_DepthC;
+            
+            // no branches and a fixed width, the compiler turns this into one simd pass over the row
+            for (uint32_t lane = 0; lane < TILE_WIDTH; ++lane)
+            {
+                const float offset = static_cast<float>(lane);
+                const bool inside = (edge0 + aTriangle.m_EdgeA[0] * offset >= 0.0f) &
+                                    (edge1 + aTriangle.m_EdgeA[1] * offset >= 0.0f) &
+                                    (edge2 + aTriangle.m_EdgeA[2] * offset >= 0.0f);
+                const float z = depth + aTriangle.m_DepthA * offset;
+                
+                pixels[lane] = inside ? std::min(pixels[lane], z) : pixels[lane];
+            }
+        }
+    }
+}
+
+bool Scene_OcclusionCuller::IsBoxVisible(const glm::vec3& aMin, const glm::vec3& aMax) const
+{
+    float minX = FLT_MAX;
+    float minY = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float maxY = -FLT_MAX;
+    float nearest = FLT_MAX;
+    
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner((i & 1) ? aMax.x : aMin.x, (i & 2) ? aMax.y : aMin.y, (i & 4) ? aMax.z : aMin.z);
+        const glm::vec4 clip = m_ViewProj * glm::vec4(corner, 1.0f);
+        
+        // reaches past the near plane, nothing drawn can be in front of it
+        if(clip.z < 0.0f || clip.w <= 0.0f)
+            return true;
+        
+        const glm::vec2 pixel = ToPixels(clip);
+        
+        minX = std::min(minX, pixel.x);
+        minY = std::min(minY, pixel.y);
+        maxX = std::max(maxX, pixel.x);
+        maxY = std::max(maxY, pixel.y);
+        nearest = std::min(nearest, clip.z / clip.w);
+    }
+    
+    // every pixel the rect touches, not just the centres inside it
+    const float firstXf = std::max(std::floor(minX), 0.0f);
+    const float firstYf = std::max(std::floor(minY), 0.0f);
+    const float lastXf = std::min(std::floor(maxX), static_cast<float>(GetWidth() - 1));
+    const float lastYf = std::min(std::floor(maxY), static_cast<float>(GetHeight() - 1));
+    
+    // off screen, the frustum has it
+    if(firstXf > lastXf || firstYf > lastYf)
+        return false;
+    
+    const uint32_t firstX = static_cast<uint32_t>(firstXf);
+    const uint32_t firstY = static_cast<uint32_t>(firstYf);
+    const uint32_t lastX = static_cast<uint32_t>(lastXf);
+    const uint32_t lastY = static_cast<uint32_t>(lastYf);
+    
+    for (uint32_t tileY = firstY / TILE_HEIGHT; tileY <= lastY / TILE_HEIGHT; ++tileY)
+    {
+        for (uint32_t tileX = firstX / TILE_WIDTH; tileX <= lastX / TILE_WIDTH; ++tileX)
+        {
+            const uint32_t tile = tileY * m_TilesX + tileX;
+            
+            // the whole tile is nearer than the box
+            if(nearest > m_TileMaxDepth[tile])
+                continue;
+            
+            const uint32_t rowY = tileY * TILE_HEIGHT;
+            const uint32_t minRow = std::max(firstY, rowY);
+            const uint32_t maxRow = std::min(lastY, rowY + TILE_HEIGHT - 1);
+            
+            for (uint32_t y = minRow; y <= maxRow; ++y)
+            {
+                const float* pixels = &m_Depth[tile * TILE_PIXELS + (y - rowY) * TILE_WIDTH];
+                bool visible = false;
+                
+                for (uint32_t lane = 0; lane < TILE_WIDTH; ++lane)
+                {
+                    const uint32_t x = tileX * TILE_WIDTH + lane;
+                    visible |= (x >= firstX) & (x <= lastX) & (pixels[lane] >= nearest);
+                }
+                
+                if(visible)
+                    return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+void Scene_OcclusionCuller::Cull(const std::vector<Scene_Aabb>& someBoxes, std::vector<uint32_t>& ioVisible)
+{
+    size_t visibleCount = 0;
+    
+    for (uint32_t index : ioVisible)
+    {
+        const Scene_Aabb& box = someBoxes[index];
+        
+        if(IsBoxVisible(box.m_Min, box.m_Max))
+            ioVisible[visibleCount++] = index;
+    }
+    
+    m_Stats.m_Tested = static_cast<uint32_t>(ioVisible.size());
+    m_Stats.m_Occluded = static_cast<uint32_t>(ioVisible.size() - visibleCount);
+    
+    ioVisible.resize(visibleCount);
+}
+
+glm::vec2 Scene_OcclusionCuller::ToPixels(const glm::vec4& aClip) const
+{
+    const glm::vec2 ndc = glm::vec2(aClip) / aClip.w;
+    return (ndc * 0.5f + 0.5f) * glm::vec2(static_cast<float>(GetWidth()), static_cast<float>(GetHeight()));
+}
@@ -0,0 +1,137 @@
+//
+//  Scene_OcclusionCuller.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef Scene_OcclusionCuller_hpp
+#define Scene_OcclusionCuller_hpp
+
+#include "Core_Math.hpp"
+#include "Scene_Aabb.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class Core_JobSystem;
+
+// Software occlusion culling for devices where a gpu occlusion pass costs more than it
+// saves. Occluder meshes are rasterised on the cpu into a small depth buffer, then the
+// boxes of the objects that survived the frustum are tested against it before any
+// draws are recorded.
+//
+// The depth buffer is stored as 8x4 pixel tiles, one tile is a contiguous run of floats
+// so a tile row fills a simd register and the pixel loops vectorise. Each tile also keeps
+// the farthest depth in it, a box nearer than that is visible without looking at a pixel.
+//
+// Occluders are rasterised a tile row at a time, given a job system the rows are split across
+// its workers and no two jobs ever write the same tile. Only pixel centres a triangle covers are
+// written and triangles that cross the near plane are dropped, so an occluder can only ever
+// hide less than it really does.
+class Scene_OcclusionCuller
+{
+public:
+    struct Stats
+    {
+        bool operator==(const Stats& other) const;
+        
+        uint32_t    m_Occluders;
+        uint32_t    m_Triangles;    // rasterised, after the near plane and off screen ones are dropped
+        uint32_t    m_Tested;
+        uint32_t    m_Occluded;
+    };
+    
+    Scene_OcclusionCuller();
+    ~Scene_OcclusionCuller();
+    
+    // rounded up to whole tiles
+    void Init(uint32_t aWidth, uint32_t aHeight);
+    
+    // model space triangles, kept until the culler goes. meant for simplified meshes that
+    // sit inside what they stand in for, anything bigger hides objects that are visible
+    uint32_t AddOccluderMesh(const std::vector<glm::vec3>& somePositions, const std::vector<uint32_t>& someIndices);
+    
+    // what the next Render draws
+    void ClearOccluders();
+    void AddOccluder(uint32_t aMesh, const glm::mat4& aTransform);
+    
+    void Render(const glm::mat4& aViewProj, Core_JobSystem* aJobs = nullptr);
+    
+    // against the last Render, false only when every pixel the box covers is nearer than it
+    bool IsBoxVisible(const glm::vec3& aMin, const glm::vec3& aMax) const;
+    
+    // drops the indices in ioVisible whose box in someBoxes is hidden, the order is kept
+    void Cull(const std::vector<Scene_Aabb>& someBoxes, std::vector<uint32_t>& ioVisible);
+    
+    uint32_t GetWidth() const { return m_TilesX * TILE_WIDTH; }
+    uint32_t GetHeight() const { return m_TilesY * TILE_HEIGHT; }
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    static const uint32_t TILE_WIDTH = 8;
+    static const uint32_t TILE_HEIGHT = 4;
+    static const uint32_t TILE_PIXELS = TILE_WIDTH * TILE_HEIGHT;
+    
+    // below this many triangles per worker the hand off costs more than it saves
+    static const uint32_t MIN_TRIANGLES_PER_JOB = 256;
+    
+    struct OccluderMesh
+    {
+        uint32_t    m_FirstPosition;
+        uint32_t    m_PositionCount;
+        uint32_t    m_FirstIndex;
+        uint32_t    m_IndexCount;
+    };
+    
+    struct Occluder
+    {
+        uint32_t    m_Mesh;
+        glm::mat4   m_Transform;
+    };
+    
+    // edge functions and depth plane in pixels, everything inside has all three edges >= 0
+    struct Triangle
+    {
+        float       m_EdgeA[3];
+        float       m_EdgeB[3];
+        float       m_EdgeC[3];
+        float       m_DepthA;
+        float       m_DepthB;
+        float       m_DepthC;
+        int32_t     m_MinX;
+        int32_t     m_MinY;
+        int32_t     m_MaxX;
+        int32_t     m_MaxY;
+    };
+    
+    void SetupTriangles();
+    bool SetupTriangle(const glm::vec4& aClip0, const glm::vec4& aClip1, const glm::vec4& aClip2, Triangle& outTriangle) const;
+    
+    // every aRowStep'th tile row from aFirstRow, then updates those tiles' farthest depth
+    void RasterizeRows(uint32_t aFirstRow, uint32_t aRowStep);
+    void RasterizeInRow(const Triangle& aTriangle, uint32_t aTileRow);
+    
+    glm::vec2 ToPixels(const glm::vec4& aClip) const;
+    
+    uint32_t                m_TilesX;
+    uint32_t                m_TilesY;
+    std::vector<float>      m_Depth;
+    std::vector<float>      m_TileMaxDepth;
+    
+    std::vector<glm::vec3>      m_MeshPositions;
+    std::vector<uint32_t>       m_MeshIndices;
+    std::vector<OccluderMesh>   m_Meshes;
+    std::vector<Occluder>       m_Occluders;
+    
+    // rebuilt every Render, a triangle sits in the bin of every tile row it touches
+    glm::mat4                           m_ViewProj;
+    std::vector<Triangle>               m_Triangles;
+    std::vector<std::vector<uint32_t>>  m_RowBins;
+    std::vector<glm::vec4>              m_ClipPositions;
+    
+    Stats                   m_Stats;
+};
+
+#endif /* Scene_OcclusionCuller_hpp */
@@ -37,6 +37,7 @@ bool GLWindow::Init()
     glfwSetWindowUserPointer(myInternalWindow, this);
     
     glfwSetWindowSizeCallback(myInternalWindow, WindowSizeCallback);
+    glfwSetWindowRefreshCallback(myInternalWindow, WindowRefreshCallback);
     
     return true;
 }
@@ -64,6 +65,16 @@ void GLWindow::PollEvents()
     glfwPollEvents();
 }
 
+void GLWindow::WaitEvents(double aTimeoutSeconds)
+{
+    glfwWaitEventsTimeout(aTimeoutSeconds);
+}
+
+void GLWindow::WakeUp()
+{
+    glfwPostEmptyEvent();
+}
+
 const char** GLWindow::GetExtensionList(uint32_t* outExtensionCount)
 {
     return glfwGetRequiredInstanceExtensions(outExtensionCount);
@@ -79,4 +90,12 @@ void GLWindow::WindowSizeCallback(GLFWwindow* aWindow, int aWidth, int aHeight)
     GLWindow* thisWindow = static_cast<GLWindow*>(glfwGetWindowUserPointer(aWindow));
     thisWindow->m_Width = aWidth;
     thisWindow->m_Height = aHeight;
+    
+    thisWindow->NotifyWindowChanged(WE_SIZE);
+}
+
+void GLWindow::WindowRefreshCallback(GLFWwindow* aWindow)
+{
+    GLWindow* thisWindow = static_cast<GLWindow*>(glfwGetWindowUserPointer(aWindow));
+    thisWindow->NotifyWindowChanged(WE_REFRESH);
 }
@@ -26,6 +26,8 @@ public:
     
     bool ShouldCloseWindow() const override;
     void PollEvents() override;
+    void WaitEvents(double aTimeoutSeconds) override;
+    void WakeUp() override;
     
     const char** GetExtensionList(uint32_t* outExtensionCount) override;
 
@@ -33,6 +35,7 @@ public:
     
 private:
     static void WindowSizeCallback(GLFWwindow* window, int width, int height);
+    static void WindowRefreshCallback(GLFWwindow* window);
     
     GLFWwindow* myInternalWindow;
 };
@@ -0,0 +1,235 @@
+//
+//  VulkanBindlessTable.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanBindlessTable.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanTimeline.hpp"
+
+#include <array>
+
+VulkanBindlessTable::VulkanBindlessTable()
+: m_Timeline(nullptr)
+, m_SetLayout(VK_NULL_HANDLE)
+, m_DescriptorPool(VK_NULL_HANDLE)
+, m_Set(VK_NULL_HANDLE)
+, m_TextureCount(0)
+, m_SamplerCount(0)
+{
+}
+
+VulkanBindlessTable::~VulkanBindlessTable()
+{
+    Shutdown();
+}
+
+bool VulkanBindlessTable::Init()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    const DeviceCapabilities& caps = renderer->GetDeviceCapabilities();
+    
+    m_Timeline = renderer->GetGraphicsTimeline();
+    
+    if(!caps.m_DescriptorIndexing)
+    {
+        std::cout << "Bindless textures disabled: VK_EXT_descriptor_indexing or dynamic sampled image indexing not supported" << std::endl;
+        return true;
+    }
+    
+    if(caps.m_MaxBindlessTextures < MAX_TEXTURES)
+    {
+        std::cout << "Bindless textures disabled: device allows " << caps.m_MaxBindlessTextures << " textures per stage" << std::endl;
+        return true;
+    }
+    
+    return CreateSetLayout() && CreateSet();
+}
+
+void VulkanBindlessTable::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    // the set goes with the pool
+    if(m_DescriptorPool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
+    
+    if(m_SetLayout != VK_NULL_HANDLE)
+        vkDestroyDescriptorSetLayout(device, m_SetLayout, nullptr);
+    
+    m_DescriptorPool = VK_NULL_HANDLE;
+    m_SetLayout = VK_NULL_HANDLE;
+    m_Set = VK_NULL_HANDLE;
+    
+    m_TextureCount = 0;
+    m_SamplerCount = 0;
+    m_FreeTextures.clear();
+    m_RetiredTextures.clear();
+}
+
+bool VulkanBindlessTable::CreateSetLayout()
+{
+    // not through the layout cache, reflection knows nothing of the binding flags
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    
+    bindings[0].binding = TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = MAX_TEXTURES;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    
+    bindings[1].binding = SAMPLER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[1].descriptorCount = MAX_SAMPLERS;
+    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    
+    // unwritten slots are fine as long as nothing indexes them
+    std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags =
+    {
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
+    };
+    
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo = {};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    flagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.data();
+    
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    
+    return vkCreateDescriptorSetLayout(VulkanRenderer::GetInstance()->GetLogicalDevice(), &layoutInfo, nullptr, &m_SetLayout) == VK_SUCCESS;
+}
+
+bool VulkanBindlessTable::CreateSet()
+{
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    poolSizes[0].descriptorCount = MAX_TEXTURES;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+    poolSizes[1].descriptorCount = MAX_SAMPLERS;
+    
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1;
+    
+    if(vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+        return false;
+    
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_DescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_SetLayout;
+    
+    if(vkAllocateDescriptorSets(device, &allocInfo, &m_Set) != VK_SUCCESS)
+    {
+        m_Set = VK_NULL_HANDLE;
+        return false;
+    }
+    
+    return true;
+}
+
+uint32_t VulkanBindlessTable::AddTexture(VkImageView anImageView)
+{
+    if(!IsSupported())
+        return INVALID_INDEX;
+    
+    RecycleTextures();
+    
+    uint32_t index = INVALID_INDEX;
+    
+    if(!m_FreeTextures.empty())
+    {
+        index = m_FreeTextures.back();
+        m_FreeTextures.pop_back();
+    }
+    else if(m_TextureCount < MAX_TEXTURES)
+    {
+        index = m_TextureCount++;
+    }
+    else
+    {
+        return INVALID_INDEX;
+    }
+    
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = anImageView;
+    
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = m_Set;
+    descriptorWrite.dstBinding = TEXTURE_BINDING;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+    
+    vkUpdateDescriptorSets(VulkanRenderer::GetInstance()->GetLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+    
+    return index;
+}
+
+uint32_t VulkanBindlessTable::AddSampler(VkSampler aSampler)
+{
+    if(!IsSupported() || m_SamplerCount >= MAX_SAMPLERS)
+        return INVALID_INDEX;
+    
+    const uint32_t index = m_SamplerCount++;
+    
+    VkDescriptorImageInfo samplerInfo = {};
+    samplerInfo.sampler = aSampler;
+    
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = m_Set;
+    descriptorWrite.dstBinding = SAMPLER_BINDING;
+    descriptorWrite.dstArrayElement = index;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &samplerInfo;
+    
+    vkUpdateDescriptorSets(VulkanRenderer::GetInstance()->GetLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+    
+    return index;
+}
+
+void VulkanBindlessTable::RemoveTexture(uint32_t anIndex)
+{
+    if(anIndex >= m_TextureCount)
+        return;
+    
+    // frames already submitted may still sample it, the descriptor has to stay until they are done
+    RetiredTexture retired;
+    retired.m_Value = m_Timeline->GetLastSubmittedValue();
+    retired.m_Index = anIndex;
+    
+    m_RetiredTextures.push_back(retired);
+}
+
+void VulkanBindlessTable::RecycleTextures()
+{
+    while (!m_RetiredTextures.empty() && m_Timeline->IsComplete(m_RetiredTextures.front().m_Value))
+    {
+        m_FreeTextures.push_back(m_RetiredTextures.front().m_Index);
+        m_RetiredTextures.pop_front();
+    }
+}
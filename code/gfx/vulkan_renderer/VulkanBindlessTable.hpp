@@ -0,0 +1,84 @@
+//
+//  VulkanBindlessTable.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanBindlessTable_hpp
+#define VulkanBindlessTable_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <deque>
+
+class VulkanTimeline;
+
+// Every texture in the scene in one descriptor set, a large partially bound array of
+// sampled images next to a small array of samplers. Draws pick theirs by index through
+// MaterialConstants, so one bind of the set a frame serves every material and draws no
+// longer split on descriptor sets.
+//
+// The image array is update after bind, textures can be added while frames using the
+// set are in flight. Samplers are not, add them before the set is first bound. A removed
+// texture's slot is only handed out again once the frames that could still read it have
+// finished on the graphics timeline.
+//
+// Needs VK_EXT_descriptor_indexing and shaderSampledImageArrayDynamicIndexing, IsSupported
+// is false without them and the caller keeps writing a combined image sampler per set.
+class VulkanBindlessTable
+{
+public:
+    static const uint32_t SET_INDEX = 1;
+    static const uint32_t TEXTURE_BINDING = 0;
+    static const uint32_t SAMPLER_BINDING = 1;
+    
+    // must match the array sizes in shader_bindless.frag
+    static const uint32_t MAX_TEXTURES = 4096;
+    static const uint32_t MAX_SAMPLERS = 4;
+    
+    static const uint32_t INVALID_INDEX = 0xffffffff;
+    
+    VulkanBindlessTable();
+    ~VulkanBindlessTable();
+    
+    bool Init();
+    void Shutdown();
+    
+    bool IsSupported() const { return m_Set != VK_NULL_HANDLE; }
+    
+    // INVALID_INDEX once the table is full
+    uint32_t AddTexture(VkImageView anImageView);
+    uint32_t AddSampler(VkSampler aSampler);
+    
+    // retire once nothing recorded but not yet submitted reads the slot, like VulkanDeletionQueue
+    void RemoveTexture(uint32_t anIndex);
+    
+    VkDescriptorSetLayout   GetSetLayout() const { return m_SetLayout; }
+    VkDescriptorSet         GetSet() const { return m_Set; }
+    uint32_t                GetTextureCount() const { return m_TextureCount - static_cast<uint32_t>(m_FreeTextures.size() + m_RetiredTextures.size()); }
+
+private:
+    struct RetiredTexture
+    {
+        uint64_t    m_Value;
+        uint32_t    m_Index;
+    };
+    
+    bool CreateSetLayout();
+    bool CreateSet();
+    void RecycleTextures();
+    
+    VulkanTimeline*         m_Timeline;
+    VkDescriptorSetLayout   m_SetLayout;
+    VkDescriptorPool        m_DescriptorPool;
+    VkDescriptorSet         m_Set;
+    
+    uint32_t                m_TextureCount;
+    uint32_t                m_SamplerCount;
+    std::vector<uint32_t>   m_FreeTextures;
+    std::deque<RetiredTexture> m_RetiredTextures;  // values only go up, so oldest first
+};
+
+#endif /* VulkanBindlessTable_hpp */
@@ -0,0 +1,406 @@
+//
+//  VulkanCommandRecorder.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanCommandRecorder.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanModel.hpp"
+
+#include "Core_JobSystem.hpp"
+#include "VulkanBindlessTable.hpp"
+#include "Core_Utils.hpp"
+
+#include <algorithm>
+
+VulkanDrawItem::VulkanDrawItem()
+: m_Pipeline(VK_NULL_HANDLE)
+, m_Layout(VK_NULL_HANDLE)
+, m_DescriptorSet(VK_NULL_HANDLE)
+, m_Model(nullptr)
+, m_PositionOnly(false)
+, m_DynamicOffsetCount(0)
+, m_DynamicOffset(0)
+, m_BindlessSet(VK_NULL_HANDLE)
+, m_Material()
+, m_InstanceBuffer(VK_NULL_HANDLE)
+, m_FirstInstance(0)
+, m_InstanceCount(1)
+, m_IndirectBuffer(VK_NULL_HANDLE)
+, m_CountBuffer(VK_NULL_HANDLE)
+, m_MaxDrawCount(0)
+{
+}
+
+bool VulkanDrawItem::HasSameBindings(const VulkanDrawItem& other) const
+{
+    return m_DescriptorSet == other.m_DescriptorSet
+        && m_DynamicOffset == other.m_DynamicOffset
+        && m_BindlessSet == other.m_BindlessSet
+        && m_Material.m_TextureIndex == other.m_Material.m_TextureIndex
+        && m_Material.m_SamplerIndex == other.m_Material.m_SamplerIndex;
+}
+
+VulkanCommandRecorder::VulkanCommandRecorder()
+: m_ActivePassInfo(nullptr)
+, m_JobSystem(nullptr)
+, m_QueueFamily(0)
+{
+}
+
+VulkanCommandRecorder::~VulkanCommandRecorder()
+{
+    Shutdown();
+}
+
+bool VulkanCommandRecorder::Init(uint32_t aQueueFamily, uint32_t aFrameCount)
+{
+    m_QueueFamily = aQueueFamily;
+    m_JobSystem = Core_JobSystem::GetInstance();
+    
+    // the render thread records a slice too while it waits on the workers
+    const uint32_t sliceCount = m_JobSystem ? m_JobSystem->GetWorkerCount() + 1 : 1;
+    
+    m_Frames.resize(aFrameCount);
+    
+    for (FrameRecorder& frame : m_Frames)
+    {
+        frame.m_PrimaryPool = VK_NULL_HANDLE;
+        frame.m_Slices.resize(sliceCount, { VK_NULL_HANDLE, VK_NULL_HANDLE });
+        
+        if(!CreateCommandPool(frame.m_PrimaryPool))
+            return false;
+        
+        if(!AllocateCommandBuffer(frame.m_PrimaryPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, frame.m_Primary))
+            return false;
+        
+        for (SliceRecorder& slice : frame.m_Slices)
+        {
+            if(!CreateCommandPool(slice.m_Pool))
+                return false;
+            
+            if(!AllocateCommandBuffer(slice.m_Pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, slice.m_CmdBuffer))
+                return false;
+        }
+    }
+    
+    return true;
+}
+
+void VulkanCommandRecorder::Shutdown()
+{
+    // RecordFrame always waits on its slices, nothing of ours is left queued
+    m_JobSystem = nullptr;
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    // destroying a pool frees every buffer allocated from it
+    for (FrameRecorder& frame : m_Frames)
+    {
+        if(frame.m_PrimaryPool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(device, frame.m_PrimaryPool, nullptr);
+        
+        for (SliceRecorder& slice : frame.m_Slices)
+        {
+            if(slice.m_Pool != VK_NULL_HANDLE)
+                vkDestroyCommandPool(device, slice.m_Pool, nullptr);
+        }
+    }
+    
+    m_Frames.clear();
+}
+
+bool VulkanCommandRecorder::CreateCommandPool(VkCommandPool& outPool)
+{
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = m_QueueFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    
+    return vkCreateCommandPool(VulkanRenderer::GetInstance()->GetLogicalDevice(), &poolInfo, nullptr, &outPool) == VK_SUCCESS;
+}
+
+bool VulkanCommandRecorder::AllocateCommandBuffer(VkCommandPool aPool, VkCommandBufferLevel aLevel, VkCommandBuffer& outCmdBuffer)
+{
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = aPool;
+    allocInfo.level = aLevel;
+    allocInfo.commandBufferCount = 1;
+    
+    return vkAllocateCommandBuffers(VulkanRenderer::GetInstance()->GetLogicalDevice(), &allocInfo, &outCmdBuffer) == VK_SUCCESS;
+}
+
+bool VulkanCommandRecorder::RecordFrame(uint32_t aFrameIndex,
+                                        const VkRenderPassBeginInfo& aPassInfo,
+                                        const std::vector<VulkanDrawItem>& someDraws,
+                                        VkCommandBuffer& outCmdBuffer,
+                                        const FrameCallback& aRecordFrame)
+{
+    if(aFrameIndex >= m_Frames.size())
+        return false;
+    
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    FrameRecorder& frame = m_Frames[aFrameIndex];
+    
+    const size_t drawCount = someDraws.size();
+    const size_t maxSlices = frame.m_Slices.size();
+    const size_t sliceCount = std::max<size_t>(1, std::min(maxSlices, (drawCount + MIN_DRAWS_PER_SLICE - 1) / MIN_DRAWS_PER_SLICE));
+    const size_t drawsPerSlice = (drawCount + sliceCount - 1) / sliceCount;
+    
+    // resetting the pool is one call instead of one per buffer
+    vkResetCommandPool(device, frame.m_PrimaryPool, 0);
+    
+    for (size_t i = 0; i < sliceCount; ++i)
+    {
+        vkResetCommandPool(device, frame.m_Slices[i].m_Pool, 0);
+    }
+    
+    // not a vector<bool>, every slice writes a byte of its own
+    std::vector<uint8_t> sliceRecorded(sliceCount, 0);
+    Core_JobCounter pendingSlices;
+    
+    // slice 0 stays on this thread
+    for (size_t i = 1; i < sliceCount; ++i)
+    {
+        const size_t first = std::min(drawCount, i * drawsPerSlice);
+        const size_t count = std::min(drawCount, first + drawsPerSlice) - first;
+        const VkCommandBuffer cmdBuffer = frame.m_Slices[i].m_CmdBuffer;
+        const VulkanDrawItem* draws = someDraws.data() + first;
+        uint8_t* result = &sliceRecorded[i];
+        
+        m_JobSystem->Run([cmdBuffer, &aPassInfo, draws, count, result]()
+        {
+            *result = RecordSlice(cmdBuffer, aPassInfo, draws, count) ? 1 : 0;
+        }, &pendingSlices);
+    }
+    
+    bool recorded = RecordSlice(frame.m_Slices[0].m_CmdBuffer, aPassInfo, someDraws.data(), std::min(drawCount, drawsPerSlice));
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    recorded &= vkBeginCommandBuffer(frame.m_Primary, &beginInfo) == VK_SUCCESS;
+    
+    // always wait, the workers are still writing into this frame's buffers
+    if(sliceCount > 1)
+        m_JobSystem->Wait(pendingSlices);
+    
+    for (size_t i = 1; i < sliceCount; ++i)
+    {
+        recorded &= sliceRecorded[i] != 0;
+    }
+    
+    if(!recorded)
+        return false;
+    
+    m_ActivePassInfo = &aPassInfo;
+    m_ActiveSecondaries.resize(sliceCount);
+    
+    for (size_t i = 0; i < sliceCount; ++i)
+    {
+        m_ActiveSecondaries[i] = frame.m_Slices[i].m_CmdBuffer;
+    }
+    
+    if(aRecordFrame)
+        aRecordFrame(frame.m_Primary);
+    else
+        ExecuteDraws(frame.m_Primary);
+    
+    m_ActivePassInfo = nullptr;
+    m_ActiveSecondaries.clear();
+    
+    if(vkEndCommandBuffer(frame.m_Primary) != VK_SUCCESS)
+        return false;
+    
+    outCmdBuffer = frame.m_Primary;
+    
+    return true;
+}
+
+void VulkanCommandRecorder::RecordIndirectDraw(VkCommandBuffer aCmdBuffer, const VulkanDrawItem& aDraw)
+{
+    const DeviceCapabilities& caps = VulkanRenderer::GetInstance()->GetDeviceCapabilities();
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    
+    // the gpu wrote how many commands survived, only the count variant can use that directly
+    if(caps.m_CmdDrawIndexedIndirectCount && aDraw.m_CountBuffer != VK_NULL_HANDLE)
+    {
+        caps.m_CmdDrawIndexedIndirectCount(aCmdBuffer, aDraw.m_IndirectBuffer, 0, aDraw.m_CountBuffer, 0, aDraw.m_MaxDrawCount, stride);
+        return;
+    }
+    
+    // otherwise every slot is drawn, culled slots were cleared to zero instances
+    if(caps.m_MultiDrawIndirect)
+    {
+        vkCmdDrawIndexedIndirect(aCmdBuffer, aDraw.m_IndirectBuffer, 0, aDraw.m_MaxDrawCount, stride);
+        return;
+    }
+    
+    for (uint32_t i = 0; i < aDraw.m_MaxDrawCount; ++i)
+    {
+        vkCmdDrawIndexedIndirect(aCmdBuffer, aDraw.m_IndirectBuffer, i * stride, 1, stride);
+    }
+}
+
+void VulkanCommandRecorder::ExecuteDraws(VkCommandBuffer aCmdBuffer, VkRenderPass aRenderPass)
+{
+    if(!m_ActivePassInfo)
+        return;
+    
+    // the secondaries only need a compatible pass, the load and store ops are free to differ
+    VkRenderPassBeginInfo passInfo = *m_ActivePassInfo;
+    
+    if(aRenderPass != VK_NULL_HANDLE)
+        passInfo.renderPass = aRenderPass;
+    
+    vkCmdBeginRenderPass(aCmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(aCmdBuffer, static_cast<uint32_t>(m_ActiveSecondaries.size()), m_ActiveSecondaries.data());
+    vkCmdEndRenderPass(aCmdBuffer);
+}
+
+void VulkanCommandRecorder::RecordDraws(VkCommandBuffer aCmdBuffer, VkRenderPass aRenderPass, const std::vector<VulkanDrawItem>& someDraws)
+{
+    if(!m_ActivePassInfo || someDraws.empty())
+        return;
+    
+    VkRenderPassBeginInfo passInfo = *m_ActivePassInfo;
+    
+    if(aRenderPass != VK_NULL_HANDLE)
+        passInfo.renderPass = aRenderPass;
+    
+    // too few to be worth a secondary
+    vkCmdBeginRenderPass(aCmdBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+    RecordDrawCommands(aCmdBuffer, passInfo.renderArea, someDraws.data(), someDraws.size());
+    vkCmdEndRenderPass(aCmdBuffer);
+}
+
+bool VulkanCommandRecorder::RecordSlice(VkCommandBuffer aCmdBuffer,
+                                        const VkRenderPassBeginInfo& aPassInfo,
+                                        const VulkanDrawItem* someDraws,
+                                        size_t aDrawCount)
+{
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = aPassInfo.renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = aPassInfo.framebuffer;
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    
+    if(vkBeginCommandBuffer(aCmdBuffer, &beginInfo) != VK_SUCCESS)
+        return false;
+    
+    RecordDrawCommands(aCmdBuffer, aPassInfo.renderArea, someDraws, aDrawCount);
+    
+    return vkEndCommandBuffer(aCmdBuffer) == VK_SUCCESS;
+}
+
+void VulkanCommandRecorder::RecordDrawCommands(VkCommandBuffer aCmdBuffer,
+                                               const VkRect2D& aRenderArea,
+                                               const VulkanDrawItem* someDraws,
+                                               size_t aDrawCount)
+{
+    // dynamic state is not inherited from the primary
+    VkViewport viewport = {};
+    viewport.x = static_cast<float>(aRenderArea.offset.x);
+    viewport.y = static_cast<float>(aRenderArea.offset.y);
+    viewport.width = static_cast<float>(aRenderArea.extent.width);
+    viewport.height = static_cast<float>(aRenderArea.extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    
+    vkCmdSetViewport(aCmdBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(aCmdBuffer, 0, 1, &aRenderArea);
+    
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+    VkDescriptorSet boundSet = VK_NULL_HANDLE;
+    VkDescriptorSet boundBindlessSet = VK_NULL_HANDLE;
+    uint32_t boundOffset = 0;
+    MaterialConstants boundMaterial = {};
+    bool materialPushed = false;
+    VkBuffer boundInstances = VK_NULL_HANDLE;
+    VulkanModel* boundModel = nullptr;
+    bool boundPositionOnly = false;
+    
+    for (size_t i = 0; i < aDrawCount; ++i)
+    {
+        const VulkanDrawItem& draw = someDraws[i];
+        
+        // still compiling with no fallback, skip rather than stall the frame
+        if(draw.m_Pipeline == VK_NULL_HANDLE || !draw.m_Model)
+            continue;
+        
+        if(draw.m_Pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.m_Pipeline);
+            boundPipeline = draw.m_Pipeline;
+        }
+        
+        // the bindless layout has an extra set and a push range, so sets bound with the other one are disturbed
+        if(draw.m_Layout != boundLayout)
+        {
+            boundLayout = draw.m_Layout;
+            boundSet = VK_NULL_HANDLE;
+            boundBindlessSet = VK_NULL_HANDLE;
+            materialPushed = false;
+        }
+        
+        // a new dynamic offset is a rebind of the same set, which is cheap
+        if((draw.m_DescriptorSet != boundSet || draw.m_DynamicOffset != boundOffset) && draw.m_DescriptorSet != VK_NULL_HANDLE)
+        {
+            vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.m_Layout, 0, 1, &draw.m_DescriptorSet, draw.m_DynamicOffsetCount, &draw.m_DynamicOffset);
+            boundSet = draw.m_DescriptorSet;
+            boundOffset = draw.m_DynamicOffset;
+        }
+        
+        if(draw.m_BindlessSet != VK_NULL_HANDLE)
+        {
+            if(draw.m_BindlessSet != boundBindlessSet)
+            {
+                vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.m_Layout, VulkanBindlessTable::SET_INDEX, 1, &draw.m_BindlessSet, 0, nullptr);
+                boundBindlessSet = draw.m_BindlessSet;
+            }
+            
+            if(!materialPushed || draw.m_Material.m_TextureIndex != boundMaterial.m_TextureIndex || draw.m_Material.m_SamplerIndex != boundMaterial.m_SamplerIndex)
+            {
+                vkCmdPushConstants(aCmdBuffer, draw.m_Layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MaterialConstants), &draw.m_Material);
+                boundMaterial = draw.m_Material;
+                materialPushed = true;
+            }
+        }
+        
+        // batches index into one shared buffer by first instance, so it only binds once
+        if(draw.m_InstanceBuffer != boundInstances && draw.m_InstanceBuffer != VK_NULL_HANDLE)
+        {
+            const VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(aCmdBuffer, InstanceData::BINDING, 1, &draw.m_InstanceBuffer, &offset);
+            boundInstances = draw.m_InstanceBuffer;
+        }
+        
+        if(draw.m_Model != boundModel || draw.m_PositionOnly != boundPositionOnly)
+        {
+            draw.m_Model->Bind(aCmdBuffer, draw.m_PositionOnly);
+            boundModel = draw.m_Model;
+            boundPositionOnly = draw.m_PositionOnly;
+        }
+        
+        if(draw.m_IndirectBuffer != VK_NULL_HANDLE)
+            RecordIndirectDraw(aCmdBuffer, draw);
+        else
+            draw.m_Model->Draw(aCmdBuffer, draw.m_InstanceCount, draw.m_FirstInstance);
+    }
+}
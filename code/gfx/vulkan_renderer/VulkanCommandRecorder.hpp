@@ -0,0 +1,129 @@
+//
+//  VulkanCommandRecorder.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanCommandRecorder_hpp
+#define VulkanCommandRecorder_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <functional>
+
+class Core_JobSystem;
+class VulkanModel;
+
+//----------------------------------------------------------------------
+struct VulkanDrawItem
+{
+    VulkanDrawItem();
+    
+    // same sets, dynamic offset and material, nothing to rebind or push between the two
+    bool HasSameBindings(const VulkanDrawItem& other) const;
+    
+    VkPipeline          m_Pipeline;
+    VkPipelineLayout    m_Layout;
+    VkDescriptorSet     m_DescriptorSet;
+    VulkanModel*        m_Model;
+    bool                m_PositionOnly;     // binds the model's PositionVertex stream, for depth only pipelines
+    
+    // for a set with a dynamic uniform buffer, only one per set is supported
+    uint32_t            m_DynamicOffsetCount;
+    uint32_t            m_DynamicOffset;
+    
+    // bindless mode, the table goes to VulkanBindlessTable::SET_INDEX and the material is pushed
+    VkDescriptorSet     m_BindlessSet;
+    MaterialConstants   m_Material;
+    
+    // bound to InstanceData::BINDING when set
+    VkBuffer            m_InstanceBuffer;
+    uint32_t            m_FirstInstance;
+    uint32_t            m_InstanceCount;
+    
+    // gpu driven, draws up to m_MaxDrawCount VkDrawIndexedIndirectCommands instead of the above
+    VkBuffer            m_IndirectBuffer;
+    VkBuffer            m_CountBuffer;      // only read when the device has draw indirect count
+    uint32_t            m_MaxDrawCount;
+};
+
+//----------------------------------------------------------------------
+// Records a frame's draw list every frame. The list is cut into slices and each
+// slice is recorded into a secondary command buffer on its own thread, the primary
+// only begins the render pass and executes them.
+//
+// Every frame in flight has its own transient pools, one per recording thread, so
+// a pool is only ever touched by one thread and is reset in one call once the
+// graphics timeline has passed the value the frame was submitted with.
+class VulkanCommandRecorder
+{
+public:
+    // records the primary in place of just the draw pass, ExecuteDraws puts the draws where they belong
+    typedef std::function<void(VkCommandBuffer)> FrameCallback;
+    
+    VulkanCommandRecorder();
+    ~VulkanCommandRecorder();
+    
+    // records in one slice per job system worker plus the calling thread, one slice without a job system
+    bool Init(uint32_t aQueueFamily, uint32_t aFrameCount);
+    void Shutdown();
+    
+    // caller must have waited on the frame's timeline value, the returned buffer is valid until
+    // the same frame index is recorded again
+    bool RecordFrame(uint32_t aFrameIndex,
+                     const VkRenderPassBeginInfo& aPassInfo,
+                     const std::vector<VulkanDrawItem>& someDraws,
+                     VkCommandBuffer& outCmdBuffer,
+                     const FrameCallback& aRecordFrame = FrameCallback());
+    
+    // only from inside the frame callback, begins the render pass and executes the recorded draws.
+    // aRenderPass replaces the frame's with a compatible one, e.g. the same attachments with other load ops
+    void ExecuteDraws(VkCommandBuffer aCmdBuffer, VkRenderPass aRenderPass = VK_NULL_HANDLE);
+    
+    // only from inside the frame callback, records a few more draws straight into the primary
+    // in their own instance of a pass compatible with the frame's
+    void RecordDraws(VkCommandBuffer aCmdBuffer, VkRenderPass aRenderPass, const std::vector<VulkanDrawItem>& someDraws);
+
+private:
+    // below this many draws a slice costs more to hand off than to record
+    static const size_t MIN_DRAWS_PER_SLICE = 128;
+    
+    struct SliceRecorder
+    {
+        VkCommandPool   m_Pool;
+        VkCommandBuffer m_CmdBuffer;
+    };
+    
+    struct FrameRecorder
+    {
+        VkCommandPool               m_PrimaryPool;
+        VkCommandBuffer             m_Primary;
+        std::vector<SliceRecorder>  m_Slices;
+    };
+    
+    bool CreateCommandPool(VkCommandPool& outPool);
+    bool AllocateCommandBuffer(VkCommandPool aPool, VkCommandBufferLevel aLevel, VkCommandBuffer& outCmdBuffer);
+    
+    static void RecordIndirectDraw(VkCommandBuffer aCmdBuffer, const VulkanDrawItem& aDraw);
+    static void RecordDrawCommands(VkCommandBuffer aCmdBuffer,
+                                   const VkRect2D& aRenderArea,
+                                   const VulkanDrawItem* someDraws,
+                                   size_t aDrawCount);
+    static bool RecordSlice(VkCommandBuffer aCmdBuffer,
+                            const VkRenderPassBeginInfo& aPassInfo,
+                            const VulkanDrawItem* someDraws,
+                            size_t aDrawCount);
+    
+    std::vector<FrameRecorder>  m_Frames;
+    
+    // what ExecuteDraws inserts, only set while RecordFrame runs
+    const VkRenderPassBeginInfo*    m_ActivePassInfo;
+    std::vector<VkCommandBuffer>    m_ActiveSecondaries;
+    
+    Core_JobSystem*             m_JobSystem;
+    uint32_t                    m_QueueFamily;
+};
+
+#endif /* VulkanCommandRecorder_hpp */
@@ -22,6 +22,25 @@ bool QueueFamilyIndices::IsComplete()
     return m_GraphicsFamily >= 0 && m_PresentFamily >= 0;
 }
 
+//---------------------------------------------------------------------------
+// DeviceCapabilities
+//---------------------------------------------------------------------------
+DeviceCapabilities::DeviceCapabilities()
+: m_MultiDrawIndirect(false)
+, m_DrawIndirectFirstInstance(false)
+, m_Maintenance1(false)
+, m_DescriptorIndexing(false)
+, m_MaxBindlessTextures(0)
+, m_CmdDrawIndexedIndirectCount(nullptr)
+, m_CreateDescriptorUpdateTemplate(nullptr)
+, m_DestroyDescriptorUpdateTemplate(nullptr)
+, m_UpdateDescriptorSetWithTemplate(nullptr)
+, m_TimelineSemaphore(false)
+, m_GetSemaphoreCounterValue(nullptr)
+, m_WaitSemaphores(nullptr)
+{
+}
+
 //---------------------------------------------------------------------------
 // SwapChainSupportDetails
 //---------------------------------------------------------------------------
@@ -37,6 +56,23 @@ namespace VK_Common
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
     
+    // enabled when the device has them
+    const std::vector<const char*> ourOptionalDeviceExtensions =
+    {
+        "VK_KHR_draw_indirect_count",
+        "VK_KHR_maintenance1",
+        "VK_KHR_maintenance3",
+        "VK_EXT_descriptor_indexing",
+        "VK_KHR_descriptor_update_template",
+        "VK_KHR_timeline_semaphore"
+    };
+    
+    // needed to query the descriptor indexing features on a 1.0 instance
+    const std::vector<const char*> ourOptionalInstanceExtensions =
+    {
+        "VK_KHR_get_physical_device_properties2"
+    };
+    
     const std::vector<VkFormat> ourDepthFormats =
     {
         VK_FORMAT_D32_SFLOAT,
@@ -19,16 +19,26 @@
 #include <thread>
 #include <iostream>
 
-#define GLM_FORCE_RADIANS
-#define GLM_FORCE_DEPTH_ZERO_TO_ONE
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include "Core_Math.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
 #include "Core_ScopedTimer.hpp"
 
+enum RenderPassID
+{
+    RENDER_PASS_MAIN,
+    RENDER_PASS_MAIN_BINDLESS,      // the main render pass with the bindless table layout
+};
+
+enum VertexLayout
+{
+    VERTEX_LAYOUT_POSITION_COLOR,
+    VERTEX_LAYOUT_POSITION_COLOR_INSTANCED,     // PositionColorVertex + InstanceData
+    VERTEX_LAYOUT_POSITION_INSTANCED,           // PositionVertex + InstanceData, for depth only passes
+};
+
 struct PositionColorVertex
 {
     glm::vec3 m_Pos;
@@ -72,6 +82,33 @@ struct PositionColorVertex
     }
 };
 
+// the positions of a PositionColorVertex stream on their own, depth only passes read a third of the memory
+struct PositionVertex
+{
+    glm::vec3 m_Pos;
+    
+    static VkVertexInputBindingDescription GetBindingDescription()
+    {
+        VkVertexInputBindingDescription bindingDescription = {};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(PositionVertex);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescription;
+    }
+    
+    static std::array<VkVertexInputAttributeDescription, 1> GetAttributeDescriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 1> attributeDescriptions = {};
+        
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(PositionVertex, m_Pos);
+        
+        return attributeDescriptions;
+    }
+};
+
 namespace std
 {
     template<> struct hash<PositionColorVertex>
@@ -83,13 +120,63 @@ namespace std
     };
 }
 
-struct ConstantBufferObject
+// per instance stream, the model matrix goes in as four vec4 columns after the vertex attributes
+struct InstanceData
 {
+    static const uint32_t BINDING = 1;
+    static const uint32_t FIRST_LOCATION = 3;
+    
     glm::mat4 m_Model;
+    
+    static VkVertexInputBindingDescription GetBindingDescription()
+    {
+        VkVertexInputBindingDescription bindingDescription = {};
+        bindingDescription.binding = BINDING;
+        bindingDescription.stride = sizeof(InstanceData);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        return bindingDescription;
+    }
+    
+    static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions()
+    {
+        std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+        
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            attributeDescriptions[i].binding = BINDING;
+            attributeDescriptions[i].location = FIRST_LOCATION + i;
+            attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            attributeDescriptions[i].offset = offsetof(InstanceData, m_Model) + sizeof(glm::vec4) * i;
+        }
+        
+        return attributeDescriptions;
+    }
+};
+
+// per object input to the gpu cull, matches GpuObject in cull.comp (std430)
+struct GpuObjectData
+{
+    glm::vec4   m_BoundingSphere;   // model space center + radius
+    uint32_t    m_IndexCount;
+    uint32_t    m_FirstIndex;
+    int32_t     m_VertexOffset;
+    uint32_t    m_Pad;
+};
+
+// per view, the model matrix comes in per instance, see InstanceData
+struct ViewConstants
+{
     glm::mat4 m_View;
     glm::mat4 m_Proj;
 };
 
+// per draw push constant in bindless mode, indices into VulkanBindlessTable
+struct MaterialConstants
+{
+    uint32_t m_TextureIndex;
+    uint32_t m_SamplerIndex;
+};
+
 //----------------------------------------------------------------------
 struct QueueFamilyIndices
 {
@@ -100,6 +187,40 @@ struct QueueFamilyIndices
     int m_PresentFamily;
 };
 
+//----------------------------------------------------------------------
+typedef void (VKAPI_PTR *DrawIndexedIndirectCountFunc)(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                                       VkBuffer countBuffer, VkDeviceSize countBufferOffset,
+                                                       uint32_t maxDrawCount, uint32_t stride);
+
+// optional device features, everything here has a fallback when it is missing
+struct DeviceCapabilities
+{
+    DeviceCapabilities();
+    
+    bool m_MultiDrawIndirect;
+    bool m_DrawIndirectFirstInstance;
+    
+    // VK_KHR_maintenance1, without it a full descriptor pool is not guaranteed to say so
+    bool m_Maintenance1;
+    
+    // VK_EXT_descriptor_indexing and shaderSampledImageArrayDynamicIndexing, with what the bindless table needs enabled
+    bool        m_DescriptorIndexing;
+    uint32_t    m_MaxBindlessTextures;
+    
+    // VK_KHR_draw_indirect_count, null when the extension is not there
+    DrawIndexedIndirectCountFunc m_CmdDrawIndexedIndirectCount;
+    
+    // VK_KHR_descriptor_update_template, null when the extension is not there
+    PFN_vkCreateDescriptorUpdateTemplateKHR     m_CreateDescriptorUpdateTemplate;
+    PFN_vkDestroyDescriptorUpdateTemplateKHR    m_DestroyDescriptorUpdateTemplate;
+    PFN_vkUpdateDescriptorSetWithTemplateKHR    m_UpdateDescriptorSetWithTemplate;
+    
+    // VK_KHR_timeline_semaphore with the feature enabled, the functions are null otherwise
+    bool                                    m_TimelineSemaphore;
+    PFN_vkGetSemaphoreCounterValueKHR       m_GetSemaphoreCounterValue;
+    PFN_vkWaitSemaphoresKHR                 m_WaitSemaphores;
+};
+
 //----------------------------------------------------------------------
 struct SwapChainSupportDetails
 {
@@ -115,6 +236,8 @@ namespace VK_Common
 {
     extern const std::vector<VkFormat> ourDepthFormats;
     extern const std::vector<const char*> ourDeviceExtensions;
+    extern const std::vector<const char*> ourOptionalDeviceExtensions;
+    extern const std::vector<const char*> ourOptionalInstanceExtensions;
     
     bool CheckForValidExtensions(uint32_t winExtensionCount, const char** winExtensions);
 }
@@ -0,0 +1,134 @@
+//
+//  VulkanDeletionQueue.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanDeletionQueue.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanTimeline.hpp"
+
+VulkanDeletionQueue::VulkanDeletionQueue()
+: m_Timeline(nullptr)
+{
+}
+
+VulkanDeletionQueue::~VulkanDeletionQueue()
+{
+}
+
+bool VulkanDeletionQueue::Init(VulkanTimeline* aTimeline)
+{
+    m_Timeline = aTimeline;
+    return m_Timeline != nullptr;
+}
+
+void VulkanDeletionQueue::Shutdown()
+{
+    for (const Retired& retired : m_Pending)
+    {
+        Destroy(retired);
+    }
+    
+    m_Pending.clear();
+    m_Timeline = nullptr;
+}
+
+void VulkanDeletionQueue::RetireBuffer(VkBuffer aBuffer)
+{
+    if(aBuffer == VK_NULL_HANDLE)
+        return;
+    
+    Retired retired;
+    retired.m_Type = HANDLE_BUFFER;
+    retired.m_Buffer = aBuffer;
+    Push(retired);
+}
+
+void VulkanDeletionQueue::RetireImage(VkImage anImage)
+{
+    if(anImage == VK_NULL_HANDLE)
+        return;
+    
+    Retired retired;
+    retired.m_Type = HANDLE_IMAGE;
+    retired.m_Image = anImage;
+    Push(retired);
+}
+
+void VulkanDeletionQueue::RetireImageView(VkImageView aView)
+{
+    if(aView == VK_NULL_HANDLE)
+        return;
+    
+    Retired retired;
+    retired.m_Type = HANDLE_IMAGE_VIEW;
+    retired.m_ImageView = aView;
+    Push(retired);
+}
+
+void VulkanDeletionQueue::RetireMemory(VkDeviceMemory aMemory)
+{
+    if(aMemory == VK_NULL_HANDLE)
+        return;
+    
+    Retired retired;
+    retired.m_Type = HANDLE_MEMORY;
+    retired.m_Memory = aMemory;
+    Push(retired);
+}
+
+void VulkanDeletionQueue::RetireFramebuffer(VkFramebuffer aFramebuffer)
+{
+    if(aFramebuffer == VK_NULL_HANDLE)
+        return;
+    
+    Retired retired;
+    retired.m_Type = HANDLE_FRAMEBUFFER;
+    retired.m_Framebuffer = aFramebuffer;
+    Push(retired);
+}
+
+void VulkanDeletionQueue::Collect()
+{
+    while (!m_Pending.empty() && m_Timeline->IsComplete(m_Pending.front().m_Value))
+    {
+        Destroy(m_Pending.front());
+        m_Pending.pop_front();
+    }
+}
+
+void VulkanDeletionQueue::Push(Retired& aRetired)
+{
+    // every submit that could have used it has gone in, none after it can
+    aRetired.m_Value = m_Timeline->GetLastSubmittedValue();
+    m_Pending.push_back(aRetired);
+}
+
+void VulkanDeletionQueue::Destroy(const Retired& aRetired)
+{
+    VkDevice device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    switch (aRetired.m_Type)
+    {
+        case HANDLE_BUFFER:
+            vkDestroyBuffer(device, aRetired.m_Buffer, nullptr);
+            break;
+        case HANDLE_IMAGE:
+            vkDestroyImage(device, aRetired.m_Image, nullptr);
+            break;
+        case HANDLE_IMAGE_VIEW:
+            vkDestroyImageView(device, aRetired.m_ImageView, nullptr);
+            break;
+        case HANDLE_MEMORY:
+            vkFreeMemory(device, aRetired.m_Memory, nullptr);
+            break;
+        case HANDLE_FRAMEBUFFER:
+            vkDestroyFramebuffer(device, aRetired.m_Framebuffer, nullptr);
+            break;
+        default:
+            break;
+    }
+}
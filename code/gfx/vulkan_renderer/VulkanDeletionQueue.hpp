@@ -0,0 +1,77 @@
+//
+//  VulkanDeletionQueue.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanDeletionQueue_hpp
+#define VulkanDeletionQueue_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <deque>
+
+class VulkanTimeline;
+
+// Destroys objects once the gpu can no longer be using them, instead of waiting for the
+// device to go idle first. A retired object is tagged with the last value submitted on the
+// graphics timeline and destroyed by the first Collect after that value completes.
+//
+// Retire only once nothing recorded but not yet submitted uses the object, anything dropped
+// while building a frame must not be in that frame. Null handles are ignored.
+class VulkanDeletionQueue
+{
+public:
+    VulkanDeletionQueue();
+    ~VulkanDeletionQueue();
+    
+    bool Init(VulkanTimeline* aTimeline);
+    // destroys everything still queued, the device must be idle
+    void Shutdown();
+    
+    void RetireBuffer(VkBuffer aBuffer);
+    void RetireImage(VkImage anImage);
+    void RetireImageView(VkImageView aView);
+    void RetireMemory(VkDeviceMemory aMemory);
+    void RetireFramebuffer(VkFramebuffer aFramebuffer);
+    
+    // destroys whatever the gpu has finished with, once a frame. a compare when there is nothing
+    void Collect();
+    
+    size_t GetPendingCount() const { return m_Pending.size(); }
+
+private:
+    enum HandleType
+    {
+        HANDLE_BUFFER,
+        HANDLE_IMAGE,
+        HANDLE_IMAGE_VIEW,
+        HANDLE_MEMORY,
+        HANDLE_FRAMEBUFFER,
+    };
+    
+    struct Retired
+    {
+        uint64_t    m_Value;
+        HandleType  m_Type;
+        
+        union
+        {
+            VkBuffer        m_Buffer;
+            VkImage         m_Image;
+            VkImageView     m_ImageView;
+            VkDeviceMemory  m_Memory;
+            VkFramebuffer   m_Framebuffer;
+        };
+    };
+    
+    void Push(Retired& aRetired);
+    void Destroy(const Retired& aRetired);
+    
+    VulkanTimeline*         m_Timeline;
+    std::deque<Retired>     m_Pending;      // values only go up, so oldest first
+};
+
+#endif /* VulkanDeletionQueue_hpp */
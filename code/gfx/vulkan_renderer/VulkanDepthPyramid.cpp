@@ -0,0 +1,342 @@
+//
+//  VulkanDepthPyramid.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanDepthPyramid.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanDeletionQueue.hpp"
+#include "VulkanShader.hpp"
+#include "VulkanShaderLibrary.hpp"
+#include "VulkanLayoutCache.hpp"
+#include "VulkanUtils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+    const VkFormat ourPyramidFormat = VK_FORMAT_R32_SFLOAT;
+    
+    uint32_t PreviousPowerOfTwo(uint32_t aValue)
+    {
+        uint32_t result = 1;
+        
+        while (result * 2 <= aValue)
+        {
+            result *= 2;
+        }
+        
+        return result;
+    }
+}
+
+VulkanDepthPyramid::VulkanDepthPyramid()
+: m_DepthFormat(VK_FORMAT_UNDEFINED)
+, m_DepthExtent({0, 0})
+, m_SourceExtent({0, 0})
+, m_DepthImage(VK_NULL_HANDLE)
+, m_DepthView(VK_NULL_HANDLE)
+, m_Width(0)
+, m_Height(0)
+, m_Image(VK_NULL_HANDLE)
+, m_Memory(VK_NULL_HANDLE)
+, m_View(VK_NULL_HANDLE)
+, m_Sampler(VK_NULL_HANDLE)
+, m_SetLayout(VK_NULL_HANDLE)
+, m_PipelineLayout(VK_NULL_HANDLE)
+, m_Pipeline(VK_NULL_HANDLE)
+, m_UpdateTemplate(VulkanDescriptorAllocator::INVALID_TEMPLATE)
+{
+}
+
+VulkanDepthPyramid::~VulkanDepthPyramid()
+{
+    Shutdown();
+}
+
+bool VulkanDepthPyramid::Init(const char* aReduceShader, VkFormat aDepthFormat)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(renderer->GetPhysicalDevice(), aDepthFormat, &formatProperties);
+    
+    if((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+    {
+        std::cout << "Occlusion culling disabled: depth format cannot be sampled" << std::endl;
+        return true;
+    }
+    
+    if(!CreatePipeline(aReduceShader))
+    {
+        std::cout << "Occlusion culling disabled: could not load " << aReduceShader << std::endl;
+        return true;
+    }
+    
+    m_DepthFormat = aDepthFormat;
+    
+    VulkanDescriptorAllocator::TemplateEntries entries(2);
+    
+    entries[0].dstBinding = 0;
+    entries[0].descriptorCount = 1;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    entries[0].offset = offsetof(ReduceDescriptors, m_Source);
+    entries[0].stride = sizeof(VkDescriptorImageInfo);
+    
+    entries[1].dstBinding = 1;
+    entries[1].descriptorCount = 1;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    entries[1].offset = offsetof(ReduceDescriptors, m_Destination);
+    entries[1].stride = sizeof(VkDescriptorImageInfo);
+    
+    m_UpdateTemplate = renderer->GetDescriptorAllocator()->GetUpdateTemplate(m_SetLayout, entries);
+    
+    return m_UpdateTemplate != VulkanDescriptorAllocator::INVALID_TEMPLATE && CreateSampler();
+}
+
+void VulkanDepthPyramid::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    Release();
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    if(m_Sampler != VK_NULL_HANDLE)
+        vkDestroySampler(device, m_Sampler, nullptr);
+    
+    // the layouts belong to the layout cache, the template to the descriptor allocator
+    if(m_Pipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, m_Pipeline, nullptr);
+    
+    m_Sampler = VK_NULL_HANDLE;
+    m_Pipeline = VK_NULL_HANDLE;
+}
+
+bool VulkanDepthPyramid::CreatePipeline(const char* aReduceShader)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    const VulkanShader* reduceShader = renderer->GetShaderLibrary()->GetShader(aReduceShader);
+    
+    if(!reduceShader)
+        return false;
+    
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    
+    if(!renderer->GetLayoutCache()->GetLayouts({reduceShader}, m_PipelineLayout, setLayouts) || setLayouts.size() != 1)
+        return false;
+    
+    m_SetLayout = setLayouts[0];
+    
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = reduceShader->GetStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout = m_PipelineLayout;
+    
+    const VkPipelineCache pipelineCache = renderer->GetPipelineBuilder()->GetPipelineCache();
+    
+    if(vkCreateComputePipelines(renderer->GetLogicalDevice(), pipelineCache, 1, &pipelineInfo, nullptr, &m_Pipeline) != VK_SUCCESS)
+    {
+        m_Pipeline = VK_NULL_HANDLE;
+        return false;
+    }
+    
+    return true;
+}
+
+bool VulkanDepthPyramid::CreateSampler()
+{
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    
+    return vkCreateSampler(VulkanRenderer::GetInstance()->GetLogicalDevice(), &samplerInfo, nullptr, &m_Sampler) == VK_SUCCESS;
+}
+
+bool VulkanDepthPyramid::Resize(const VkExtent2D& aDepthExtent)
+{
+    if(m_Image != VK_NULL_HANDLE && aDepthExtent.width == m_DepthExtent.width && aDepthExtent.height == m_DepthExtent.height)
+        return true;
+    
+    // the old pyramid is retired, frames still in flight keep reading it
+    if(m_Image != VK_NULL_HANDLE)
+        Release();
+    
+    m_DepthExtent = aDepthExtent;
+    m_SourceExtent = aDepthExtent;
+    m_Width = PreviousPowerOfTwo(aDepthExtent.width);
+    m_Height = PreviousPowerOfTwo(aDepthExtent.height);
+    
+    uint32_t levelCount = 1;
+    
+    while ((std::max(m_Width, m_Height) >> levelCount) > 0)
+    {
+        ++levelCount;
+    }
+    
+    if(!VulkanUtils::CreateImage(m_Width, m_Height, levelCount, ourPyramidFormat, VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Image, m_Memory))
+        return false;
+    
+    if(!VulkanUtils::CreateImageView(m_Image, ourPyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_View, levelCount))
+        return false;
+    
+    m_LevelViews.resize(levelCount, VK_NULL_HANDLE);
+    
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        if(!VulkanUtils::CreateImageView(m_Image, ourPyramidFormat, VK_IMAGE_ASPECT_COLOR_BIT, m_LevelViews[level], 1, level))
+            return false;
+    }
+    
+    // where every frame leaves it, so the first one can transition from the same layout as the rest
+    return VulkanUtils::TransitionImageLayout(m_Image, ourPyramidFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, levelCount);
+}
+
+bool VulkanDepthPyramid::SetDepthSource(VkImage aDepthImage)
+{
+    if(aDepthImage == m_DepthImage && m_DepthView != VK_NULL_HANDLE)
+        return true;
+    
+    // frames in flight may still sample the old view
+    VulkanRenderer::GetInstance()->GetDeletionQueue()->RetireImageView(m_DepthView);
+    
+    m_DepthImage = aDepthImage;
+    m_DepthView = VK_NULL_HANDLE;
+    
+    if(aDepthImage == VK_NULL_HANDLE)
+        return false;
+    
+    // a sampled view can only see one of depth and stencil
+    return VulkanUtils::CreateImageView(aDepthImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, m_DepthView, 1);
+}
+
+void VulkanDepthPyramid::Release()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    // nothing was ever created without the queue
+    if(!renderer || !renderer->GetDeletionQueue())
+        return;
+    
+    VulkanDeletionQueue* deletionQueue = renderer->GetDeletionQueue();
+    
+    for (VkImageView& view : m_LevelViews)
+    {
+        deletionQueue->RetireImageView(view);
+    }
+    
+    m_LevelViews.clear();
+    
+    deletionQueue->RetireImageView(m_View);
+    deletionQueue->RetireImage(m_Image);
+    deletionQueue->RetireMemory(m_Memory);
+    deletionQueue->RetireImageView(m_DepthView);
+    
+    m_View = VK_NULL_HANDLE;
+    m_Image = VK_NULL_HANDLE;
+    m_Memory = VK_NULL_HANDLE;
+    m_DepthView = VK_NULL_HANDLE;
+    m_DepthImage = VK_NULL_HANDLE;
+    m_DepthExtent = {0, 0};
+    m_SourceExtent = {0, 0};
+    m_Width = 0;
+    m_Height = 0;
+}
+
+void VulkanDepthPyramid::SetSourceExtent(const VkExtent2D& anExtent)
+{
+    m_SourceExtent.width = std::max(1u, std::min(anExtent.width, m_DepthExtent.width));
+    m_SourceExtent.height = std::max(1u, std::min(anExtent.height, m_DepthExtent.height));
+}
+
+void VulkanDepthPyramid::Record(VkCommandBuffer aCmdBuffer)
+{
+    if(m_Image == VK_NULL_HANDLE || m_DepthView == VK_NULL_HANDLE)
+        return;
+    
+    VulkanDescriptorAllocator* descriptorAllocator = VulkanRenderer::GetInstance()->GetDescriptorAllocator();
+    
+    vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    
+    ReduceConstants constants = {};
+    constants.m_SourceSize[0] = static_cast<int32_t>(m_SourceExtent.width);
+    constants.m_SourceSize[1] = static_cast<int32_t>(m_SourceExtent.height);
+    
+    const uint32_t levelCount = GetLevelCount();
+    
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        // gone with the frame's other transient sets once the timeline has passed it
+        VkDescriptorSet descriptorSet = descriptorAllocator->AllocateTransient(m_SetLayout);
+        
+        if(descriptorSet == VK_NULL_HANDLE)
+            return;
+        
+        ReduceDescriptors descriptors = {};
+        descriptors.m_Source.sampler = m_Sampler;
+        descriptors.m_Source.imageView = level == 0 ? m_DepthView : m_LevelViews[level - 1];
+        descriptors.m_Source.imageLayout = level == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+        descriptors.m_Destination.imageView = m_LevelViews[level];
+        descriptors.m_Destination.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        
+        descriptorAllocator->UpdateSet(descriptorSet, m_UpdateTemplate, &descriptors);
+        
+        const uint32_t width = std::max(m_Width >> level, 1u);
+        const uint32_t height = std::max(m_Height >> level, 1u);
+        
+        constants.m_DestinationSize[0] = static_cast<int32_t>(width);
+        constants.m_DestinationSize[1] = static_cast<int32_t>(height);
+        
+        vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+        vkCmdPushConstants(aCmdBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReduceConstants), &constants);
+        vkCmdDispatch(aCmdBuffer, (width + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, (height + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE, 1);
+        
+        constants.m_SourceSize[0] = constants.m_DestinationSize[0];
+        constants.m_SourceSize[1] = constants.m_DestinationSize[1];
+        
+        // the last level is left to the render graph, whoever reads the pyramid next syncs on the whole image
+        if(level + 1 == levelCount)
+            break;
+        
+        // the next level reads this one
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = m_Image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = level;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        
+        vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+}
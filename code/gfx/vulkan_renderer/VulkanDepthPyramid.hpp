@@ -0,0 +1,101 @@
+//
+//  VulkanDepthPyramid.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanDepthPyramid_hpp
+#define VulkanDepthPyramid_hpp
+
+#include "VulkanCommon.hpp"
+#include "VulkanDescriptorAllocator.hpp"
+
+// A hierarchical depth buffer (Hi-Z) for occlusion culling. Each level holds the
+// farthest depth of the texels it covers in the level below, so a screen rect can be
+// tested against everything drawn over it with a handful of taps at the right level.
+//
+// Level 0 is the depth buffer rounded down to a power of two, built with one compute
+// dispatch per level. The pyramid is made for the swapchain extent and kept until
+// Release, between frames it sits in SHADER_READ_ONLY_OPTIMAL for the cull to sample.
+//
+// Needs a depth format that can be sampled and the reduce shader, IsSupported is
+// false without them and the caller culls by the frustum alone.
+class VulkanDepthPyramid
+{
+public:
+    VulkanDepthPyramid();
+    ~VulkanDepthPyramid();
+    
+    bool Init(const char* aReduceShader, VkFormat aDepthFormat);
+    void Shutdown();
+    
+    bool IsSupported() const { return m_Pipeline != VK_NULL_HANDLE; }
+    
+    // remakes the pyramid for a new extent, waits for the device when it has to replace one
+    bool Resize(const VkExtent2D& aDepthExtent);
+    
+    // the depth image the next Record reduces, a new image gets a new view
+    bool SetDepthSource(VkImage aDepthImage);
+    
+    // the part of the depth image at the origin that was drawn this frame, the whole image by default.
+    // the pyramid always covers the screen, a smaller source is stretched over it
+    void SetSourceExtent(const VkExtent2D& anExtent);
+    
+    // caller makes sure no frame in flight still uses it, e.g. on swapchain cleanup
+    void Release();
+    
+    // a render graph pass that reads the depth source as SAMPLED_COMPUTE and writes the pyramid as STORAGE_COMPUTE
+    void Record(VkCommandBuffer aCmdBuffer);
+    
+    VkImage     GetImage() const { return m_Image; }
+    VkImageView GetView() const { return m_View; }
+    VkSampler   GetSampler() const { return m_Sampler; }
+    uint32_t    GetWidth() const { return m_Width; }
+    uint32_t    GetHeight() const { return m_Height; }
+    uint32_t    GetLevelCount() const { return static_cast<uint32_t>(m_LevelViews.size()); }
+
+private:
+    static const uint32_t REDUCE_GROUP_SIZE = 8;
+    
+    // matches ReduceConstants in hiz.comp
+    struct ReduceConstants
+    {
+        int32_t m_SourceSize[2];
+        int32_t m_DestinationSize[2];
+    };
+    
+    // matches the bindings in hiz.comp, written through an update template
+    struct ReduceDescriptors
+    {
+        VkDescriptorImageInfo   m_Source;
+        VkDescriptorImageInfo   m_Destination;
+    };
+    
+    bool CreatePipeline(const char* aReduceShader);
+    bool CreateSampler();
+    
+    VkFormat                    m_DepthFormat;
+    VkExtent2D                  m_DepthExtent;
+    VkExtent2D                  m_SourceExtent;
+    VkImage                     m_DepthImage;
+    VkImageView                 m_DepthView;
+    
+    uint32_t                    m_Width;
+    uint32_t                    m_Height;
+    VkImage                     m_Image;
+    VkDeviceMemory              m_Memory;
+    VkImageView                 m_View;
+    std::vector<VkImageView>    m_LevelViews;
+    
+    // nearest, the cull and the reduce both want texels, never a blend of them
+    VkSampler                   m_Sampler;
+    
+    VkDescriptorSetLayout       m_SetLayout;
+    VkPipelineLayout            m_PipelineLayout;
+    VkPipeline                  m_Pipeline;
+    VulkanDescriptorAllocator::TemplateID   m_UpdateTemplate;
+};
+
+#endif /* VulkanDepthPyramid_hpp */
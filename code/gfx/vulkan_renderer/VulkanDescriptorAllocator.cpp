@@ -0,0 +1,431 @@
+//
+//  VulkanDescriptorAllocator.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanDescriptorAllocator.hpp"
+#include "VulkanLayoutCache.hpp"
+#include "VulkanRenderer.hpp"
+
+namespace
+{
+    struct PoolRatio
+    {
+        VkDescriptorType    m_Type;
+        float               m_PerSet;
+    };
+    
+    // rough mix of what a set holds, a pool that runs out of one type just chains the next
+    const PoolRatio ourPoolRatios[] =
+    {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,            1.0f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,    1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,            2.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,    2.0f },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,             1.0f },
+        { VK_DESCRIPTOR_TYPE_SAMPLER,                   0.5f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,             0.5f },
+    };
+    
+    const uint32_t ourPoolTypeCount = sizeof(ourPoolRatios) / sizeof(ourPoolRatios[0]);
+    
+    // index into ourPoolRatios, ourPoolTypeCount for a type no pool holds
+    uint32_t GetPoolTypeIndex(VkDescriptorType aType)
+    {
+        uint32_t index = 0;
+        
+        while (index < ourPoolTypeCount && ourPoolRatios[index].m_Type != aType)
+        {
+            ++index;
+        }
+        
+        return index;
+    }
+    
+    uint32_t GetPoolCapacity(uint32_t aTypeIndex, uint32_t aSetsPerPool)
+    {
+        return static_cast<uint32_t>(ourPoolRatios[aTypeIndex].m_PerSet * aSetsPerPool);
+    }
+}
+
+VulkanDescriptorAllocator::VulkanDescriptorAllocator()
+: m_FrameIndex(0)
+{
+    m_StaticChain.m_Current = 0;
+}
+
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+{
+    Shutdown();
+}
+
+bool VulkanDescriptorAllocator::Init(uint32_t aFrameCount)
+{
+    static_assert(ourPoolTypeCount == POOL_TYPE_COUNT, "PoolUsage counts one entry per pool ratio");
+    
+    PoolChain emptyChain;
+    emptyChain.m_Current = 0;
+    
+    m_FrameChains.resize(aFrameCount, emptyChain);
+    m_FrameIndex = 0;
+    
+    // one pool up front, the first static sets should not pay for a create
+    VkDescriptorPool pool = CreatePool();
+    
+    if(pool == VK_NULL_HANDLE)
+        return false;
+    
+    AddPool(m_StaticChain, pool);
+    
+    return true;
+}
+
+void VulkanDescriptorAllocator::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    const DeviceCapabilities& caps = renderer->GetDeviceCapabilities();
+    
+    for (UpdateTemplate& updateTemplate : m_Templates)
+    {
+        if(updateTemplate.m_Template != VK_NULL_HANDLE)
+            caps.m_DestroyDescriptorUpdateTemplate(device, updateTemplate.m_Template, nullptr);
+    }
+    
+    m_Templates.clear();
+    m_TemplateIDs.clear();
+    
+    // sets go with their pools
+    for (VkDescriptorPool pool : m_StaticChain.m_Pools)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    
+    for (PoolChain& chain : m_FrameChains)
+    {
+        for (VkDescriptorPool pool : chain.m_Pools)
+        {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+    }
+    
+    m_StaticChain.m_Pools.clear();
+    m_StaticChain.m_Usage.clear();
+    m_StaticChain.m_Current = 0;
+    m_FrameChains.clear();
+}
+
+void VulkanDescriptorAllocator::BeginFrame(uint32_t aFrameIndex)
+{
+    m_FrameIndex = aFrameIndex;
+    
+    PoolChain& chain = m_FrameChains[m_FrameIndex];
+    
+    // the chain keeps its pools, a frame that needed several once will likely need them again
+    for (size_t i = 0; i <= chain.m_Current && i < chain.m_Pools.size(); ++i)
+    {
+        vkResetDescriptorPool(VulkanRenderer::GetInstance()->GetLogicalDevice(), chain.m_Pools[i], 0);
+        chain.m_Usage[i] = PoolUsage();
+    }
+    
+    chain.m_Current = 0;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::AllocateStatic(VkDescriptorSetLayout aLayout)
+{
+    return Allocate(m_StaticChain, aLayout);
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::AllocateTransient(VkDescriptorSetLayout aLayout)
+{
+    return Allocate(m_FrameChains[m_FrameIndex], aLayout);
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::Allocate(PoolChain& aChain, VkDescriptorSetLayout aLayout)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    // indexed like ourPoolRatios
+    uint32_t descriptors[POOL_TYPE_COUNT] = {};
+    const VulkanLayoutCache::DescriptorCounts* counts = renderer->GetLayoutCache()->GetDescriptorCounts(aLayout);
+    
+    if(counts)
+    {
+        // a type no pool holds, or more of one than a whole pool holds, would chain pools forever
+        for (const VkDescriptorPoolSize& count : *counts)
+        {
+            const uint32_t typeIndex = GetPoolTypeIndex(count.type);
+            
+            if(typeIndex == ourPoolTypeCount || count.descriptorCount > GetPoolCapacity(typeIndex, SETS_PER_POOL))
+                return VK_NULL_HANDLE;
+            
+            descriptors[typeIndex] += count.descriptorCount;
+        }
+    }
+    
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &aLayout;
+    
+    while (true)
+    {
+        const bool freshPool = aChain.m_Current == aChain.m_Pools.size();
+        
+        if(freshPool)
+        {
+            VkDescriptorPool pool = CreatePool();
+            
+            if(pool == VK_NULL_HANDLE)
+                return VK_NULL_HANDLE;
+            
+            AddPool(aChain, pool);
+        }
+        
+        PoolUsage& usage = aChain.m_Usage[aChain.m_Current];
+        
+        if(counts && !Fits(usage, descriptors))
+        {
+            ++aChain.m_Current;
+            continue;
+        }
+        
+        allocInfo.descriptorPool = aChain.m_Pools[aChain.m_Current];
+        
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        
+        if(result == VK_SUCCESS)
+        {
+            ++usage.m_Sets;
+            
+            for (uint32_t i = 0; i < POOL_TYPE_COUNT; ++i)
+            {
+                usage.m_Descriptors[i] += descriptors[i];
+            }
+            
+            return set;
+        }
+        
+        // an empty pool failing means the set is bigger than a whole pool. otherwise only these errors are the
+        // pool's fault, except for an uncounted layout before maintenance1 where a full pool can fail with any
+        const bool poolFull = result == VK_ERROR_OUT_OF_POOL_MEMORY_KHR || result == VK_ERROR_FRAGMENTED_POOL ||
+                              (!counts && !renderer->GetDeviceCapabilities().m_Maintenance1);
+        
+        if(freshPool || !poolFull)
+            return VK_NULL_HANDLE;
+        
+        ++aChain.m_Current;
+    }
+}
+
+bool VulkanDescriptorAllocator::Fits(const PoolUsage& aUsage, const uint32_t* someDescriptors) const
+{
+    if(aUsage.m_Sets >= SETS_PER_POOL)
+        return false;
+    
+    for (uint32_t i = 0; i < POOL_TYPE_COUNT; ++i)
+    {
+        if(aUsage.m_Descriptors[i] + someDescriptors[i] > GetPoolCapacity(i, SETS_PER_POOL))
+            return false;
+    }
+    
+    return true;
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::CreatePool()
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    
+    for (uint32_t i = 0; i < ourPoolTypeCount; ++i)
+    {
+        VkDescriptorPoolSize poolSize = {};
+        poolSize.type = ourPoolRatios[i].m_Type;
+        poolSize.descriptorCount = GetPoolCapacity(i, SETS_PER_POOL);
+        
+        poolSizes.push_back(poolSize);
+    }
+    
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = SETS_PER_POOL;
+    
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    
+    if(vkCreateDescriptorPool(VulkanRenderer::GetInstance()->GetLogicalDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    
+    return pool;
+}
+
+void VulkanDescriptorAllocator::AddPool(PoolChain& aChain, VkDescriptorPool aPool)
+{
+    aChain.m_Pools.push_back(aPool);
+    aChain.m_Usage.push_back(PoolUsage());
+}
+
+uint32_t VulkanDescriptorAllocator::GetPoolCount() const
+{
+    size_t count = m_StaticChain.m_Pools.size();
+    
+    for (const PoolChain& chain : m_FrameChains)
+    {
+        count += chain.m_Pools.size();
+    }
+    
+    return static_cast<uint32_t>(count);
+}
+
+VulkanDescriptorAllocator::TemplateID VulkanDescriptorAllocator::GetUpdateTemplate(VkDescriptorSetLayout aLayout, const TemplateEntries& someEntries)
+{
+    TemplateKey key;
+    key.first = aLayout;
+    key.second.reserve(someEntries.size() * 6);
+    
+    for (const VkDescriptorUpdateTemplateEntryKHR& entry : someEntries)
+    {
+        key.second.push_back(entry.dstBinding);
+        key.second.push_back(entry.dstArrayElement);
+        key.second.push_back(entry.descriptorCount);
+        key.second.push_back(static_cast<uint32_t>(entry.descriptorType));
+        key.second.push_back(static_cast<uint32_t>(entry.offset));
+        key.second.push_back(static_cast<uint32_t>(entry.stride));
+    }
+    
+    auto it = m_TemplateIDs.find(key);
+    
+    if(it != m_TemplateIDs.end())
+        return it->second;
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    const DeviceCapabilities& caps = renderer->GetDeviceCapabilities();
+    
+    UpdateTemplate updateTemplate;
+    updateTemplate.m_Template = VK_NULL_HANDLE;
+    updateTemplate.m_Entries = someEntries;
+    
+    // no extension means the entries are replayed as plain writes, see WriteFallback
+    if(caps.m_CreateDescriptorUpdateTemplate)
+    {
+        VkDescriptorUpdateTemplateCreateInfoKHR templateInfo = {};
+        templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+        templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(someEntries.size());
+        templateInfo.pDescriptorUpdateEntries = someEntries.data();
+        templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+        templateInfo.descriptorSetLayout = aLayout;
+        
+        if(caps.m_CreateDescriptorUpdateTemplate(renderer->GetLogicalDevice(), &templateInfo, nullptr, &updateTemplate.m_Template) != VK_SUCCESS)
+            return INVALID_TEMPLATE;
+    }
+    
+    const TemplateID templateID = static_cast<TemplateID>(m_Templates.size());
+    
+    m_Templates.push_back(updateTemplate);
+    m_TemplateIDs[key] = templateID;
+    
+    return templateID;
+}
+
+void VulkanDescriptorAllocator::UpdateSet(VkDescriptorSet aSet, TemplateID aTemplate, const void* someData)
+{
+    if(aSet == VK_NULL_HANDLE || aTemplate >= m_Templates.size())
+        return;
+    
+    const UpdateTemplate& updateTemplate = m_Templates[aTemplate];
+    
+    if(updateTemplate.m_Template == VK_NULL_HANDLE)
+    {
+        WriteFallback(aSet, updateTemplate.m_Entries, someData);
+        return;
+    }
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    renderer->GetDeviceCapabilities().m_UpdateDescriptorSetWithTemplate(renderer->GetLogicalDevice(), aSet, updateTemplate.m_Template, someData);
+}
+
+void VulkanDescriptorAllocator::WriteFallback(VkDescriptorSet aSet, const TemplateEntries& someEntries, const void* someData)
+{
+    const uint8_t* data = static_cast<const uint8_t*>(someData);
+    
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkBufferView> texelViews;
+    
+    // the infos are gathered first, the writes point into them once they stop growing
+    for (const VkDescriptorUpdateTemplateEntryKHR& entry : someEntries)
+    {
+        for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+        {
+            const uint8_t* element = data + entry.offset + entry.stride * i;
+            
+            switch (entry.descriptorType)
+            {
+                case VK_DESCRIPTOR_TYPE_SAMPLER:
+                case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                    imageInfos.push_back(*reinterpret_cast<const VkDescriptorImageInfo*>(element));
+                    break;
+                case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                    texelViews.push_back(*reinterpret_cast<const VkBufferView*>(element));
+                    break;
+                default:
+                    bufferInfos.push_back(*reinterpret_cast<const VkDescriptorBufferInfo*>(element));
+                    break;
+            }
+        }
+    }
+    
+    size_t imageIndex = 0;
+    size_t bufferIndex = 0;
+    size_t texelIndex = 0;
+    
+    for (const VkDescriptorUpdateTemplateEntryKHR& entry : someEntries)
+    {
+        VkWriteDescriptorSet descriptorWrite = {};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = aSet;
+        descriptorWrite.dstBinding = entry.dstBinding;
+        descriptorWrite.dstArrayElement = entry.dstArrayElement;
+        descriptorWrite.descriptorType = entry.descriptorType;
+        descriptorWrite.descriptorCount = entry.descriptorCount;
+        
+        switch (entry.descriptorType)
+        {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                descriptorWrite.pImageInfo = &imageInfos[imageIndex];
+                imageIndex += entry.descriptorCount;
+                break;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                descriptorWrite.pTexelBufferView = &texelViews[texelIndex];
+                texelIndex += entry.descriptorCount;
+                break;
+            default:
+                descriptorWrite.pBufferInfo = &bufferInfos[bufferIndex];
+                bufferIndex += entry.descriptorCount;
+                break;
+        }
+        
+        descriptorWrites.push_back(descriptorWrite);
+    }
+    
+    vkUpdateDescriptorSets(VulkanRenderer::GetInstance()->GetLogicalDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
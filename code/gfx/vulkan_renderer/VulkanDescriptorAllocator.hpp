@@ -0,0 +1,99 @@
+//
+//  VulkanDescriptorAllocator.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanDescriptorAllocator_hpp
+#define VulkanDescriptorAllocator_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <map>
+
+// Hands out descriptor sets from chains of pools that grow instead of running dry.
+// Every pool counts the sets and descriptors taken from it, and an allocation that
+// would not fit moves on to the next pool in the chain, creating one if needed. Before
+// VK_KHR_maintenance1 a full pool may fail with any error or not fail at all, so it is
+// never allowed to fill. Sets of layouts the layout cache did not make are not counted,
+// for those the chain moves on when the allocation fails, on any error before maintenance1.
+//
+// Static sets live until Shutdown. Transient sets come from the current frame's chain
+// and are all freed by BeginFrame with one vkResetDescriptorPool per pool, so a frame
+// can allocate freely without ever freeing a set on its own.
+//
+// Writes go through VkDescriptorUpdateTemplates: the caller describes where each
+// descriptor sits in its own struct once and then updates a set from a pointer to it.
+// Without VK_KHR_descriptor_update_template the same entries are turned into
+// VkWriteDescriptorSets, so callers do not need to care which one runs.
+class VulkanDescriptorAllocator
+{
+public:
+    typedef std::vector<VkDescriptorUpdateTemplateEntryKHR> TemplateEntries;
+    
+    // opaque handle, valid until Shutdown
+    typedef uint32_t TemplateID;
+    static const TemplateID INVALID_TEMPLATE = 0xffffffff;
+    
+    VulkanDescriptorAllocator();
+    ~VulkanDescriptorAllocator();
+    
+    bool Init(uint32_t aFrameCount);
+    void Shutdown();
+    
+    // caller must have waited on the frame's timeline value, every transient set of the frame is gone after this
+    void BeginFrame(uint32_t aFrameIndex);
+    
+    VkDescriptorSet AllocateStatic(VkDescriptorSetLayout aLayout);
+    VkDescriptorSet AllocateTransient(VkDescriptorSetLayout aLayout);
+    
+    // the same layout and entries give back the same template
+    TemplateID GetUpdateTemplate(VkDescriptorSetLayout aLayout, const TemplateEntries& someEntries);
+    void UpdateSet(VkDescriptorSet aSet, TemplateID aTemplate, const void* someData);
+    
+    uint32_t GetPoolCount() const;
+
+private:
+    // descriptors of each type per pool, as a multiple of SETS_PER_POOL
+    static const uint32_t SETS_PER_POOL = 256;
+    static const uint32_t POOL_TYPE_COUNT = 7;     // one per pool ratio
+    
+    // what has been taken from a pool since it was made or last reset
+    struct PoolUsage
+    {
+        uint32_t    m_Sets;
+        uint32_t    m_Descriptors[POOL_TYPE_COUNT];
+    };
+    
+    struct PoolChain
+    {
+        std::vector<VkDescriptorPool>   m_Pools;
+        std::vector<PoolUsage>          m_Usage;
+        size_t                          m_Current;
+    };
+    
+    struct UpdateTemplate
+    {
+        VkDescriptorUpdateTemplateKHR   m_Template;
+        TemplateEntries                 m_Entries;
+    };
+    
+    typedef std::pair<VkDescriptorSetLayout, std::vector<uint32_t>> TemplateKey;
+    
+    VkDescriptorSet Allocate(PoolChain& aChain, VkDescriptorSetLayout aLayout);
+    VkDescriptorPool CreatePool();
+    void AddPool(PoolChain& aChain, VkDescriptorPool aPool);
+    bool Fits(const PoolUsage& aUsage, const uint32_t* someDescriptors) const;
+    void WriteFallback(VkDescriptorSet aSet, const TemplateEntries& someEntries, const void* someData);
+    
+    PoolChain                   m_StaticChain;
+    std::vector<PoolChain>      m_FrameChains;
+    uint32_t                    m_FrameIndex;
+    
+    std::vector<UpdateTemplate>         m_Templates;
+    std::map<TemplateKey, TemplateID>   m_TemplateIDs;
+};
+
+#endif /* VulkanDescriptorAllocator_hpp */
@@ -0,0 +1,562 @@
+//
+//  VulkanGpuCuller.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanGpuCuller.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanShader.hpp"
+#include "VulkanShaderLibrary.hpp"
+#include "VulkanLayoutCache.hpp"
+#include "VulkanDescriptorAllocator.hpp"
+#include "VulkanUtils.hpp"
+
+#include "Scene_Frustum.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+    enum CullBinding
+    {
+        CULL_BINDING_OBJECTS,
+        CULL_BINDING_TRANSFORMS,
+        CULL_BINDING_COMMANDS,
+        CULL_BINDING_COUNT,
+        
+        CULL_BINDING_NUM
+    };
+    
+    enum OcclusionBinding
+    {
+        OCCLUSION_BINDING_OBJECTS,
+        OCCLUSION_BINDING_TRANSFORMS,
+        OCCLUSION_BINDING_COMMANDS,
+        OCCLUSION_BINDING_COUNT,
+        OCCLUSION_BINDING_VISIBILITY,
+        OCCLUSION_BINDING_STATS,
+        OCCLUSION_BINDING_PYRAMID,
+        
+        OCCLUSION_BINDING_NUM
+    };
+    
+    // the stats array in cull_occlusion.comp
+    enum OcclusionStat
+    {
+        STAT_FRUSTUM_CULLED,
+        STAT_OCCLUSION_CULLED,
+        STAT_DRAWN_EARLY,
+        STAT_DRAWN_LATE,
+        
+        STAT_NUM
+    };
+    
+    // matches the bindings in cull_occlusion.comp, written through an update template
+    struct OcclusionDescriptors
+    {
+        VkDescriptorBufferInfo  m_Buffers[OCCLUSION_BINDING_PYRAMID];
+        VkDescriptorImageInfo   m_Pyramid;
+    };
+    
+    // the fills before a cull have to land before the shader counts into the same buffers
+    void RecordClearBarrier(VkCommandBuffer aCmdBuffer)
+    {
+        VkMemoryBarrier clearBarrier = {};
+        clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        
+        vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+    }
+}
+
+bool VulkanGpuCuller::CullStats::operator==(const CullStats& other) const
+{
+    return m_Objects == other.m_Objects
+        && m_FrustumCulled == other.m_FrustumCulled
+        && m_OcclusionCulled == other.m_OcclusionCulled
+        && m_DrawnEarly == other.m_DrawnEarly
+        && m_DrawnLate == other.m_DrawnLate;
+}
+
+VulkanGpuCuller::VulkanGpuCuller()
+: m_FrameIndex(0)
+, m_MaxObjects(0)
+, m_ObjectCount(0)
+, m_SetLayout(VK_NULL_HANDLE)
+, m_PipelineLayout(VK_NULL_HANDLE)
+, m_Pipeline(VK_NULL_HANDLE)
+, m_OcclusionSetLayout(VK_NULL_HANDLE)
+, m_OcclusionPipelineLayout(VK_NULL_HANDLE)
+, m_OcclusionPipeline(VK_NULL_HANDLE)
+, m_OcclusionTemplate(VulkanDescriptorAllocator::INVALID_TEMPLATE)
+, m_Visibility({ VK_NULL_HANDLE, VK_NULL_HANDLE })
+, m_VisibilityCleared(false)
+, m_PyramidSampler(VK_NULL_HANDLE)
+, m_PyramidView(VK_NULL_HANDLE)
+, m_PyramidSize(0.0f)
+, m_PyramidLevels(0)
+, m_Stats()
+{
+}
+
+VulkanGpuCuller::~VulkanGpuCuller()
+{
+    Shutdown();
+}
+
+bool VulkanGpuCuller::Init(uint32_t aFrameCount, uint32_t aMaxObjects, const char* aCullShader, const char* anOcclusionShader)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    // the instance index doubles as the object index, without firstInstance every draw would read transform 0
+    if(!renderer->GetDeviceCapabilities().m_DrawIndirectFirstInstance)
+    {
+        std::cout << "GPU culling disabled: drawIndirectFirstInstance not supported" << std::endl;
+        return true;
+    }
+    
+    if(!CreatePipeline(aCullShader, m_PipelineLayout, m_SetLayout, m_Pipeline))
+    {
+        std::cout << "GPU culling disabled: could not load " << aCullShader << std::endl;
+        return true;
+    }
+    
+    // the frustum cull still runs on its own without it
+    if(!CreatePipeline(anOcclusionShader, m_OcclusionPipelineLayout, m_OcclusionSetLayout, m_OcclusionPipeline))
+        std::cout << "Occlusion culling disabled: could not load " << anOcclusionShader << std::endl;
+    
+    m_MaxObjects = aMaxObjects;
+    
+    if(IsOcclusionSupported())
+    {
+        // the buffers sit back to back in front of the pyramid
+        VulkanDescriptorAllocator::TemplateEntries entries(OCCLUSION_BINDING_NUM);
+        
+        for (uint32_t i = 0; i < OCCLUSION_BINDING_NUM; ++i)
+        {
+            entries[i].dstBinding = i;
+            entries[i].descriptorCount = 1;
+            entries[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            entries[i].offset = offsetof(OcclusionDescriptors, m_Buffers) + sizeof(VkDescriptorBufferInfo) * i;
+            entries[i].stride = sizeof(VkDescriptorBufferInfo);
+        }
+        
+        entries[OCCLUSION_BINDING_PYRAMID].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        entries[OCCLUSION_BINDING_PYRAMID].offset = offsetof(OcclusionDescriptors, m_Pyramid);
+        entries[OCCLUSION_BINDING_PYRAMID].stride = sizeof(VkDescriptorImageInfo);
+        
+        m_OcclusionTemplate = renderer->GetDescriptorAllocator()->GetUpdateTemplate(m_OcclusionSetLayout, entries);
+        
+        if(m_OcclusionTemplate == VulkanDescriptorAllocator::INVALID_TEMPLATE)
+            return false;
+        
+        // one flag per object, cleared by the first early phase
+        if(!VulkanUtils::CreateBuffer(sizeof(uint32_t) * m_MaxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Visibility.m_Buffer, m_Visibility.m_Memory))
+            return false;
+    }
+    
+    FrameData emptyFrame = {};
+    m_Frames.resize(aFrameCount, emptyFrame);
+    
+    for (FrameData& frame : m_Frames)
+    {
+        if(!CreateFrame(frame))
+            return false;
+        
+        if(IsOcclusionSupported() && !CreateOcclusionFrame(frame))
+            return false;
+    }
+    
+    return true;
+}
+
+void VulkanGpuCuller::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    for (FrameData& frame : m_Frames)
+    {
+        DestroyBuffer(frame.m_Objects);
+        DestroyBuffer(frame.m_Transforms);
+        DestroyBuffer(frame.m_Commands);
+        DestroyBuffer(frame.m_Count);
+        DestroyBuffer(frame.m_LateCommands);
+        DestroyBuffer(frame.m_LateCount);
+        DestroyBuffer(frame.m_Stats);
+    }
+    
+    m_Frames.clear();
+    
+    DestroyBuffer(m_Visibility);
+    
+    // the sets belong to the descriptor allocator, the layouts to the layout cache
+    if(m_Pipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, m_Pipeline, nullptr);
+    
+    if(m_OcclusionPipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(device, m_OcclusionPipeline, nullptr);
+    
+    m_Pipeline = VK_NULL_HANDLE;
+    m_OcclusionPipeline = VK_NULL_HANDLE;
+}
+
+bool VulkanGpuCuller::CreatePipeline(const char* aCullShader, VkPipelineLayout& outLayout, VkDescriptorSetLayout& outSetLayout, VkPipeline& outPipeline)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    const VulkanShader* cullShader = renderer->GetShaderLibrary()->GetShader(aCullShader);
+    
+    if(!cullShader)
+        return false;
+    
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    
+    if(!renderer->GetLayoutCache()->GetLayouts({cullShader}, outLayout, setLayouts) || setLayouts.size() != 1)
+        return false;
+    
+    outSetLayout = setLayouts[0];
+    
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = cullShader->GetStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout = outLayout;
+    
+    const VkPipelineCache pipelineCache = renderer->GetPipelineBuilder()->GetPipelineCache();
+    
+    if(vkCreateComputePipelines(renderer->GetLogicalDevice(), pipelineCache, 1, &pipelineInfo, nullptr, &outPipeline) != VK_SUCCESS)
+    {
+        outPipeline = VK_NULL_HANDLE;
+        return false;
+    }
+    
+    return true;
+}
+
+bool VulkanGpuCuller::CreateFrame(FrameData& aFrame)
+{
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    const VkMemoryPropertyFlags hostProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags deviceProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    const VkBufferUsageFlags indirectUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    
+    const VkDeviceSize objectsSize = sizeof(GpuObjectData) * m_MaxObjects;
+    const VkDeviceSize transformsSize = sizeof(InstanceData) * m_MaxObjects;
+    const VkDeviceSize commandsSize = sizeof(VkDrawIndexedIndirectCommand) * m_MaxObjects;
+    const VkDeviceSize countSize = sizeof(uint32_t);
+    
+    // the cpu writes objects and transforms every frame, the cull output never leaves the gpu
+    bool created = VulkanUtils::CreateBuffer(objectsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostProperties, aFrame.m_Objects.m_Buffer, aFrame.m_Objects.m_Memory);
+    created = created && VulkanUtils::CreateBuffer(transformsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostProperties, aFrame.m_Transforms.m_Buffer, aFrame.m_Transforms.m_Memory);
+    created = created && VulkanUtils::CreateBuffer(commandsSize, indirectUsage, deviceProperties, aFrame.m_Commands.m_Buffer, aFrame.m_Commands.m_Memory);
+    created = created && VulkanUtils::CreateBuffer(countSize, indirectUsage, deviceProperties, aFrame.m_Count.m_Buffer, aFrame.m_Count.m_Memory);
+    
+    if(!created)
+        return false;
+    
+    void* objects = nullptr;
+    void* transforms = nullptr;
+    
+    if(vkMapMemory(device, aFrame.m_Objects.m_Memory, 0, objectsSize, 0, &objects) != VK_SUCCESS)
+        return false;
+    
+    if(vkMapMemory(device, aFrame.m_Transforms.m_Memory, 0, transformsSize, 0, &transforms) != VK_SUCCESS)
+        return false;
+    
+    aFrame.m_MappedObjects = static_cast<GpuObjectData*>(objects);
+    aFrame.m_MappedTransforms = static_cast<InstanceData*>(transforms);
+    
+    VulkanDescriptorAllocator* descriptorAllocator = VulkanRenderer::GetInstance()->GetDescriptorAllocator();
+    
+    aFrame.m_DescriptorSet = descriptorAllocator->AllocateStatic(m_SetLayout);
+    
+    if(aFrame.m_DescriptorSet == VK_NULL_HANDLE)
+        return false;
+    
+    // every binding is one storage buffer, the infos sit back to back
+    VulkanDescriptorAllocator::TemplateEntries entries(CULL_BINDING_NUM);
+    
+    for (uint32_t i = 0; i < CULL_BINDING_NUM; ++i)
+    {
+        entries[i].dstBinding = i;
+        entries[i].descriptorCount = 1;
+        entries[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        entries[i].offset = sizeof(VkDescriptorBufferInfo) * i;
+        entries[i].stride = sizeof(VkDescriptorBufferInfo);
+    }
+    
+    VulkanDescriptorAllocator::TemplateID updateTemplate = descriptorAllocator->GetUpdateTemplate(m_SetLayout, entries);
+    
+    if(updateTemplate == VulkanDescriptorAllocator::INVALID_TEMPLATE)
+        return false;
+    
+    std::array<VkDescriptorBufferInfo, CULL_BINDING_NUM> bufferInfos = {};
+    bufferInfos[CULL_BINDING_OBJECTS] = { aFrame.m_Objects.m_Buffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[CULL_BINDING_TRANSFORMS] = { aFrame.m_Transforms.m_Buffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[CULL_BINDING_COMMANDS] = { aFrame.m_Commands.m_Buffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[CULL_BINDING_COUNT] = { aFrame.m_Count.m_Buffer, 0, VK_WHOLE_SIZE };
+    
+    descriptorAllocator->UpdateSet(aFrame.m_DescriptorSet, updateTemplate, bufferInfos.data());
+    
+    return true;
+}
+
+bool VulkanGpuCuller::CreateOcclusionFrame(FrameData& aFrame)
+{
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    const VkMemoryPropertyFlags hostProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags deviceProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    const VkBufferUsageFlags indirectUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    
+    const VkDeviceSize commandsSize = sizeof(VkDrawIndexedIndirectCommand) * m_MaxObjects;
+    const VkDeviceSize countSize = sizeof(uint32_t);
+    const VkDeviceSize statsSize = sizeof(uint32_t) * STAT_NUM;
+    
+    // the stats are read back on the cpu once the timeline has passed the frame
+    bool created = VulkanUtils::CreateBuffer(commandsSize, indirectUsage, deviceProperties, aFrame.m_LateCommands.m_Buffer, aFrame.m_LateCommands.m_Memory);
+    created = created && VulkanUtils::CreateBuffer(countSize, indirectUsage, deviceProperties, aFrame.m_LateCount.m_Buffer, aFrame.m_LateCount.m_Memory);
+    created = created && VulkanUtils::CreateBuffer(statsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, hostProperties, aFrame.m_Stats.m_Buffer, aFrame.m_Stats.m_Memory);
+    
+    if(!created)
+        return false;
+    
+    void* stats = nullptr;
+    
+    if(vkMapMemory(device, aFrame.m_Stats.m_Memory, 0, statsSize, 0, &stats) != VK_SUCCESS)
+        return false;
+    
+    // read before the first cull has written them
+    memset(stats, 0, static_cast<size_t>(statsSize));
+    aFrame.m_MappedStats = static_cast<uint32_t*>(stats);
+    
+    VulkanDescriptorAllocator* descriptorAllocator = VulkanRenderer::GetInstance()->GetDescriptorAllocator();
+    
+    // written once there is a pyramid to point them at
+    for (VkDescriptorSet& descriptorSet : aFrame.m_OcclusionSets)
+    {
+        descriptorSet = descriptorAllocator->AllocateStatic(m_OcclusionSetLayout);
+        
+        if(descriptorSet == VK_NULL_HANDLE)
+            return false;
+    }
+    
+    return true;
+}
+
+void VulkanGpuCuller::UpdateOcclusionSets(FrameData& aFrame)
+{
+    VulkanDescriptorAllocator* descriptorAllocator = VulkanRenderer::GetInstance()->GetDescriptorAllocator();
+    
+    for (uint32_t phase = 0; phase < CULL_PHASE_NUM; ++phase)
+    {
+        const bool late = phase == CULL_PHASE_LATE;
+        
+        OcclusionDescriptors descriptors = {};
+        descriptors.m_Buffers[OCCLUSION_BINDING_OBJECTS] = { aFrame.m_Objects.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Buffers[OCCLUSION_BINDING_TRANSFORMS] = { aFrame.m_Transforms.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Buffers[OCCLUSION_BINDING_COMMANDS] = { late ? aFrame.m_LateCommands.m_Buffer : aFrame.m_Commands.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Buffers[OCCLUSION_BINDING_COUNT] = { late ? aFrame.m_LateCount.m_Buffer : aFrame.m_Count.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Buffers[OCCLUSION_BINDING_VISIBILITY] = { m_Visibility.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Buffers[OCCLUSION_BINDING_STATS] = { aFrame.m_Stats.m_Buffer, 0, VK_WHOLE_SIZE };
+        descriptors.m_Pyramid = { m_PyramidSampler, m_PyramidView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        
+        descriptorAllocator->UpdateSet(aFrame.m_OcclusionSets[phase], m_OcclusionTemplate, &descriptors);
+    }
+    
+    aFrame.m_PyramidView = m_PyramidView;
+}
+
+void VulkanGpuCuller::DestroyBuffer(BufferInfo& aBuffer)
+{
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    if(aBuffer.m_Buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, aBuffer.m_Buffer, nullptr);
+    
+    // freeing mapped memory implicitly unmaps it
+    if(aBuffer.m_Memory != VK_NULL_HANDLE)
+        vkFreeMemory(device, aBuffer.m_Memory, nullptr);
+    
+    aBuffer.m_Buffer = VK_NULL_HANDLE;
+    aBuffer.m_Memory = VK_NULL_HANDLE;
+}
+
+void VulkanGpuCuller::Begin(uint32_t aFrameIndex)
+{
+    m_FrameIndex = aFrameIndex;
+    m_ObjectCount = 0;
+    
+    const FrameData& frame = m_Frames[m_FrameIndex];
+    
+    // the timeline has passed the frame, whatever the last cull with this index counted is final
+    if(frame.m_MappedStats)
+    {
+        m_Stats.m_Objects = frame.m_StatsObjects;
+        m_Stats.m_FrustumCulled = frame.m_MappedStats[STAT_FRUSTUM_CULLED];
+        m_Stats.m_OcclusionCulled = frame.m_MappedStats[STAT_OCCLUSION_CULLED];
+        m_Stats.m_DrawnEarly = frame.m_MappedStats[STAT_DRAWN_EARLY];
+        m_Stats.m_DrawnLate = frame.m_MappedStats[STAT_DRAWN_LATE];
+    }
+}
+
+bool VulkanGpuCuller::AddObject(const glm::mat4& aTransform, const glm::vec4& aBoundingSphere, uint32_t anIndexCount,
+                                uint32_t aFirstIndex, int32_t aVertexOffset)
+{
+    if(m_ObjectCount >= m_MaxObjects)
+        return false;
+    
+    FrameData& frame = m_Frames[m_FrameIndex];
+    
+    GpuObjectData& object = frame.m_MappedObjects[m_ObjectCount];
+    object.m_BoundingSphere = aBoundingSphere;
+    object.m_IndexCount = anIndexCount;
+    object.m_FirstIndex = aFirstIndex;
+    object.m_VertexOffset = aVertexOffset;
+    object.m_Pad = 0;
+    
+    frame.m_MappedTransforms[m_ObjectCount].m_Model = aTransform;
+    
+    ++m_ObjectCount;
+    
+    return true;
+}
+
+void VulkanGpuCuller::RecordCull(VkCommandBuffer aCmdBuffer, const glm::mat4& aViewProj)
+{
+    if(m_ObjectCount == 0)
+        return;
+    
+    FrameData& frame = m_Frames[m_FrameIndex];
+    
+    vkCmdFillBuffer(aCmdBuffer, frame.m_Count.m_Buffer, 0, sizeof(uint32_t), 0);
+    
+    // without a count buffer the draw reads every slot, culled ones must be zero sized draws
+    if(!VulkanRenderer::GetInstance()->GetDeviceCapabilities().m_CmdDrawIndexedIndirectCount)
+        vkCmdFillBuffer(aCmdBuffer, frame.m_Commands.m_Buffer, 0, sizeof(VkDrawIndexedIndirectCommand) * m_ObjectCount, 0);
+    
+    RecordClearBarrier(aCmdBuffer);
+    
+    const Scene_Frustum frustum(aViewProj);
+    
+    CullConstants constants = {};
+    std::copy(frustum.m_Planes, frustum.m_Planes + Scene_Frustum::PLANE_COUNT, constants.m_Planes);
+    constants.m_ObjectCount = m_ObjectCount;
+    
+    vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &frame.m_DescriptorSet, 0, nullptr);
+    vkCmdPushConstants(aCmdBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+    vkCmdDispatch(aCmdBuffer, (m_ObjectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+void VulkanGpuCuller::SetDepthPyramid(VkImageView aView, VkSampler aSampler, uint32_t aWidth, uint32_t aHeight, uint32_t aLevelCount)
+{
+    m_PyramidView = aView;
+    m_PyramidSampler = aSampler;
+    m_PyramidSize = glm::vec2(static_cast<float>(aWidth), static_cast<float>(aHeight));
+    m_PyramidLevels = aLevelCount;
+    
+    FrameData& frame = m_Frames[m_FrameIndex];
+    
+    // only this frame's sets are known to be idle, the others catch up when their index comes round
+    if(IsOcclusionSupported() && frame.m_PyramidView != aView)
+        UpdateOcclusionSets(frame);
+}
+
+void VulkanGpuCuller::RecordOcclusionCull(VkCommandBuffer aCmdBuffer, const glm::mat4& aViewProj, CullPhase aPhase)
+{
+    if(m_ObjectCount == 0 || !IsOcclusionSupported())
+        return;
+    
+    FrameData& frame = m_Frames[m_FrameIndex];
+    
+    if(frame.m_PyramidView == VK_NULL_HANDLE)
+        return;
+    
+    const bool late = aPhase == CULL_PHASE_LATE;
+    const BufferInfo& commands = late ? frame.m_LateCommands : frame.m_Commands;
+    const BufferInfo& count = late ? frame.m_LateCount : frame.m_Count;
+    
+    vkCmdFillBuffer(aCmdBuffer, count.m_Buffer, 0, sizeof(uint32_t), 0);
+    
+    // without a count buffer the draw reads every slot, culled ones must be zero sized draws
+    if(!VulkanRenderer::GetInstance()->GetDeviceCapabilities().m_CmdDrawIndexedIndirectCount)
+        vkCmdFillBuffer(aCmdBuffer, commands.m_Buffer, 0, sizeof(VkDrawIndexedIndirectCommand) * m_ObjectCount, 0);
+    
+    if(!late)
+    {
+        vkCmdFillBuffer(aCmdBuffer, frame.m_Stats.m_Buffer, 0, sizeof(uint32_t) * STAT_NUM, 0);
+        frame.m_StatsObjects = m_ObjectCount;
+        
+        // nothing was visible before the first frame, the late phase draws it all
+        if(!m_VisibilityCleared)
+        {
+            vkCmdFillBuffer(aCmdBuffer, m_Visibility.m_Buffer, 0, VK_WHOLE_SIZE, 0);
+            m_VisibilityCleared = true;
+        }
+    }
+    
+    RecordClearBarrier(aCmdBuffer);
+    
+    OcclusionConstants constants = {};
+    constants.m_ViewProj = aViewProj;
+    constants.m_PyramidSize = m_PyramidSize;
+    constants.m_PyramidLevels = m_PyramidLevels;
+    constants.m_ObjectCount = m_ObjectCount;
+    constants.m_Phase = aPhase;
+    
+    vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_OcclusionPipeline);
+    vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_OcclusionPipelineLayout, 0, 1, &frame.m_OcclusionSets[aPhase], 0, nullptr);
+    vkCmdPushConstants(aCmdBuffer, m_OcclusionPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(OcclusionConstants), &constants);
+    vkCmdDispatch(aCmdBuffer, (m_ObjectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    
+    if(!late)
+        return;
+    
+    // the timeline wait only makes available writes visible to the host, this makes the stats available
+    VkMemoryBarrier statsBarrier = {};
+    statsBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    statsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    statsBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    
+    vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &statsBarrier, 0, nullptr, 0, nullptr);
+}
+
+VkBuffer VulkanGpuCuller::GetCommandsBuffer(CullPhase aPhase) const
+{
+    const FrameData& frame = m_Frames[m_FrameIndex];
+    return aPhase == CULL_PHASE_LATE ? frame.m_LateCommands.m_Buffer : frame.m_Commands.m_Buffer;
+}
+
+VkBuffer VulkanGpuCuller::GetCountBuffer(CullPhase aPhase) const
+{
+    const FrameData& frame = m_Frames[m_FrameIndex];
+    return aPhase == CULL_PHASE_LATE ? frame.m_LateCount.m_Buffer : frame.m_Count.m_Buffer;
+}
+
+VulkanDrawItem VulkanGpuCuller::GetDrawItem(const VulkanDrawItem& aTemplate, CullPhase aPhase) const
+{
+    const FrameData& frame = m_Frames[m_FrameIndex];
+    
+    VulkanDrawItem draw = aTemplate;
+    draw.m_InstanceBuffer = frame.m_Transforms.m_Buffer;
+    draw.m_FirstInstance = 0;
+    draw.m_InstanceCount = 1;
+    draw.m_IndirectBuffer = GetCommandsBuffer(aPhase);
+    draw.m_CountBuffer = GetCountBuffer(aPhase);
+    draw.m_MaxDrawCount = m_ObjectCount;
+    
+    return draw;
+}
@@ -0,0 +1,167 @@
+//
+//  VulkanGpuCuller.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanGpuCuller_hpp
+#define VulkanGpuCuller_hpp
+
+#include "VulkanCommon.hpp"
+#include "VulkanCommandRecorder.hpp"
+#include "VulkanDescriptorAllocator.hpp"
+
+// GPU driven path for one model. Object bounds and transforms are written to storage
+// buffers, a compute pass frustum culls them and compacts the survivors into
+// VkDrawIndexedIndirectCommands, and the frame draws the lot with a single indirect
+// draw, so the cpu cost no longer depends on how many objects there are.
+//
+// With the occlusion shader and a depth pyramid the cull runs in two phases. The early
+// phase draws what was visible last frame, the pyramid is built from that depth and the
+// late phase tests everything in the frustum against it, drawing only what just came
+// into view and remembering the result for the next frame's early phase.
+//
+// Needs drawIndirectFirstInstance (the instance index is the object index) and the
+// cull shader, IsSupported is false without them and the caller keeps the cpu path.
+class VulkanGpuCuller
+{
+public:
+    enum CullPhase
+    {
+        CULL_PHASE_EARLY,
+        CULL_PHASE_LATE,
+        
+        CULL_PHASE_NUM
+    };
+    
+    // occlusion culling only, read back once the timeline has passed the frame
+    struct CullStats
+    {
+        bool operator==(const CullStats& other) const;
+        
+        uint32_t    m_Objects;
+        uint32_t    m_FrustumCulled;
+        uint32_t    m_OcclusionCulled;
+        uint32_t    m_DrawnEarly;
+        uint32_t    m_DrawnLate;        // not visible last frame, drawn after the pyramid
+    };
+    
+    VulkanGpuCuller();
+    ~VulkanGpuCuller();
+    
+    bool Init(uint32_t aFrameCount, uint32_t aMaxObjects, const char* aCullShader, const char* anOcclusionShader);
+    void Shutdown();
+    
+    bool IsSupported() const { return m_Pipeline != VK_NULL_HANDLE; }
+    bool IsOcclusionSupported() const { return m_OcclusionPipeline != VK_NULL_HANDLE; }
+    
+    // also picks up the stats the frame index last recorded
+    void Begin(uint32_t aFrameIndex);
+    
+    // false once the frame is full
+    bool AddObject(const glm::mat4& aTransform, const glm::vec4& aBoundingSphere, uint32_t anIndexCount,
+                   uint32_t aFirstIndex = 0, int32_t aVertexOffset = 0);
+    
+    // a render graph pass that writes GetCommandsBuffer and GetCountBuffer, the graph syncs the draws that read them
+    void RecordCull(VkCommandBuffer aCmdBuffer, const glm::mat4& aViewProj);
+    
+    // the pyramid every later occlusion pass samples, levels are the farthest depth of the one below
+    void SetDepthPyramid(VkImageView aView, VkSampler aSampler, uint32_t aWidth, uint32_t aHeight, uint32_t aLevelCount);
+    
+    // render graph passes, both read the visibility buffer and write the phase's commands and count and
+    // the stats, the late one also writes the visibility buffer and samples the pyramid as SAMPLED_COMPUTE
+    void RecordOcclusionCull(VkCommandBuffer aCmdBuffer, const glm::mat4& aViewProj, CullPhase aPhase);
+    
+    VkBuffer GetCommandsBuffer(CullPhase aPhase = CULL_PHASE_EARLY) const;
+    VkBuffer GetCountBuffer(CullPhase aPhase = CULL_PHASE_EARLY) const;
+    VkBuffer GetStatsBuffer() const { return m_Frames[m_FrameIndex].m_Stats.m_Buffer; }
+    
+    // shared by every frame, each one's late phase writes what the next one's early phase reads
+    VkBuffer GetVisibilityBuffer() const { return m_Visibility.m_Buffer; }
+    
+    // copies aTemplate and points it at this frame's indirect buffers for the phase
+    VulkanDrawItem GetDrawItem(const VulkanDrawItem& aTemplate, CullPhase aPhase = CULL_PHASE_EARLY) const;
+    
+    uint32_t GetObjectCount() const { return m_ObjectCount; }
+    const CullStats& GetStats() const { return m_Stats; }
+
+private:
+    static const uint32_t CULL_GROUP_SIZE = 64;
+    
+    // matches CullConstants in cull.comp
+    struct CullConstants
+    {
+        glm::vec4   m_Planes[6];
+        uint32_t    m_ObjectCount;
+    };
+    
+    // matches CullConstants in cull_occlusion.comp, no room for the planes so the shader takes them from the matrix
+    struct OcclusionConstants
+    {
+        glm::mat4   m_ViewProj;
+        glm::vec2   m_PyramidSize;
+        uint32_t    m_PyramidLevels;
+        uint32_t    m_ObjectCount;
+        uint32_t    m_Phase;
+    };
+    
+    struct BufferInfo
+    {
+        VkBuffer        m_Buffer;
+        VkDeviceMemory  m_Memory;
+    };
+    
+    struct FrameData
+    {
+        BufferInfo      m_Objects;
+        BufferInfo      m_Transforms;
+        BufferInfo      m_Commands;
+        BufferInfo      m_Count;
+        GpuObjectData*  m_MappedObjects;
+        InstanceData*   m_MappedTransforms;
+        VkDescriptorSet m_DescriptorSet;
+        
+        // occlusion only, the late phase draws from its own buffers
+        BufferInfo      m_LateCommands;
+        BufferInfo      m_LateCount;
+        BufferInfo      m_Stats;
+        uint32_t*       m_MappedStats;
+        uint32_t        m_StatsObjects;
+        VkDescriptorSet m_OcclusionSets[CULL_PHASE_NUM];
+        VkImageView     m_PyramidView;
+    };
+    
+    bool CreatePipeline(const char* aCullShader, VkPipelineLayout& outLayout, VkDescriptorSetLayout& outSetLayout, VkPipeline& outPipeline);
+    bool CreateFrame(FrameData& aFrame);
+    bool CreateOcclusionFrame(FrameData& aFrame);
+    void UpdateOcclusionSets(FrameData& aFrame);
+    void DestroyBuffer(BufferInfo& aBuffer);
+    
+    std::vector<FrameData>  m_Frames;
+    uint32_t                m_FrameIndex;
+    uint32_t                m_MaxObjects;
+    uint32_t                m_ObjectCount;
+    
+    VkDescriptorSetLayout   m_SetLayout;
+    VkPipelineLayout        m_PipelineLayout;
+    VkPipeline              m_Pipeline;
+    
+    VkDescriptorSetLayout   m_OcclusionSetLayout;
+    VkPipelineLayout        m_OcclusionPipelineLayout;
+    VkPipeline              m_OcclusionPipeline;
+    VulkanDescriptorAllocator::TemplateID   m_OcclusionTemplate;
+    
+    BufferInfo              m_Visibility;
+    bool                    m_VisibilityCleared;
+    
+    VkSampler               m_PyramidSampler;
+    VkImageView             m_PyramidView;
+    glm::vec2               m_PyramidSize;
+    uint32_t                m_PyramidLevels;
+    
+    CullStats               m_Stats;
+};
+
+#endif /* VulkanGpuCuller_hpp */
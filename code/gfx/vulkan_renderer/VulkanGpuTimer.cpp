@@ -0,0 +1,103 @@
+//
+//  VulkanGpuTimer.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanGpuTimer.hpp"
+#include "VulkanRenderer.hpp"
+
+VulkanGpuTimer::VulkanGpuTimer()
+: m_QueryPool(VK_NULL_HANDLE)
+, m_NanosecondsPerTick(0.0f)
+, m_TimestampMask(0)
+{
+}
+
+VulkanGpuTimer::~VulkanGpuTimer()
+{
+}
+
+bool VulkanGpuTimer::Init(uint32_t aFrameCount, uint32_t aQueueFamily)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer->GetPhysicalDevice(), &familyCount, nullptr);
+    
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(renderer->GetPhysicalDevice(), &familyCount, families.data());
+    
+    const uint32_t validBits = aQueueFamily < familyCount ? families[aQueueFamily].timestampValidBits : 0;
+    
+    if(validBits == 0)
+    {
+        std::cout << "GPU timing disabled: no timestamps on the graphics queue" << std::endl;
+        return true;
+    }
+    
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = aFrameCount * 2;
+    
+    if(vkCreateQueryPool(renderer->GetLogicalDevice(), &poolInfo, nullptr, &m_QueryPool) != VK_SUCCESS)
+        return false;
+    
+    m_NanosecondsPerTick = renderer->GetDeviceProperties().limits.timestampPeriod;
+    m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    m_Recorded.assign(aFrameCount, false);
+    
+    return true;
+}
+
+void VulkanGpuTimer::Shutdown()
+{
+    if(m_QueryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(VulkanRenderer::GetInstance()->GetLogicalDevice(), m_QueryPool, nullptr);
+    
+    m_QueryPool = VK_NULL_HANDLE;
+    m_Recorded.clear();
+}
+
+void VulkanGpuTimer::Begin(VkCommandBuffer aCmdBuffer, uint32_t aFrameIndex)
+{
+    if(!IsSupported() || aFrameIndex >= m_Recorded.size())
+        return;
+    
+    // Resolve has already taken what the last use of these left
+    vkCmdResetQueryPool(aCmdBuffer, m_QueryPool, aFrameIndex * 2, 2);
+    vkCmdWriteTimestamp(aCmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, aFrameIndex * 2);
+}
+
+void VulkanGpuTimer::End(VkCommandBuffer aCmdBuffer, uint32_t aFrameIndex)
+{
+    if(!IsSupported() || aFrameIndex >= m_Recorded.size())
+        return;
+    
+    vkCmdWriteTimestamp(aCmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, aFrameIndex * 2 + 1);
+    m_Recorded[aFrameIndex] = true;
+}
+
+bool VulkanGpuTimer::Resolve(uint32_t aFrameIndex, float& outMilliseconds)
+{
+    if(!IsSupported() || aFrameIndex >= m_Recorded.size() || !m_Recorded[aFrameIndex])
+        return false;
+    
+    uint64_t timestamps[2] = {};
+    
+    // the timeline has passed the frame so they are written, no need to wait
+    const VkResult result = vkGetQueryPoolResults(VulkanRenderer::GetInstance()->GetLogicalDevice(), m_QueryPool, aFrameIndex * 2, 2,
+                                                  sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    
+    if(result != VK_SUCCESS)
+        return false;
+    
+    // masked so a counter that wrapped between the two still gives the right difference
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & m_TimestampMask;
+    outMilliseconds = static_cast<float>(static_cast<double>(ticks) * m_NanosecondsPerTick * 1e-6);
+    
+    return true;
+}
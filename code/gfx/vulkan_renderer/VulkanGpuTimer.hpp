@@ -0,0 +1,45 @@
+//
+//  VulkanGpuTimer.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanGpuTimer_hpp
+#define VulkanGpuTimer_hpp
+
+#include "VulkanCommon.hpp"
+
+// GPU time of a whole frame from a pair of timestamps written at the start and end of
+// its primary command buffer. Every frame in flight has its own two queries, they are
+// read back without waiting once the timeline says the gpu is done with the frame.
+//
+// Needs timestamp support on the graphics queue, IsSupported is false without it and
+// Resolve never has a time to give.
+class VulkanGpuTimer
+{
+public:
+    VulkanGpuTimer();
+    ~VulkanGpuTimer();
+    
+    bool Init(uint32_t aFrameCount, uint32_t aQueueFamily);
+    void Shutdown();
+    
+    bool IsSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+    
+    // outside any render pass, Begin first thing in the primary and End last
+    void Begin(VkCommandBuffer aCmdBuffer, uint32_t aFrameIndex);
+    void End(VkCommandBuffer aCmdBuffer, uint32_t aFrameIndex);
+    
+    // once the timeline has passed the frame, false until the frame index has been timed once
+    bool Resolve(uint32_t aFrameIndex, float& outMilliseconds);
+
+private:
+    VkQueryPool         m_QueryPool;
+    float               m_NanosecondsPerTick;
+    uint64_t            m_TimestampMask;        // the bits the queue actually writes
+    std::vector<bool>   m_Recorded;
+};
+
+#endif /* VulkanGpuTimer_hpp */
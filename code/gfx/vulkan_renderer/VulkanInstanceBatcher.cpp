@@ -0,0 +1,157 @@
+//
+//  VulkanInstanceBatcher.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanInstanceBatcher.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanUtils.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    bool SameBatch(const VulkanDrawItem& a, const VulkanDrawItem& b)
+    {
+        return a.m_Pipeline == b.m_Pipeline && a.HasSameBindings(b) && a.m_Model == b.m_Model;
+    }
+}
+
+VulkanInstanceBatcher::VulkanInstanceBatcher()
+: m_FrameIndex(0)
+{
+}
+
+VulkanInstanceBatcher::~VulkanInstanceBatcher()
+{
+    Shutdown();
+}
+
+bool VulkanInstanceBatcher::Init(uint32_t aFrameCount, uint32_t anInitialCapacity)
+{
+    m_Frames.resize(aFrameCount, { VK_NULL_HANDLE, VK_NULL_HANDLE, nullptr, 0 });
+    
+    for (InstanceBuffer& frame : m_Frames)
+    {
+        if(!Reserve(frame, anInitialCapacity))
+            return false;
+    }
+    
+    return true;
+}
+
+void VulkanInstanceBatcher::Shutdown()
+{
+    for (InstanceBuffer& frame : m_Frames)
+    {
+        Release(frame);
+    }
+    
+    m_Frames.clear();
+}
+
+void VulkanInstanceBatcher::Release(InstanceBuffer& aBuffer)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer || aBuffer.m_Buffer == VK_NULL_HANDLE)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    vkUnmapMemory(device, aBuffer.m_Memory);
+    vkDestroyBuffer(device, aBuffer.m_Buffer, nullptr);
+    vkFreeMemory(device, aBuffer.m_Memory, nullptr);
+    
+    aBuffer.m_Buffer = VK_NULL_HANDLE;
+    aBuffer.m_Memory = VK_NULL_HANDLE;
+    aBuffer.m_Mapped = nullptr;
+    aBuffer.m_Capacity = 0;
+}
+
+bool VulkanInstanceBatcher::Reserve(InstanceBuffer& aBuffer, uint32_t aCount)
+{
+    if(aCount <= aBuffer.m_Capacity)
+        return true;
+    
+    // grow geometrically so a scene that keeps adding props does not reallocate every frame
+    const uint32_t capacity = std::max(aCount, aBuffer.m_Capacity * 2);
+    
+    Release(aBuffer);
+    
+    const VkDeviceSize bufferSize = sizeof(InstanceData) * capacity;
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    
+    if(!VulkanUtils::CreateBuffer(bufferSize, usage, properties, aBuffer.m_Buffer, aBuffer.m_Memory))
+        return false;
+    
+    void* data = nullptr;
+    
+    // stays mapped, coherent memory needs no flush
+    if(vkMapMemory(VulkanRenderer::GetInstance()->GetLogicalDevice(), aBuffer.m_Memory, 0, bufferSize, 0, &data) != VK_SUCCESS)
+        return false;
+    
+    aBuffer.m_Mapped = static_cast<InstanceData*>(data);
+    aBuffer.m_Capacity = capacity;
+    
+    return true;
+}
+
+void VulkanInstanceBatcher::Begin(uint32_t aFrameIndex)
+{
+    m_FrameIndex = aFrameIndex;
+    
+    m_Queue.Begin();
+    m_Transforms.clear();
+}
+
+void VulkanInstanceBatcher::Add(const VulkanDrawItem& aDraw, const glm::mat4& aTransform, float aDepth)
+{
+    m_Queue.Add(aDraw, aDepth);
+    m_Transforms.push_back(aTransform);
+}
+
+bool VulkanInstanceBatcher::Build(std::vector<VulkanDrawItem>& outDraws, Core_JobSystem* aJobs)
+{
+    const uint32_t drawCount = m_Queue.GetDrawCount();
+    
+    if(drawCount == 0)
+        return true;
+    
+    InstanceBuffer& frame = m_Frames[m_FrameIndex];
+    
+    if(!Reserve(frame, drawCount))
+        return false;
+    
+    // the key puts everything that can share an instanced draw next to each other
+    m_Queue.Sort(aJobs);
+    
+    const std::vector<Core_SortKey>& order = m_Queue.GetSortedKeys();
+    
+    for (uint32_t first = 0; first < drawCount;)
+    {
+        const VulkanDrawItem& batchDraw = m_Queue.GetDraw(order[first].m_Value);
+        uint32_t last = first;
+        
+        while (last < drawCount && SameBatch(batchDraw, m_Queue.GetDraw(order[last].m_Value)))
+        {
+            frame.m_Mapped[last].m_Model = m_Transforms[order[last].m_Value];
+            ++last;
+        }
+        
+        VulkanDrawItem draw = batchDraw;
+        draw.m_InstanceBuffer = frame.m_Buffer;
+        draw.m_FirstInstance = first;
+        draw.m_InstanceCount = last - first;
+        
+        outDraws.push_back(draw);
+        
+        first = last;
+    }
+    
+    return true;
+}
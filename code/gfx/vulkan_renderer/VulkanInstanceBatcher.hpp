@@ -0,0 +1,64 @@
+//
+//  VulkanInstanceBatcher.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanInstanceBatcher_hpp
+#define VulkanInstanceBatcher_hpp
+
+#include "VulkanCommon.hpp"
+#include "VulkanCommandRecorder.hpp"
+#include "VulkanRenderQueue.hpp"
+
+// Collects one draw per object for a frame and merges every draw that shares a
+// pipeline, descriptor set and model into a single instanced draw. The object
+// transforms are packed per group into the frame's instance buffer, so a forest of
+// the same prop costs one vkCmdDrawIndexed instead of one per tree.
+//
+// Objects go through a VulkanRenderQueue, so the groups come out in state key order
+// and the instances inside a group front to back.
+//
+// Each frame in flight has its own persistently mapped buffer, it only grows once
+// that frame's timeline value has been waited on.
+class VulkanInstanceBatcher
+{
+public:
+    VulkanInstanceBatcher();
+    ~VulkanInstanceBatcher();
+    
+    bool Init(uint32_t aFrameCount, uint32_t anInitialCapacity = 1024);
+    void Shutdown();
+    
+    void Begin(uint32_t aFrameIndex);
+    void Add(const VulkanDrawItem& aDraw, const glm::mat4& aTransform, float aDepth = 0.0f);
+    
+    // appends one draw per group to outDraws, the sort is split across aJobs when given
+    bool Build(std::vector<VulkanDrawItem>& outDraws, Core_JobSystem* aJobs = nullptr);
+    
+    uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_Transforms.size()); }
+    
+    const VulkanRenderQueue& GetQueue() const { return m_Queue; }
+
+private:
+    struct InstanceBuffer
+    {
+        VkBuffer        m_Buffer;
+        VkDeviceMemory  m_Memory;
+        InstanceData*   m_Mapped;
+        uint32_t        m_Capacity;
+    };
+    
+    bool Reserve(InstanceBuffer& aBuffer, uint32_t aCount);
+    void Release(InstanceBuffer& aBuffer);
+    
+    std::vector<InstanceBuffer> m_Frames;
+    uint32_t                    m_FrameIndex;
+    
+    VulkanRenderQueue           m_Queue;
+    std::vector<glm::mat4>      m_Transforms;
+};
+
+#endif /* VulkanInstanceBatcher_hpp */
@@ -0,0 +1,240 @@
+//
+//  VulkanLayoutCache.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanLayoutCache.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanShader.hpp"
+
+#include <algorithm>
+
+VulkanLayoutCache::VulkanLayoutCache()
+{
+}
+
+VulkanLayoutCache::~VulkanLayoutCache()
+{
+    Shutdown();
+}
+
+void VulkanLayoutCache::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    for (auto& pipelineLayout : m_PipelineLayouts)
+    {
+        vkDestroyPipelineLayout(device, pipelineLayout.second, nullptr);
+    }
+    
+    for (auto& setLayout : m_SetLayouts)
+    {
+        vkDestroyDescriptorSetLayout(device, setLayout.second, nullptr);
+    }
+    
+    m_PipelineLayouts.clear();
+    m_SetLayouts.clear();
+    m_DescriptorCounts.clear();
+}
+
+bool VulkanLayoutCache::GetLayouts(const std::vector<const VulkanShader*>& someShaders,
+                                   VkPipelineLayout& outPipelineLayout,
+                                   std::vector<VkDescriptorSetLayout>& outSetLayouts,
+                                   bool aDynamicUniforms)
+{
+    // set -> bindings, a binding used by several stages is listed once with all their bits
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+    VkPushConstantRange pushConstants = {};
+    
+    for (const VulkanShader* shader : someShaders)
+    {
+        if(!shader)
+            continue;
+        
+        const ShaderReflection& reflection = shader->GetReflection();
+        
+        for (const ShaderBinding& binding : reflection.m_Bindings)
+        {
+            if(binding.m_Set >= sets.size())
+                sets.resize(binding.m_Set + 1);
+            
+            std::vector<VkDescriptorSetLayoutBinding>& setBindings = sets[binding.m_Set];
+            
+            VkDescriptorType type = binding.m_Type;
+            
+            if(aDynamicUniforms && type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+                type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            
+            auto existing = std::find_if(setBindings.begin(), setBindings.end(), [&binding](const VkDescriptorSetLayoutBinding& aBinding)
+            {
+                return aBinding.binding == binding.m_Binding;
+            });
+            
+            if(existing != setBindings.end())
+            {
+                if(existing->descriptorType != type)
+                {
+                    std::cout << "Shader stages disagree on set " << binding.m_Set << " binding " << binding.m_Binding << std::endl;
+                    return false;
+                }
+                
+                existing->stageFlags |= reflection.m_Stage;
+                existing->descriptorCount = std::max(existing->descriptorCount, binding.m_Count);
+                continue;
+            }
+            
+            VkDescriptorSetLayoutBinding layoutBinding = {};
+            layoutBinding.binding = binding.m_Binding;
+            layoutBinding.descriptorType = type;
+            layoutBinding.descriptorCount = binding.m_Count;
+            layoutBinding.stageFlags = reflection.m_Stage;
+            layoutBinding.pImmutableSamplers = nullptr;
+            
+            setBindings.push_back(layoutBinding);
+        }
+        
+        // one range from zero shared by every stage that declares a block
+        if(reflection.m_PushConstantSize > 0)
+        {
+            pushConstants.stageFlags |= reflection.m_Stage;
+            pushConstants.size = std::max(pushConstants.size, reflection.m_PushConstantSize);
+        }
+    }
+    
+    outSetLayouts.clear();
+    
+    // unused set numbers in between still need a (empty) layout
+    for (std::vector<VkDescriptorSetLayoutBinding>& setBindings : sets)
+    {
+        VkDescriptorSetLayout setLayout = GetDescriptorSetLayout(setBindings);
+        
+        if(setLayout == VK_NULL_HANDLE)
+            return false;
+        
+        outSetLayouts.push_back(setLayout);
+    }
+    
+    std::vector<VkPushConstantRange> pushConstantRanges;
+    
+    if(pushConstants.size > 0)
+        pushConstantRanges.push_back(pushConstants);
+    
+    outPipelineLayout = GetPipelineLayout(outSetLayouts, pushConstantRanges);
+    
+    return outPipelineLayout != VK_NULL_HANDLE;
+}
+
+VkDescriptorSetLayout VulkanLayoutCache::GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& someBindings)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings = someBindings;
+    
+    // binding order does not change the layout so it should not change the key either
+    std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+    {
+        return a.binding < b.binding;
+    });
+    
+    SetLayoutKey key;
+    key.reserve(bindings.size() * 4);
+    
+    for (const VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        key.push_back(binding.binding);
+        key.push_back(static_cast<uint32_t>(binding.descriptorType));
+        key.push_back(binding.descriptorCount);
+        key.push_back(binding.stageFlags);
+    }
+    
+    auto it = m_SetLayouts.find(key);
+    
+    if(it != m_SetLayouts.end())
+        return it->second;
+    
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    
+    if(vkCreateDescriptorSetLayout(VulkanRenderer::GetInstance()->GetLogicalDevice(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    
+    m_SetLayouts[key] = setLayout;
+    
+    // the descriptor allocator sizes its pools against these
+    DescriptorCounts& counts = m_DescriptorCounts[setLayout];
+    
+    for (const VkDescriptorSetLayoutBinding& binding : bindings)
+    {
+        auto count = std::find_if(counts.begin(), counts.end(), [&binding](const VkDescriptorPoolSize& aSize)
+        {
+            return aSize.type == binding.descriptorType;
+        });
+        
+        if(count != counts.end())
+        {
+            count->descriptorCount += binding.descriptorCount;
+        }
+        else
+        {
+            VkDescriptorPoolSize size = {};
+            size.type = binding.descriptorType;
+            size.descriptorCount = binding.descriptorCount;
+            
+            counts.push_back(size);
+        }
+    }
+    
+    return setLayout;
+}
+
+const VulkanLayoutCache::DescriptorCounts* VulkanLayoutCache::GetDescriptorCounts(VkDescriptorSetLayout aLayout) const
+{
+    auto it = m_DescriptorCounts.find(aLayout);
+    
+    return it != m_DescriptorCounts.end() ? &it->second : nullptr;
+}
+
+VkPipelineLayout VulkanLayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& someSetLayouts,
+                                                      const std::vector<VkPushConstantRange>& somePushConstants)
+{
+    PipelineLayoutKey key;
+    key.first = someSetLayouts;
+    
+    for (const VkPushConstantRange& range : somePushConstants)
+    {
+        key.second.push_back(range.stageFlags);
+        key.second.push_back(range.offset);
+        key.second.push_back(range.size);
+    }
+    
+    auto it = m_PipelineLayouts.find(key);
+    
+    if(it != m_PipelineLayouts.end())
+        return it->second;
+    
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(someSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = someSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(somePushConstants.size());
+    pipelineLayoutInfo.pPushConstantRanges = somePushConstants.data();
+    
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    
+    if(vkCreatePipelineLayout(VulkanRenderer::GetInstance()->GetLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+    
+    m_PipelineLayouts[key] = pipelineLayout;
+    
+    return pipelineLayout;
+}
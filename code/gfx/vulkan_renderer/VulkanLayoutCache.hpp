@@ -0,0 +1,60 @@
+//
+//  VulkanLayoutCache.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanLayoutCache_hpp
+#define VulkanLayoutCache_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <map>
+
+class VulkanShader;
+
+// Builds descriptor set and pipeline layouts from shader reflection and hands back
+// the same handle for the same description, so every pipeline sharing a binding
+// layout also shares the vulkan objects and stays compatible for descriptor binds.
+//
+// The cache owns every layout it hands out, they live until Shutdown.
+class VulkanLayoutCache
+{
+public:
+    typedef std::vector<VkDescriptorPoolSize> DescriptorCounts;
+    
+    VulkanLayoutCache();
+    ~VulkanLayoutCache();
+    
+    void Shutdown();
+    
+    // merges the reflection of every stage, outSetLayouts is indexed by set number.
+    // reflection cannot tell a dynamic uniform buffer from a plain one, aDynamicUniforms
+    // makes every uniform buffer dynamic so it is bound with an offset per draw
+    bool GetLayouts(const std::vector<const VulkanShader*>& someShaders,
+                    VkPipelineLayout& outPipelineLayout,
+                    std::vector<VkDescriptorSetLayout>& outSetLayouts,
+                    bool aDynamicUniforms = false);
+    
+    VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& someBindings);
+    VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout>& someSetLayouts,
+                                       const std::vector<VkPushConstantRange>& somePushConstants);
+    
+    // how many descriptors of each type a set of the layout takes, null for layouts made elsewhere
+    const DescriptorCounts* GetDescriptorCounts(VkDescriptorSetLayout aLayout) const;
+    
+    size_t GetSetLayoutCount() const { return m_SetLayouts.size(); }
+    size_t GetPipelineLayoutCount() const { return m_PipelineLayouts.size(); }
+
+private:
+    typedef std::vector<uint32_t> SetLayoutKey;
+    typedef std::pair<std::vector<VkDescriptorSetLayout>, std::vector<uint32_t>> PipelineLayoutKey;
+    
+    std::map<SetLayoutKey, VkDescriptorSetLayout>       m_SetLayouts;
+    std::map<PipelineLayoutKey, VkPipelineLayout>       m_PipelineLayouts;
+    std::map<VkDescriptorSetLayout, DescriptorCounts>   m_DescriptorCounts;
+};
+
+#endif /* VulkanLayoutCache_hpp */
@@ -8,27 +8,41 @@
 
 #include "VulkanModel.hpp"
 #include "VulkanRenderer.hpp"
+#include "VulkanDeletionQueue.hpp"
 #include "VulkanUtils.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "obj_loader.h"
 #undef TINYOBJLOADER_IMPLEMENTATION
 
-VulkanModel::VulkanModel(const char* aModelFile)
+VulkanModel::VulkanModel(const char* aModelFile, bool anIsOccluder)
 : IModel(aModelFile)
+, m_ModelIndexCount(0)
+, m_BoundsMin(0.0f)
+, m_BoundsMax(0.0f)
+, m_IsOccluder(anIsOccluder)
+, m_ModelVertexBuffer(VK_NULL_HANDLE)
+, m_ModelPositionBuffer(VK_NULL_HANDLE)
+, m_ModelIndexBuffer(VK_NULL_HANDLE)
+, m_ModelVertexBufferMemory(VK_NULL_HANDLE)
+, m_ModelPositionBufferMemory(VK_NULL_HANDLE)
+, m_ModelIndexBufferMemory(VK_NULL_HANDLE)
 {
 }
 
 VulkanModel::~VulkanModel()
 {
-    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
-    VkDevice& aDevice = renderer->GetLogicalDevice();
+    // frames in flight may still draw it
+    VulkanDeletionQueue* deletionQueue = VulkanRenderer::GetInstance()->GetDeletionQueue();
     
-    vkDestroyBuffer(aDevice, m_ModelIndexBuffer, nullptr);
-    vkFreeMemory(aDevice, m_ModelIndexBufferMemory, nullptr);
+    deletionQueue->RetireBuffer(m_ModelIndexBuffer);
+    deletionQueue->RetireMemory(m_ModelIndexBufferMemory);
     
-    vkDestroyBuffer(aDevice, m_ModelVertexBuffer, nullptr);
-    vkFreeMemory(aDevice, m_ModelVertexBufferMemory, nullptr);
+    deletionQueue->RetireBuffer(m_ModelPositionBuffer);
+    deletionQueue->RetireMemory(m_ModelPositionBufferMemory);
+    
+    deletionQueue->RetireBuffer(m_ModelVertexBuffer);
+    deletionQueue->RetireMemory(m_ModelVertexBufferMemory);
 }
 
 bool VulkanModel::Load()
@@ -37,25 +51,49 @@ bool VulkanModel::Load()
     IndexList modelIndices;
     
     bool loaded = CreateModelFromFile(modelVertices, modelIndices);
+    
+    if(loaded && m_IsOccluder)
+    {
+        m_OccluderPositions.reserve(modelVertices.size());
+        
+        for (const PositionColorVertex& vertex : modelVertices)
+        {
+            m_OccluderPositions.push_back(vertex.m_Pos);
+        }
+        
+        m_OccluderIndices = modelIndices;
+    }
         
     if(loaded)
         loaded &= CreateVertexBuffer(modelVertices);
     
+    if(loaded)
+        loaded &= CreatePositionBuffer(modelVertices);
+    
     if(loaded)
         loaded &= CreateIndexBuffer(modelIndices);
     
     return loaded;
 }
 
-void VulkanModel::Draw(VkCommandBuffer& aCmdBuffer)
+glm::vec4 VulkanModel::GetBoundingSphere() const
 {
-    VkBuffer vertexBuffers[] = {m_ModelVertexBuffer};
+    const glm::vec3 center = (m_BoundsMin + m_BoundsMax) * 0.5f;
+    return glm::vec4(center, glm::length(m_BoundsMax - center));
+}
+
+void VulkanModel::Bind(VkCommandBuffer& aCmdBuffer, bool aPositionOnly)
+{
+    VkBuffer vertexBuffers[] = {aPositionOnly ? m_ModelPositionBuffer : m_ModelVertexBuffer};
     VkDeviceSize offsets[] = {0};
     
     vkCmdBindVertexBuffers(aCmdBuffer, 0, 1, vertexBuffers, offsets);
     vkCmdBindIndexBuffer(aCmdBuffer, m_ModelIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-    
-    vkCmdDrawIndexed(aCmdBuffer, m_ModelIndexCount, 1, 0, 0, 0);
+}
+
+void VulkanModel::Draw(VkCommandBuffer& aCmdBuffer, uint32_t anInstanceCount, uint32_t aFirstInstance)
+{
+    vkCmdDrawIndexed(aCmdBuffer, m_ModelIndexCount, anInstanceCount, 0, 0, aFirstInstance);
 }
 
 bool VulkanModel::CreateModelFromFile(VertexList& outVertecies, IndexList& outIndices)
@@ -115,57 +153,60 @@ bool VulkanModel::CreateModelFromFile(VertexList& outVertecies, IndexList& outIn
         }
     }
     
+    if(!outVertecies.empty())
+    {
+        m_BoundsMin = m_BoundsMax = outVertecies[0].m_Pos;
+        
+        for (const PositionColorVertex& vertex : outVertecies)
+        {
+            m_BoundsMin = glm::min(m_BoundsMin, vertex.m_Pos);
+            m_BoundsMax = glm::max(m_BoundsMax, vertex.m_Pos);
+        }
+    }
+    
     return true;
 }
 
 bool VulkanModel::CreateVertexBuffer(const VertexList& outVertecies)
 {
-    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
-    VkDevice& aDevice = renderer->GetLogicalDevice();
-    
     const VkDeviceSize size = sizeof(PositionColorVertex) * outVertecies.size();
     
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    return CreateDeviceLocalBuffer(outVertecies.data(), size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_ModelVertexBuffer, m_ModelVertexBufferMemory);
+}
+
+bool VulkanModel::CreatePositionBuffer(const VertexList& someVertices)
+{
+    std::vector<PositionVertex> positions;
+    positions.reserve(someVertices.size());
     
-    // create staging buffer
+    for (const PositionColorVertex& vertex : someVertices)
     {
-        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        
-        if(!VulkanUtils::CreateBuffer(size, usage, properties, stagingBuffer, stagingBufferMemory))
-            return false;
+        PositionVertex position = {vertex.m_Pos};
+        positions.push_back(position);
     }
     
-    void* data;
-    vkMapMemory(aDevice, stagingBufferMemory, 0, size, 0, &data);
-    memcpy(data, outVertecies.data(), size);
-    vkUnmapMemory(aDevice, stagingBufferMemory);
+    const VkDeviceSize size = sizeof(PositionVertex) * positions.size();
     
-    // create device local buffer
-    {
-        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-        const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-        
-        if(!VulkanUtils::CreateBuffer(size, usage, properties, m_ModelVertexBuffer, m_ModelVertexBufferMemory))
-            return false;
-    }
+    return CreateDeviceLocalBuffer(positions.data(), size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_ModelPositionBuffer, m_ModelPositionBufferMemory);
+}
+
+bool VulkanModel::CreateIndexBuffer(const IndexList& outIndices)
+{
+    const VkDeviceSize bufferSize = sizeof(outIndices[0]) * outIndices.size();
     
-    VulkanUtils::CopyBuffer(stagingBuffer, m_ModelVertexBuffer, size);
+    if(!CreateDeviceLocalBuffer(outIndices.data(), bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_ModelIndexBuffer, m_ModelIndexBufferMemory))
+        return false;
     
-    vkDestroyBuffer(aDevice, stagingBuffer, nullptr);
-    vkFreeMemory(aDevice, stagingBufferMemory, nullptr);
+    m_ModelIndexCount = static_cast<uint32_t>(outIndices.size());
     
     return true;
 }
 
-bool VulkanModel::CreateIndexBuffer(const IndexList& outIndices)
+bool VulkanModel::CreateDeviceLocalBuffer(const void* someData, VkDeviceSize aSize, VkBufferUsageFlags aUsage, VkBuffer& outBuffer, VkDeviceMemory& outBufferMemory)
 {
     VulkanRenderer* renderer = VulkanRenderer::GetInstance();
     VkDevice& aDevice = renderer->GetLogicalDevice();
     
-    const VkDeviceSize bufferSize = sizeof(outIndices[0]) * outIndices.size();
-    
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
     
@@ -174,30 +215,32 @@ bool VulkanModel::CreateIndexBuffer(const IndexList& outIndices)
         const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
         
-        if(!VulkanUtils::CreateBuffer(bufferSize, usage, properties, stagingBuffer, stagingBufferMemory))
+        if(!VulkanUtils::CreateBuffer(aSize, usage, properties, stagingBuffer, stagingBufferMemory))
             return false;
     }
     
     void* data;
-    vkMapMemory(aDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, outIndices.data(), (size_t)bufferSize);
+    vkMapMemory(aDevice, stagingBufferMemory, 0, aSize, 0, &data);
+    memcpy(data, someData, (size_t)aSize);
     vkUnmapMemory(aDevice, stagingBufferMemory);
     
     // create device local buffer
     {
-        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | aUsage;
         const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
         
-        if(!VulkanUtils::CreateBuffer(bufferSize, usage, properties, m_ModelIndexBuffer, m_ModelIndexBufferMemory))
+        if(!VulkanUtils::CreateBuffer(aSize, usage, properties, outBuffer, outBufferMemory))
+        {
+            vkDestroyBuffer(aDevice, stagingBuffer, nullptr);
+            vkFreeMemory(aDevice, stagingBufferMemory, nullptr);
             return false;
+        }
     }
     
-    VulkanUtils::CopyBuffer(stagingBuffer, m_ModelIndexBuffer, bufferSize);
+    const bool copied = VulkanUtils::CopyBuffer(stagingBuffer, outBuffer, aSize);
     
     vkDestroyBuffer(aDevice, stagingBuffer, nullptr);
     vkFreeMemory(aDevice, stagingBufferMemory, nullptr);
     
-    m_ModelIndexCount = static_cast<uint32_t>(outIndices.size());
-    
-    return true;
+    return copied;
 }
@@ -12,27 +12,56 @@
 #include "VulkanCommon.hpp"
 #include "IModel.hpp"
 
+#include "Scene_Aabb.hpp"
+
 class VulkanModel : public IModel
 {
     typedef std::vector<PositionColorVertex> VertexList;
     typedef std::vector<uint32_t> IndexList;
 public:
-    VulkanModel(const char* aModelFile);
+    // an occluder keeps a cpu copy of its triangles for the software occlusion culler
+    VulkanModel(const char* aModelFile, bool anIsOccluder = false);
     ~VulkanModel();
     
     virtual bool Load();
     
-    void Draw(VkCommandBuffer& aCmdBuffer);
+    // Draw expects the buffers bound, the recorder only rebinds when the model changes.
+    // position only binds the PositionVertex stream for depth only pipelines
+    void Bind(VkCommandBuffer& aCmdBuffer, bool aPositionOnly = false);
+    void Draw(VkCommandBuffer& aCmdBuffer, uint32_t anInstanceCount = 1, uint32_t aFirstInstance = 0);
+    
+    uint32_t            GetIndexCount() const { return m_ModelIndexCount; }
+    
+    // model space bounds, worked out once at load
+    const glm::vec3&    GetBoundsMin() const { return m_BoundsMin; }
+    const glm::vec3&    GetBoundsMax() const { return m_BoundsMax; }
+    Scene_Aabb          GetBounds() const { return Scene_Aabb(m_BoundsMin, m_BoundsMax); }
+    glm::vec4           GetBoundingSphere() const;
+    
+    // empty unless the model is an occluder
+    const std::vector<glm::vec3>&   GetOccluderPositions() const { return m_OccluderPositions; }
+    const IndexList&                GetOccluderIndices() const { return m_OccluderIndices; }
 
 private:
     bool CreateModelFromFile(VertexList& outVertecies, IndexList& outIndices);
     bool CreateVertexBuffer(const VertexList& outVertecies);
+    bool CreatePositionBuffer(const VertexList& someVertices);
     bool CreateIndexBuffer(const IndexList& outIndices);
+    
+    // copies someData through a staging buffer into a new device local buffer
+    bool CreateDeviceLocalBuffer(const void* someData, VkDeviceSize aSize, VkBufferUsageFlags aUsage, VkBuffer& outBuffer, VkDeviceMemory& outBufferMemory);
 
     uint32_t                            m_ModelIndexCount;
+    glm::vec3                           m_BoundsMin;
+    glm::vec3                           m_BoundsMax;
+    bool                                m_IsOccluder;
+    std::vector<glm::vec3>              m_OccluderPositions;
+    IndexList                           m_OccluderIndices;
     VkBuffer                            m_ModelVertexBuffer;
+    VkBuffer                            m_ModelPositionBuffer;
     VkBuffer                            m_ModelIndexBuffer;
     VkDeviceMemory                      m_ModelVertexBufferMemory;
+    VkDeviceMemory                      m_ModelPositionBufferMemory;
     VkDeviceMemory                      m_ModelIndexBufferMemory;
 };
 
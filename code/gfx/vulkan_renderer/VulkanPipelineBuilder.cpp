@@ -0,0 +1,454 @@
+//
+//  VulkanPipelineBuilder.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanPipelineBuilder.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanShader.hpp"
+#include "VulkanShaderLibrary.hpp"
+
+#include "Core_ThreadPool.hpp"
+#include "Core_Utils.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    void HashCombine(size_t& aSeed, size_t aValue)
+    {
+        aSeed ^= aValue + 0x9e3779b9 + (aSeed << 6) + (aSeed >> 2);
+    }
+    
+    void GetVertexInput(VertexLayout aLayout,
+                        std::vector<VkVertexInputBindingDescription>& outBindings,
+                        std::vector<VkVertexInputAttributeDescription>& outAttributes)
+    {
+        switch (aLayout)
+        {
+            case VERTEX_LAYOUT_POSITION_COLOR:
+                {
+                    outBindings.push_back(PositionColorVertex::GetBindingDescription());
+                    
+                    auto attributeDescriptions = PositionColorVertex::GetAttributeDescriptions();
+                    outAttributes.insert(outAttributes.end(), attributeDescriptions.begin(), attributeDescriptions.end());
+                }
+                break;
+            case VERTEX_LAYOUT_POSITION_COLOR_INSTANCED:
+                {
+                    GetVertexInput(VERTEX_LAYOUT_POSITION_COLOR, outBindings, outAttributes);
+                    
+                    outBindings.push_back(InstanceData::GetBindingDescription());
+                    
+                    auto instanceDescriptions = InstanceData::GetAttributeDescriptions();
+                    outAttributes.insert(outAttributes.end(), instanceDescriptions.begin(), instanceDescriptions.end());
+                }
+                break;
+            case VERTEX_LAYOUT_POSITION_INSTANCED:
+                {
+                    outBindings.push_back(PositionVertex::GetBindingDescription());
+                    
+                    auto attributeDescriptions = PositionVertex::GetAttributeDescriptions();
+                    outAttributes.insert(outAttributes.end(), attributeDescriptions.begin(), attributeDescriptions.end());
+                    
+                    outBindings.push_back(InstanceData::GetBindingDescription());
+                    
+                    auto instanceDescriptions = InstanceData::GetAttributeDescriptions();
+                    outAttributes.insert(outAttributes.end(), instanceDescriptions.begin(), instanceDescriptions.end());
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // a layout that does not feed every shader input gives garbage on some drivers and a crash on others
+    bool MatchesVertexInput(const ShaderReflection& aReflection, const std::vector<VkVertexInputAttributeDescription>& someAttributes)
+    {
+        for (const ShaderVertexInput& input : aReflection.m_VertexInputs)
+        {
+            bool found = false;
+            
+            for (const VkVertexInputAttributeDescription& attribute : someAttributes)
+            {
+                if(attribute.location == input.m_Location)
+                {
+                    found = input.m_Format == VK_FORMAT_UNDEFINED || attribute.format == input.m_Format;
+                    break;
+                }
+            }
+            
+            if(!found)
+            {
+                std::cout << "Vertex layout does not match shader input at location " << input.m_Location << std::endl;
+                return false;
+            }
+        }
+        
+        return true;
+    }
+}
+
+//---------------------------------------------------------------------------
+// VulkanPipelineState
+//---------------------------------------------------------------------------
+VulkanPipelineState::VulkanPipelineState()
+: m_PassID(RENDER_PASS_MAIN)
+, m_VertEntryPoint("main")
+, m_FragEntryPoint("main")
+, m_VertexLayout(VERTEX_LAYOUT_POSITION_COLOR)
+, m_Topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+, m_PolygonMode(VK_POLYGON_MODE_FILL)
+, m_CullMode(VK_CULL_MODE_BACK_BIT)
+, m_FrontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE)
+, m_DepthTest(true)
+, m_DepthWrite(true)
+, m_DepthCompareOp(VK_COMPARE_OP_LESS)
+, m_BlendEnable(false)
+, m_ColorWrite(true)
+{
+}
+
+bool VulkanPipelineState::operator== (const VulkanPipelineState& other) const
+{
+    return m_PassID == other.m_PassID
+        && m_VertShader == other.m_VertShader
+        && m_VertEntryPoint == other.m_VertEntryPoint
+        && m_FragShader == other.m_FragShader
+        && m_FragEntryPoint == other.m_FragEntryPoint
+        && m_VertexLayout == other.m_VertexLayout
+        && m_Topology == other.m_Topology
+        && m_PolygonMode == other.m_PolygonMode
+        && m_CullMode == other.m_CullMode
+        && m_FrontFace == other.m_FrontFace
+        && m_DepthTest == other.m_DepthTest
+        && m_DepthWrite == other.m_DepthWrite
+        && m_DepthCompareOp == other.m_DepthCompareOp
+        && m_BlendEnable == other.m_BlendEnable
+        && m_ColorWrite == other.m_ColorWrite;
+}
+
+size_t VulkanPipelineState::Hash() const
+{
+    size_t seed = 0;
+    
+    HashCombine(seed, m_PassID);
+    HashCombine(seed, std::hash<std::string>()(m_VertShader));
+    HashCombine(seed, std::hash<std::string>()(m_VertEntryPoint));
+    HashCombine(seed, std::hash<std::string>()(m_FragShader));
+    HashCombine(seed, std::hash<std::string>()(m_FragEntryPoint));
+    HashCombine(seed, m_VertexLayout);
+    HashCombine(seed, m_Topology);
+    HashCombine(seed, m_PolygonMode);
+    HashCombine(seed, m_CullMode);
+    HashCombine(seed, m_FrontFace);
+    HashCombine(seed, m_DepthTest);
+    HashCombine(seed, m_DepthWrite);
+    HashCombine(seed, m_DepthCompareOp);
+    HashCombine(seed, m_BlendEnable);
+    HashCombine(seed, m_ColorWrite);
+    
+    return seed;
+}
+
+//---------------------------------------------------------------------------
+// VulkanPipelineDesc
+//---------------------------------------------------------------------------
+VulkanPipelineDesc::VulkanPipelineDesc()
+: m_RenderPass(VK_NULL_HANDLE)
+, m_Subpass(0)
+, m_Layout(VK_NULL_HANDLE)
+{
+}
+
+//---------------------------------------------------------------------------
+// VulkanPipelineBuilder
+//---------------------------------------------------------------------------
+VulkanPipelineBuilder::VulkanPipelineBuilder()
+: m_PipelineCache(VK_NULL_HANDLE)
+, m_ThreadPool(nullptr)
+{
+}
+
+VulkanPipelineBuilder::~VulkanPipelineBuilder()
+{
+    Shutdown();
+}
+
+bool VulkanPipelineBuilder::Init(const char* aCacheFile)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return false;
+    
+    m_CacheFile = aCacheFile;
+    
+    std::vector<char> cacheData;
+    const bool hasCacheData = LoadPipelineCache(cacheData);
+    
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = hasCacheData ? cacheData.size() : 0;
+    cacheInfo.pInitialData = hasCacheData ? cacheData.data() : nullptr;
+    
+    if(vkCreatePipelineCache(renderer->GetLogicalDevice(), &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+        return false;
+    
+    m_ThreadPool = new Core_ThreadPool();
+    
+    return true;
+}
+
+void VulkanPipelineBuilder::Shutdown()
+{
+    // finish anything still compiling before the cache goes away
+    Core_SafeDelete(m_ThreadPool);
+    
+    if(m_PipelineCache == VK_NULL_HANDLE)
+        return;
+    
+    SavePipelineCache();
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(renderer)
+        vkDestroyPipelineCache(renderer->GetLogicalDevice(), m_PipelineCache, nullptr);
+    
+    m_PipelineCache = VK_NULL_HANDLE;
+}
+
+bool VulkanPipelineBuilder::LoadPipelineCache(std::vector<char>& outCacheData)
+{
+    std::ifstream file(m_CacheFile, std::ios::ate | std::ios::binary);
+    
+    if (!file.is_open())
+        return false;
+    
+    const size_t fileSize = (size_t) file.tellg();
+    
+    // header is length, version, vendor id, device id then the cache uuid
+    const size_t headerSize = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+    
+    if(fileSize < headerSize)
+        return false;
+    
+    outCacheData.resize(fileSize);
+    
+    file.seekg(0);
+    file.read(outCacheData.data(), fileSize);
+    
+    uint32_t header[4];
+    memcpy(header, outCacheData.data(), sizeof(header));
+    
+    const VkPhysicalDeviceProperties& properties = VulkanRenderer::GetInstance()->GetDeviceProperties();
+    
+    // drivers should reject a foreign cache themselves but not all of them do
+    const bool matchesDevice = header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                            && header[2] == properties.vendorID
+                            && header[3] == properties.deviceID
+                            && memcmp(outCacheData.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    
+    if(!matchesDevice)
+        outCacheData.clear();
+    
+    return matchesDevice;
+}
+
+bool VulkanPipelineBuilder::SavePipelineCache()
+{
+    VkDevice& device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    size_t dataSize = 0;
+    
+    if(vkGetPipelineCacheData(device, m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+        return false;
+    
+    std::vector<char> cacheData(dataSize);
+    
+    if(vkGetPipelineCacheData(device, m_PipelineCache, &dataSize, cacheData.data()) != VK_SUCCESS)
+        return false;
+    
+    std::ofstream file(m_CacheFile, std::ios::binary | std::ios::trunc);
+    
+    if (!file.is_open())
+        return false;
+    
+    file.write(cacheData.data(), dataSize);
+    
+    return true;
+}
+
+VulkanPipelineBuilder::PipelineFuture VulkanPipelineBuilder::CompilePipeline(const VulkanPipelineDesc& aDesc)
+{
+    return m_ThreadPool->Submit([this, aDesc]()
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        
+        if(!CreatePipeline(aDesc, pipeline))
+            pipeline = VK_NULL_HANDLE;
+        
+        return pipeline;
+    }).share();
+}
+
+std::vector<VulkanPipelineBuilder::PipelineFuture> VulkanPipelineBuilder::CompilePipelines(const std::vector<VulkanPipelineDesc>& someDescs)
+{
+    std::vector<PipelineFuture> futures;
+    futures.reserve(someDescs.size());
+    
+    for (const VulkanPipelineDesc& desc : someDescs)
+    {
+        futures.push_back(CompilePipeline(desc));
+    }
+    
+    return futures;
+}
+
+bool VulkanPipelineBuilder::CreatePipeline(const VulkanPipelineDesc& aDesc, VkPipeline& outPipeline)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return false;
+    
+    const VulkanPipelineState& state = aDesc.m_State;
+    VulkanShaderLibrary* shaderLibrary = renderer->GetShaderLibrary();
+    
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    
+    const VulkanShader* vertShader = shaderLibrary->GetShader(state.m_VertShader.c_str(), state.m_VertEntryPoint.c_str());
+    
+    if(!vertShader)
+        return false;
+    
+    shaderStages.push_back(vertShader->GetStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT));
+    
+    // no fragment shader is valid, e.g. depth only passes
+    if(!state.m_FragShader.empty())
+    {
+        const VulkanShader* fragShader = shaderLibrary->GetShader(state.m_FragShader.c_str(), state.m_FragEntryPoint.c_str());
+        
+        if(!fragShader)
+            return false;
+        
+        shaderStages.push_back(fragShader->GetStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT));
+    }
+    
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    GetVertexInput(state.m_VertexLayout, bindingDescriptions, attributeDescriptions);
+    
+    if(!MatchesVertexInput(vertShader->GetReflection(), attributeDescriptions))
+        return false;
+    
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+    
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = state.m_Topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    
+    // viewport and scissor are set when recording so a resize does not need a new pipeline
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = nullptr;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = nullptr;
+    
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = state.m_PolygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = state.m_CullMode;
+    rasterizer.frontFace = state.m_FrontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+    rasterizer.depthBiasClamp = 0.0f; // Optional
+    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+    
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading = 1.0f; // Optional
+    multisampling.pSampleMask = nullptr; // Optional
+    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+    multisampling.alphaToOneEnable = VK_FALSE; // Optional
+    
+    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+    colorBlendAttachment.colorWriteMask = state.m_ColorWrite ? VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT : 0;
+    colorBlendAttachment.blendEnable = state.m_BlendEnable ? VK_TRUE : VK_FALSE;
+    colorBlendAttachment.srcColorBlendFactor = state.m_BlendEnable ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstColorBlendFactor = state.m_BlendEnable ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    
+    VkPipelineColorBlendStateCreateInfo colorBlending = {};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f; // Optional
+    colorBlending.blendConstants[1] = 0.0f; // Optional
+    colorBlending.blendConstants[2] = 0.0f; // Optional
+    colorBlending.blendConstants[3] = 0.0f; // Optional
+    
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = state.m_DepthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable = state.m_DepthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp = state.m_DepthCompareOp;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.minDepthBounds = 0.0f; // Optional
+    depthStencil.maxDepthBounds = 1.0f; // Optional
+    depthStencil.stencilTestEnable = VK_FALSE;
+    depthStencil.front = {}; // Optional
+    depthStencil.back = {}; // Optional
+    
+    VkDynamicState dynamicStates[] =
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+    
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = aDesc.m_Layout;
+    pipelineInfo.renderPass = aDesc.m_RenderPass;
+    pipelineInfo.subpass = aDesc.m_Subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
+    
+    return vkCreateGraphicsPipelines(renderer->GetLogicalDevice(), m_PipelineCache, 1, &pipelineInfo, nullptr, &outPipeline) == VK_SUCCESS;
+}
@@ -0,0 +1,94 @@
+//
+//  VulkanPipelineBuilder.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanPipelineBuilder_hpp
+#define VulkanPipelineBuilder_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <future>
+#include <string>
+
+class Core_ThreadPool;
+
+//----------------------------------------------------------------------
+// everything that goes into a graphics pipeline that is not a vulkan handle
+struct VulkanPipelineState
+{
+    VulkanPipelineState();
+    
+    bool operator== (const VulkanPipelineState& other) const;
+    size_t Hash() const;
+    
+    // which registered render pass / layout pair the pipeline is built for
+    uint32_t            m_PassID;
+    
+    std::string         m_VertShader;
+    std::string         m_VertEntryPoint;
+    std::string         m_FragShader;
+    std::string         m_FragEntryPoint;
+    
+    VertexLayout        m_VertexLayout;
+    VkPrimitiveTopology m_Topology;
+    VkPolygonMode       m_PolygonMode;
+    VkCullModeFlags     m_CullMode;
+    VkFrontFace         m_FrontFace;
+    
+    bool                m_DepthTest;
+    bool                m_DepthWrite;
+    VkCompareOp         m_DepthCompareOp;
+    bool                m_BlendEnable;
+    bool                m_ColorWrite;       // off for depth only pipelines in a pass that still has a colour attachment
+};
+
+//----------------------------------------------------------------------
+struct VulkanPipelineDesc
+{
+    VulkanPipelineDesc();
+    
+    VulkanPipelineState m_State;
+    VkRenderPass        m_RenderPass;
+    uint32_t            m_Subpass;
+    VkPipelineLayout    m_Layout;
+};
+
+//----------------------------------------------------------------------
+// Compiles graphics pipelines on worker threads against one shared VkPipelineCache.
+// The cache is internally synchronised so every worker can feed it at once, and it
+// is persisted to disk so later launches mostly skip the driver compiler.
+class VulkanPipelineBuilder
+{
+public:
+    typedef std::shared_future<VkPipeline> PipelineFuture;
+    
+    VulkanPipelineBuilder();
+    ~VulkanPipelineBuilder();
+    
+    bool Init(const char* aCacheFile);
+    void Shutdown();
+    
+    // queue a compile and return straight away, the future holds VK_NULL_HANDLE on failure
+    PipelineFuture CompilePipeline(const VulkanPipelineDesc& aDesc);
+    std::vector<PipelineFuture> CompilePipelines(const std::vector<VulkanPipelineDesc>& someDescs);
+    
+    // compile on the calling thread
+    bool CreatePipeline(const VulkanPipelineDesc& aDesc, VkPipeline& outPipeline);
+    
+    VkPipelineCache     GetPipelineCache() const { return m_PipelineCache; }
+    Core_ThreadPool*    GetThreadPool() { return m_ThreadPool; }
+
+private:
+    bool LoadPipelineCache(std::vector<char>& outCacheData);
+    bool SavePipelineCache();
+    
+    std::string         m_CacheFile;
+    VkPipelineCache     m_PipelineCache;
+    Core_ThreadPool*    m_ThreadPool;
+};
+
+#endif /* VulkanPipelineBuilder_hpp */
@@ -0,0 +1,314 @@
+//
+//  VulkanPipelineManager.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanPipelineManager.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    const char WARMUP_SEPARATOR = ';';
+    const size_t WARMUP_FIELD_COUNT = 15;
+    
+    // a hand edited or truncated list should not take the app down, junk just reads as zero
+    long ToInt(const std::string& aField)
+    {
+        return std::strtol(aField.c_str(), nullptr, 10);
+    }
+}
+
+VulkanPipelineManager::VulkanPipelineManager(VulkanPipelineBuilder* aBuilder)
+: m_Builder(aBuilder)
+, m_PendingCount(0)
+{
+}
+
+VulkanPipelineManager::~VulkanPipelineManager()
+{
+    Shutdown();
+}
+
+void VulkanPipelineManager::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    for (PipelineMap::value_type& pipeline : m_Pipelines)
+    {
+        ResolveEntry(pipeline.second, true);
+        
+        if(renderer && pipeline.second.m_Pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(renderer->GetLogicalDevice(), pipeline.second.m_Pipeline, nullptr);
+    }
+    
+    m_Pipelines.clear();
+    m_Passes.clear();
+    m_PendingCount = 0;
+}
+
+void VulkanPipelineManager::RegisterPass(uint32_t aPassID, VkRenderPass aRenderPass, VkPipelineLayout aLayout)
+{
+    PassInfo& pass = m_Passes[aPassID];
+    pass.m_RenderPass = aRenderPass;
+    pass.m_Layout = aLayout;
+    pass.m_HasFallback = false;
+}
+
+void VulkanPipelineManager::SetFallback(uint32_t aPassID, const VulkanPipelineState& aState)
+{
+    PassMap::iterator it = m_Passes.find(aPassID);
+    
+    if(it == m_Passes.end() || aState.m_PassID != aPassID)
+        return;
+    
+    it->second.m_FallbackState = aState;
+    it->second.m_HasFallback = true;
+    
+    RequestPipeline(aState);
+}
+
+void VulkanPipelineManager::DestroyPassPipelines(uint32_t aPassID)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    for (PipelineMap::iterator it = m_Pipelines.begin(); it != m_Pipelines.end();)
+    {
+        if(it->first.m_PassID != aPassID)
+        {
+            ++it;
+            continue;
+        }
+        
+        // cannot abandon a compile that is using the old render pass
+        ResolveEntry(it->second, true);
+        
+        if(renderer && it->second.m_Pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(renderer->GetLogicalDevice(), it->second.m_Pipeline, nullptr);
+        
+        it = m_Pipelines.erase(it);
+    }
+    
+    m_Passes.erase(aPassID);
+}
+
+VulkanPipelineManager::PipelineEntry* VulkanPipelineManager::RequestPipeline(const VulkanPipelineState& aState)
+{
+    PipelineMap::iterator it = m_Pipelines.find(aState);
+    
+    if(it != m_Pipelines.end())
+        return &it->second;
+    
+    PassMap::const_iterator passIt = m_Passes.find(aState.m_PassID);
+    
+    if(passIt == m_Passes.end())
+        return nullptr;
+    
+    VulkanPipelineDesc desc;
+    desc.m_State = aState;
+    desc.m_RenderPass = passIt->second.m_RenderPass;
+    desc.m_Layout = passIt->second.m_Layout;
+    
+    PipelineEntry& entry = m_Pipelines[aState];
+    entry.m_Request = m_Builder->CompilePipeline(desc);
+    entry.m_Pipeline = VK_NULL_HANDLE;
+    entry.m_Failed = false;
+    
+    ++m_PendingCount;
+    
+    return &entry;
+}
+
+bool VulkanPipelineManager::ResolveEntry(PipelineEntry& anEntry, bool aBlock)
+{
+    if(anEntry.m_Pipeline != VK_NULL_HANDLE || anEntry.m_Failed)
+        return anEntry.m_Pipeline != VK_NULL_HANDLE;
+    
+    if(!anEntry.m_Request.valid())
+        return false;
+    
+    if(!aBlock && anEntry.m_Request.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+    
+    anEntry.m_Pipeline = anEntry.m_Request.get();
+    anEntry.m_Request = VulkanPipelineBuilder::PipelineFuture();
+    anEntry.m_Failed = anEntry.m_Pipeline == VK_NULL_HANDLE;
+    
+    --m_PendingCount;
+    
+    if(anEntry.m_Failed)
+        std::cout << "Failed to compile pipeline" << std::endl;
+    
+    return !anEntry.m_Failed;
+}
+
+VkPipeline VulkanPipelineManager::GetFallback(uint32_t aPassID)
+{
+    PassMap::const_iterator passIt = m_Passes.find(aPassID);
+    
+    if(passIt == m_Passes.end() || !passIt->second.m_HasFallback)
+        return VK_NULL_HANDLE;
+    
+    PipelineMap::iterator it = m_Pipelines.find(passIt->second.m_FallbackState);
+    
+    if(it == m_Pipelines.end() || !ResolveEntry(it->second, false))
+        return VK_NULL_HANDLE;
+    
+    return it->second.m_Pipeline;
+}
+
+VkPipeline VulkanPipelineManager::GetPipeline(const VulkanPipelineState& aState)
+{
+    m_UsedStates.insert(aState);
+    
+    PipelineEntry* entry = RequestPipeline(aState);
+    
+    if(entry && ResolveEntry(*entry, false))
+        return entry->m_Pipeline;
+    
+    return GetFallback(aState.m_PassID);
+}
+
+bool VulkanPipelineManager::IsReady(const VulkanPipelineState& aState)
+{
+    m_UsedStates.insert(aState);
+    
+    PipelineEntry* entry = RequestPipeline(aState);
+    
+    return entry && ResolveEntry(*entry, false);
+}
+
+VkPipeline VulkanPipelineManager::WaitForPipeline(const VulkanPipelineState& aState)
+{
+    m_UsedStates.insert(aState);
+    
+    PipelineEntry* entry = RequestPipeline(aState);
+    
+    if(entry && ResolveEntry(*entry, true))
+        return entry->m_Pipeline;
+    
+    return VK_NULL_HANDLE;
+}
+
+bool VulkanPipelineManager::Update()
+{
+    if(m_PendingCount == 0)
+        return false;
+    
+    bool anyReady = false;
+    
+    for (PipelineMap::value_type& pipeline : m_Pipelines)
+    {
+        PipelineEntry& entry = pipeline.second;
+        
+        if(entry.m_Pipeline == VK_NULL_HANDLE && entry.m_Request.valid())
+            anyReady |= ResolveEntry(entry, false);
+    }
+    
+    return anyReady;
+}
+
+void VulkanPipelineManager::PrecompileWarmupList(uint32_t aPassID)
+{
+    for (const VulkanPipelineState& state : m_WarmupStates)
+    {
+        if(state.m_PassID == aPassID)
+            RequestPipeline(state);
+    }
+}
+
+void VulkanPipelineManager::WriteState(std::ostream& aStream, const VulkanPipelineState& aState)
+{
+    const char sep = WARMUP_SEPARATOR;
+    
+    aStream << aState.m_PassID << sep
+            << aState.m_VertShader << sep
+            << aState.m_VertEntryPoint << sep
+            << aState.m_FragShader << sep
+            << aState.m_FragEntryPoint << sep
+            << aState.m_VertexLayout << sep
+            << aState.m_Topology << sep
+            << aState.m_PolygonMode << sep
+            << aState.m_CullMode << sep
+            << aState.m_FrontFace << sep
+            << aState.m_DepthTest << sep
+            << aState.m_DepthWrite << sep
+            << aState.m_DepthCompareOp << sep
+            << aState.m_BlendEnable << sep
+            << aState.m_ColorWrite << "\n";
+}
+
+bool VulkanPipelineManager::ReadState(const std::string& aLine, VulkanPipelineState& outState)
+{
+    std::vector<std::string> fields;
+    std::istringstream lineStream(aLine);
+    std::string field;
+    
+    while (std::getline(lineStream, field, WARMUP_SEPARATOR))
+    {
+        fields.push_back(field);
+    }
+    
+    if(fields.size() != WARMUP_FIELD_COUNT)
+        return false;
+    
+    outState.m_PassID = static_cast<uint32_t>(ToInt(fields[0]));
+    outState.m_VertShader = fields[1];
+    outState.m_VertEntryPoint = fields[2];
+    outState.m_FragShader = fields[3];
+    outState.m_FragEntryPoint = fields[4];
+    outState.m_VertexLayout = static_cast<VertexLayout>(ToInt(fields[5]));
+    outState.m_Topology = static_cast<VkPrimitiveTopology>(ToInt(fields[6]));
+    outState.m_PolygonMode = static_cast<VkPolygonMode>(ToInt(fields[7]));
+    outState.m_CullMode = static_cast<VkCullModeFlags>(ToInt(fields[8]));
+    outState.m_FrontFace = static_cast<VkFrontFace>(ToInt(fields[9]));
+    outState.m_DepthTest = ToInt(fields[10]) != 0;
+    outState.m_DepthWrite = ToInt(fields[11]) != 0;
+    outState.m_DepthCompareOp = static_cast<VkCompareOp>(ToInt(fields[12]));
+    outState.m_BlendEnable = ToInt(fields[13]) != 0;
+    outState.m_ColorWrite = ToInt(fields[14]) != 0;
+    
+    return true;
+}
+
+bool VulkanPipelineManager::LoadWarmupList(const char* aWarmupFile)
+{
+    std::ifstream file(aWarmupFile);
+    
+    if (!file.is_open())
+        return false;
+    
+    std::string line;
+    
+    while (std::getline(file, line))
+    {
+        VulkanPipelineState state;
+        
+        if(!line.empty() && ReadState(line, state))
+            m_WarmupStates.push_back(state);
+    }
+    
+    return true;
+}
+
+bool VulkanPipelineManager::SaveWarmupList(const char* aWarmupFile) const
+{
+    std::ofstream file(aWarmupFile, std::ios::trunc);
+    
+    if (!file.is_open())
+        return false;
+    
+    for (const VulkanPipelineState& state : m_UsedStates)
+    {
+        WriteState(file, state);
+    }
+    
+    return true;
+}
@@ -0,0 +1,100 @@
+//
+//  VulkanPipelineManager.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanPipelineManager_hpp
+#define VulkanPipelineManager_hpp
+
+#include "VulkanCommon.hpp"
+#include "VulkanPipelineBuilder.hpp"
+
+#include <unordered_set>
+
+// Hands out pipelines by state without ever blocking the frame. A state that has
+// not been compiled yet is queued on the builder and the pass fallback is returned
+// until it is ready. Every state asked for is remembered so the next launch can
+// compile it up front from the warm-up list.
+//
+// Only the render thread talks to the manager, the builder workers never touch it.
+class VulkanPipelineManager
+{
+public:
+    VulkanPipelineManager(VulkanPipelineBuilder* aBuilder);
+    ~VulkanPipelineManager();
+    
+    void Shutdown();
+    
+    void RegisterPass(uint32_t aPassID, VkRenderPass aRenderPass, VkPipelineLayout aLayout);
+    void SetFallback(uint32_t aPassID, const VulkanPipelineState& aState);
+    
+    // the pass render pass is going away, caller must make sure the gpu is done with them
+    void DestroyPassPipelines(uint32_t aPassID);
+    
+    // never blocks, returns the pass fallback (or VK_NULL_HANDLE) while compiling
+    VkPipeline GetPipeline(const VulkanPipelineState& aState);
+    
+    // queues the compile like GetPipeline, true once the state's own pipeline can be used. for
+    // callers that cannot draw with the fallback, e.g. a pass that depends on another's depth
+    bool IsReady(const VulkanPipelineState& aState);
+    
+    // blocks until the pipeline is compiled, for init time only
+    VkPipeline WaitForPipeline(const VulkanPipelineState& aState);
+    
+    // picks up finished compiles, returns true if any new pipeline became usable
+    bool Update();
+    
+    bool LoadWarmupList(const char* aWarmupFile);
+    bool SaveWarmupList(const char* aWarmupFile) const;
+    
+    // queue every loaded warm-up state that targets this pass
+    void PrecompileWarmupList(uint32_t aPassID);
+    
+    uint32_t GetPendingCount() const { return m_PendingCount; }
+
+private:
+    struct PipelineEntry
+    {
+        VulkanPipelineBuilder::PipelineFuture   m_Request;
+        VkPipeline                              m_Pipeline;
+        bool                                    m_Failed;
+    };
+    
+    struct PassInfo
+    {
+        VkRenderPass        m_RenderPass;
+        VkPipelineLayout    m_Layout;
+        VulkanPipelineState m_FallbackState;
+        bool                m_HasFallback;
+    };
+    
+    struct StateHasher
+    {
+        size_t operator()(const VulkanPipelineState& aState) const { return aState.Hash(); }
+    };
+    
+    typedef std::unordered_map<VulkanPipelineState, PipelineEntry, StateHasher> PipelineMap;
+    typedef std::unordered_set<VulkanPipelineState, StateHasher> StateSet;
+    typedef std::unordered_map<uint32_t, PassInfo> PassMap;
+    
+    PipelineEntry* RequestPipeline(const VulkanPipelineState& aState);
+    bool ResolveEntry(PipelineEntry& anEntry, bool aBlock);
+    VkPipeline GetFallback(uint32_t aPassID);
+    
+    static void WriteState(std::ostream& aStream, const VulkanPipelineState& aState);
+    static bool ReadState(const std::string& aLine, VulkanPipelineState& outState);
+    
+    VulkanPipelineBuilder*              m_Builder;
+    
+    PassMap                             m_Passes;
+    PipelineMap                         m_Pipelines;
+    StateSet                            m_UsedStates;
+    std::vector<VulkanPipelineState>    m_WarmupStates;
+    
+    uint32_t                            m_PendingCount;
+};
+
+#endif /* VulkanPipelineManager_hpp */
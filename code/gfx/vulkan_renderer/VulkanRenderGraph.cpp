@@ -0,0 +1,916 @@
+//
+//  VulkanRenderGraph.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanRenderGraph.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanDeletionQueue.hpp"
+#include "VulkanUtils.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const VkAccessFlags ourWriteAccess = VK_ACCESS_SHADER_WRITE_BIT |
+                                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                         VK_ACCESS_TRANSFER_WRITE_BIT |
+                                         VK_ACCESS_HOST_WRITE_BIT |
+                                         VK_ACCESS_MEMORY_WRITE_BIT;
+    
+    const VkImageUsageFlags ourAttachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                                                 VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+    
+    struct BlockPlacement
+    {
+        uint32_t                                    m_TypeBits;
+        VkDeviceSize                                m_Size;
+        bool                                        m_Lazy;
+        std::vector<std::pair<uint32_t, uint32_t>>  m_Lifetimes;
+    };
+    
+    bool Overlaps(const BlockPlacement& aBlock, uint32_t aFirst, uint32_t aLast)
+    {
+        for (const std::pair<uint32_t, uint32_t>& lifetime : aBlock.m_Lifetimes)
+        {
+            if(aFirst <= lifetime.second && lifetime.first <= aLast)
+                return true;
+        }
+        
+        return false;
+    }
+    
+    // close enough for the bandwidth estimate, tilers may pack depth and stencil differently
+    VkDeviceSize GetPixelSize(VkFormat aFormat)
+    {
+        switch (aFormat)
+        {
+            case VK_FORMAT_D16_UNORM:
+                return 2;
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+                return 8;
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                return 16;
+            default:
+                return 4;
+        }
+    }
+    
+    bool HasLazyMemory(VkPhysicalDevice aPhysicalDevice)
+    {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(aPhysicalDevice, &memProperties);
+        
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; ++i)
+        {
+            if(memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+                return true;
+        }
+        
+        return false;
+    }
+}
+
+bool VulkanRenderGraph::AttachmentOps::operator==(const AttachmentOps& other) const
+{
+    return m_Load == other.m_Load && m_Store == other.m_Store;
+}
+
+bool VulkanRenderGraph::MemoryStats::operator==(const MemoryStats& other) const
+{
+    return m_ImageBytes == other.m_ImageBytes
+        && m_AllocatedBytes == other.m_AllocatedBytes
+        && m_LazyBytes == other.m_LazyBytes
+        && m_SkippedBytes == other.m_SkippedBytes;
+}
+
+VulkanRenderGraph::VulkanRenderGraph()
+: m_BarrierCount(0)
+, m_MemoryStats()
+{
+}
+
+VulkanRenderGraph::~VulkanRenderGraph()
+{
+    Shutdown();
+}
+
+void VulkanRenderGraph::Shutdown()
+{
+    ReleaseTransients();
+    Reset();
+}
+
+void VulkanRenderGraph::Reset()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_PassBarriers.clear();
+    m_FinalBarriers = BarrierBatch();
+    m_BarrierCount = 0;
+}
+
+const VulkanRenderGraph::UsageInfo& VulkanRenderGraph::GetUsageInfo(ResourceUsage aUsage)
+{
+    static const UsageInfo ourUsages[USAGE_NUM] =
+    {
+        // USAGE_NONE
+        { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED },
+        // USAGE_SWAPCHAIN_ACQUIRE
+        { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED },
+        // USAGE_SWAPCHAIN_ACQUIRE_BLIT
+        { VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED },
+        // USAGE_PRESENT
+        { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR },
+        // USAGE_COLOR_ATTACHMENT
+        { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+          VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+          VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+        // USAGE_DEPTH_ATTACHMENT
+        { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+        // USAGE_DEPTH_READ
+        { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+        // USAGE_SAMPLED_FRAGMENT
+        { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        // USAGE_SAMPLED_COMPUTE
+        { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+        // USAGE_STORAGE_COMPUTE
+        { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL },
+        // USAGE_INDIRECT
+        { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED },
+        // USAGE_VERTEX
+        { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED },
+        // USAGE_TRANSFER_SRC
+        { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL },
+        // USAGE_TRANSFER_DST
+        { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL },
+    };
+    
+    return ourUsages[aUsage];
+}
+
+VulkanRenderGraph::ResourceID VulkanRenderGraph::CreateImage(const char* aName, const ImageDesc& aDesc)
+{
+    Resource resource = {};
+    resource.m_Name = aName;
+    resource.m_Image = true;
+    resource.m_Desc = aDesc;
+    resource.m_InitialUsage = USAGE_NONE;
+    resource.m_FinalUsage = USAGE_NONE;
+    resource.m_Physical = INVALID_ID;
+    
+    m_Resources.push_back(resource);
+    
+    return static_cast<ResourceID>(m_Resources.size() - 1);
+}
+
+VulkanRenderGraph::ResourceID VulkanRenderGraph::ImportImage(const char* aName, VkImage anImage, VkImageAspectFlags anAspect,
+                                                             ResourceUsage anInitialUsage, ResourceUsage aFinalUsage)
+{
+    Resource resource = {};
+    resource.m_Name = aName;
+    resource.m_Image = true;
+    resource.m_Imported = true;
+    resource.m_Desc.m_Aspect = anAspect;
+    resource.m_ImageHandle = anImage;
+    resource.m_InitialUsage = anInitialUsage;
+    resource.m_FinalUsage = aFinalUsage;
+    resource.m_Physical = INVALID_ID;
+    
+    m_Resources.push_back(resource);
+    
+    return static_cast<ResourceID>(m_Resources.size() - 1);
+}
+
+VulkanRenderGraph::ResourceID VulkanRenderGraph::ImportBuffer(const char* aName, VkBuffer aBuffer,
+                                                              ResourceUsage anInitialUsage, ResourceUsage aFinalUsage)
+{
+    Resource resource = {};
+    resource.m_Name = aName;
+    resource.m_Imported = true;
+    resource.m_Buffer = aBuffer;
+    resource.m_InitialUsage = anInitialUsage;
+    resource.m_FinalUsage = aFinalUsage;
+    resource.m_Physical = INVALID_ID;
+    
+    m_Resources.push_back(resource);
+    
+    return static_cast<ResourceID>(m_Resources.size() - 1);
+}
+
+VulkanRenderGraph::PassID VulkanRenderGraph::AddPass(const char* aName, const ExecuteFunc& anExecute)
+{
+    Pass pass;
+    pass.m_Name = aName;
+    pass.m_Execute = anExecute;
+    pass.m_Culled = false;
+    
+    m_Passes.push_back(pass);
+    
+    return static_cast<PassID>(m_Passes.size() - 1);
+}
+
+void VulkanRenderGraph::Read(PassID aPass, ResourceID aResource, ResourceUsage aUsage)
+{
+    Access access = { aResource, aUsage, false, false, { VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE } };
+    m_Passes[aPass].m_Accesses.push_back(access);
+}
+
+void VulkanRenderGraph::Write(PassID aPass, ResourceID aResource, ResourceUsage aUsage, bool aClear)
+{
+    Access access = { aResource, aUsage, true, aClear, { VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE } };
+    m_Passes[aPass].m_Accesses.push_back(access);
+}
+
+bool VulkanRenderGraph::Compile()
+{
+    CullPasses();
+    ComputeLifetimes();
+    ComputeAttachmentOps();
+    
+    if(!RealizeTransients())
+        return false;
+    
+    BuildBarriers();
+    
+    return true;
+}
+
+void VulkanRenderGraph::CullPasses()
+{
+    // passes only feed later ones, so one walk backwards from the outputs finds everything that matters
+    std::vector<bool> needed(m_Resources.size(), false);
+    
+    for (size_t i = 0; i < m_Resources.size(); ++i)
+    {
+        needed[i] = m_Resources[i].m_Imported && m_Resources[i].m_FinalUsage != USAGE_NONE;
+    }
+    
+    for (size_t i = m_Passes.size(); i-- > 0;)
+    {
+        Pass& pass = m_Passes[i];
+        pass.m_Culled = true;
+        
+        for (const Access& access : pass.m_Accesses)
+        {
+            if(access.m_Write && needed[access.m_Resource])
+                pass.m_Culled = false;
+        }
+        
+        if(pass.m_Culled)
+            continue;
+        
+        for (const Access& access : pass.m_Accesses)
+        {
+            if(!access.m_Write)
+                needed[access.m_Resource] = true;
+        }
+    }
+}
+
+void VulkanRenderGraph::ComputeLifetimes()
+{
+    for (Resource& resource : m_Resources)
+    {
+        resource.m_FirstPass = INVALID_ID;
+        resource.m_LastPass = INVALID_ID;
+    }
+    
+    for (uint32_t i = 0; i < m_Passes.size(); ++i)
+    {
+        if(m_Passes[i].m_Culled)
+            continue;
+        
+        for (const Access& access : m_Passes[i].m_Accesses)
+        {
+            Resource& resource = m_Resources[access.m_Resource];
+            
+            if(resource.m_FirstPass == INVALID_ID)
+                resource.m_FirstPass = i;
+            
+            resource.m_LastPass = i;
+        }
+    }
+}
+
+void VulkanRenderGraph::ComputeAttachmentOps()
+{
+    // whether the memory holds anything worth loading yet, only an earlier write or the caller's contents count
+    std::vector<bool> defined(m_Resources.size(), false);
+    
+    for (size_t i = 0; i < m_Resources.size(); ++i)
+    {
+        Resource& resource = m_Resources[i];
+        
+        defined[i] = resource.m_Imported && resource.m_InitialUsage != USAGE_NONE
+                  && resource.m_InitialUsage != USAGE_SWAPCHAIN_ACQUIRE && resource.m_InitialUsage != USAGE_SWAPCHAIN_ACQUIRE_BLIT;
+        
+        // until an op below needs the memory, an attachment only image never has to leave the tile
+        resource.m_Lazy = !resource.m_Imported && (resource.m_Desc.m_Usage & ~ourAttachmentUsage) == 0;
+    }
+    
+    m_MemoryStats.m_SkippedBytes = 0;
+    
+    for (uint32_t p = 0; p < m_Passes.size(); ++p)
+    {
+        Pass& pass = m_Passes[p];
+        
+        if(pass.m_Culled)
+            continue;
+        
+        for (Access& access : pass.m_Accesses)
+        {
+            Resource& resource = m_Resources[access.m_Resource];
+            
+            const bool attachment = access.m_Usage == USAGE_COLOR_ATTACHMENT || access.m_Usage == USAGE_DEPTH_ATTACHMENT || access.m_Usage == USAGE_DEPTH_READ;
+            
+            if(attachment)
+            {
+                if(access.m_Clear)
+                    access.m_Ops.m_Load = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                else
+                    access.m_Ops.m_Load = defined[access.m_Resource] ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                
+                access.m_Ops.m_Store = IsReadAfter(access.m_Resource, p) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                
+                if(access.m_Ops.m_Load == VK_ATTACHMENT_LOAD_OP_LOAD || access.m_Ops.m_Store == VK_ATTACHMENT_STORE_OP_STORE)
+                    resource.m_Lazy = false;
+                
+                // imported images come without a size, their ops are counted as they were
+                if(!resource.m_Imported)
+                {
+                    const VkDeviceSize bytes = static_cast<VkDeviceSize>(resource.m_Desc.m_Width) * resource.m_Desc.m_Height * GetPixelSize(resource.m_Desc.m_Format);
+                    
+                    m_MemoryStats.m_SkippedBytes += access.m_Ops.m_Load != VK_ATTACHMENT_LOAD_OP_LOAD ? bytes : 0;
+                    m_MemoryStats.m_SkippedBytes += access.m_Ops.m_Store != VK_ATTACHMENT_STORE_OP_STORE ? bytes : 0;
+                }
+            }
+            
+            if(access.m_Write)
+                defined[access.m_Resource] = true;
+        }
+    }
+}
+
+bool VulkanRenderGraph::IsReadAfter(ResourceID aResource, uint32_t aPass) const
+{
+    // the next pass to touch the resource decides, a clear there throws the contents away
+    for (uint32_t p = aPass + 1; p < m_Passes.size(); ++p)
+    {
+        if(m_Passes[p].m_Culled)
+            continue;
+        
+        for (const Access& access : m_Passes[p].m_Accesses)
+        {
+            if(access.m_Resource == aResource)
+                return !access.m_Clear;
+        }
+    }
+    
+    const Resource& resource = m_Resources[aResource];
+    return resource.m_Imported && resource.m_FinalUsage != USAGE_NONE;
+}
+
+bool VulkanRenderGraph::RealizeTransients()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    const bool lazyMemory = HasLazyMemory(renderer->GetPhysicalDevice());
+    
+    std::vector<ResourceID> transients;
+    std::vector<uint32_t> key;
+    
+    for (ResourceID i = 0; i < m_Resources.size(); ++i)
+    {
+        const Resource& resource = m_Resources[i];
+        
+        // a transient nothing live touches never gets memory
+        if(resource.m_Imported || resource.m_FirstPass == INVALID_ID)
+            continue;
+        
+        m_Resources[i].m_Lazy = resource.m_Lazy && lazyMemory;
+        transients.push_back(i);
+        
+        key.push_back(resource.m_Desc.m_Width);
+        key.push_back(resource.m_Desc.m_Height);
+        key.push_back(static_cast<uint32_t>(resource.m_Desc.m_Format));
+        key.push_back(resource.m_Desc.m_Usage);
+        key.push_back(resource.m_Desc.m_Aspect);
+        key.push_back(resource.m_Lazy);
+    }
+    
+    // lifetimes are left out of the key, a pass turning on or off moves them all
+    std::vector<uint32_t> aliasingKey;
+    
+    const bool reuse = key == m_TransientKey && m_PhysicalImages.size() == transients.size() &&
+                       GetAliasingKey(transients, aliasingKey) && aliasingKey == m_AliasingKey;
+    
+    if(!reuse)
+    {
+        // the old images are retired, frames still in flight keep drawing to them
+        if(!m_PhysicalImages.empty())
+            ReleaseTransients();
+        
+        VkDevice& device = renderer->GetLogicalDevice();
+        
+        std::vector<VkMemoryRequirements> requirements(transients.size());
+        
+        for (size_t i = 0; i < transients.size(); ++i)
+        {
+            const Resource& resource = m_Resources[transients[i]];
+            const ImageDesc& desc = resource.m_Desc;
+            
+            VkImageCreateInfo imageInfo = {};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = desc.m_Width;
+            imageInfo.extent.height = desc.m_Height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = desc.m_Format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = desc.m_Usage | (resource.m_Lazy ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            
+            PhysicalImage physical = {};
+            physical.m_Desc = desc;
+            
+            if(vkCreateImage(device, &imageInfo, nullptr, &physical.m_Image) != VK_SUCCESS)
+                return false;
+            
+            vkGetImageMemoryRequirements(device, physical.m_Image, &requirements[i]);
+            m_PhysicalImages.push_back(physical);
+        }
+        
+        // biggest first, each image goes in the first block that is large enough and free for its whole lifetime
+        std::vector<size_t> order(transients.size());
+        
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        
+        std::sort(order.begin(), order.end(), [&requirements](size_t a, size_t b) { return requirements[a].size > requirements[b].size; });
+        
+        std::vector<BlockPlacement> placements;
+        
+        for (size_t index : order)
+        {
+            const Resource& resource = m_Resources[transients[index]];
+            const VkMemoryRequirements& requirement = requirements[index];
+            
+            uint32_t block = INVALID_ID;
+            
+            for (uint32_t b = 0; b < placements.size() && block == INVALID_ID; ++b)
+            {
+                const BlockPlacement& placement = placements[b];
+                
+                // lazily allocated memory can only back transient attachments, the two never share
+                if(placement.m_Lazy == resource.m_Lazy && (placement.m_TypeBits & requirement.memoryTypeBits) != 0 &&
+                   placement.m_Size >= requirement.size && !Overlaps(placement, resource.m_FirstPass, resource.m_LastPass))
+                {
+                    block = b;
+                }
+            }
+            
+            if(block == INVALID_ID)
+            {
+                BlockPlacement placement;
+                placement.m_TypeBits = requirement.memoryTypeBits;
+                placement.m_Size = requirement.size;
+                placement.m_Lazy = resource.m_Lazy;
+                
+                placements.push_back(placement);
+                block = static_cast<uint32_t>(placements.size() - 1);
+            }
+            
+            placements[block].m_TypeBits &= requirement.memoryTypeBits;
+            placements[block].m_Lifetimes.push_back(std::make_pair(resource.m_FirstPass, resource.m_LastPass));
+            m_PhysicalImages[index].m_Block = block;
+        }
+        
+        MemoryStats stats = {};
+        
+        for (const VkMemoryRequirements& requirement : requirements)
+        {
+            stats.m_ImageBytes += requirement.size;
+        }
+        
+        for (const BlockPlacement& placement : placements)
+        {
+            const uint32_t noType = std::numeric_limits<uint32_t>::max();
+            
+            uint32_t lazyType = noType;
+            if(placement.m_Lazy)
+                lazyType = VulkanUtils::FindMemoryType(renderer->GetPhysicalDevice(), placement.m_TypeBits,
+                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+            
+            VkMemoryAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize = placement.m_Size;
+            allocInfo.memoryTypeIndex = lazyType;
+            
+            // the images' type bits can still leave out the lazy type
+            if(lazyType == noType)
+                allocInfo.memoryTypeIndex = VulkanUtils::FindMemoryType(renderer->GetPhysicalDevice(), placement.m_TypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            
+            MemoryBlock block = {};
+            block.m_Size = placement.m_Size;
+            block.m_Lazy = lazyType != noType;
+            
+            if(vkAllocateMemory(device, &allocInfo, nullptr, &block.m_Memory) != VK_SUCCESS)
+                return false;
+            
+            m_MemoryBlocks.push_back(block);
+            
+            stats.m_AllocatedBytes += block.m_Size;
+            stats.m_LazyBytes += block.m_Lazy ? block.m_Size : 0;
+        }
+        
+        m_MemoryStats.m_ImageBytes = stats.m_ImageBytes;
+        m_MemoryStats.m_AllocatedBytes = stats.m_AllocatedBytes;
+        m_MemoryStats.m_LazyBytes = stats.m_LazyBytes;
+        
+        for (PhysicalImage& physical : m_PhysicalImages)
+        {
+            // every image starts at the front of its block, the block is as big as its biggest image
+            if(vkBindImageMemory(device, physical.m_Image, m_MemoryBlocks[physical.m_Block].m_Memory, 0) != VK_SUCCESS)
+                return false;
+            
+            if(!VulkanUtils::CreateImageView(physical.m_Image, physical.m_Desc.m_Format, physical.m_Desc.m_Aspect, physical.m_View, 1))
+                return false;
+        }
+        
+        m_TransientKey = key;
+        GetAliasingKey(transients, m_AliasingKey);
+    }
+    
+    for (uint32_t i = 0; i < transients.size(); ++i)
+    {
+        Resource& resource = m_Resources[transients[i]];
+        resource.m_Physical = i;
+        resource.m_ImageHandle = m_PhysicalImages[i].m_Image;
+        resource.m_View = m_PhysicalImages[i].m_View;
+    }
+    
+    return true;
+}
+
+// each transient's block and its place in the block's order, false when two sharing a block overlap
+bool VulkanRenderGraph::GetAliasingKey(const std::vector<ResourceID>& someTransients, std::vector<uint32_t>& outKey) const
+{
+    outKey.assign(someTransients.size() * 2, 0);
+    
+    for (size_t i = 0; i < someTransients.size(); ++i)
+    {
+        const Resource& resource = m_Resources[someTransients[i]];
+        uint32_t order = 0;
+        
+        for (size_t j = 0; j < someTransients.size(); ++j)
+        {
+            if(j == i || m_PhysicalImages[j].m_Block != m_PhysicalImages[i].m_Block)
+                continue;
+            
+            const Resource& other = m_Resources[someTransients[j]];
+            
+            if(resource.m_FirstPass <= other.m_LastPass && other.m_FirstPass <= resource.m_LastPass)
+                return false;
+            
+            if(other.m_FirstPass < resource.m_FirstPass)
+                ++order;
+        }
+        
+        outKey[i * 2] = m_PhysicalImages[i].m_Block;
+        outKey[i * 2 + 1] = order;
+    }
+    
+    return true;
+}
+
+void VulkanRenderGraph::ReleaseTransients()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return;
+    
+    VulkanDeletionQueue* deletionQueue = renderer->GetDeletionQueue();
+    
+    for (PhysicalImage& physical : m_PhysicalImages)
+    {
+        deletionQueue->RetireImageView(physical.m_View);
+        deletionQueue->RetireImage(physical.m_Image);
+    }
+    
+    for (MemoryBlock& block : m_MemoryBlocks)
+    {
+        deletionQueue->RetireMemory(block.m_Memory);
+    }
+    
+    m_PhysicalImages.clear();
+    m_MemoryBlocks.clear();
+    m_TransientKey.clear();
+    m_AliasingKey.clear();
+    
+    m_MemoryStats.m_ImageBytes = 0;
+    m_MemoryStats.m_AllocatedBytes = 0;
+    m_MemoryStats.m_LazyBytes = 0;
+}
+
+void VulkanRenderGraph::BuildBarriers()
+{
+    std::vector<ResourceState> states(m_Resources.size());
+    
+    // the last access of each resource, aliased images wait on whoever had their memory before them
+    std::vector<UsageInfo> lastUsages(m_Resources.size(), GetUsageInfo(USAGE_NONE));
+    
+    for (const Pass& pass : m_Passes)
+    {
+        if(pass.m_Culled)
+            continue;
+        
+        for (const Access& access : pass.m_Accesses)
+        {
+            lastUsages[access.m_Resource] = GetUsageInfo(access.m_Usage);
+        }
+    }
+    
+    std::vector<std::vector<ResourceID>> blockOccupants(m_MemoryBlocks.size());
+    
+    for (ResourceID i = 0; i < m_Resources.size(); ++i)
+    {
+        const Resource& resource = m_Resources[i];
+        
+        if(!resource.m_Imported && resource.m_Physical != INVALID_ID)
+            blockOccupants[m_PhysicalImages[resource.m_Physical].m_Block].push_back(i);
+    }
+    
+    for (std::vector<ResourceID>& occupants : blockOccupants)
+    {
+        std::sort(occupants.begin(), occupants.end(), [this](ResourceID a, ResourceID b) { return m_Resources[a].m_FirstPass < m_Resources[b].m_FirstPass; });
+        
+        // the first occupant follows the last one, from the previous frame using the same memory
+        for (size_t i = 0; i < occupants.size(); ++i)
+        {
+            const ResourceID previous = occupants[(i + occupants.size() - 1) % occupants.size()];
+            const UsageInfo& previousUsage = lastUsages[previous];
+            
+            ResourceState& state = states[occupants[i]];
+            state.m_WriteStages = previousUsage.m_Stage;
+            state.m_WriteAccess = previousUsage.m_Access & ourWriteAccess;
+            state.m_Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+    }
+    
+    for (ResourceID i = 0; i < m_Resources.size(); ++i)
+    {
+        const Resource& resource = m_Resources[i];
+        
+        if(!resource.m_Imported)
+            continue;
+        
+        const UsageInfo& initial = GetUsageInfo(resource.m_InitialUsage);
+        
+        ResourceState& state = states[i];
+        state.m_WriteStages = resource.m_InitialUsage != USAGE_NONE ? initial.m_Stage : 0;
+        state.m_WriteAccess = initial.m_Access & ourWriteAccess;
+        state.m_Layout = initial.m_Layout;
+    }
+    
+    m_PassBarriers.assign(m_Passes.size(), BarrierBatch());
+    m_FinalBarriers = BarrierBatch();
+    m_BarrierCount = 0;
+    
+    for (size_t p = 0; p < m_Passes.size(); ++p)
+    {
+        const Pass& pass = m_Passes[p];
+        
+        if(pass.m_Culled)
+            continue;
+        
+        // one transition per resource per pass, a pass that reads and writes the same thing wants both at once
+        std::vector<ResourceID> resources;
+        std::vector<UsageInfo> usages;
+        std::vector<bool> writes;
+        
+        for (const Access& access : pass.m_Accesses)
+        {
+            const UsageInfo& usage = GetUsageInfo(access.m_Usage);
+            auto it = std::find(resources.begin(), resources.end(), access.m_Resource);
+            
+            if(it == resources.end())
+            {
+                resources.push_back(access.m_Resource);
+                usages.push_back(usage);
+                writes.push_back(access.m_Write);
+                continue;
+            }
+            
+            const size_t index = it - resources.begin();
+            usages[index].m_Stage |= usage.m_Stage;
+            usages[index].m_Access |= usage.m_Access;
+            
+            if(access.m_Write)
+            {
+                usages[index].m_Layout = usage.m_Layout;
+                writes[index] = true;
+            }
+        }
+        
+        for (size_t i = 0; i < resources.size(); ++i)
+        {
+            AddTransition(m_PassBarriers[p], states[resources[i]], resources[i], usages[i], writes[i]);
+        }
+    }
+    
+    for (ResourceID i = 0; i < m_Resources.size(); ++i)
+    {
+        const Resource& resource = m_Resources[i];
+        
+        if(resource.m_Imported && resource.m_FinalUsage != USAGE_NONE)
+            AddTransition(m_FinalBarriers, states[i], i, GetUsageInfo(resource.m_FinalUsage), false);
+    }
+}
+
+void VulkanRenderGraph::AddTransition(BarrierBatch& aBatch, ResourceState& aState, ResourceID aResource, const UsageInfo& aUsage, bool aWrite)
+{
+    const bool image = m_Resources[aResource].m_Image;
+    const bool layoutChange = image && aState.m_Layout != aUsage.m_Layout;
+    
+    VkPipelineStageFlags srcStages = 0;
+    VkAccessFlags srcAccess = 0;
+    bool needed = false;
+    
+    if(aWrite || layoutChange)
+    {
+        // write after write and write after read, a layout transition counts as a write
+        srcStages = aState.m_WriteStages | aState.m_ReadStages;
+        srcAccess = aState.m_WriteAccess;
+        needed = srcStages != 0 || layoutChange;
+    }
+    else if(aState.m_WriteStages != 0 && ((aUsage.m_Stage & ~aState.m_ReadStages) != 0 || (aUsage.m_Access & ~aState.m_ReadAccess) != 0))
+    {
+        // read after write, the write has not been made visible to this reader yet
+        srcStages = aState.m_WriteStages;
+        srcAccess = aState.m_WriteAccess;
+        needed = true;
+    }
+    
+    if(needed)
+    {
+        aBatch.m_SrcStages |= srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        aBatch.m_DstStages |= aUsage.m_Stage;
+        
+        if(image)
+        {
+            ImageBarrier barrier = { aResource, aState.m_Layout, aUsage.m_Layout, srcAccess, aUsage.m_Access };
+            aBatch.m_Images.push_back(barrier);
+        }
+        else
+        {
+            BufferBarrier barrier = { aResource, srcAccess, aUsage.m_Access };
+            aBatch.m_Buffers.push_back(barrier);
+        }
+        
+        ++m_BarrierCount;
+    }
+    
+    if(aWrite)
+    {
+        aState.m_WriteStages = aUsage.m_Stage;
+        aState.m_WriteAccess = aUsage.m_Access & ourWriteAccess;
+        aState.m_ReadStages = 0;
+        aState.m_ReadAccess = 0;
+    }
+    else if(layoutChange)
+    {
+        // later readers in other stages still have to wait on the transition
+        aState.m_WriteStages = aUsage.m_Stage;
+        aState.m_WriteAccess = 0;
+        aState.m_ReadStages = aUsage.m_Stage;
+        aState.m_ReadAccess = aUsage.m_Access;
+    }
+    else
+    {
+        aState.m_ReadStages |= aUsage.m_Stage;
+        aState.m_ReadAccess |= needed ? aUsage.m_Access : 0;
+    }
+    
+    aState.m_Layout = image ? aUsage.m_Layout : aState.m_Layout;
+}
+
+void VulkanRenderGraph::Execute(VkCommandBuffer aCmdBuffer)
+{
+    for (size_t i = 0; i < m_Passes.size(); ++i)
+    {
+        const Pass& pass = m_Passes[i];
+        
+        if(pass.m_Culled)
+            continue;
+        
+        RecordBarriers(aCmdBuffer, m_PassBarriers[i]);
+        
+        if(pass.m_Execute)
+            pass.m_Execute(aCmdBuffer);
+    }
+    
+    RecordBarriers(aCmdBuffer, m_FinalBarriers);
+}
+
+void VulkanRenderGraph::RecordBarriers(VkCommandBuffer aCmdBuffer, const BarrierBatch& aBatch) const
+{
+    if(aBatch.m_Images.empty() && aBatch.m_Buffers.empty())
+        return;
+    
+    std::vector<VkImageMemoryBarrier> imageBarriers(aBatch.m_Images.size());
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(aBatch.m_Buffers.size());
+    
+    for (size_t i = 0; i < aBatch.m_Images.size(); ++i)
+    {
+        const ImageBarrier& source = aBatch.m_Images[i];
+        const Resource& resource = m_Resources[source.m_Resource];
+        
+        VkImageMemoryBarrier& barrier = imageBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = source.m_OldLayout;
+        barrier.newLayout = source.m_NewLayout;
+        barrier.srcAccessMask = source.m_SrcAccess;
+        barrier.dstAccessMask = source.m_DstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.m_ImageHandle;
+        barrier.subresourceRange.aspectMask = resource.m_Desc.m_Aspect;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    }
+    
+    for (size_t i = 0; i < aBatch.m_Buffers.size(); ++i)
+    {
+        const BufferBarrier& source = aBatch.m_Buffers[i];
+        
+        VkBufferMemoryBarrier& barrier = bufferBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = source.m_SrcAccess;
+        barrier.dstAccessMask = source.m_DstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = m_Resources[source.m_Resource].m_Buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+    
+    vkCmdPipelineBarrier(aCmdBuffer,
+                         aBatch.m_SrcStages, aBatch.m_DstStages,
+                         0,
+                         0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+VkImage VulkanRenderGraph::GetImage(ResourceID aResource) const
+{
+    return aResource < m_Resources.size() ? m_Resources[aResource].m_ImageHandle : VK_NULL_HANDLE;
+}
+
+VkImageView VulkanRenderGraph::GetImageView(ResourceID aResource) const
+{
+    return aResource < m_Resources.size() ? m_Resources[aResource].m_View : VK_NULL_HANDLE;
+}
+
+VulkanRenderGraph::AttachmentOps VulkanRenderGraph::GetAttachmentOps(PassID aPass, ResourceID aResource) const
+{
+    AttachmentOps ops = { VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE };
+    
+    if(aPass >= m_Passes.size())
+        return ops;
+    
+    for (const Access& access : m_Passes[aPass].m_Accesses)
+    {
+        if(access.m_Resource != aResource)
+            continue;
+        
+        // a pass that reads and writes the same attachment needs the strongest of the two
+        if(access.m_Ops.m_Load == VK_ATTACHMENT_LOAD_OP_LOAD || ops.m_Load == VK_ATTACHMENT_LOAD_OP_DONT_CARE)
+            ops.m_Load = access.m_Ops.m_Load;
+        
+        if(access.m_Ops.m_Store == VK_ATTACHMENT_STORE_OP_STORE)
+            ops.m_Store = VK_ATTACHMENT_STORE_OP_STORE;
+    }
+    
+    return ops;
+}
@@ -0,0 +1,243 @@
+//
+//  VulkanRenderGraph.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanRenderGraph_hpp
+#define VulkanRenderGraph_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <functional>
+
+// A frame's passes and the resources they touch, declared every frame and compiled
+// into the work that actually has to run.
+//
+// Passes say what they read and write and how (ResourceUsage), never how to sync it.
+// Compile then
+//  - culls passes whose writes nothing reaches, an output is an imported resource with a final usage
+//  - derives the barriers between passes from the usages and batches each pass's into one vkCmdPipelineBarrier
+//  - creates the transient images and aliases ones whose lifetimes do not overlap onto the same memory
+//  - picks each attachment's load and store ops from what comes before and after it, an image that is
+//    never loaded or stored is a transient attachment in lazily allocated memory when the device has it
+//
+// Passes run in the order they were added. Transient images are kept between frames
+// and only made again when the transients declared change, e.g. on a resize. Passes
+// coming and going only shift lifetimes, the images stay as long as the ones sharing
+// memory still do not overlap and keep their order.
+class VulkanRenderGraph
+{
+public:
+    typedef uint32_t ResourceID;
+    typedef uint32_t PassID;
+    typedef std::function<void(VkCommandBuffer)> ExecuteFunc;
+    
+    static const uint32_t INVALID_ID = 0xffffffff;
+    
+    enum ResourceUsage
+    {
+        USAGE_NONE,                     // nothing before or after the frame, contents are discarded
+        USAGE_SWAPCHAIN_ACQUIRE,        // just acquired, waited on at colour attachment output
+        USAGE_SWAPCHAIN_ACQUIRE_BLIT,   // just acquired, waited on at transfer, for frames drawn offscreen and blitted to it
+        USAGE_PRESENT,
+        USAGE_COLOR_ATTACHMENT,
+        USAGE_DEPTH_ATTACHMENT,
+        USAGE_DEPTH_READ,               // depth test without writes
+        USAGE_SAMPLED_FRAGMENT,
+        USAGE_SAMPLED_COMPUTE,
+        USAGE_STORAGE_COMPUTE,
+        USAGE_INDIRECT,
+        USAGE_VERTEX,
+        USAGE_TRANSFER_SRC,
+        USAGE_TRANSFER_DST,
+        
+        USAGE_NUM
+    };
+    
+    struct ImageDesc
+    {
+        uint32_t            m_Width;
+        uint32_t            m_Height;
+        VkFormat            m_Format;
+        VkImageUsageFlags   m_Usage;
+        VkImageAspectFlags  m_Aspect;
+    };
+    
+    struct AttachmentOps
+    {
+        bool operator==(const AttachmentOps& other) const;
+        
+        VkAttachmentLoadOp  m_Load;
+        VkAttachmentStoreOp m_Store;
+    };
+    
+    struct MemoryStats
+    {
+        bool operator==(const MemoryStats& other) const;
+        
+        VkDeviceSize    m_ImageBytes;       // what the transients would take on their own
+        VkDeviceSize    m_AllocatedBytes;   // after aliasing, lazily allocated blocks included
+        VkDeviceSize    m_LazyBytes;        // may never be backed on a tiler
+        VkDeviceSize    m_SkippedBytes;     // attachment loads and stores a frame the ops leave out
+    };
+    
+    VulkanRenderGraph();
+    ~VulkanRenderGraph();
+    
+    void Shutdown();
+    
+    // drops the frame's declarations, the transient images stay for the next Compile
+    void Reset();
+    
+    ResourceID CreateImage(const char* aName, const ImageDesc& aDesc);
+    ResourceID ImportImage(const char* aName, VkImage anImage, VkImageAspectFlags anAspect,
+                           ResourceUsage anInitialUsage, ResourceUsage aFinalUsage = USAGE_NONE);
+    ResourceID ImportBuffer(const char* aName, VkBuffer aBuffer,
+                            ResourceUsage anInitialUsage = USAGE_NONE, ResourceUsage aFinalUsage = USAGE_NONE);
+    
+    PassID AddPass(const char* aName, const ExecuteFunc& anExecute);
+    void Read(PassID aPass, ResourceID aResource, ResourceUsage aUsage);
+    // a cleared attachment does not care what was there before
+    void Write(PassID aPass, ResourceID aResource, ResourceUsage aUsage, bool aClear = false);
+    
+    bool Compile();
+    void Execute(VkCommandBuffer aCmdBuffer);
+    
+    // valid after Compile until the transients change, null for a culled resource
+    VkImage     GetImage(ResourceID aResource) const;
+    VkImageView GetImageView(ResourceID aResource) const;
+    
+    // waits for nothing, the caller makes sure no frame in flight still uses them
+    void ReleaseTransients();
+    
+    // valid after Compile, for the render pass the attachment is used in
+    AttachmentOps GetAttachmentOps(PassID aPass, ResourceID aResource) const;
+    
+    bool IsPassCulled(PassID aPass) const { return m_Passes[aPass].m_Culled; }
+    uint32_t GetBarrierCount() const { return m_BarrierCount; }
+    const MemoryStats& GetMemoryStats() const { return m_MemoryStats; }
+
+private:
+    struct UsageInfo
+    {
+        VkPipelineStageFlags    m_Stage;
+        VkAccessFlags           m_Access;
+        VkImageLayout           m_Layout;
+    };
+    
+    struct Access
+    {
+        ResourceID      m_Resource;
+        ResourceUsage   m_Usage;
+        bool            m_Write;
+        bool            m_Clear;
+        AttachmentOps   m_Ops;
+    };
+    
+    struct Resource
+    {
+        const char*         m_Name;
+        bool                m_Image;
+        bool                m_Imported;
+        ImageDesc           m_Desc;
+        VkImage             m_ImageHandle;
+        VkImageView         m_View;
+        VkBuffer            m_Buffer;
+        ResourceUsage       m_InitialUsage;
+        ResourceUsage       m_FinalUsage;
+        
+        // filled in by Compile
+        uint32_t            m_FirstPass;
+        uint32_t            m_LastPass;
+        uint32_t            m_Physical;
+        bool                m_Lazy;
+    };
+    
+    struct Pass
+    {
+        const char*         m_Name;
+        ExecuteFunc         m_Execute;
+        std::vector<Access> m_Accesses;
+        bool                m_Culled;
+    };
+    
+    struct ImageBarrier
+    {
+        ResourceID      m_Resource;
+        VkImageLayout   m_OldLayout;
+        VkImageLayout   m_NewLayout;
+        VkAccessFlags   m_SrcAccess;
+        VkAccessFlags   m_DstAccess;
+    };
+    
+    struct BufferBarrier
+    {
+        ResourceID      m_Resource;
+        VkAccessFlags   m_SrcAccess;
+        VkAccessFlags   m_DstAccess;
+    };
+    
+    struct BarrierBatch
+    {
+        VkPipelineStageFlags        m_SrcStages;
+        VkPipelineStageFlags        m_DstStages;
+        std::vector<ImageBarrier>   m_Images;
+        std::vector<BufferBarrier>  m_Buffers;
+    };
+    
+    // where a resource was left, what has been made visible to whom since the last write
+    struct ResourceState
+    {
+        VkPipelineStageFlags    m_WriteStages;
+        VkAccessFlags           m_WriteAccess;
+        VkPipelineStageFlags    m_ReadStages;
+        VkAccessFlags           m_ReadAccess;
+        VkImageLayout           m_Layout;
+    };
+    
+    // a transient image, several may share one memory block
+    struct PhysicalImage
+    {
+        ImageDesc       m_Desc;
+        VkImage         m_Image;
+        VkImageView     m_View;
+        uint32_t        m_Block;
+    };
+    
+    struct MemoryBlock
+    {
+        VkDeviceMemory  m_Memory;
+        VkDeviceSize    m_Size;
+        bool            m_Lazy;
+    };
+    
+    static const UsageInfo& GetUsageInfo(ResourceUsage aUsage);
+    
+    void CullPasses();
+    void ComputeLifetimes();
+    void ComputeAttachmentOps();
+    bool IsReadAfter(ResourceID aResource, uint32_t aPass) const;
+    bool RealizeTransients();
+    bool GetAliasingKey(const std::vector<ResourceID>& someTransients, std::vector<uint32_t>& outKey) const;
+    void BuildBarriers();
+    void AddTransition(BarrierBatch& aBatch, ResourceState& aState, ResourceID aResource, const UsageInfo& aUsage, bool aWrite);
+    void RecordBarriers(VkCommandBuffer aCmdBuffer, const BarrierBatch& aBatch) const;
+    
+    std::vector<Resource>       m_Resources;
+    std::vector<Pass>           m_Passes;
+    std::vector<BarrierBatch>   m_PassBarriers;
+    BarrierBatch                m_FinalBarriers;
+    uint32_t                    m_BarrierCount;
+    MemoryStats                 m_MemoryStats;
+    
+    // what the physical images were made for and how they share memory, a different key means they are made again
+    std::vector<uint32_t>       m_TransientKey;
+    std::vector<uint32_t>       m_AliasingKey;
+    std::vector<PhysicalImage>  m_PhysicalImages;
+    std::vector<MemoryBlock>    m_MemoryBlocks;
+};
+
+#endif /* VulkanRenderGraph_hpp */
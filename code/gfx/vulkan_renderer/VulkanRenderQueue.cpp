@@ -0,0 +1,139 @@
+//
+//  VulkanRenderQueue.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanRenderQueue.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // non dispatchable handles are pointers on 64 bit and uint64_t on 32 bit
+    template<typename Handle>
+    uint64_t GetHandleKey(Handle aHandle)
+    {
+        uint64_t key = 0;
+        memcpy(&key, &aHandle, sizeof(aHandle));
+        return key;
+    }
+    
+    // everything HasSameBindings compares, a new dynamic offset or material counts as a
+    // different set. the ids only order draws so a collision just sorts worse
+    uint64_t GetBindingsKey(const VulkanDrawItem& aDraw)
+    {
+        const uint64_t prime = 1099511628211ull;
+        
+        uint64_t key = GetHandleKey(aDraw.m_DescriptorSet);
+        key = (key * prime) ^ aDraw.m_DynamicOffset;
+        key = (key * prime) ^ GetHandleKey(aDraw.m_BindlessSet);
+        key = (key * prime) ^ aDraw.m_Material.m_TextureIndex;
+        key = (key * prime) ^ aDraw.m_Material.m_SamplerIndex;
+        
+        return key;
+    }
+}
+
+//---------------------------------------------------------------------------
+// BindStats
+//---------------------------------------------------------------------------
+VulkanRenderQueue::BindStats::BindStats()
+: m_Pipelines(0)
+, m_DescriptorSets(0)
+, m_Meshes(0)
+{
+}
+
+bool VulkanRenderQueue::BindStats::operator== (const BindStats& other) const
+{
+    return m_Pipelines == other.m_Pipelines && m_DescriptorSets == other.m_DescriptorSets && m_Meshes == other.m_Meshes;
+}
+
+//---------------------------------------------------------------------------
+// VulkanRenderQueue
+//---------------------------------------------------------------------------
+VulkanRenderQueue::VulkanRenderQueue()
+{
+}
+
+VulkanRenderQueue::~VulkanRenderQueue()
+{
+}
+
+void VulkanRenderQueue::Begin()
+{
+    m_Draws.clear();
+    m_Keys.clear();
+}
+
+uint32_t VulkanRenderQueue::GetId(IdMap& someIds, uint64_t aHandle, uint32_t aBits)
+{
+    IdMap::const_iterator idItr = someIds.find(aHandle);
+    
+    if(idItr != someIds.end())
+        return idItr->second;
+    
+    // out of ids, start over. draws only sort worse for the frame, they still draw
+    if(someIds.size() >= (1u << aBits))
+        someIds.clear();
+    
+    const uint32_t id = static_cast<uint32_t>(someIds.size());
+    someIds[aHandle] = id;
+    
+    return id;
+}
+
+uint32_t VulkanRenderQueue::Add(const VulkanDrawItem& aDraw, float aDepth, uint32_t aPass)
+{
+    const uint64_t pass = aPass & ((1u << PASS_BITS) - 1);
+    const uint64_t pipeline = GetId(m_PipelineIds, GetHandleKey(aDraw.m_Pipeline), PIPELINE_BITS);
+    const uint64_t descriptorSet = GetId(m_DescriptorIds, GetBindingsKey(aDraw), DESCRIPTOR_BITS);
+    const uint64_t mesh = GetId(m_MeshIds, GetHandleKey(aDraw.m_Model), MESH_BITS);
+    const uint64_t depth = static_cast<uint64_t>(std::min(std::max(aDepth, 0.0f), 1.0f) * ((1u << DEPTH_BITS) - 1));
+    
+    uint64_t key = pass;
+    key = (key << PIPELINE_BITS) | pipeline;
+    key = (key << DESCRIPTOR_BITS) | descriptorSet;
+    key = (key << MESH_BITS) | mesh;
+    key = (key << DEPTH_BITS) | depth;
+    
+    const uint32_t index = static_cast<uint32_t>(m_Draws.size());
+    
+    m_Draws.push_back(aDraw);
+    m_Keys.push_back({ key, index });
+    
+    return index;
+}
+
+template<typename Func>
+VulkanRenderQueue::BindStats VulkanRenderQueue::CountBinds(const Func& aGetDraw) const
+{
+    BindStats stats;
+    const VulkanDrawItem* previous = nullptr;
+    
+    for (size_t i = 0; i < m_Draws.size(); ++i)
+    {
+        const VulkanDrawItem& draw = aGetDraw(i);
+        
+        stats.m_Pipelines += !previous || previous->m_Pipeline != draw.m_Pipeline;
+        stats.m_DescriptorSets += !previous || !previous->HasSameBindings(draw);
+        stats.m_Meshes += !previous || previous->m_Model != draw.m_Model;
+        
+        previous = &draw;
+    }
+    
+    return stats;
+}
+
+void VulkanRenderQueue::Sort(Core_JobSystem* aJobs)
+{
+    m_SubmitStats = CountBinds([this](size_t anIndex) -> const VulkanDrawItem& { return m_Draws[anIndex]; });
+    
+    Core_RadixSort::Sort(m_Keys, m_Scratch, aJobs);
+    
+    m_SortedStats = CountBinds([this](size_t anIndex) -> const VulkanDrawItem& { return m_Draws[m_Keys[anIndex].m_Value]; });
+}
@@ -0,0 +1,85 @@
+//
+//  VulkanRenderQueue.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanRenderQueue_hpp
+#define VulkanRenderQueue_hpp
+
+#include "VulkanCommon.hpp"
+#include "VulkanCommandRecorder.hpp"
+
+#include "Core_RadixSort.hpp"
+
+// A frame's draws ordered by one packed 64 bit key, most significant field first:
+//
+//   pass (4) | pipeline (12) | descriptor set (16) | mesh (16) | depth bucket (16)
+//
+// so a radix sort on the key groups draws by the state that is most expensive to
+// change, and draws sharing all of it come out front to back. Handles are mapped to
+// small ids the first time they are seen, the ids are only used for ordering.
+class VulkanRenderQueue
+{
+public:
+    // binds the recorder would emit for a draw order, it only binds on a change
+    struct BindStats
+    {
+        BindStats();
+        
+        uint32_t GetTotal() const { return m_Pipelines + m_DescriptorSets + m_Meshes; }
+        bool operator== (const BindStats& other) const;
+        
+        uint32_t m_Pipelines;
+        uint32_t m_DescriptorSets;
+        uint32_t m_Meshes;
+    };
+    
+    VulkanRenderQueue();
+    ~VulkanRenderQueue();
+    
+    void Begin();
+    
+    // aDepth is 0 at the near plane and 1 at the far one, returns the draw's submit index
+    uint32_t Add(const VulkanDrawItem& aDraw, float aDepth, uint32_t aPass = 0);
+    
+    void Sort(Core_JobSystem* aJobs = nullptr);
+    
+    // sorted keys, m_Value is the submit index
+    const std::vector<Core_SortKey>&    GetSortedKeys() const { return m_Keys; }
+    const VulkanDrawItem&               GetDraw(uint32_t anIndex) const { return m_Draws[anIndex]; }
+    uint32_t                            GetDrawCount() const { return static_cast<uint32_t>(m_Draws.size()); }
+    
+    // filled in by Sort, in the order draws were added and in key order
+    const BindStats& GetSubmitStats() const { return m_SubmitStats; }
+    const BindStats& GetSortedStats() const { return m_SortedStats; }
+
+private:
+    static const uint32_t PASS_BITS = 4;
+    static const uint32_t PIPELINE_BITS = 12;
+    static const uint32_t DESCRIPTOR_BITS = 16;
+    static const uint32_t MESH_BITS = 16;
+    static const uint32_t DEPTH_BITS = 16;
+    
+    typedef std::unordered_map<uint64_t, uint32_t> IdMap;
+    
+    static uint32_t GetId(IdMap& someIds, uint64_t aHandle, uint32_t aBits);
+    
+    template<typename Func>
+    BindStats CountBinds(const Func& aGetDraw) const;
+    
+    std::vector<VulkanDrawItem> m_Draws;
+    std::vector<Core_SortKey>   m_Keys;
+    std::vector<Core_SortKey>   m_Scratch;
+    
+    IdMap   m_PipelineIds;
+    IdMap   m_DescriptorIds;
+    IdMap   m_MeshIds;
+    
+    BindStats   m_SubmitStats;
+    BindStats   m_SortedStats;
+};
+
+#endif /* VulkanRenderQueue_hpp */
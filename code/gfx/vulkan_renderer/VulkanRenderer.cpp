@@ -8,17 +8,167 @@
 
 #include "VulkanRenderer.hpp"
 #include "VulkanShader.hpp"
+#include "VulkanShaderLibrary.hpp"
+#include "VulkanLayoutCache.hpp"
+#include "VulkanPipelineManager.hpp"
+#include "VulkanCommandRecorder.hpp"
+#include "VulkanInstanceBatcher.hpp"
+#include "VulkanUniformAllocator.hpp"
+#include "VulkanDescriptorAllocator.hpp"
+#include "VulkanBindlessTable.hpp"
+#include "VulkanGpuCuller.hpp"
+#include "VulkanDepthPyramid.hpp"
+#include "VulkanGpuTimer.hpp"
+#include "VulkanResolutionScaler.hpp"
+#include "VulkanTimeline.hpp"
+#include "VulkanDeletionQueue.hpp"
+#include "VulkanRenderGraph.hpp"
 #include "VulkanModel.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanUtils.hpp"
 
+#include "Scene_Frustum.hpp"
+#include "Scene_FrustumCuller.hpp"
+#include "Scene_OcclusionCuller.hpp"
+
+#include "Core_JobSystem.hpp"
 #include "Core_Utils.hpp"
 #include "GLWindow.hpp"
 
+#include <algorithm>
+
 const char* MODEL_PATH = "../data/models/chalet.obj";
+const char* OCCLUDER_MODEL_PATH = "../data/models/chalet_occluder.obj";
 const char* TEXTURE_PATH = "../data/textures/chalet.jpg";
-const char* VERT_SHADER_PATH = "../data/shaders/compiled/vert.spv";
+const char* VERT_INSTANCED_SHADER_PATH = "../data/shaders/compiled/vert_instanced.spv";
+const char* VERT_DEPTH_PREPASS_SHADER_PATH = "../data/shaders/compiled/vert_depth_prepass.spv";
 const char* FRAG_SHADER_PATH = "../data/shaders/compiled/frag.spv";
+const char* FRAG_BINDLESS_SHADER_PATH = "../data/shaders/compiled/frag_bindless.spv";
+const char* CULL_SHADER_PATH = "../data/shaders/compiled/cull.spv";
+const char* OCCLUSION_CULL_SHADER_PATH = "../data/shaders/compiled/cull_occlusion.spv";
+const char* HIZ_SHADER_PATH = "../data/shaders/compiled/hiz.spv";
+const char* PIPELINE_CACHE_PATH = "../data/pipeline_cache.bin";
+const char* PIPELINE_WARMUP_PATH = "../data/pipeline_warmup.txt";
+
+// houses per side, every copy goes out in the same instanced draw. the grid runs away from
+// the camera from the house it looks at, so the front rows hide the ones behind
+const int HOUSE_GRID_SIZE = 5;
+const float HOUSE_GRID_SPACING = 2.5f;
+
+// upper bound for the gpu culled path, sized per frame in flight
+const uint32_t MAX_GPU_OBJECTS = 16384;
+
+// for weak gpus, skip the gpu cull and occlude on the cpu instead
+const bool PREFER_CPU_OCCLUSION = false;
+
+// the software occlusion buffer, coarse is fine since a miss only costs a draw
+// without an occluder mesh the house hides what its bounds shrunk to this share per axis would,
+// around the centre so the roof and porch are left out and it stays inside the walls
+const float OCCLUDER_BOX_SCALE = 0.5f;
+const uint32_t OCCLUSION_BUFFER_WIDTH = 256;
+const uint32_t OCCLUSION_BUFFER_HEIGHT = 128;
+
+// estimated overdraw where the auto depth pre-pass turns on and back off, apart so it does not flicker
+const float DEPTH_PREPASS_ON_OVERDRAW = 2.0f;
+const float DEPTH_PREPASS_OFF_OVERDRAW = 1.5f;
+
+// gpu time a frame may take before the render resolution drops, and the lowest it drops to per axis
+const float DYNAMIC_RESOLUTION_BUDGET_MS = 16.0f;
+const float DYNAMIC_RESOLUTION_MIN_SCALE = 0.5f;
+
+// until told otherwise, one frame recording while another renders
+const int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+// the house turns slowly, with it off the scene is static and rendering on demand idles
+const bool ROTATE_HOUSE = true;
+
+// uniform data a frame can allocate, the view constants plus whatever per object data needs it
+const VkDeviceSize UNIFORM_RING_FRAME_SIZE = 64 * 1024;
+
+namespace
+{
+    // model space bounding sphere to world space, the radius takes the largest axis scale
+    glm::vec4 TransformSphere(const glm::mat4& aTransform, const glm::vec4& aSphere)
+    {
+        const glm::vec3 center = glm::vec3(aTransform * glm::vec4(glm::vec3(aSphere), 1.0f));
+        const float scale = glm::max(glm::length(glm::vec3(aTransform[0])), glm::max(glm::length(glm::vec3(aTransform[1])), glm::length(glm::vec3(aTransform[2]))));
+        
+        return glm::vec4(center, aSphere.w * scale);
+    }
+    
+    // share of the screen the projected box covers, zero to one. a box reaching behind the
+    // camera counts as the whole screen, it overestimates which only errs towards the pre-pass
+    float GetScreenCoverage(const glm::mat4& aWorldViewProj, const Scene_Aabb& aBox)
+    {
+        glm::vec2 ndcMin(FLT_MAX);
+        glm::vec2 ndcMax(-FLT_MAX);
+        int behind = 0;
+        
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const glm::vec3 position((corner & 1) ? aBox.m_Max.x : aBox.m_Min.x,
+                                     (corner & 2) ? aBox.m_Max.y : aBox.m_Min.y,
+                                     (corner & 4) ? aBox.m_Max.z : aBox.m_Min.z);
+            
+            const glm::vec4 clip = aWorldViewProj * glm::vec4(position, 1.0f);
+            
+            if(clip.w <= 0.0f)
+            {
+                ++behind;
+                continue;
+            }
+            
+            const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        
+        if(behind > 0)
+            return behind == 8 ? 0.0f : 1.0f;
+        
+        ndcMin = glm::clamp(ndcMin, glm::vec2(-1.0f), glm::vec2(1.0f));
+        ndcMax = glm::clamp(ndcMax, glm::vec2(-1.0f), glm::vec2(1.0f));
+        
+        const glm::vec2 size = ndcMax - ndcMin;
+        return size.x * size.y * 0.25f;
+    }
+    
+    // the box scaled about its centre as 12 triangles, the culler draws both windings so the order is free
+    void BuildOccluderBox(const Scene_Aabb& aBox, float aScale, std::vector<glm::vec3>& outPositions, std::vector<uint32_t>& outIndices)
+    {
+        static const uint32_t ourBoxIndices[] =
+        {
+            0, 1, 3, 0, 3, 2,   // -x
+            4, 6, 7, 4, 7, 5,   // +x
+            0, 4, 5, 0, 5, 1,   // -y
+            2, 3, 7, 2, 7, 6,   // +y
+            0, 2, 6, 0, 6, 4,   // -z
+            1, 5, 7, 1, 7, 3,   // +z
+        };
+        
+        const glm::vec3 center = aBox.GetCenter();
+        const glm::vec3 extents = aBox.GetExtents() * aScale;
+        
+        outPositions.clear();
+        
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            outPositions.push_back(center + glm::vec3((corner & 4) ? extents.x : -extents.x,
+                                                      (corner & 2) ? extents.y : -extents.y,
+                                                      (corner & 1) ? extents.z : -extents.z));
+        }
+        
+        outIndices.assign(ourBoxIndices, ourBoxIndices + sizeof(ourBoxIndices) / sizeof(ourBoxIndices[0]));
+    }
+    
+    // the main pass after a depth pre-pass, only the nearest surface passes and nothing is written twice
+    VulkanPipelineState WithDepthEqual(VulkanPipelineState aState)
+    {
+        aState.m_DepthWrite = false;
+        aState.m_DepthCompareOp = VK_COMPARE_OP_EQUAL;
+        return aState;
+    }
+}
 
 VulkanRenderer* VulkanRenderer::ourInstance = nullptr;
 
@@ -28,9 +178,70 @@ VulkanRenderer* VulkanRenderer::ourInstance = nullptr;
 VulkanRenderer::VulkanRenderer(IWindow* aWindow)
  : IRenderer(aWindow)
  , m_PhysicalDevice(VK_NULL_HANDLE)
+ , m_SwapChain(VK_NULL_HANDLE)
+ , m_SwapChainBlitTarget(false)
  , m_VKInstCreated(false)
  , m_VKDeviceCreated(false)
  , m_CurrentFrame(0)
+ , m_FramesInFlight(DEFAULT_FRAMES_IN_FLIGHT)
+ , m_WindowChangedID(-1)
+ , m_SwapChainDirty(false)
+ , m_PresentMode(PRESENT_MODE_LOW_LATENCY)
+ , m_FrameBegun(false)
+ , m_ImageIndex(0)
+ , m_HasPendingInput(false)
+ , m_LatencyFrames(0)
+ , m_LatencyTotalMilliseconds(0.0)
+ , m_LatencyWorstMilliseconds(0.0f)
+ , m_GraphicsTimeline(nullptr)
+ , m_DeletionQueue(nullptr)
+ , m_DescriptorAllocator(nullptr)
+ , m_RenderGraph(nullptr)
+ , m_FramebufferColorView(VK_NULL_HANDLE)
+ , m_FramebufferDepthView(VK_NULL_HANDLE)
+ , m_BackBufferID(VulkanRenderGraph::INVALID_ID)
+ , m_ColorTargetID(VulkanRenderGraph::INVALID_ID)
+ , m_DepthID(VulkanRenderGraph::INVALID_ID)
+ , m_PrepassID(VulkanRenderGraph::INVALID_ID)
+ , m_MainPassID(VulkanRenderGraph::INVALID_ID)
+ , m_LatePassID(VulkanRenderGraph::INVALID_ID)
+ , m_AttachmentMemoryStats()
+ , m_DescriptorSet(VK_NULL_HANDLE)
+ , m_BindlessTable(nullptr)
+ , m_BindlessPipelineLayout(VK_NULL_HANDLE)
+ , m_HouseMaterial()
+ , m_UniformAllocator(nullptr)
+ , m_ViewConstantsOffset(0)
+ , m_ShaderLibrary(nullptr)
+ , m_LayoutCache(nullptr)
+ , m_PipelineBuilder(nullptr)
+ , m_PipelineManager(nullptr)
+ , m_GpuTimer(nullptr)
+ , m_ResolutionScaler(nullptr)
+ , m_RenderExtent({0, 0})
+ , m_ReportedRenderExtent({0, 0})
+ , m_FullScaleFrame(false)
+ , m_CommandRecorder(nullptr)
+ , m_InstanceBatcher(nullptr)
+ , m_GpuCuller(nullptr)
+ , m_DepthPyramid(nullptr)
+ , m_CullStats()
+ , m_FrustumCuller(nullptr)
+ , m_OcclusionCuller(nullptr)
+ , m_HouseOccluderMesh(0)
+ , m_OcclusionStats()
+ , m_HouseOccluderModel(nullptr)
+ , m_DepthPrepassMode(DEPTH_PREPASS_AUTO)
+ , m_DepthPrepassWanted(false)
+ , m_ReportedDepthPrepass(false)
+ , m_EstimatedOverdraw(0.0f)
+ , m_DepthPrepassActive(false)
+ , m_HouseTransform(1.0f)
+ , m_ViewProj(1.0f)
+ , m_ViewConstants()
+ , m_SubmittedHouseTransform(1.0f)
+ , m_SubmittedViewProj(1.0f)
+ , m_HasDeviceProperties2(false)
 {
 }
 
@@ -63,23 +274,42 @@ bool VulkanRenderer::Init()
     CreateStep(CreateSurface);
     CreateStep(SelectPhysicalDevice);
     CreateStep(CreateLogicalDevice)
+    CreateStep(CreateTimeline);
+    CreateStep(CreateDeletionQueue);
     CreateStep(CreateSwapChain)
     CreateStep(CreateImageViews);
+    CreateStep(CreateRenderGraph);
     CreateStep(CreateRenderPass)
+    CreateStep(CreateShaderLibrary);
     CreateStep(CreateDescriptorSetLayout)
+    CreateStep(CreatePipelineBuilder);
+    CreateStep(CreatePipelineManager);
     CreateStep(CreateGraphicsPipeline);
     CreateStep(CreateCommandPool);
-    CreateStep(CreateDepthResources);
-    CreateStep(CreateFrameBuffers);
     CreateStep(CreateTextures);
     CreateStep(CreateSamplers);
     CreateStep(CreateModels);
-    CreateStep(CreateConstantBuffer);
-    CreateStep(CreateDescriptorPool);
+    CreateStep(CreateUniformAllocator);
+    CreateStep(CreateDescriptorAllocator);
     CreateStep(CreateDescriptorSet)
-    CreateStep(CreateCommandBuffers);
+    CreateStep(CreateBindlessTable);
+    CreateStep(CreateCommandRecorder);
+    CreateStep(CreateInstanceBatcher);
+    CreateStep(CreateGpuCuller);
+    CreateStep(CreateDepthPyramid);
+    CreateStep(CreateFrustumCuller);
+    CreateStep(CreateOcclusionCuller);
+    CreateStep(CreateDynamicResolution);
     CreateStep(CreateSyncObjects);
     
+    m_WindowChangedID = m_Window->RegisterWindowChangedCallback([this](IWindow::WindowEvent anEvent)
+    {
+        if(anEvent == IWindow::WE_SIZE)
+            m_SwapChainDirty = true;
+        else if(anEvent == IWindow::WE_REFRESH)
+            RequestRedraw();
+    });
+    
     return created;
 }
 
@@ -87,20 +317,45 @@ bool VulkanRenderer::RecreateSwapChain()
 {
     if (m_Window->GetWidth() == 0 || m_Window->GetHeight() == 0)
         return false;
-
-    vkDeviceWaitIdle(m_Device);
+    
+    // the old swapchain cannot go while its images are in use, only the frames in flight can be using them
+    WaitForFramesInFlight();
     
     CleanupSwapChain();
     
-    bool created = true;
+    const VkFormat oldImageFormat = m_SwapChainImageFormat;
+    VkSwapchainKHR oldSwapChain = m_SwapChain;
+    
+    bool created = CreateSwapChain();
+    
+    // the old swapchain is retired by the create call, but presents already queued on it are not
+    // covered by the graphics timeline. they have to finish before it goes
+    if(oldSwapChain != VK_NULL_HANDLE)
+        vkQueueWaitIdle(m_PresentQueue);
+    
+    vkDestroySwapchainKHR(m_Device, oldSwapChain, nullptr);
+    
+    if(!created)
+    {
+        m_SwapChain = VK_NULL_HANDLE;
+        std::cout << "Failed in: " << "CreateSwapChain" << std::endl;
+        return false;
+    }
     
-    CreateStep(CreateSwapChain);
     CreateStep(CreateImageViews);
-    CreateStep(CreateRenderPass);
-    CreateStep(CreateGraphicsPipeline);
-    CreateStep(CreateDepthResources);
-    CreateStep(CreateFrameBuffers);
-    CreateStep(CreateCommandBuffers);
+    
+    // viewport and scissor are dynamic so the pipeline only depends on the render pass formats
+    if(m_SwapChainImageFormat != oldImageFormat)
+    {
+        DestroyGraphicsPipeline();
+        
+        CreateStep(CreateRenderPass);
+        CreateStep(CreateGraphicsPipeline);
+        CreateStep(WaitForGraphicsPipeline);
+    }
+    
+    // the depth target and the framebuffers come back with the first frame's render graph
+    m_SwapChainDirty = false;
     
     return created;
 }
@@ -108,7 +363,9 @@ bool VulkanRenderer::RecreateSwapChain()
 void VulkanRenderer::Update()
 {
     IRenderer::Update();
-    DrawFrame();
+    
+    if(BeginFrame())
+        EndFrame();
 }
 
 void VulkanRenderer::WaitForSafeShutdown()
@@ -116,55 +373,155 @@ void VulkanRenderer::WaitForSafeShutdown()
     vkDeviceWaitIdle(m_Device);
 }
 
+void VulkanRenderer::WaitForFramesInFlight()
+{
+    // every frame went through the timeline, the last value covers all of them
+    m_GraphicsTimeline->Wait(m_GraphicsTimeline->GetLastSubmittedValue());
+}
+
 bool VulkanRenderer::CleanupSwapChain()
 {
-    vkDestroyImageView(m_Device, m_DepthImageView, nullptr);
-    vkDestroyImage(m_Device, m_DepthImage, nullptr);
-    vkFreeMemory(m_Device, m_DepthImageMemory, nullptr);
-    
-    for (VkFramebuffer& framebuffer : m_SwapChainFramebuffers)
-    {
-        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
-    }
+    DestroyFrameBuffers();
     
-    vkFreeCommandBuffers(m_Device, m_CommandPool, static_cast<uint32_t>(m_CommandBuffers.size()), m_CommandBuffers.data());
+    // all of it is retired, so frames still in flight are safe
+    if(m_RenderGraph)
+        m_RenderGraph->ReleaseTransients();
     
-    vkDestroyPipeline(m_Device, m_GraphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
-    vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+    if(m_DepthPyramid)
+        m_DepthPyramid->Release();
     
     for (VkImageView& imageView : m_SwapChainImageViews)
     {
-        vkDestroyImageView(m_Device, imageView, nullptr);
+        m_DeletionQueue->RetireImageView(imageView);
     }
     
-    vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
-    
     return true;
 }
 
+void VulkanRenderer::DestroyGraphicsPipeline()
+{
+    // waits on anything still compiling against the render pass
+    if(m_PipelineManager)
+    {
+        m_PipelineManager->DestroyPassPipelines(RENDER_PASS_MAIN);
+        m_PipelineManager->DestroyPassPipelines(RENDER_PASS_MAIN_BINDLESS);
+    }
+    
+    // m_RenderPass is the first of them
+    for (const RenderPassVariant& variant : m_RenderPassVariants)
+    {
+        vkDestroyRenderPass(m_Device, variant.m_RenderPass, nullptr);
+    }
+    
+    m_RenderPassVariants.clear();
+    m_RenderPass = VK_NULL_HANDLE;
+}
+
 void VulkanRenderer::Shutdown()
 {
+    if(m_WindowChangedID >= 0)
+        m_Window->UnregisterWindowChangedCallback(m_WindowChangedID);
+    
     CleanupSwapChain();
+    DestroyGraphicsPipeline();
+    
+    vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
     
     vkDestroySampler(m_Device, m_HouseTextureSampler, nullptr);
     DeleteTextures();
     DeleteModels();
     
-    vkDestroyDescriptorPool(m_Device, m_DescriptorPool, nullptr);
+    if(m_BindlessTable)
+        m_BindlessTable->Shutdown();
+    
+    Core_SafeDelete(m_BindlessTable);
+    
+    if(m_ShaderLibrary)
+        m_ShaderLibrary->Shutdown();
+    
+    Core_SafeDelete(m_ShaderLibrary);
+    
+    if(m_PipelineManager)
+    {
+        m_PipelineManager->SaveWarmupList(PIPELINE_WARMUP_PATH);
+        m_PipelineManager->Shutdown();
+    }
+    
+    Core_SafeDelete(m_PipelineManager);
+    
+    if(m_PipelineBuilder)
+        m_PipelineBuilder->Shutdown();
+    
+    Core_SafeDelete(m_PipelineBuilder);
     
-    vkDestroyDescriptorSetLayout(m_Device, m_DescriptorSetLayout, nullptr);
-    vkDestroyBuffer(m_Device, m_ConstantBuffer, nullptr);
-    vkFreeMemory(m_Device, m_ConstantBufferMemory, nullptr);
+    // owns the descriptor set and pipeline layouts, nothing can be compiling against them now
+    if(m_LayoutCache)
+        m_LayoutCache->Shutdown();
+    
+    Core_SafeDelete(m_LayoutCache);
+    
+    if(m_CommandRecorder)
+        m_CommandRecorder->Shutdown();
+    
+    Core_SafeDelete(m_CommandRecorder);
+    
+    if(m_RenderGraph)
+        m_RenderGraph->Shutdown();
+    
+    Core_SafeDelete(m_RenderGraph);
+    
+    if(m_InstanceBatcher)
+        m_InstanceBatcher->Shutdown();
+    
+    Core_SafeDelete(m_InstanceBatcher);
+    
+    if(m_GpuCuller)
+        m_GpuCuller->Shutdown();
+    
+    Core_SafeDelete(m_GpuCuller);
+    Core_SafeDelete(m_FrustumCuller);
+    Core_SafeDelete(m_OcclusionCuller);
+    
+    if(m_DepthPyramid)
+        m_DepthPyramid->Shutdown();
+    
+    Core_SafeDelete(m_DepthPyramid);
+    
+    if(m_GpuTimer)
+        m_GpuTimer->Shutdown();
+    
+    Core_SafeDelete(m_GpuTimer);
+    Core_SafeDelete(m_ResolutionScaler);
+    
+    if(m_UniformAllocator)
+        m_UniformAllocator->Shutdown();
+    
+    Core_SafeDelete(m_UniformAllocator);
+    
+    // frees every set it handed out, so after everything holding one
+    if(m_DescriptorAllocator)
+        m_DescriptorAllocator->Shutdown();
+    
+    Core_SafeDelete(m_DescriptorAllocator);
     
     for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
     {
         SwapChainLocks& lockInfo = m_SwapChainLocks[i];
         vkDestroySemaphore(m_Device, lockInfo.m_ImageAvailable, nullptr);
         vkDestroySemaphore(m_Device, lockInfo.m_RenderFinished, nullptr);
-        vkDestroyFence(m_Device, lockInfo.m_InUse, nullptr);
     }
     
+    // last, everything above may have retired something into it
+    if(m_DeletionQueue)
+        m_DeletionQueue->Shutdown();
+    
+    Core_SafeDelete(m_DeletionQueue);
+    
+    if(m_GraphicsTimeline)
+        m_GraphicsTimeline->Shutdown();
+    
+    Core_SafeDelete(m_GraphicsTimeline);
+    
     vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
     
     if(m_VKDeviceCreated)
@@ -192,54 +549,141 @@ void VulkanRenderer::DeleteTextures()
 void VulkanRenderer::DeleteModels()
 {
     Core_SafeDelete(m_HouseModel);
+    Core_SafeDelete(m_HouseOccluderModel);
 }
 
-void VulkanRenderer::UpdateConstantBuffer(uint32_t aFrameOffset)
+void VulkanRenderer::UpdateScene()
 {
-    bool rotate =  true;
     static auto startTime = std::chrono::high_resolution_clock::now();
     auto currentTime = std::chrono::high_resolution_clock::now();
     float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
     
-    ConstantBufferObject cbo = {};
-    
-    if(rotate)
-        cbo.m_Model = glm::rotate(glm::mat4(1.0f), time * glm::radians(22.5f), glm::vec3(0.0f, 0.0f, 1.0f));
+    // the model matrix is per object now, it goes out with the instance data
+    if(ROTATE_HOUSE)
+        m_HouseTransform = glm::rotate(glm::mat4(1.0f), time * glm::radians(22.5f), glm::vec3(0.0f, 0.0f, 1.0f));
     else
-        cbo.m_Model = glm::rotate(glm::mat4(1.0f), glm::radians(180.f), glm::vec3(0.0f, 0.0f, 1.0f));
+        m_HouseTransform = glm::rotate(glm::mat4(1.0f), glm::radians(180.f), glm::vec3(0.0f, 0.0f, 1.0f));
     
-    cbo.m_View = glm::lookAt(glm::vec3(2.5f, 0.f, 1.f), glm::vec3(0.0f, 0.0f, 0.25f), glm::vec3(0.0f, 0.0f, 1.0f));
-    cbo.m_Proj = glm::perspective(glm::radians(45.0f), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, 10.0f);
+    ViewConstants& view = m_ViewConstants;
+    view.m_View = glm::lookAt(glm::vec3(2.5f, 0.f, 1.f), glm::vec3(0.0f, 0.0f, 0.25f), glm::vec3(0.0f, 0.0f, 1.0f));
+    view.m_Proj = glm::perspective(glm::radians(45.0f), m_SwapChainExtent.width / (float)m_SwapChainExtent.height, 0.1f, 10.0f);
     
     // flip the y axis as glm was designed for OpenGL
-    cbo.m_Proj[1][1] *= -1;
+    view.m_Proj[1][1] *= -1;
+    
+    m_ViewProj = view.m_Proj * view.m_View;
+}
+
+void VulkanRenderer::UpdateViewConstants()
+{
+    // the frame's timeline value has been waited on, so last time's allocations from this frame are free again
+    m_UniformAllocator->Begin(m_CurrentFrame);
+    
+    ViewConstants* mapped = m_UniformAllocator->Allocate<ViewConstants>(m_ViewConstantsOffset);
+    
+    if(mapped)
+        *mapped = m_ViewConstants;
+}
+
+bool VulkanRenderer::NeedsRedraw()
+{
+    // nothing to show it in, a resize brings it back
+    if(m_Window->GetWidth() == 0 || m_Window->GetHeight() == 0)
+        return false;
     
-    void* data;
-    const size_t structSize = sizeof(ConstantBufferObject);
-    vkMapMemory(m_Device, m_ConstantBufferMemory, m_MinConstantBufferSize * aFrameOffset, structSize, 0, &data);
-    memcpy(data, &cbo, structSize);
-    vkUnmapMemory(m_Device, m_ConstantBufferMemory);
+    // pipelines that finished compiling draw what the last frame had to leave out
+    const bool pipelinesReady = m_PipelineManager->Update();
+    
+    if(pipelinesReady || m_SwapChainDirty || IRenderer::NeedsRedraw())
+        return true;
+    
+    // the camera and anything animated, worked out now as the frame would
+    UpdateScene();
+    
+    if(m_HouseTransform != m_SubmittedHouseTransform || m_ViewProj != m_SubmittedViewProj)
+        return true;
+    
+    // the frame left on screen while idle is worth a full resolution one
+    if(UseDynamicResolution() && !m_ResolutionScaler->IsAtMaxScale())
+    {
+        m_ResolutionScaler->Reset();
+        m_FullScaleFrame = true;
+        RequestRedraw();
+        return true;
+    }
+    
+    return false;
 }
 
-void VulkanRenderer::DrawFrame()
+bool VulkanRenderer::BeginFrame()
 {
+    m_FrameBegun = false;
+    
     SwapChainLocks& lockInfo = m_SwapChainLocks[m_CurrentFrame];
     
+    // pick up any pipelines that finished compiling in the background
+    m_PipelineManager->Update();
+    
+    if(m_SwapChainDirty && !RecreateSwapChain())
+        return false;
+    
+    // anything the gpu finished while the cpu was busy, before the wait skews the next one
+    CollectInputLatency(false);
+    
     {
         //Core_ScopedTimer timer("Wait Fence", TimeDenom::MilliSeconds);
         // wait incase this frame is still being used
-        vkWaitForFences(m_Device, 1, &lockInfo.m_InUse, VK_TRUE, std::numeric_limits<uint64_t>::max());
-        vkResetFences(m_Device, 1, &lockInfo.m_InUse);
+        m_GraphicsTimeline->Wait(lockInfo.m_SubmitValue);
     }
     
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(m_Device, m_SwapChain, std::numeric_limits<uint64_t>::max(), lockInfo.m_ImageAvailable, VK_NULL_HANDLE, &imageIndex);
+    CollectInputLatency(true);
     
-    UpdateConstantBuffer(imageIndex);
+    // whatever was retired before the frames now finished can go
+    m_DeletionQueue->Collect();
+    
+    // the gpu is done with this frame's transient sets
+    m_DescriptorAllocator->BeginFrame(m_CurrentFrame);
+    
+    // and with its timestamps
+    UpdateRenderResolution();
+    
+    VkResult result = vkAcquireNextImageKHR(m_Device, m_SwapChain, std::numeric_limits<uint64_t>::max(), lockInfo.m_ImageAvailable, VK_NULL_HANDLE, &m_ImageIndex);
     
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
         RecreateSwapChain();
+        return false;
+    }
+    
+    // nothing was acquired, so nothing will signal m_ImageAvailable
+    if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+        return false;
+    
+    m_FrameBegun = true;
+    return true;
+}
+
+void VulkanRenderer::EndFrame()
+{
+    if(!m_FrameBegun)
+        return;
+    
+    m_FrameBegun = false;
+    
+    SwapChainLocks& lockInfo = m_SwapChainLocks[m_CurrentFrame];
+    const uint32_t imageIndex = m_ImageIndex;
+    
+    // anything asked for from here on is not in this frame
+    TakeRedrawRequest();
+    
+    UpdateScene();
+    UpdateViewConstants();
+    
+    VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+    
+    if(!RecordCommandBuffer(imageIndex, cmdBuffer))
+    {
+        AbandonFrame(lockInfo);
         return;
     }
     
@@ -251,20 +695,34 @@ void VulkanRenderer::DrawFrame()
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         
         VkSemaphore waitSemaphores[] = { lockInfo.m_ImageAvailable };
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        // where the graph's first use of the back buffer waits, see USAGE_SWAPCHAIN_ACQUIRE_BLIT
+        const bool upscaled = m_ColorTargetID != m_BackBufferID;
+        VkPipelineStageFlags waitStages[] = {upscaled ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
         submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &m_CommandBuffers[imageIndex];
+        submitInfo.pCommandBuffers = &cmdBuffer;
         
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = submitDoneSemaphores;
         
-        bool submitted = vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, lockInfo.m_InUse) == VK_SUCCESS;
+        const uint64_t submitValue = m_GraphicsTimeline->Submit(submitInfo);
         
-        if(!submitted)
+        if(submitValue == 0)
+        {
+            AbandonFrame(lockInfo);
             return;
+        }
+        
+        lockInfo.m_SubmitValue = submitValue;
+        
+        m_SubmittedHouseTransform = m_HouseTransform;
+        m_SubmittedViewProj = m_ViewProj;
+        
+        lockInfo.m_InputTime = m_PendingInputTime;
+        lockInfo.m_HasInputTime = m_HasPendingInput;
+        m_HasPendingInput = false;
     }
     
     // present but wait for image to submitted and rendered
@@ -280,11 +738,128 @@ void VulkanRenderer::DrawFrame()
         presentInfo.pImageIndices = &imageIndex;
         presentInfo.pResults = nullptr; // Optional
         
-        vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+        VkResult presentResult = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+        
+        if(presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+            m_SwapChainDirty = true;
     }
     
     //inc to next frame
-    m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+}
+
+void VulkanRenderer::AbandonFrame(SwapChainLocks& aLockInfo)
+{
+    // the acquire still has a signal pending on m_ImageAvailable and the image is ours until it is presented.
+    // an empty batch waits the signal off, and the image goes back with the swapchain it came from
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = &aLockInfo.m_ImageAvailable;
+    submitInfo.pWaitDstStageMask = &waitStage;
+    
+    // the next acquire into this frame waits on the value, by then the semaphore is unsignalled again
+    const uint64_t submitValue = m_GraphicsTimeline->Submit(submitInfo);
+    
+    if(submitValue != 0)
+        aLockInfo.m_SubmitValue = submitValue;
+    
+    m_SwapChainDirty = true;
+    RequestRedraw();
+}
+
+void VulkanRenderer::SetFramesInFlight(uint32_t aCount)
+{
+    const int count = std::max(1, std::min(static_cast<int>(aCount), MAX_FRAMES_IN_FLIGHT));
+    
+    if(count == m_FramesInFlight)
+        return;
+    
+    // every slot is still guarded by its own timeline value, dropping out of the cycle mid flight is fine
+    m_FramesInFlight = count;
+    
+    if(m_CurrentFrame >= m_FramesInFlight)
+        m_CurrentFrame = 0;
+}
+
+void VulkanRenderer::SetPresentMode(PresentMode aMode)
+{
+    if(aMode == m_PresentMode)
+        return;
+    
+    m_PresentMode = aMode;
+    
+    // before the swapchain exists CreateSwapChain picks it up
+    if(m_SwapChain != VK_NULL_HANDLE)
+        m_SwapChainDirty = true;
+}
+
+void VulkanRenderer::OnInputSampled()
+{
+    m_PendingInputTime = std::chrono::steady_clock::now();
+    m_HasPendingInput = true;
+}
+
+bool VulkanRenderer::TakeLatencyStats(LatencyStats& outStats)
+{
+    if(m_LatencyFrames == 0)
+        return false;
+    
+    outStats.m_Frames = m_LatencyFrames;
+    outStats.m_AverageMilliseconds = static_cast<float>(m_LatencyTotalMilliseconds / m_LatencyFrames);
+    outStats.m_WorstMilliseconds = m_LatencyWorstMilliseconds;
+    
+    m_LatencyFrames = 0;
+    m_LatencyTotalMilliseconds = 0.0;
+    m_LatencyWorstMilliseconds = 0.0f;
+    return true;
+}
+
+void VulkanRenderer::ReportStats()
+{
+    ReportBindStats();
+    ReportAttachmentMemory();
+    ReportDepthPrepass();
+    ReportRenderResolution();
+    
+    // whichever path culled the last frame
+    if(UseGpuCulling())
+    {
+        if(UseOcclusionCulling())
+            ReportCullStats();
+    }
+    else if(UseSoftwareOcclusion())
+    {
+        ReportOcclusionStats();
+    }
+}
+
+void VulkanRenderer::CollectInputLatency(bool aWaited)
+{
+    // a frame is only seen finished when it is checked, so one that finished earlier reads long.
+    // when the wait on the current frame blocks the time is exact, with one frame in flight it nearly always does
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    {
+        SwapChainLocks& lockInfo = m_SwapChainLocks[i];
+        
+        if(!lockInfo.m_HasInputTime)
+            continue;
+        
+        if(!(aWaited && i == m_CurrentFrame) && !m_GraphicsTimeline->IsComplete(lockInfo.m_SubmitValue))
+            continue;
+        
+        const float milliseconds = std::chrono::duration<float, std::milli>(now - lockInfo.m_InputTime).count();
+        
+        ++m_LatencyFrames;
+        m_LatencyTotalMilliseconds += milliseconds;
+        m_LatencyWorstMilliseconds = std::max(m_LatencyWorstMilliseconds, milliseconds);
+        
+        lockInfo.m_HasInputTime = false;
+    }
 }
 
 bool VulkanRenderer::GetRequiredExtensions(std::vector<const char*>& outExtensions)
@@ -299,6 +874,26 @@ bool VulkanRenderer::GetRequiredExtensions(std::vector<const char*>& outExtensio
     
     outExtensions.insert(outExtensions.end(), winExtensions, winExtensions + winExtensionCount);
     
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+    
+    for (const char* optionalExtension : VK_Common::ourOptionalInstanceExtensions)
+    {
+        for (const VkExtensionProperties& extension : availableExtensions)
+        {
+            if(strcmp(extension.extensionName, optionalExtension) == 0)
+            {
+                outExtensions.push_back(optionalExtension);
+                break;
+            }
+        }
+    }
+    
+    m_HasDeviceProperties2 = HasExtension(outExtensions, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
 #ifdef _DEBUG
     outExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
 #endif
@@ -405,6 +1000,27 @@ bool VulkanRenderer::DeviceSupportExtensions(const VkPhysicalDevice& aDevice)
     return requiredExtensions.empty();
 }
 
+void VulkanRenderer::GetOptionalExtensions(const VkPhysicalDevice& aDevice, std::vector<const char*>& outExtensions)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(aDevice, nullptr, &extensionCount, nullptr);
+    
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(aDevice, nullptr, &extensionCount, availableExtensions.data());
+    
+    for (const char* optionalExtension : VK_Common::ourOptionalDeviceExtensions)
+    {
+        for (const VkExtensionProperties& extension : availableExtensions)
+        {
+            if(strcmp(extension.extensionName, optionalExtension) == 0)
+            {
+                outExtensions.push_back(optionalExtension);
+                break;
+            }
+        }
+    }
+}
+
 bool VulkanRenderer::IsDeviceSuitable(const VkPhysicalDevice& aDevice)
 {
     bool isSuitable = false;
@@ -485,17 +1101,61 @@ bool VulkanRenderer::CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
     
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+    
     //specify the features we want
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
     
-    VkDeviceCreateInfo createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
-    createInfo.pQueueCreateInfos = queueCreateInfos.data();
+    // indirect drawing is optional, only ask for what is there
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    
+    m_DeviceCaps = DeviceCapabilities();
+    m_DeviceCaps.m_MultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+    m_DeviceCaps.m_DrawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+    
+    std::vector<const char*> deviceExtensions = VK_Common::ourDeviceExtensions;
+    GetOptionalExtensions(m_PhysicalDevice, deviceExtensions);
+    
+    m_DeviceCaps.m_Maintenance1 = HasExtension(deviceExtensions, VK_KHR_MAINTENANCE1_EXTENSION_NAME);
+    
+    // only what the bindless table needs, left out of the chain when it is not all there
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    
+    m_DeviceCaps.m_DescriptorIndexing = QueryDescriptorIndexing(deviceExtensions, indexingFeatures);
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing = m_DeviceCaps.m_DescriptorIndexing ? VK_TRUE : VK_FALSE;
+    
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    
+    m_DeviceCaps.m_TimelineSemaphore = QueryTimelineSemaphore(deviceExtensions, timelineFeatures);
+    
+    // each optional feature struct goes on the front of the chain
+    void* featureChain = nullptr;
+    
+    if(m_DeviceCaps.m_TimelineSemaphore)
+    {
+        timelineFeatures.pNext = featureChain;
+        featureChain = &timelineFeatures;
+    }
+    
+    if(m_DeviceCaps.m_DescriptorIndexing)
+    {
+        indexingFeatures.pNext = featureChain;
+        featureChain = &indexingFeatures;
+    }
+    
+    VkDeviceCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = featureChain;
+    createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+    createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(VK_Common::ourDeviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = VK_Common::ourDeviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
 #ifdef _DEBUG
     createInfo.enabledLayerCount = static_cast<uint32_t>(VK_Debug::ourValidationLayers.size());
@@ -510,11 +1170,120 @@ bool VulkanRenderer::CreateLogicalDevice()
     {
         vkGetDeviceQueue(m_Device, m_QueueFamilyIndices.m_GraphicsFamily, 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, m_QueueFamilyIndices.m_PresentFamily, 0, &m_PresentQueue);
+        
+        // null if VK_KHR_draw_indirect_count was not enabled
+        m_DeviceCaps.m_CmdDrawIndexedIndirectCount = reinterpret_cast<DrawIndexedIndirectCountFunc>(vkGetDeviceProcAddr(m_Device, "vkCmdDrawIndexedIndirectCountKHR"));
+        
+        // all or nothing, the descriptor allocator falls back to plain writes
+        m_DeviceCaps.m_CreateDescriptorUpdateTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkCreateDescriptorUpdateTemplateKHR"));
+        m_DeviceCaps.m_DestroyDescriptorUpdateTemplate = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkDestroyDescriptorUpdateTemplateKHR"));
+        m_DeviceCaps.m_UpdateDescriptorSetWithTemplate = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(m_Device, "vkUpdateDescriptorSetWithTemplateKHR"));
+        
+        if(!m_DeviceCaps.m_CreateDescriptorUpdateTemplate || !m_DeviceCaps.m_DestroyDescriptorUpdateTemplate || !m_DeviceCaps.m_UpdateDescriptorSetWithTemplate)
+        {
+            m_DeviceCaps.m_CreateDescriptorUpdateTemplate = nullptr;
+            m_DeviceCaps.m_DestroyDescriptorUpdateTemplate = nullptr;
+            m_DeviceCaps.m_UpdateDescriptorSetWithTemplate = nullptr;
+        }
+        
+        if(m_DeviceCaps.m_TimelineSemaphore)
+        {
+            m_DeviceCaps.m_GetSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(m_Device, "vkGetSemaphoreCounterValueKHR"));
+            m_DeviceCaps.m_WaitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(m_Device, "vkWaitSemaphoresKHR"));
+            
+            // the timeline falls back to fences
+            m_DeviceCaps.m_TimelineSemaphore = m_DeviceCaps.m_GetSemaphoreCounterValue && m_DeviceCaps.m_WaitSemaphores;
+        }
     }
     
     return m_VKDeviceCreated;
 }
 
+bool VulkanRenderer::HasExtension(const std::vector<const char*>& someExtensions, const char* anExtension)
+{
+    for (const char* extension : someExtensions)
+    {
+        if(strcmp(extension, anExtension) == 0)
+            return true;
+    }
+    
+    return false;
+}
+
+bool VulkanRenderer::QueryDescriptorIndexing(const std::vector<const char*>& someExtensions, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& outFeatures)
+{
+    if(!m_HasDeviceProperties2 || !HasExtension(someExtensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) || !HasExtension(someExtensions, VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+        return false;
+    
+    PFN_vkGetPhysicalDeviceFeatures2KHR getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(m_VKInstance, "vkGetPhysicalDeviceFeatures2KHR"));
+    PFN_vkGetPhysicalDeviceProperties2KHR getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(vkGetInstanceProcAddr(m_VKInstance, "vkGetPhysicalDeviceProperties2KHR"));
+    
+    if(!getFeatures2 || !getProperties2)
+        return false;
+    
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &supportedFeatures;
+    
+    getFeatures2(m_PhysicalDevice, &features);
+    
+    // texture and sampler indices come from push constants, they are dynamically uniform so no
+    // non uniform indexing is needed. they are still not constants, indexing the arrays with
+    // them takes the core dynamic indexing feature
+    if(!features.features.shaderSampledImageArrayDynamicIndexing ||
+       !supportedFeatures.descriptorBindingPartiallyBound ||
+       !supportedFeatures.descriptorBindingSampledImageUpdateAfterBind ||
+       !supportedFeatures.descriptorBindingUpdateUnusedWhilePending)
+        return false;
+    
+    VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+    
+    VkPhysicalDeviceProperties2KHR properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    properties.pNext = &indexingProperties;
+    
+    getProperties2(m_PhysicalDevice, &properties);
+    
+    m_DeviceCaps.m_MaxBindlessTextures = std::min(indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                                  indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+    
+    outFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    outFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    outFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    
+    return true;
+}
+
+bool VulkanRenderer::QueryTimelineSemaphore(const std::vector<const char*>& someExtensions, VkPhysicalDeviceTimelineSemaphoreFeaturesKHR& outFeatures)
+{
+    if(!m_HasDeviceProperties2 || !HasExtension(someExtensions, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+        return false;
+    
+    PFN_vkGetPhysicalDeviceFeatures2KHR getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(m_VKInstance, "vkGetPhysicalDeviceFeatures2KHR"));
+    
+    if(!getFeatures2)
+        return false;
+    
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &supportedFeatures;
+    
+    getFeatures2(m_PhysicalDevice, &features);
+    
+    if(!supportedFeatures.timelineSemaphore)
+        return false;
+    
+    outFeatures.timelineSemaphore = VK_TRUE;
+    return true;
+}
+
 void VulkanRenderer::QuerySwapChainSupport(const VkPhysicalDevice& aDevice, SwapChainSupportDetails& outSomeDetails)
 {
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(aDevice, m_Surface, &outSomeDetails.m_Capabilities);
@@ -563,21 +1332,28 @@ VkSurfaceFormatKHR VulkanRenderer::ChooseSwapSurfaceFormat(const std::vector<VkS
 
 VkPresentModeKHR VulkanRenderer::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-    VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
+    std::vector<VkPresentModeKHR> preferred;
     
-    for (const VkPresentModeKHR& presentMode : availablePresentModes)
+    switch (m_PresentMode)
     {
-        if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-        {
-            return presentMode;
-        }
-        /*else if (presentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-        {
-            bestMode = presentMode;
-        }*/
+        case PRESENT_MODE_LOW_LATENCY:
+            preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+            break;
+        case PRESENT_MODE_IMMEDIATE:
+            preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+            break;
+        default:
+            break;
+    }
+    
+    for (const VkPresentModeKHR& mode : preferred)
+    {
+        if(std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end())
+            return mode;
     }
     
-    return bestMode;
+    // the only mode every device has to support
+    return VK_PRESENT_MODE_FIFO_KHR;
 }
 
 VkExtent2D VulkanRenderer::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
@@ -622,7 +1398,8 @@ bool VulkanRenderer::CreateSwapChain()
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // a blit target as well where the surface allows it, for upscaling a frame drawn at a lower resolution
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
     
     uint32_t queueFamilyIndices[] = {(uint32_t)m_QueueFamilyIndices.m_GraphicsFamily,
                                      (uint32_t)m_QueueFamilyIndices.m_PresentFamily};
@@ -644,7 +1421,7 @@ bool VulkanRenderer::CreateSwapChain()
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = m_SwapChain;
     
     bool created = vkCreateSwapchainKHR(m_Device, &createInfo, nullptr, &m_SwapChain) == VK_SUCCESS;
     
@@ -658,6 +1435,15 @@ bool VulkanRenderer::CreateSwapChain()
         m_SwapChainCount = swapCount;
         m_SwapChainImageFormat = surfaceFormat.format;
         m_SwapChainExtent = extent;
+        
+        // the offscreen target has the swapchain format, so one format has to blit both ways with filtering
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(m_PhysicalDevice, surfaceFormat.format, &formatProperties);
+        
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        
+        m_SwapChainBlitTarget = (createInfo.imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0
+                             && (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
     }
         
     return created;
@@ -679,35 +1465,72 @@ bool VulkanRenderer::CreateImageViews()
 
 bool VulkanRenderer::CreateRenderPass()
 {
+    VkFormat depthFormat;
+    
+    if(FindDepthFormat(depthFormat))
+        m_DepthFormat = depthFormat;
+    else
+        return false;
+    
+    // the ops only have to match the pass, not the framebuffer, so a frame's graph is enough to pick them
+    if(!BuildRenderGraph(0))
+        return false;
+    
+    // the pipelines and framebuffers are made against this one, passes with other ops use a compatible variant
+    m_RenderPass = GetDrawRenderPass(m_MainPassID);
+    
+    return m_RenderPass != VK_NULL_HANDLE;
+}
+
+VkRenderPass VulkanRenderer::GetDrawRenderPass(VulkanRenderGraph::PassID aPass)
+{
+    const VulkanRenderGraph::AttachmentOps colorOps = m_RenderGraph->GetAttachmentOps(aPass, m_ColorTargetID);
+    const VulkanRenderGraph::AttachmentOps depthOps = m_RenderGraph->GetAttachmentOps(aPass, m_DepthID);
+    
+    for (const RenderPassVariant& variant : m_RenderPassVariants)
+    {
+        if(variant.m_ColorOps == colorOps && variant.m_DepthOps == depthOps)
+            return variant.m_RenderPass;
+    }
+    
+    RenderPassVariant variant = { colorOps, depthOps, VK_NULL_HANDLE };
+    
+    if(!CreateDrawRenderPass(colorOps, depthOps, variant.m_RenderPass))
+        return VK_NULL_HANDLE;
+    
+    m_RenderPassVariants.push_back(variant);
+    
+    return variant.m_RenderPass;
+}
+
+bool VulkanRenderer::CreateDrawRenderPass(const VulkanRenderGraph::AttachmentOps& aColorOps, const VulkanRenderGraph::AttachmentOps& aDepthOps, VkRenderPass& outRenderPass)
+{
+    const bool hasStencil = (VulkanUtils::GetAspectFlags(m_DepthFormat) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+    
     VkAttachmentDescription colorAttachment = {};
     colorAttachment.format = m_SwapChainImageFormat;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.loadOp = aColorOps.m_Load;
+    colorAttachment.storeOp = aColorOps.m_Store;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // the render graph moves the attachments in and out of these layouts with its own barriers
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0;
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     
-    VkFormat depthFormat;
-    
-    if(FindDepthFormat(depthFormat))
-        m_DepthFormat = depthFormat;
-    else
-        return false;
-    
     VkAttachmentDescription depthAttachment = {};
     depthAttachment.format = m_DepthFormat;
     depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.loadOp = aDepthOps.m_Load;
+    depthAttachment.storeOp = aDepthOps.m_Store;
+    // the stencil shares the image, it is kept or thrown away with the depth
+    depthAttachment.stencilLoadOp = hasStencil ? aDepthOps.m_Load : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = hasStencil ? aDepthOps.m_Store : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     
     VkAttachmentReference depthAttachmentRef = {};
@@ -720,14 +1543,6 @@ bool VulkanRenderer::CreateRenderPass()
     subpass.pColorAttachments = &colorAttachmentRef;
     subpass.pDepthStencilAttachment = &depthAttachmentRef;
     
-    VkSubpassDependency dependency = {};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    
     std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
     
     VkRenderPassCreateInfo renderPassInfo = {};
@@ -736,208 +1551,112 @@ bool VulkanRenderer::CreateRenderPass()
     renderPassInfo.pAttachments = attachments.data();
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
     
-    return vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass) == VK_SUCCESS;
+    // no external dependencies, the graph's barriers before and after the pass already order it
+    
+    return vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &outRenderPass) == VK_SUCCESS;
 }
 
 bool VulkanRenderer::CreateDescriptorSetLayout()
 {
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    m_LayoutCache = new VulkanLayoutCache();
     
-    VkDescriptorSetLayoutBinding& cboLayoutBinding = bindings[0];
-    cboLayoutBinding.binding = 0;
-    cboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    cboLayoutBinding.descriptorCount = 1;
-    cboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    cboLayoutBinding.pImmutableSamplers = nullptr; // Optional
-
-    VkDescriptorSetLayoutBinding& samplerLayoutBinding = bindings[1];
-    samplerLayoutBinding.binding = 1;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    // bindings come straight from the shaders so the two cannot drift apart
+    std::vector<const VulkanShader*> shaders =
+    {
+        m_ShaderLibrary->GetShader(VERT_INSTANCED_SHADER_PATH),
+        m_ShaderLibrary->GetShader(FRAG_SHADER_PATH),
+    };
     
-    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-    layoutInfo.pBindings = bindings.data();
+    std::vector<VkDescriptorSetLayout> setLayouts;
     
-    if(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_DescriptorSetLayout) != VK_SUCCESS)
+    // the view constants come out of the uniform ring, bound with a dynamic offset
+    if(!m_LayoutCache->GetLayouts(shaders, m_PipelineLayout, setLayouts, true) || setLayouts.empty())
         return false;
     
+    m_DescriptorSetLayout = setLayouts[0];
+    
     return true;
 }
 
-bool VulkanRenderer::CreateGraphicsPipeline()
+bool VulkanRenderer::CreateShaderLibrary()
 {
-    bool created = true;
-    VkShaderModule vertShaderModule;
-    VkShaderModule fragShaderModule;
+    m_ShaderLibrary = new VulkanShaderLibrary();
     
-    VulkanShader vertShader = VulkanShader(VERT_SHADER_PATH);
+    // load everything up front so the first pipeline build is not waiting on disk
+    std::vector<VulkanShaderLibrary::ShaderRequest> requests =
+    {
+        { VERT_INSTANCED_SHADER_PATH, "main" },
+        { FRAG_SHADER_PATH, "main" },
+    };
     
-    if(vertShader.Load())
-        created &= vertShader.CreateShaderModule(m_Device, vertShaderModule);
-    else
-        return false;
+    return m_ShaderLibrary->LoadShaders(requests);
+}
+
+bool VulkanRenderer::CreatePipelineBuilder()
+{
+    m_PipelineBuilder = new VulkanPipelineBuilder();
+    return m_PipelineBuilder->Init(PIPELINE_CACHE_PATH);
+}
+
+bool VulkanRenderer::CreatePipelineManager()
+{
+    m_PipelineManager = new VulkanPipelineManager(m_PipelineBuilder);
     
-    VulkanShader fragShader = VulkanShader(FRAG_SHADER_PATH);
+    // no list yet on a first run, everything compiles on demand
+    m_PipelineManager->LoadWarmupList(PIPELINE_WARMUP_PATH);
     
-    if(fragShader.Load())
-        created &= fragShader.CreateShaderModule(m_Device, fragShaderModule);
-    else
-        return false;
+    return true;
+}
+
+bool VulkanRenderer::CreateGraphicsPipeline()
+{
+    m_GraphicsPipelineState = VulkanPipelineState();
+    m_GraphicsPipelineState.m_PassID = RENDER_PASS_MAIN;
+    m_GraphicsPipelineState.m_VertShader = VERT_INSTANCED_SHADER_PATH;
+    m_GraphicsPipelineState.m_VertexLayout = VERTEX_LAYOUT_POSITION_COLOR_INSTANCED;
+    m_GraphicsPipelineState.m_FragShader = FRAG_SHADER_PATH;
+    
+    m_PipelineManager->RegisterPass(RENDER_PASS_MAIN, m_RenderPass, m_PipelineLayout);
+    
+    // compiles on a worker while the rest of init carries on, see WaitForGraphicsPipeline
+    m_PipelineManager->SetFallback(RENDER_PASS_MAIN, m_GraphicsPipelineState);
+    m_PipelineManager->PrecompileWarmupList(RENDER_PASS_MAIN);
+    
+    // positions only and no fragment shader, the colour attachment is in the pass but never written
+    m_DepthPrepassState = m_GraphicsPipelineState;
+    m_DepthPrepassState.m_VertShader = VERT_DEPTH_PREPASS_SHADER_PATH;
+    m_DepthPrepassState.m_VertexLayout = VERTEX_LAYOUT_POSITION_INSTANCED;
+    m_DepthPrepassState.m_FragShader.clear();
+    m_DepthPrepassState.m_ColorWrite = false;
+    
+    if(m_DepthPrepassMode != DEPTH_PREPASS_OFF && !m_ShaderLibrary->GetShader(VERT_DEPTH_PREPASS_SHADER_PATH))
+    {
+        std::cout << "Depth pre-pass disabled: could not load " << VERT_DEPTH_PREPASS_SHADER_PATH << std::endl;
+        m_DepthPrepassMode = DEPTH_PREPASS_OFF;
+    }
     
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-    
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-    
-    auto bindingDescription = PositionColorVertex::GetBindingDescription();
-    auto attributeDescriptions = PositionColorVertex::GetAttributeDescriptions();
-    
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-    
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-    
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)m_SwapChainExtent.width;
-    viewport.height = (float)m_SwapChainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = m_SwapChainExtent;
-    
-    VkPipelineViewportStateCreateInfo viewportState = {};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-    
-    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL; //_LINE _POINT
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f; // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-    
-    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
-    
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_FALSE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
-    
-    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-    
-    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_TRUE;
-    depthStencil.depthWriteEnable = VK_TRUE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.minDepthBounds = 0.0f; // Optional
-    depthStencil.maxDepthBounds = 1.0f; // Optional
-    depthStencil.stencilTestEnable = VK_FALSE;
-    depthStencil.front = {}; // Optional
-    depthStencil.back = {}; // Optional
-    
-    VkDynamicState dynamicStates[] =
-    {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
-    };
+    // a new render pass after a format change, the bindless pass goes with it
+    if(m_BindlessPipelineLayout != VK_NULL_HANDLE)
+        RegisterBindlessPass();
     
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = dynamicStates;
-    
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-    
-    created &= vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) == VK_SUCCESS;
-    
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = &depthStencil;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr; // Optional
-    pipelineInfo.layout = m_PipelineLayout;
-    pipelineInfo.renderPass = m_RenderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    created &= vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) == VK_SUCCESS;
-    
-    vkDestroyShaderModule(m_Device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(m_Device, vertShaderModule, nullptr);
+    return true;
+}
+
+void VulkanRenderer::RegisterBindlessPass()
+{
+    m_BindlessPipelineState = m_GraphicsPipelineState;
+    m_BindlessPipelineState.m_PassID = RENDER_PASS_MAIN_BINDLESS;
+    m_BindlessPipelineState.m_FragShader = FRAG_BINDLESS_SHADER_PATH;
     
-    return created;
+    m_PipelineManager->RegisterPass(RENDER_PASS_MAIN_BINDLESS, m_RenderPass, m_BindlessPipelineLayout);
+    m_PipelineManager->SetFallback(RENDER_PASS_MAIN_BINDLESS, m_BindlessPipelineState);
+    m_PipelineManager->PrecompileWarmupList(RENDER_PASS_MAIN_BINDLESS);
+}
+
+bool VulkanRenderer::WaitForGraphicsPipeline()
+{
+    return m_PipelineManager->WaitForPipeline(m_GraphicsPipelineState) != VK_NULL_HANDLE;
 }
 
 bool VulkanRenderer::CreateFrameBuffers()
@@ -946,12 +1665,13 @@ bool VulkanRenderer::CreateFrameBuffers()
     
     m_SwapChainFramebuffers.resize(m_SwapChainCount);
     
+    // drawing offscreen every image's framebuffer has the same two views, kept per image so the frame code is the same
     for (size_t i = 0; i < m_SwapChainCount; i++)
     {
         std::array<VkImageView, 2> attachments =
         {
-            m_SwapChainImageViews[i],
-            m_DepthImageView
+            m_FramebufferColorView != VK_NULL_HANDLE ? m_FramebufferColorView : m_SwapChainImageViews[i],
+            m_FramebufferDepthView
         };
         
         VkFramebufferCreateInfo framebufferInfo = {};
@@ -969,6 +1689,45 @@ bool VulkanRenderer::CreateFrameBuffers()
     return created;
 }
 
+void VulkanRenderer::DestroyFrameBuffers()
+{
+    for (VkFramebuffer& framebuffer : m_SwapChainFramebuffers)
+    {
+        m_DeletionQueue->RetireFramebuffer(framebuffer);
+    }
+    
+    m_SwapChainFramebuffers.clear();
+    m_FramebufferColorView = VK_NULL_HANDLE;
+    m_FramebufferDepthView = VK_NULL_HANDLE;
+}
+
+bool VulkanRenderer::UpdateFrameBuffers(VkImageView aColorView, VkImageView aDepthView)
+{
+    if(aColorView == m_FramebufferColorView && aDepthView == m_FramebufferDepthView && !m_SwapChainFramebuffers.empty())
+        return true;
+    
+    // the graph made its targets again, the old framebuffers go once the frames in flight drawing through them are done
+    if(!m_SwapChainFramebuffers.empty())
+        DestroyFrameBuffers();
+    
+    m_FramebufferColorView = aColorView;
+    m_FramebufferDepthView = aDepthView;
+    
+    return CreateFrameBuffers();
+}
+
+bool VulkanRenderer::CreateTimeline()
+{
+    m_GraphicsTimeline = new VulkanTimeline();
+    return m_GraphicsTimeline->Init(m_GraphicsQueue);
+}
+
+bool VulkanRenderer::CreateDeletionQueue()
+{
+    m_DeletionQueue = new VulkanDeletionQueue();
+    return m_DeletionQueue->Init(m_GraphicsTimeline);
+}
+
 bool VulkanRenderer::CreateCommandPool()
 {
     VkCommandPoolCreateInfo poolInfo = {};
@@ -979,28 +1738,9 @@ bool VulkanRenderer::CreateCommandPool()
     return vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) == VK_SUCCESS;
 }
 
-bool VulkanRenderer::CreateDepthResources()
+bool VulkanRenderer::CreateRenderGraph()
 {
-    bool created = VulkanUtils::CreateImage(m_SwapChainExtent.width,
-                                            m_SwapChainExtent.height,
-                                            1,
-                                            m_DepthFormat,
-                                            VK_IMAGE_TILING_OPTIMAL,
-                                            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                            m_DepthImage,
-                                            m_DepthImageMemory);
-    
-    if(!created)
-        return false;
-    
-    created = VulkanUtils::CreateImageView(m_DepthImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, m_DepthImageView, 1);
-    
-    if(!created)
-        return false;
-    
-    VulkanUtils::TransitionImageLayout(m_DepthImage, m_DepthFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, 1);
-    
+    m_RenderGraph = new VulkanRenderGraph();
     return true;
 }
 
@@ -1040,161 +1780,755 @@ bool VulkanRenderer::CreateModels()
     SCOPE_FUNCTION_MILLI();
     
     m_HouseModel = new VulkanModel(MODEL_PATH);
-    return m_HouseModel->Load();
+    
+    if(!m_HouseModel->Load())
+        return false;
+    
+    // optional, without it the cpu path occludes with a box inside the house bounds
+    m_HouseOccluderModel = new VulkanModel(OCCLUDER_MODEL_PATH, true);
+    
+    if(!m_HouseOccluderModel->Load())
+        Core_SafeDelete(m_HouseOccluderModel);
+    
+    return true;
 }
     
-bool VulkanRenderer::CreateConstantBuffer()
+bool VulkanRenderer::CreateUniformAllocator()
+{
+    m_UniformAllocator = new VulkanUniformAllocator();
+    return m_UniformAllocator->Init(MAX_FRAMES_IN_FLIGHT, UNIFORM_RING_FRAME_SIZE);
+}
+
+bool VulkanRenderer::CreateDescriptorAllocator()
+{
+    m_DescriptorAllocator = new VulkanDescriptorAllocator();
+    return m_DescriptorAllocator->Init(MAX_FRAMES_IN_FLIGHT);
+}
+
+bool VulkanRenderer::CreateDescriptorSet()
 {
-    const VkDeviceSize minDeviceOffset = m_DeviceProperties.limits.minUniformBufferOffsetAlignment;
-    const VkDeviceSize neededSize = sizeof(ConstantBufferObject);
+    // one set for every frame, the frame's view constants are picked by the dynamic offset
+    m_DescriptorSet = m_DescriptorAllocator->AllocateStatic(m_DescriptorSetLayout);
     
-    if(neededSize <= minDeviceOffset)
-        m_MinConstantBufferSize = minDeviceOffset;
-    else
-        m_MinConstantBufferSize = ((neededSize / minDeviceOffset) + 1) * minDeviceOffset;
+    if(m_DescriptorSet == VK_NULL_HANDLE)
+        return false;
     
-    const VkDeviceSize bufferSize = m_MinConstantBufferSize * m_SwapChainCount;
-    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-        
-    if(!VulkanUtils::CreateBuffer(bufferSize, usage, properties, m_ConstantBuffer, m_ConstantBufferMemory))
+    struct DescriptorData
+    {
+        VkDescriptorBufferInfo  m_View;
+        VkDescriptorImageInfo   m_Texture;
+    };
+    
+    VulkanDescriptorAllocator::TemplateEntries entries(2);
+    
+    entries[0].dstBinding = 0;
+    entries[0].descriptorCount = 1;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    entries[0].offset = offsetof(DescriptorData, m_View);
+    entries[0].stride = sizeof(DescriptorData);
+    
+    entries[1].dstBinding = 1;
+    entries[1].descriptorCount = 1;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    entries[1].offset = offsetof(DescriptorData, m_Texture);
+    entries[1].stride = sizeof(DescriptorData);
+    
+    VulkanDescriptorAllocator::TemplateID updateTemplate = m_DescriptorAllocator->GetUpdateTemplate(m_DescriptorSetLayout, entries);
+    
+    if(updateTemplate == VulkanDescriptorAllocator::INVALID_TEMPLATE)
         return false;
     
+    DescriptorData data = {};
+    data.m_View.buffer = m_UniformAllocator->GetBuffer();
+    data.m_View.offset = 0;
+    data.m_View.range = sizeof(ViewConstants);
+    data.m_Texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    data.m_Texture.imageView = m_HouseTexture->GetImageView();
+    data.m_Texture.sampler = m_HouseTextureSampler;
+    
+    m_DescriptorAllocator->UpdateSet(m_DescriptorSet, updateTemplate, &data);
+    
     return true;
 }
 
-bool VulkanRenderer::CreateDescriptorPool()
+bool VulkanRenderer::CreateBindlessTable()
 {
-    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = m_SwapChainCount;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = m_SwapChainCount;
+    // not supported is not an error, draws keep their combined image sampler in set 0
+    m_BindlessTable = new VulkanBindlessTable();
+    
+    if(!m_BindlessTable->Init())
+        return false;
+    
+    if(!m_BindlessTable->IsSupported())
+        return true;
+    
+    if(!m_ShaderLibrary->GetShader(FRAG_BINDLESS_SHADER_PATH))
+    {
+        std::cout << "Bindless textures disabled: could not load " << FRAG_BINDLESS_SHADER_PATH << std::endl;
+        m_BindlessTable->Shutdown();
+        return true;
+    }
+    
+    m_HouseMaterial.m_TextureIndex = m_BindlessTable->AddTexture(m_HouseTexture->GetImageView());
+    m_HouseMaterial.m_SamplerIndex = m_BindlessTable->AddSampler(m_HouseTextureSampler);
+    
+    // set 0 stays the per view set so the view constants bind the same way in both modes
+    VkPushConstantRange materialRange = {};
+    materialRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    materialRange.offset = 0;
+    materialRange.size = sizeof(MaterialConstants);
     
-    VkDescriptorPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<u_int32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 128;
+    m_BindlessPipelineLayout = m_LayoutCache->GetPipelineLayout({ m_DescriptorSetLayout, m_BindlessTable->GetSetLayout() }, { materialRange });
     
-    return (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_DescriptorPool) == VK_SUCCESS);
+    if(m_BindlessPipelineLayout == VK_NULL_HANDLE)
+        return false;
+    
+    RegisterBindlessPass();
+    
+    return true;
 }
 
-bool VulkanRenderer::CreateDescriptorSet()
+bool VulkanRenderer::CreateCommandRecorder()
+{
+    if(!WaitForGraphicsPipeline())
+        return false;
+    
+    m_CommandRecorder = new VulkanCommandRecorder();
+    return m_CommandRecorder->Init(m_QueueFamilyIndices.m_GraphicsFamily, MAX_FRAMES_IN_FLIGHT);
+}
+
+bool VulkanRenderer::CreateInstanceBatcher()
+{
+    m_InstanceBatcher = new VulkanInstanceBatcher();
+    return m_InstanceBatcher->Init(MAX_FRAMES_IN_FLIGHT);
+}
+
+bool VulkanRenderer::CreateGpuCuller()
+{
+    // an unsupported culler is not an error, the cpu batcher keeps drawing
+    m_GpuCuller = new VulkanGpuCuller();
+    return m_GpuCuller->Init(MAX_FRAMES_IN_FLIGHT, MAX_GPU_OBJECTS, CULL_SHADER_PATH, OCCLUSION_CULL_SHADER_PATH);
+}
+
+bool VulkanRenderer::CreateDepthPyramid()
+{
+    // made for the swapchain extent with the first frame's render graph
+    m_DepthPyramid = new VulkanDepthPyramid();
+    return m_DepthPyramid->Init(HIZ_SHADER_PATH, m_DepthFormat);
+}
+
+bool VulkanRenderer::UseOcclusionCulling() const
+{
+    return m_GpuCuller && m_GpuCuller->IsOcclusionSupported() && m_DepthPyramid && m_DepthPyramid->IsSupported();
+}
+
+bool VulkanRenderer::CreateFrustumCuller()
+{
+    m_FrustumCuller = new Scene_FrustumCuller();
+    return true;
+}
+
+bool VulkanRenderer::CreateOcclusionCuller()
+{
+    m_OcclusionCuller = new Scene_OcclusionCuller();
+    m_OcclusionCuller->Init(OCCLUSION_BUFFER_WIDTH, OCCLUSION_BUFFER_HEIGHT);
+    
+    if(m_HouseOccluderModel)
+    {
+        m_HouseOccluderMesh = m_OcclusionCuller->AddOccluderMesh(m_HouseOccluderModel->GetOccluderPositions(), m_HouseOccluderModel->GetOccluderIndices());
+        return true;
+    }
+    
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    BuildOccluderBox(m_HouseModel->GetBounds(), OCCLUDER_BOX_SCALE, positions, indices);
+    
+    std::cout << "No occluder mesh at " << OCCLUDER_MODEL_PATH << ", occluding with the house bounds" << std::endl;
+    m_HouseOccluderMesh = m_OcclusionCuller->AddOccluderMesh(positions, indices);
+    
+    return true;
+}
+
+bool VulkanRenderer::CreateDynamicResolution()
 {
-    m_DescriptorSet.resize(m_SwapChainCount);
+    // without timestamps the frame draws straight to the swapchain at full resolution
+    m_GpuTimer = new VulkanGpuTimer();
+    
+    if(!m_GpuTimer->Init(MAX_FRAMES_IN_FLIGHT, m_QueueFamilyIndices.m_GraphicsFamily))
+        return false;
+    
+    m_ResolutionScaler = new VulkanResolutionScaler();
+    m_ResolutionScaler->Init(DYNAMIC_RESOLUTION_BUDGET_MS, DYNAMIC_RESOLUTION_MIN_SCALE);
     
-    std::vector<VkDescriptorSetLayout> layouts(m_SwapChainCount, m_DescriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = m_DescriptorPool;
-    allocInfo.descriptorSetCount = m_SwapChainCount;
-    allocInfo.pSetLayouts = layouts.data();
+    if(m_GpuTimer->IsSupported() && !m_SwapChainBlitTarget)
+        std::cout << "Dynamic resolution disabled: the swapchain cannot be blitted to" << std::endl;
     
-    if(vkAllocateDescriptorSets(m_Device, &allocInfo, m_DescriptorSet.data()) != VK_SUCCESS)
+    return true;
+}
+
+bool VulkanRenderer::UseDynamicResolution() const
+{
+    return m_GpuTimer && m_GpuTimer->IsSupported() && m_SwapChainBlitTarget;
+}
+
+bool VulkanRenderer::UseSoftwareOcclusion() const
+{
+    return m_OcclusionCuller != nullptr;
+}
+
+bool VulkanRenderer::UseGpuCulling() const
+{
+    if(PREFER_CPU_OCCLUSION && UseSoftwareOcclusion())
         return false;
     
-    for(int i = 0; i < m_SwapChainCount; ++i)
+    return m_GpuCuller && m_GpuCuller->IsSupported();
+}
+
+bool VulkanRenderer::GatherDraws()
+{
+    m_DrawList.clear();
+    m_LateDrawList.clear();
+    
+    VulkanDrawItem houseDraw;
+    houseDraw.m_Pipeline = m_PipelineManager->GetPipeline(m_GraphicsPipelineState);
+    houseDraw.m_Layout = m_PipelineLayout;
+    houseDraw.m_DescriptorSet = m_DescriptorSet;
+    houseDraw.m_DynamicOffsetCount = 1;
+    houseDraw.m_DynamicOffset = m_ViewConstantsOffset;
+    
+    // one table bind covers every texture, the classic pipeline draws until the bindless one has compiled
+    if(m_BindlessPipelineLayout != VK_NULL_HANDLE)
     {
-        VkDescriptorSet& currentSet = m_DescriptorSet[i];
+        const VkPipeline bindlessPipeline = m_PipelineManager->GetPipeline(m_BindlessPipelineState);
         
-        VkDescriptorBufferInfo bufferInfo = {};
-        bufferInfo.buffer = m_ConstantBuffer;
-        bufferInfo.offset = m_MinConstantBufferSize * i;
-        bufferInfo.range = sizeof(ConstantBufferObject);
+        if(bindlessPipeline != VK_NULL_HANDLE)
+        {
+            houseDraw.m_Pipeline = bindlessPipeline;
+            houseDraw.m_Layout = m_BindlessPipelineLayout;
+            houseDraw.m_BindlessSet = m_BindlessTable->GetSet();
+            houseDraw.m_Material = m_HouseMaterial;
+        }
+    }
+    houseDraw.m_Model = m_HouseModel;
+    
+    const glm::vec4 houseBounds = m_HouseModel->GetBoundingSphere();
+    const float gridOffset = (HOUSE_GRID_SIZE - 1) * HOUSE_GRID_SPACING * 0.5f;
+    
+    m_ObjectTransforms.clear();
+    
+    for (int x = 0; x < HOUSE_GRID_SIZE; ++x)
+    {
+        for (int y = 0; y < HOUSE_GRID_SIZE; ++y)
+        {
+            const glm::vec3 position(-x * HOUSE_GRID_SPACING, y * HOUSE_GRID_SPACING - gridOffset, 0.0f);
+            m_ObjectTransforms.push_back(glm::translate(glm::mat4(1.0f), position) * m_HouseTransform);
+        }
+    }
+    
+    // with gpu culling the objects go to the cull pass and come back as one indirect draw
+    if(UseGpuCulling())
+    {
+        m_GpuCuller->Begin(m_CurrentFrame);
         
-        VkDescriptorImageInfo imageInfo = {};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = m_HouseTexture->GetImageView();
-        imageInfo.sampler = m_HouseTextureSampler;
+        for (const glm::mat4& transform : m_ObjectTransforms)
+        {
+            m_GpuCuller->AddObject(transform, houseBounds, m_HouseModel->GetIndexCount());
+        }
         
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+        if(m_GpuCuller->GetObjectCount() == 0)
+            return true;
         
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = currentSet;
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo = &bufferInfo;
-        descriptorWrites[0].pImageInfo = nullptr; // Optional
-        descriptorWrites[0].pTexelBufferView = nullptr; // Optional
+        m_DrawList.push_back(m_GpuCuller->GetDrawItem(houseDraw));
         
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = currentSet;
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &imageInfo;
+        // what the depth pyramid shows has just come into view, drawn after it in a second pass
+        if(UseOcclusionCulling())
+            m_LateDrawList.push_back(m_GpuCuller->GetDrawItem(houseDraw, VulkanGpuCuller::CULL_PHASE_LATE));
         
-        vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        return true;
     }
     
-    return true;
+    // otherwise cull on the cpu and let the batcher fold the survivors into instanced draws
+    m_FrustumCuller->Clear();
+    
+    for (const glm::mat4& transform : m_ObjectTransforms)
+    {
+        const glm::vec4 sphere = TransformSphere(transform, houseBounds);
+        m_FrustumCuller->AddSphere(glm::vec3(sphere), sphere.w);
+    }
+    
+    m_FrustumCuller->Cull(Scene_Frustum(m_ViewProj), m_VisibleObjects, Core_JobSystem::GetInstance());
+    
+    if(UseSoftwareOcclusion())
+        CullOccludedObjects();
+    
+    m_InstanceBatcher->Begin(m_CurrentFrame);
+    
+    for (uint32_t objectIndex : m_VisibleObjects)
+    {
+        const glm::mat4& transform = m_ObjectTransforms[objectIndex];
+        
+        // post projection depth is zero to one, good enough to bucket front to back
+        const glm::vec4 clipCenter = m_ViewProj * transform * glm::vec4(glm::vec3(houseBounds), 1.0f);
+        const float depth = clipCenter.w > 0.0f ? clipCenter.z / clipCenter.w : 0.0f;
+        
+        m_InstanceBatcher->Add(houseDraw, transform, depth);
+    }
+    
+    return m_InstanceBatcher->Build(m_DrawList, Core_JobSystem::GetInstance());
 }
 
-bool VulkanRenderer::CreateCommandBuffers()
+void VulkanRenderer::CullOccludedObjects()
 {
-    m_CommandBuffers.resize(m_SwapChainCount);
+    const Scene_Aabb houseBounds = m_HouseModel->GetBounds();
     
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = m_CommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)m_CommandBuffers.size();
+    m_ObjectBounds.clear();
     
-    bool created = vkAllocateCommandBuffers(m_Device, &allocInfo, m_CommandBuffers.data()) == VK_SUCCESS;
+    for (const glm::mat4& transform : m_ObjectTransforms)
+    {
+        m_ObjectBounds.push_back(houseBounds.Transformed(transform));
+    }
     
-    if(created)
+    // only what survived the frustum can hide anything
+    m_OcclusionCuller->ClearOccluders();
+    
+    for (uint32_t objectIndex : m_VisibleObjects)
     {
-        for (size_t i = 0, e = m_CommandBuffers.size(); i < e; ++i)
+        m_OcclusionCuller->AddOccluder(m_HouseOccluderMesh, m_ObjectTransforms[objectIndex]);
+    }
+    
+    m_OcclusionCuller->Render(m_ViewProj, Core_JobSystem::GetInstance());
+    m_OcclusionCuller->Cull(m_ObjectBounds, m_VisibleObjects);
+}
+
+void VulkanRenderer::ReportOcclusionStats()
+{
+    const Scene_OcclusionCuller::Stats& stats = m_OcclusionCuller->GetStats();
+    
+    if(stats == m_OcclusionStats)
+        return;
+    
+    m_OcclusionStats = stats;
+    
+    std::cout << "Software occlusion: " << stats.m_Occluded << " of " << stats.m_Tested << " objects hidden"
+              << " by " << stats.m_Occluders << " occluders (" << stats.m_Triangles << " triangles)" << std::endl;
+}
+
+void VulkanRenderer::ReportBindStats()
+{
+    const VulkanRenderQueue& queue = m_InstanceBatcher->GetQueue();
+    const VulkanRenderQueue::BindStats& submitStats = queue.GetSubmitStats();
+    const VulkanRenderQueue::BindStats& sortedStats = queue.GetSortedStats();
+    
+    // from the last frame built, only when the scene changed since the last report
+    if(submitStats == m_SubmitBindStats && sortedStats == m_SortedBindStats)
+        return;
+    
+    m_SubmitBindStats = submitStats;
+    m_SortedBindStats = sortedStats;
+    
+    std::cout << "Binds per frame: " << submitStats.GetTotal() << " in submit order, " << sortedStats.GetTotal() << " sorted"
+              << " (pipelines " << submitStats.m_Pipelines << " -> " << sortedStats.m_Pipelines
+              << ", sets " << submitStats.m_DescriptorSets << " -> " << sortedStats.m_DescriptorSets
+              << ", meshes " << submitStats.m_Meshes << " -> " << sortedStats.m_Meshes << ")" << std::endl;
+}
+
+void VulkanRenderer::ReportCullStats()
+{
+    const VulkanGpuCuller::CullStats& stats = m_GpuCuller->GetStats();
+    
+    // read back from the last frame finished, only when what is hidden changed since the last report
+    if(stats == m_CullStats)
+        return;
+    
+    m_CullStats = stats;
+    
+    std::cout << "Objects culled: " << stats.m_FrustumCulled + stats.m_OcclusionCulled << " of " << stats.m_Objects
+              << " (frustum " << stats.m_FrustumCulled << ", occlusion " << stats.m_OcclusionCulled << ")"
+              << ", drawn " << stats.m_DrawnEarly + stats.m_DrawnLate
+              << " (" << stats.m_DrawnEarly << " visible last frame, " << stats.m_DrawnLate << " newly visible)" << std::endl;
+}
+
+void VulkanRenderer::ReportAttachmentMemory()
+{
+    const VulkanRenderGraph::MemoryStats& stats = m_RenderGraph->GetMemoryStats();
+    
+    // from the last graph built, only when the transients changed since the last report
+    if(stats == m_AttachmentMemoryStats)
+        return;
+    
+    m_AttachmentMemoryStats = stats;
+    
+    const VkDeviceSize kb = 1024;
+    
+    std::cout << "Transient attachments: " << stats.m_ImageBytes / kb << " KB in images, " << stats.m_AllocatedBytes / kb << " KB allocated"
+              << " (" << stats.m_LazyBytes / kb << " KB lazily), "
+              << stats.m_SkippedBytes / kb << " KB of loads and stores skipped a frame" << std::endl;
+}
+
+void VulkanRenderer::UpdateRenderResolution()
+{
+    float gpuMilliseconds = 0.0f;
+    
+    // as many frames old as there are in flight by the time it is read, the smoothing in the scaler covers the lag
+    if(UseDynamicResolution() && m_GpuTimer->Resolve(m_CurrentFrame, gpuMilliseconds) && !m_FullScaleFrame)
+        m_ResolutionScaler->Update(gpuMilliseconds);
+    
+    // a slow time read now would drop the scale again and the idle frame would never settle
+    m_FullScaleFrame = false;
+    
+    m_RenderExtent = UseDynamicResolution() ? m_ResolutionScaler->GetRenderExtent(m_SwapChainExtent) : m_SwapChainExtent;
+}
+
+void VulkanRenderer::ReportRenderResolution()
+{
+    // the scale moves in small steps, a second's worth of them make one line
+    if(m_RenderExtent.width == m_ReportedRenderExtent.width && m_RenderExtent.height == m_ReportedRenderExtent.height)
+        return;
+    
+    m_ReportedRenderExtent = m_RenderExtent;
+    
+    std::cout << "Render resolution: " << m_RenderExtent.width << "x" << m_RenderExtent.height
+              << " of " << m_SwapChainExtent.width << "x" << m_SwapChainExtent.height;
+    
+    if(UseDynamicResolution())
+        std::cout << " (gpu " << m_ResolutionScaler->GetSmoothedMilliseconds() << " ms, budget " << DYNAMIC_RESOLUTION_BUDGET_MS << " ms)";
+    
+    std::cout << std::endl;
+}
+
+void VulkanRenderer::RecordUpscale(VkCommandBuffer aCmdBuffer, uint32_t anImageIndex)
+{
+    VkImageBlit blit = {};
+    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.layerCount = 1;
+    blit.srcOffsets[1] = { static_cast<int32_t>(m_RenderExtent.width), static_cast<int32_t>(m_RenderExtent.height), 1 };
+    blit.dstSubresource = blit.srcSubresource;
+    blit.dstOffsets[1] = { static_cast<int32_t>(m_SwapChainExtent.width), static_cast<int32_t>(m_SwapChainExtent.height), 1 };
+    
+    vkCmdBlitImage(aCmdBuffer, m_RenderGraph->GetImage(m_ColorTargetID), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   m_SwapChainImages[anImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+}
+
+void VulkanRenderer::SetupDepthPrepass()
+{
+    m_PrepassDrawList.clear();
+    
+    bool active = WantsDepthPrepass() && !m_DrawList.empty() && m_PipelineManager->IsReady(m_DepthPrepassState);
+    
+    // the main pass can only test EQUAL once its own pipelines exist, until then it draws as before
+    for (const VulkanDrawItem& draw : m_DrawList)
+    {
+        active = active && m_PipelineManager->IsReady(GetDepthEqualState(draw));
+    }
+    
+    m_DepthPrepassActive = active;
+    
+    if(!active)
+        return;
+    
+    const VkPipeline prepassPipeline = m_PipelineManager->GetPipeline(m_DepthPrepassState);
+    
+    // the same draws, indirect ones included, with positions only and no material
+    for (VulkanDrawItem& draw : m_DrawList)
+    {
+        VulkanDrawItem prepassDraw = draw;
+        prepassDraw.m_Pipeline = prepassPipeline;
+        prepassDraw.m_Layout = m_PipelineLayout;
+        prepassDraw.m_BindlessSet = VK_NULL_HANDLE;
+        prepassDraw.m_PositionOnly = true;
+        m_PrepassDrawList.push_back(prepassDraw);
+        
+        draw.m_Pipeline = m_PipelineManager->GetPipeline(GetDepthEqualState(draw));
+    }
+}
+
+bool VulkanRenderer::WantsDepthPrepass()
+{
+    bool wanted = m_DepthPrepassMode == DEPTH_PREPASS_ON;
+    
+    if(m_DepthPrepassMode == DEPTH_PREPASS_AUTO)
+    {
+        m_EstimatedOverdraw = EstimateOverdraw();
+        wanted = m_EstimatedOverdraw > (m_DepthPrepassWanted ? DEPTH_PREPASS_OFF_OVERDRAW : DEPTH_PREPASS_ON_OVERDRAW);
+    }
+    
+    m_DepthPrepassWanted = wanted;
+    
+    return wanted;
+}
+
+void VulkanRenderer::ReportDepthPrepass()
+{
+    // the hysteresis keeps it from flipping every frame, this only says where it settled
+    if(m_DepthPrepassWanted == m_ReportedDepthPrepass)
+        return;
+    
+    m_ReportedDepthPrepass = m_DepthPrepassWanted;
+    
+    std::cout << "Depth pre-pass " << (m_DepthPrepassWanted ? "on" : "off");
+    
+    if(m_DepthPrepassMode == DEPTH_PREPASS_AUTO)
+        std::cout << " (estimated overdraw " << m_EstimatedOverdraw << ")";
+    
+    std::cout << std::endl;
+}
+
+float VulkanRenderer::EstimateOverdraw() const
+{
+    const Scene_Aabb houseBounds = m_HouseModel->GetBounds();
+    
+    float coverage = 0.0f;
+    
+    // the gpu culls after this runs, off screen boxes add nothing anyway
+    if(UseGpuCulling())
+    {
+        for (const glm::mat4& transform : m_ObjectTransforms)
         {
-            VkCommandBuffer& currentCmdBuffer = m_CommandBuffers[i];
-            
-            VkCommandBufferBeginInfo beginInfo = {};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-            beginInfo.pInheritanceInfo = nullptr; // Optional
-            
-            created &= vkBeginCommandBuffer(currentCmdBuffer, &beginInfo) == VK_SUCCESS;
+            coverage += GetScreenCoverage(m_ViewProj * transform, houseBounds);
+        }
+    }
+    else
+    {
+        for (uint32_t objectIndex : m_VisibleObjects)
+        {
+            coverage += GetScreenCoverage(m_ViewProj * m_ObjectTransforms[objectIndex], houseBounds);
+        }
+    }
+    
+    // covered pixels over screen pixels. boxes are looser than the meshes and a mesh's own
+    // overlap is missed, rough but it only has to land on the right side of the thresholds
+    return coverage;
+}
 
-            if(!created)
-                break;
-            
-            VkRenderPassBeginInfo renderPassInfo = {};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = m_RenderPass;
-            renderPassInfo.framebuffer = m_SwapChainFramebuffers[i];
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = m_SwapChainExtent;
-            
-            const float greyColor = 0.0f;
+VulkanPipelineState VulkanRenderer::GetDepthEqualState(const VulkanDrawItem& aDraw) const
+{
+    const bool bindless = m_BindlessPipelineLayout != VK_NULL_HANDLE && aDraw.m_Layout == m_BindlessPipelineLayout;
     
-            std::array<VkClearValue, 2> clearValues = {};
-            clearValues[0].color = {greyColor, greyColor, greyColor, 1.0f};
-            clearValues[1].depthStencil = {1.0f, 0};
+    return WithDepthEqual(bindless ? m_BindlessPipelineState : m_GraphicsPipelineState);
+}
 
-            renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-            renderPassInfo.pClearValues = clearValues.data();
-            
-            vkCmdBeginRenderPass(currentCmdBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-            {
-                vkCmdBindPipeline(currentCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
-                vkCmdBindDescriptorSets(currentCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet[i], 0, nullptr);
-                
-                m_HouseModel->Draw(currentCmdBuffer);
-            }
-            vkCmdEndRenderPass(currentCmdBuffer);
-            
-            created &= vkEndCommandBuffer(currentCmdBuffer) == VK_SUCCESS;
+bool VulkanRenderer::BuildRenderGraph(uint32_t anImageIndex)
+{
+    m_RenderGraph->Reset();
+    m_PrepassID = VulkanRenderGraph::INVALID_ID;
+    m_LatePassID = VulkanRenderGraph::INVALID_ID;
+    
+    // not made yet when the render pass builds the graph for its ops
+    const bool gpuCull = UseGpuCulling() && m_GpuCuller->GetObjectCount() > 0;
+    const bool occlusion = gpuCull && UseOcclusionCulling();
+    const bool prepass = m_DepthPrepassActive && !m_PrepassDrawList.empty();
+    const bool upscale = UseDynamicResolution();
+    
+    // drawn offscreen, nothing waits on the image until the blit and the scene is not held up by the acquire
+    const VulkanRenderGraph::ResourceUsage acquireUsage = upscale ? VulkanRenderGraph::USAGE_SWAPCHAIN_ACQUIRE_BLIT : VulkanRenderGraph::USAGE_SWAPCHAIN_ACQUIRE;
+    
+    m_BackBufferID = m_RenderGraph->ImportImage("back buffer", m_SwapChainImages[anImageIndex], VK_IMAGE_ASPECT_COLOR_BIT,
+                                                acquireUsage, VulkanRenderGraph::USAGE_PRESENT);
+    m_ColorTargetID = m_BackBufferID;
+    
+    // full size whatever the scale, the draw passes only cover m_RenderExtent of it
+    if(upscale)
+    {
+        VulkanRenderGraph::ImageDesc colorDesc = {};
+        colorDesc.m_Width = m_SwapChainExtent.width;
+        colorDesc.m_Height = m_SwapChainExtent.height;
+        colorDesc.m_Format = m_SwapChainImageFormat;
+        colorDesc.m_Usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        colorDesc.m_Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        
+        m_ColorTargetID = m_RenderGraph->CreateImage("scene color", colorDesc);
+    }
+    
+    VulkanRenderGraph::ImageDesc depthDesc = {};
+    depthDesc.m_Width = m_SwapChainExtent.width;
+    depthDesc.m_Height = m_SwapChainExtent.height;
+    depthDesc.m_Format = m_DepthFormat;
+    depthDesc.m_Usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (occlusion ? VK_IMAGE_USAGE_SAMPLED_BIT : 0);
+    depthDesc.m_Aspect = VulkanUtils::GetAspectFlags(m_DepthFormat);
+    
+    m_DepthID = m_RenderGraph->CreateImage("depth", depthDesc);
+    
+    VulkanRenderGraph::ResourceID cullCommands = VulkanRenderGraph::INVALID_ID;
+    VulkanRenderGraph::ResourceID cullCount = VulkanRenderGraph::INVALID_ID;
+    VulkanRenderGraph::ResourceID cullVisibility = VulkanRenderGraph::INVALID_ID;
+    VulkanRenderGraph::ResourceID cullStats = VulkanRenderGraph::INVALID_ID;
+    
+    if(gpuCull)
+    {
+        cullCommands = m_RenderGraph->ImportBuffer("cull commands", m_GpuCuller->GetCommandsBuffer());
+        cullCount = m_RenderGraph->ImportBuffer("cull count", m_GpuCuller->GetCountBuffer());
+        
+        const glm::mat4 viewProj = m_ViewProj;
+        const VulkanRenderGraph::PassID cullPass = m_RenderGraph->AddPass(occlusion ? "early cull" : "gpu cull", [this, viewProj, occlusion](VkCommandBuffer aCmdBuffer)
+        {
+            if(occlusion)
+                m_GpuCuller->RecordOcclusionCull(aCmdBuffer, viewProj, VulkanGpuCuller::CULL_PHASE_EARLY);
+            else
+                m_GpuCuller->RecordCull(aCmdBuffer, viewProj);
+        });
+        
+        m_RenderGraph->Write(cullPass, cullCommands, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+        m_RenderGraph->Write(cullPass, cullCount, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+        
+        if(occlusion)
+        {
+            // the previous frame's late cull left it there
+            cullVisibility = m_RenderGraph->ImportBuffer("cull visibility", m_GpuCuller->GetVisibilityBuffer(),
+                                                         VulkanRenderGraph::USAGE_STORAGE_COMPUTE, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+            cullStats = m_RenderGraph->ImportBuffer("cull stats", m_GpuCuller->GetStatsBuffer());
             
-            if(!created)
-                break;
+            m_RenderGraph->Read(cullPass, cullVisibility, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+            m_RenderGraph->Write(cullPass, cullStats, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
         }
     }
     
-    return created;
+    // the colour attachment is only there to keep the pass compatible, the main pass clears it after
+    if(prepass)
+    {
+        m_PrepassID = m_RenderGraph->AddPass("depth prepass", [this](VkCommandBuffer aCmdBuffer)
+        {
+            m_CommandRecorder->RecordDraws(aCmdBuffer, GetDrawRenderPass(m_PrepassID), m_PrepassDrawList);
+        });
+        
+        m_RenderGraph->Write(m_PrepassID, m_ColorTargetID, VulkanRenderGraph::USAGE_COLOR_ATTACHMENT);
+        m_RenderGraph->Write(m_PrepassID, m_DepthID, VulkanRenderGraph::USAGE_DEPTH_ATTACHMENT, true);
+        
+        if(cullCommands != VulkanRenderGraph::INVALID_ID)
+        {
+            m_RenderGraph->Read(m_PrepassID, cullCommands, VulkanRenderGraph::USAGE_INDIRECT);
+            m_RenderGraph->Read(m_PrepassID, cullCount, VulkanRenderGraph::USAGE_INDIRECT);
+        }
+    }
+    
+    m_MainPassID = m_RenderGraph->AddPass("main", [this](VkCommandBuffer aCmdBuffer)
+    {
+        m_CommandRecorder->ExecuteDraws(aCmdBuffer, GetDrawRenderPass(m_MainPassID));
+    });
+    
+    // after a pre-pass the depth is loaded and only tested against
+    m_RenderGraph->Write(m_MainPassID, m_ColorTargetID, VulkanRenderGraph::USAGE_COLOR_ATTACHMENT, true);
+    m_RenderGraph->Write(m_MainPassID, m_DepthID, VulkanRenderGraph::USAGE_DEPTH_ATTACHMENT, !prepass);
+    
+    if(cullCommands != VulkanRenderGraph::INVALID_ID)
+    {
+        m_RenderGraph->Read(m_MainPassID, cullCommands, VulkanRenderGraph::USAGE_INDIRECT);
+        m_RenderGraph->Read(m_MainPassID, cullCount, VulkanRenderGraph::USAGE_INDIRECT);
+    }
+    
+    if(occlusion && !BuildOcclusionPasses(cullVisibility, cullStats))
+        return false;
+    
+    if(upscale)
+    {
+        const VulkanRenderGraph::PassID upscalePass = m_RenderGraph->AddPass("upscale", [this, anImageIndex](VkCommandBuffer aCmdBuffer)
+        {
+            RecordUpscale(aCmdBuffer, anImageIndex);
+        });
+        
+        m_RenderGraph->Read(upscalePass, m_ColorTargetID, VulkanRenderGraph::USAGE_TRANSFER_SRC);
+        m_RenderGraph->Write(upscalePass, m_BackBufferID, VulkanRenderGraph::USAGE_TRANSFER_DST);
+    }
+    
+    if(!m_RenderGraph->Compile())
+        return false;
+    
+    // the depth image only exists once the graph has compiled
+    if(occlusion)
+        return m_DepthPyramid->SetDepthSource(m_RenderGraph->GetImage(m_DepthID));
+    
+    return true;
+}
+
+bool VulkanRenderer::BuildOcclusionPasses(VulkanRenderGraph::ResourceID aVisibility, VulkanRenderGraph::ResourceID aStats)
+{
+    if(!m_DepthPyramid->Resize(m_SwapChainExtent))
+        return false;
+    
+    // only what was drawn, stretched over the whole pyramid so the cull's screen mapping holds at any scale
+    m_DepthPyramid->SetSourceExtent(m_RenderExtent);
+    
+    m_GpuCuller->SetDepthPyramid(m_DepthPyramid->GetView(), m_DepthPyramid->GetSampler(),
+                                 m_DepthPyramid->GetWidth(), m_DepthPyramid->GetHeight(), m_DepthPyramid->GetLevelCount());
+    
+    // kept between frames, the late cull leaves it where the next frame's build starts from
+    const VulkanRenderGraph::ResourceID pyramid = m_RenderGraph->ImportImage("depth pyramid", m_DepthPyramid->GetImage(), VK_IMAGE_ASPECT_COLOR_BIT,
+                                                                             VulkanRenderGraph::USAGE_SAMPLED_COMPUTE, VulkanRenderGraph::USAGE_SAMPLED_COMPUTE);
+    
+    const VulkanRenderGraph::PassID pyramidPass = m_RenderGraph->AddPass("depth pyramid", [this](VkCommandBuffer aCmdBuffer)
+    {
+        m_DepthPyramid->Record(aCmdBuffer);
+    });
+    
+    m_RenderGraph->Read(pyramidPass, m_DepthID, VulkanRenderGraph::USAGE_SAMPLED_COMPUTE);
+    m_RenderGraph->Write(pyramidPass, pyramid, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+    
+    const VulkanRenderGraph::ResourceID lateCommands = m_RenderGraph->ImportBuffer("late cull commands", m_GpuCuller->GetCommandsBuffer(VulkanGpuCuller::CULL_PHASE_LATE));
+    const VulkanRenderGraph::ResourceID lateCount = m_RenderGraph->ImportBuffer("late cull count", m_GpuCuller->GetCountBuffer(VulkanGpuCuller::CULL_PHASE_LATE));
+    
+    const glm::mat4 viewProj = m_ViewProj;
+    const VulkanRenderGraph::PassID lateCullPass = m_RenderGraph->AddPass("late cull", [this, viewProj](VkCommandBuffer aCmdBuffer)
+    {
+        m_GpuCuller->RecordOcclusionCull(aCmdBuffer, viewProj, VulkanGpuCuller::CULL_PHASE_LATE);
+    });
+    
+    m_RenderGraph->Read(lateCullPass, pyramid, VulkanRenderGraph::USAGE_SAMPLED_COMPUTE);
+    m_RenderGraph->Write(lateCullPass, aVisibility, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+    m_RenderGraph->Write(lateCullPass, aStats, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+    m_RenderGraph->Write(lateCullPass, lateCommands, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+    m_RenderGraph->Write(lateCullPass, lateCount, VulkanRenderGraph::USAGE_STORAGE_COMPUTE);
+    
+    // loads what the main pass drew and adds the newly visible objects on top
+    m_LatePassID = m_RenderGraph->AddPass("late draws", [this](VkCommandBuffer aCmdBuffer)
+    {
+        m_CommandRecorder->RecordDraws(aCmdBuffer, GetDrawRenderPass(m_LatePassID), m_LateDrawList);
+    });
+    
+    m_RenderGraph->Write(m_LatePassID, m_ColorTargetID, VulkanRenderGraph::USAGE_COLOR_ATTACHMENT);
+    m_RenderGraph->Write(m_LatePassID, m_DepthID, VulkanRenderGraph::USAGE_DEPTH_ATTACHMENT);
+    m_RenderGraph->Read(m_LatePassID, lateCommands, VulkanRenderGraph::USAGE_INDIRECT);
+    m_RenderGraph->Read(m_LatePassID, lateCount, VulkanRenderGraph::USAGE_INDIRECT);
+    
+    return true;
+}
+
+bool VulkanRenderer::RecordCommandBuffer(uint32_t anImageIndex, VkCommandBuffer& outCmdBuffer)
+{
+    if(!GatherDraws())
+        return false;
+    
+    SetupDepthPrepass();
+    
+    if(!BuildRenderGraph(anImageIndex))
+        return false;
+    
+    const VkImageView colorView = m_ColorTargetID != m_BackBufferID ? m_RenderGraph->GetImageView(m_ColorTargetID) : VK_NULL_HANDLE;
+    
+    if(!UpdateFrameBuffers(colorView, m_RenderGraph->GetImageView(m_DepthID)))
+        return false;
+    
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = m_RenderPass;
+    renderPassInfo.framebuffer = m_SwapChainFramebuffers[anImageIndex];
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = m_RenderExtent;
+    
+    const float greyColor = 0.0f;
+    
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color = {greyColor, greyColor, greyColor, 1.0f};
+    clearValues[1].depthStencil = {1.0f, 0};
+    
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+    
+    // the graph runs the passes and their barriers in the primary, the main pass executes the recorded draws
+    return m_CommandRecorder->RecordFrame(m_CurrentFrame, renderPassInfo, m_DrawList, outCmdBuffer, [this](VkCommandBuffer aCmdBuffer)
+    {
+        m_GpuTimer->Begin(aCmdBuffer, m_CurrentFrame);
+        m_RenderGraph->Execute(aCmdBuffer);
+        m_GpuTimer->End(aCmdBuffer, m_CurrentFrame);
+    });
 }
 
 bool VulkanRenderer::CreateSyncObjects()
@@ -1204,17 +2538,15 @@ bool VulkanRenderer::CreateSyncObjects()
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    
     for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
     {
         SwapChainLocks& lockInfo = m_SwapChainLocks[i];
         created &= vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &lockInfo.m_ImageAvailable) == VK_SUCCESS;
         created &= vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &lockInfo.m_RenderFinished) == VK_SUCCESS;
         
-        created &= vkCreateFence(m_Device, &fenceInfo, nullptr, &lockInfo.m_InUse) == VK_SUCCESS;
+        // nothing submitted yet, the timeline reads 0 as done
+        lockInfo.m_SubmitValue = 0;
+        lockInfo.m_HasInputTime = false;
     }
     
     return created;
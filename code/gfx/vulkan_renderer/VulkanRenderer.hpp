@@ -11,13 +11,44 @@
 
 #include "IRenderer.hpp"
 #include "VulkanCommon.hpp"
+#include "VulkanPipelineBuilder.hpp"
+#include "VulkanCommandRecorder.hpp"
+#include "VulkanRenderQueue.hpp"
+#include "VulkanRenderGraph.hpp"
+#include "VulkanGpuCuller.hpp"
+#include "Scene_OcclusionCuller.hpp"
+
+#include <chrono>
 
 class VulkanModel;
 class VulkanTexture;
+class VulkanShaderLibrary;
+class VulkanLayoutCache;
+class VulkanPipelineBuilder;
+class VulkanPipelineManager;
+class VulkanInstanceBatcher;
+class VulkanUniformAllocator;
+class VulkanDescriptorAllocator;
+class VulkanBindlessTable;
+class VulkanGpuCuller;
+class VulkanDepthPyramid;
+class VulkanGpuTimer;
+class VulkanResolutionScaler;
+class VulkanTimeline;
+class VulkanDeletionQueue;
+class Scene_FrustumCuller;
 
 class VulkanRenderer : public IRenderer
 {
 public:
+    // a depth only pass ahead of the main one, so the main pass shades each pixel once
+    enum DepthPrepassMode
+    {
+        DEPTH_PREPASS_OFF,
+        DEPTH_PREPASS_ON,
+        DEPTH_PREPASS_AUTO,     // on while the estimated overdraw is high enough to pay for the extra geometry pass
+    };
+    
     VulkanRenderer(IWindow* aWindow);
     ~VulkanRenderer();
     
@@ -27,44 +58,102 @@ public:
     
     void WaitForSafeShutdown() override;
     
+    bool BeginFrame() override;
+    void EndFrame() override;
+    
+    // both take effect from the next frame, a new present mode recreates the swapchain
+    void SetFramesInFlight(uint32_t aCount) override;
+    void SetPresentMode(PresentMode aMode) override;
+    
+    void OnInputSampled() override;
+    bool TakeLatencyStats(LatencyStats& outStats) override;
+    void ReportStats() override;
+    
+    bool NeedsRedraw() override;
+    
     static VulkanRenderer* GetInstance() { return ourInstance; }
     
     VkCommandPool&       GetCommandPool() { return m_CommandPool; }
     VkPhysicalDevice&    GetPhysicalDevice() { return m_PhysicalDevice; }
     VkDevice&            GetLogicalDevice() { return m_Device; }
     VkQueue&             GetGraphicsQueue() { return m_GraphicsQueue; }
+    VulkanTimeline*      GetGraphicsTimeline() { return m_GraphicsTimeline; }
+    VulkanDeletionQueue* GetDeletionQueue() { return m_DeletionQueue; }
+    VulkanShaderLibrary* GetShaderLibrary() { return m_ShaderLibrary; }
+    VulkanLayoutCache*   GetLayoutCache() { return m_LayoutCache; }
+    VulkanPipelineBuilder* GetPipelineBuilder() { return m_PipelineBuilder; }
+    VulkanDescriptorAllocator* GetDescriptorAllocator() { return m_DescriptorAllocator; }
+    
+    const VkPhysicalDeviceProperties& GetDeviceProperties() const { return m_DeviceProperties; }
+    const DeviceCapabilities&         GetDeviceCapabilities() const { return m_DeviceCaps; }
+    
+    // per scene, a scene that knows its depth complexity can skip the estimate
+    void SetDepthPrepassMode(DepthPrepassMode aMode) { m_DepthPrepassMode = aMode; }
 private:
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
+    // what the per frame resources are made for, m_FramesInFlight of them are used
+    static const int MAX_FRAMES_IN_FLIGHT = 3;
+    
+    // the draw passes differ only in load and store ops, so all of them are compatible with m_RenderPass
+    struct RenderPassVariant
+    {
+        VulkanRenderGraph::AttachmentOps    m_ColorOps;
+        VulkanRenderGraph::AttachmentOps    m_DepthOps;
+        VkRenderPass                        m_RenderPass;
+    };
     
     struct SwapChainLocks
     {
         VkSemaphore m_ImageAvailable;
         VkSemaphore m_RenderFinished;
-        VkFence     m_InUse;
+        uint64_t    m_SubmitValue;  // on the graphics timeline, the frame is free once it is reached
+        
+        // when the input this frame was built from was read, if it was
+        std::chrono::steady_clock::time_point   m_InputTime;
+        bool                                    m_HasInputTime;
     };
     
     bool CreateVKInstance();
     bool CreateLogicalDevice();
+    bool CreateTimeline();
+    bool CreateDeletionQueue();
     bool CreateSurface();
     bool CreateSwapChain();
     bool CreateImageViews();
     bool CreateRenderPass();
+    bool CreateDrawRenderPass(const VulkanRenderGraph::AttachmentOps& aColorOps, const VulkanRenderGraph::AttachmentOps& aDepthOps, VkRenderPass& outRenderPass);
     bool CreateDescriptorSetLayout();
+    bool CreateShaderLibrary();
+    bool CreatePipelineBuilder();
+    bool CreatePipelineManager();
     bool CreateGraphicsPipeline();
     bool CreateCommandPool();
-    bool CreateDepthResources();
+    bool CreateRenderGraph();
     bool CreateFrameBuffers();
+    void DestroyFrameBuffers();
+    bool UpdateFrameBuffers(VkImageView aColorView, VkImageView aDepthView);
     bool CreateTextures();
     bool CreateSamplers();
     bool CreateModels();
-    bool CreateConstantBuffer();
-    bool CreateDescriptorPool();
+    bool CreateUniformAllocator();
+    bool CreateDescriptorAllocator();
     bool CreateDescriptorSet();
-    bool CreateCommandBuffers();
+    bool CreateBindlessTable();
+    bool CreateCommandRecorder();
+    bool CreateInstanceBatcher();
+    bool CreateGpuCuller();
+    bool CreateDepthPyramid();
+    bool CreateFrustumCuller();
+    bool CreateOcclusionCuller();
+    bool CreateDynamicResolution();
     bool CreateSyncObjects();
     
     bool CleanupSwapChain();
     bool RecreateSwapChain();
+    void DestroyGraphicsPipeline();
+    bool WaitForGraphicsPipeline();
+    void RegisterBindlessPass();
+    void WaitForFramesInFlight();
+    void CollectInputLatency(bool aWaited);
     void DeleteModels();
     void DeleteTextures();
     
@@ -72,7 +161,12 @@ private:
 
     bool IsDeviceSuitable(const VkPhysicalDevice& aDevice);
     bool DeviceSupportExtensions(const VkPhysicalDevice& aDevice);
+    void GetOptionalExtensions(const VkPhysicalDevice& aDevice, std::vector<const char*>& outExtensions);
     bool GetRequiredExtensions(std::vector<const char*>& outExtensions);
+    bool QueryDescriptorIndexing(const std::vector<const char*>& someExtensions, VkPhysicalDeviceDescriptorIndexingFeaturesEXT& outFeatures);
+    bool QueryTimelineSemaphore(const std::vector<const char*>& someExtensions, VkPhysicalDeviceTimelineSemaphoreFeaturesKHR& outFeatures);
+    
+    static bool HasExtension(const std::vector<const char*>& someExtensions, const char* anExtension);
     
     QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice& aDevice);
     
@@ -85,19 +179,47 @@ private:
     
     bool FindDepthFormat(VkFormat& outFormat);
     
-    void UpdateConstantBuffer(uint32_t aFrameOffset);
-    void DrawFrame();
+    void UpdateScene();
+    void UpdateViewConstants();
+    bool GatherDraws();
+    bool UseGpuCulling() const;
+    bool UseSoftwareOcclusion() const;
+    void CullOccludedObjects();
+    void ReportOcclusionStats();
+    void ReportBindStats();
+    void ReportCullStats();
+    void ReportAttachmentMemory();
+    bool UseDynamicResolution() const;
+    void UpdateRenderResolution();
+    void ReportRenderResolution();
+    void RecordUpscale(VkCommandBuffer aCmdBuffer, uint32_t anImageIndex);
+    void SetupDepthPrepass();
+    bool WantsDepthPrepass();
+    void ReportDepthPrepass();
+    float EstimateOverdraw() const;
+    VulkanPipelineState GetDepthEqualState(const VulkanDrawItem& aDraw) const;
+    bool UseOcclusionCulling() const;
+    bool BuildRenderGraph(uint32_t anImageIndex);
+    bool BuildOcclusionPasses(VulkanRenderGraph::ResourceID aVisibility, VulkanRenderGraph::ResourceID aStats);
+    
+    // a pass compatible with m_RenderPass with the ops the graph picked for aPass, made on first use
+    VkRenderPass GetDrawRenderPass(VulkanRenderGraph::PassID aPass);
+    bool RecordCommandBuffer(uint32_t anImageIndex, VkCommandBuffer& outCmdBuffer);
+    void AbandonFrame(SwapChainLocks& aLockInfo);
     
     VkInstance          m_VKInstance;
     VkPhysicalDevice    m_PhysicalDevice;
     VkDevice            m_Device;
     VkQueue             m_GraphicsQueue;
     VkQueue             m_PresentQueue;
+    VulkanTimeline*     m_GraphicsTimeline;     // every graphics queue submit goes through it
+    VulkanDeletionQueue* m_DeletionQueue;
     VkSurfaceKHR        m_Surface;
 
     QueueFamilyIndices m_QueueFamilyIndices;
     
     VkPhysicalDeviceProperties m_DeviceProperties;
+    DeviceCapabilities         m_DeviceCaps;
 
     VkSwapchainKHR                  m_SwapChain;
     VkFormat                        m_SwapChainImageFormat;
@@ -106,29 +228,96 @@ private:
     std::vector<VkImageView>        m_SwapChainImageViews;
     std::vector<VkFramebuffer>      m_SwapChainFramebuffers;
     uint32_t                        m_SwapChainCount;
+    bool                            m_SwapChainBlitTarget;  // transfer dst and a format that can be blitted to and from
     
 
     VkRenderPass                    m_RenderPass;
+    std::vector<RenderPassVariant>  m_RenderPassVariants;
     VkDescriptorSetLayout           m_DescriptorSetLayout;
-    VkDescriptorPool                m_DescriptorPool;
-    std::vector<VkDescriptorSet>    m_DescriptorSet;
+    VulkanDescriptorAllocator*      m_DescriptorAllocator;
+    VkDescriptorSet                 m_DescriptorSet;
     VkPipelineLayout                m_PipelineLayout;
-    VkPipeline                      m_GraphicsPipeline;
+    VulkanPipelineState             m_GraphicsPipelineState;
+    VulkanPipelineState             m_DepthPrepassState;
+    
+    // null layout when the device or the shader cannot do bindless
+    VulkanBindlessTable*            m_BindlessTable;
+    VkPipelineLayout                m_BindlessPipelineLayout;
+    VulkanPipelineState             m_BindlessPipelineState;
+    MaterialConstants               m_HouseMaterial;
     
     VkCommandPool                   m_CommandPool;
-    std::vector<VkCommandBuffer>    m_CommandBuffers;
+    VulkanCommandRecorder*          m_CommandRecorder;
+    VulkanInstanceBatcher*          m_InstanceBatcher;
+    VulkanGpuCuller*                m_GpuCuller;
+    VulkanDepthPyramid*             m_DepthPyramid;
+    VulkanGpuCuller::CullStats      m_CullStats;
+    Scene_FrustumCuller*            m_FrustumCuller;
+    std::vector<glm::mat4>          m_ObjectTransforms;
+    std::vector<uint32_t>           m_VisibleObjects;
+    Scene_OcclusionCuller*          m_OcclusionCuller;
+    uint32_t                        m_HouseOccluderMesh;
+    std::vector<Scene_Aabb>         m_ObjectBounds;
+    Scene_OcclusionCuller::Stats    m_OcclusionStats;
+    VulkanRenderQueue::BindStats    m_SubmitBindStats;
+    VulkanRenderQueue::BindStats    m_SortedBindStats;
+    std::vector<VulkanDrawItem>     m_DrawList;
+    std::vector<VulkanDrawItem>     m_LateDrawList;
+    std::vector<VulkanDrawItem>     m_PrepassDrawList;
+    DepthPrepassMode                m_DepthPrepassMode;
+    bool                            m_DepthPrepassWanted;
+    bool                            m_ReportedDepthPrepass;
+    float                           m_EstimatedOverdraw;    // of the last frame, auto mode only
+    bool                            m_DepthPrepassActive;   // wanted and every pipeline it needs has compiled
     
     SwapChainLocks  m_SwapChainLocks[MAX_FRAMES_IN_FLIGHT];
     int             m_CurrentFrame;
+    int             m_FramesInFlight;
+    int             m_WindowChangedID;
+    bool            m_SwapChainDirty;
+    PresentMode     m_PresentMode;
+    
+    // between BeginFrame and EndFrame
+    bool            m_FrameBegun;
+    uint32_t        m_ImageIndex;
     
-    VkBuffer        m_ConstantBuffer;
-    VkDeviceMemory  m_ConstantBufferMemory;
-    VkDeviceSize    m_MinConstantBufferSize;
+    // input read but not yet in a submitted frame, and the frames since the last TakeLatencyStats
+    std::chrono::steady_clock::time_point   m_PendingInputTime;
+    bool                                    m_HasPendingInput;
+    uint32_t                                m_LatencyFrames;
+    double                                  m_LatencyTotalMilliseconds;
+    float                                   m_LatencyWorstMilliseconds;
     
-    VkImage         m_DepthImage;
-    VkImageView     m_DepthImageView;
-    VkDeviceMemory  m_DepthImageMemory;
-    VkFormat        m_DepthFormat;
+    VulkanUniformAllocator*         m_UniformAllocator;
+    uint32_t                        m_ViewConstantsOffset;
+    
+    // the depth target is a render graph transient, the framebuffers are made for whichever view it has.
+    // so is the colour target with dynamic resolution, otherwise the framebuffers draw to the swapchain
+    VulkanRenderGraph*  m_RenderGraph;
+    VkImageView         m_FramebufferColorView;
+    VkImageView         m_FramebufferDepthView;
+    VkFormat            m_DepthFormat;
+    
+    // the last graph built, the render pass takes its attachment ops from the main pass
+    VulkanRenderGraph::ResourceID   m_BackBufferID;
+    VulkanRenderGraph::ResourceID   m_ColorTargetID;    // the back buffer unless the frame is upscaled to it
+    VulkanRenderGraph::ResourceID   m_DepthID;
+    VulkanRenderGraph::PassID       m_PrepassID;
+    VulkanRenderGraph::PassID       m_MainPassID;
+    VulkanRenderGraph::PassID       m_LatePassID;
+    VulkanRenderGraph::MemoryStats  m_AttachmentMemoryStats;
+    
+    VulkanShaderLibrary*            m_ShaderLibrary;
+    VulkanLayoutCache*              m_LayoutCache;
+    VulkanPipelineBuilder*          m_PipelineBuilder;
+    VulkanPipelineManager*          m_PipelineManager;
+    
+    // the draw passes cover m_RenderExtent of targets made at the swapchain extent, so a new scale never reallocates
+    VulkanGpuTimer*                 m_GpuTimer;
+    VulkanResolutionScaler*         m_ResolutionScaler;
+    VkExtent2D                      m_RenderExtent;
+    VkExtent2D                      m_ReportedRenderExtent;
+    bool                            m_FullScaleFrame;       // the last frame before idling, the scaler sits it out
     
     //textures & samplers
     VulkanTexture*  m_HouseTexture;
@@ -136,9 +325,18 @@ private:
     
     //models
     VulkanModel*    m_HouseModel;
+    VulkanModel*    m_HouseOccluderModel;
+    glm::mat4       m_HouseTransform;
+    glm::mat4       m_ViewProj;
+    ViewConstants   m_ViewConstants;
+    
+    // what the last submitted frame was drawn with, when nothing differs there is no need for another
+    glm::mat4       m_SubmittedHouseTransform;
+    glm::mat4       m_SubmittedViewProj;
     
     bool m_VKInstCreated;
     bool m_VKDeviceCreated;
+    bool m_HasDeviceProperties2;
     
     static VulkanRenderer* ourInstance;
 #ifdef _DEBUG
@@ -0,0 +1,95 @@
+//
+//  VulkanResolutionScaler.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanResolutionScaler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // weight of the newest frame, a few frames of history without lagging a real change for long
+    const float SMOOTHING = 0.1f;
+    
+    // aim under the budget so the time left over absorbs the noise
+    const float TARGET_FRACTION = 0.9f;
+    
+    // how far off the target the time has to be before the scale moves, and the most it moves at once
+    const float DEAD_ZONE = 0.05f;
+    const float MAX_STEP = 0.05f;
+    
+    // the scale is kept on a grid so the extent does not creep a pixel at a time
+    const float SCALE_GRANULARITY = 1.0f / 64.0f;
+}
+
+VulkanResolutionScaler::VulkanResolutionScaler()
+: m_BudgetMilliseconds(0.0f)
+, m_MinScale(1.0f)
+, m_MaxScale(1.0f)
+, m_Scale(1.0f)
+, m_SmoothedMilliseconds(0.0f)
+, m_HasSample(false)
+{
+}
+
+void VulkanResolutionScaler::Init(float aBudgetMilliseconds, float aMinScale, float aMaxScale)
+{
+    m_BudgetMilliseconds = aBudgetMilliseconds;
+    m_MinScale = std::min(aMinScale, aMaxScale);
+    m_MaxScale = aMaxScale;
+    m_Scale = aMaxScale;
+    m_SmoothedMilliseconds = 0.0f;
+    m_HasSample = false;
+}
+
+bool VulkanResolutionScaler::Update(float aGpuMilliseconds)
+{
+    if(m_BudgetMilliseconds <= 0.0f || aGpuMilliseconds <= 0.0f)
+        return false;
+    
+    if(m_HasSample)
+        m_SmoothedMilliseconds += (aGpuMilliseconds - m_SmoothedMilliseconds) * SMOOTHING;
+    else
+        m_SmoothedMilliseconds = aGpuMilliseconds;
+    
+    m_HasSample = true;
+    
+    const float ratio = (m_BudgetMilliseconds * TARGET_FRACTION) / m_SmoothedMilliseconds;
+    
+    if(std::abs(ratio - 1.0f) < DEAD_ZONE)
+        return false;
+    
+    // pixels go with the square of the scale
+    float scale = m_Scale * std::sqrt(ratio);
+    scale = std::max(m_Scale - MAX_STEP, std::min(m_Scale + MAX_STEP, scale));
+    scale = std::round(scale / SCALE_GRANULARITY) * SCALE_GRANULARITY;
+    scale = std::max(m_MinScale, std::min(m_MaxScale, scale));
+    
+    if(scale == m_Scale)
+        return false;
+    
+    m_Scale = scale;
+    
+    return true;
+}
+
+void VulkanResolutionScaler::Reset()
+{
+    m_Scale = m_MaxScale;
+    m_SmoothedMilliseconds = 0.0f;
+    m_HasSample = false;
+}
+
+VkExtent2D VulkanResolutionScaler::GetRenderExtent(const VkExtent2D& aMaxExtent) const
+{
+    VkExtent2D extent = {};
+    extent.width = std::min(aMaxExtent.width, std::max(1u, static_cast<uint32_t>(aMaxExtent.width * m_Scale + 0.5f)));
+    extent.height = std::min(aMaxExtent.height, std::max(1u, static_cast<uint32_t>(aMaxExtent.height * m_Scale + 0.5f)));
+    
+    return extent;
+}
@@ -0,0 +1,51 @@
+//
+//  VulkanResolutionScaler.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanResolutionScaler_hpp
+#define VulkanResolutionScaler_hpp
+
+#include "VulkanCommon.hpp"
+
+// Picks the render resolution from the measured GPU frame time. The cost of a frame is
+// taken to follow the pixels drawn, so the next scale is the current one times the
+// square root of how far the smoothed time is from the target.
+//
+// The target sits a little under the budget and small misses are ignored, a frame near
+// the edge should not flip between two sizes. Steps are capped so one slow frame, a
+// hitch or a shader compile, does not halve the resolution.
+class VulkanResolutionScaler
+{
+public:
+    VulkanResolutionScaler();
+    
+    // scales are per axis, 1 is the full extent
+    void Init(float aBudgetMilliseconds, float aMinScale, float aMaxScale = 1.0f);
+    
+    // the gpu time of a finished frame, true when the scale changed
+    bool Update(float aGpuMilliseconds);
+    
+    // back to the max scale with the history dropped, for a frame that has to be sharp
+    void Reset();
+    
+    float GetScale() const { return m_Scale; }
+    bool IsAtMaxScale() const { return m_Scale >= m_MaxScale; }
+    float GetSmoothedMilliseconds() const { return m_SmoothedMilliseconds; }
+    
+    // aMaxExtent at the current scale, at least a pixel a side
+    VkExtent2D GetRenderExtent(const VkExtent2D& aMaxExtent) const;
+
+private:
+    float   m_BudgetMilliseconds;
+    float   m_MinScale;
+    float   m_MaxScale;
+    float   m_Scale;
+    float   m_SmoothedMilliseconds;
+    bool    m_HasSample;
+};
+
+#endif /* VulkanResolutionScaler_hpp */
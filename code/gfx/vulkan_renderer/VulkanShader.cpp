@@ -7,46 +7,564 @@
 //
 
 #include "VulkanShader.hpp"
-#include <fstream>
 
-VulkanShader::VulkanShader(const char* aShaderFile)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // just the parts of the spir-v spec the reflection needs
+    const uint32_t SPV_MAGIC = 0x07230203;
+    const uint32_t SPV_HEADER_WORDS = 5;
+    
+    enum SpvOp
+    {
+        SPV_OP_ENTRY_POINT          = 15,
+        SPV_OP_TYPE_INT             = 21,
+        SPV_OP_TYPE_FLOAT           = 22,
+        SPV_OP_TYPE_VECTOR          = 23,
+        SPV_OP_TYPE_MATRIX          = 24,
+        SPV_OP_TYPE_IMAGE           = 25,
+        SPV_OP_TYPE_SAMPLER         = 26,
+        SPV_OP_TYPE_SAMPLED_IMAGE   = 27,
+        SPV_OP_TYPE_ARRAY           = 28,
+        SPV_OP_TYPE_RUNTIME_ARRAY   = 29,
+        SPV_OP_TYPE_STRUCT          = 30,
+        SPV_OP_TYPE_POINTER         = 32,
+        SPV_OP_CONSTANT             = 43,
+        SPV_OP_VARIABLE             = 59,
+        SPV_OP_DECORATE             = 71,
+        SPV_OP_MEMBER_DECORATE      = 72,
+    };
+    
+    enum SpvDecoration
+    {
+        SPV_DECORATION_BLOCK            = 2,
+        SPV_DECORATION_BUFFER_BLOCK     = 3,
+        SPV_DECORATION_ARRAY_STRIDE     = 6,
+        SPV_DECORATION_MATRIX_STRIDE    = 7,
+        SPV_DECORATION_BUILT_IN         = 11,
+        SPV_DECORATION_LOCATION         = 30,
+        SPV_DECORATION_BINDING          = 33,
+        SPV_DECORATION_DESCRIPTOR_SET   = 34,
+        SPV_DECORATION_OFFSET           = 35,
+    };
+    
+    enum SpvStorageClass
+    {
+        SPV_STORAGE_UNIFORM_CONSTANT    = 0,
+        SPV_STORAGE_INPUT               = 1,
+        SPV_STORAGE_UNIFORM             = 2,
+        SPV_STORAGE_PUSH_CONSTANT       = 9,
+        SPV_STORAGE_STORAGE_BUFFER      = 12,
+    };
+    
+    enum SpvExecutionModel
+    {
+        SPV_EXECUTION_VERTEX    = 0,
+        SPV_EXECUTION_FRAGMENT  = 4,
+        SPV_EXECUTION_COMPUTE   = 5,
+    };
+    
+    const uint32_t SPV_DIM_BUFFER = 5;
+    
+    struct SpvMember
+    {
+        SpvMember() : m_Offset(0), m_MatrixStride(0), m_BuiltIn(false) {}
+        
+        uint32_t    m_Offset;
+        uint32_t    m_MatrixStride;
+        bool        m_BuiltIn;
+    };
+    
+    // one entry per result id, filled in as the instructions are walked
+    struct SpvId
+    {
+        SpvId()
+        : m_Opcode(0), m_TypeID(0), m_StorageClass(0), m_Width(0), m_Count(0), m_Signed(0)
+        , m_ImageDim(0), m_ImageSampled(0), m_ArrayStride(0), m_Value(0)
+        , m_Set(0), m_Binding(0), m_Location(0)
+        , m_HasBinding(false), m_HasLocation(false), m_BuiltIn(false), m_Block(false), m_BufferBlock(false)
+        {}
+        
+        uint32_t    m_Opcode;
+        uint32_t    m_TypeID;       // pointee, element, component or column type
+        uint32_t    m_StorageClass;
+        uint32_t    m_Width;
+        uint32_t    m_Count;        // vector size, matrix columns or array length id
+        uint32_t    m_Signed;
+        uint32_t    m_ImageDim;
+        uint32_t    m_ImageSampled;
+        uint32_t    m_ArrayStride;
+        uint32_t    m_Value;
+        
+        uint32_t    m_Set;
+        uint32_t    m_Binding;
+        uint32_t    m_Location;
+        bool        m_HasBinding;
+        bool        m_HasLocation;
+        bool        m_BuiltIn;
+        bool        m_Block;
+        bool        m_BufferBlock;
+        
+        std::vector<uint32_t>   m_MemberTypes;
+        std::vector<SpvMember>  m_Members;
+    };
+    
+    uint32_t GetTypeSize(const std::vector<SpvId>& someIDs, uint32_t aTypeID, uint32_t aMatrixStride)
+    {
+        if(aTypeID >= someIDs.size())
+            return 0;
+        
+        const SpvId& type = someIDs[aTypeID];
+        
+        switch (type.m_Opcode)
+        {
+            case SPV_OP_TYPE_INT:
+            case SPV_OP_TYPE_FLOAT:
+                return type.m_Width / 8;
+            case SPV_OP_TYPE_VECTOR:
+                return type.m_Count * GetTypeSize(someIDs, type.m_TypeID, 0);
+            case SPV_OP_TYPE_MATRIX:
+            {
+                const uint32_t columnSize = aMatrixStride > 0 ? aMatrixStride : GetTypeSize(someIDs, type.m_TypeID, 0);
+                return type.m_Count * columnSize;
+            }
+            case SPV_OP_TYPE_ARRAY:
+            {
+                const uint32_t stride = type.m_ArrayStride > 0 ? type.m_ArrayStride : GetTypeSize(someIDs, type.m_TypeID, aMatrixStride);
+                return type.m_Count < someIDs.size() ? someIDs[type.m_Count].m_Value * stride : 0;
+            }
+            case SPV_OP_TYPE_STRUCT:
+            {
+                uint32_t size = 0;
+                
+                for (size_t i = 0; i < type.m_MemberTypes.size(); ++i)
+                {
+                    const SpvMember& member = type.m_Members[i];
+                    size = std::max(size, member.m_Offset + GetTypeSize(someIDs, type.m_MemberTypes[i], member.m_MatrixStride));
+                }
+                
+                return size;
+            }
+            default:
+                return 0;
+        }
+    }
+    
+    VkFormat GetVertexFormat(const std::vector<SpvId>& someIDs, uint32_t aTypeID)
+    {
+        const SpvId& type = someIDs[aTypeID];
+        const bool isVector = type.m_Opcode == SPV_OP_TYPE_VECTOR && type.m_TypeID < someIDs.size();
+        const SpvId& component = isVector ? someIDs[type.m_TypeID] : type;
+        const uint32_t count = isVector ? type.m_Count : 1;
+        
+        if(component.m_Width != 32 || count < 1 || count > 4)
+            return VK_FORMAT_UNDEFINED;
+        
+        static const VkFormat floatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+        static const VkFormat sintFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+        static const VkFormat uintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+        
+        if(component.m_Opcode == SPV_OP_TYPE_FLOAT)
+            return floatFormats[count - 1];
+        
+        if(component.m_Opcode == SPV_OP_TYPE_INT)
+            return component.m_Signed ? sintFormats[count - 1] : uintFormats[count - 1];
+        
+        return VK_FORMAT_UNDEFINED;
+    }
+    
+    bool GetDescriptorType(const std::vector<SpvId>& someIDs, const SpvId& aVariable, uint32_t aTypeID, VkDescriptorType& outType)
+    {
+        const SpvId& type = someIDs[aTypeID];
+        
+        switch (aVariable.m_StorageClass)
+        {
+            case SPV_STORAGE_UNIFORM_CONSTANT:
+                if(type.m_Opcode == SPV_OP_TYPE_SAMPLED_IMAGE)
+                {
+                    const bool isBuffer = someIDs[type.m_TypeID].m_ImageDim == SPV_DIM_BUFFER;
+                    outType = isBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                    return true;
+                }
+                
+                if(type.m_Opcode == SPV_OP_TYPE_SAMPLER)
+                {
+                    outType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                    return true;
+                }
+                
+                if(type.m_Opcode == SPV_OP_TYPE_IMAGE)
+                {
+                    const bool isBuffer = type.m_ImageDim == SPV_DIM_BUFFER;
+                    
+                    // sampled 2 means the image is only ever read and written without a sampler
+                    if(type.m_ImageSampled == 2)
+                        outType = isBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                    else
+                        outType = isBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                    
+                    return true;
+                }
+                
+                return false;
+            case SPV_STORAGE_UNIFORM:
+                // older glslang marks ssbos as uniform + BufferBlock
+                outType = type.m_BufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                return true;
+            case SPV_STORAGE_STORAGE_BUFFER:
+                outType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+ShaderReflection::ShaderReflection()
+: m_Stage(VK_SHADER_STAGE_VERTEX_BIT)
+, m_PushConstantSize(0)
+{
+}
+
+VulkanShader::VulkanShader(const char* aShaderFile, const char* anEntryPoint)
  : IShader(aShaderFile)
+ , m_EntryPoint(anEntryPoint)
+ , m_Code(nullptr)
+ , m_CodeSize(0)
+ , m_ShaderModule(VK_NULL_HANDLE)
 {
 }
-    
+
+VulkanShader::~VulkanShader()
+{
+    UnloadFile();
+}
+
 bool VulkanShader::Load()
 {
-    return LoadFile();
+    return LoadFile() && Reflect();
 }
 
 bool VulkanShader::LoadFile()
 {
-    std::ifstream file(m_ShaderFile, std::ios::ate | std::ios::binary);
+    if(m_Code)
+        return true;
+    
+    int fileHandle = open(m_ShaderFile.c_str(), O_RDONLY);
+    
+    if(fileHandle < 0)
+        return false;
+    
+    struct stat fileStats;
+    
+    // spir-v is a stream of 32 bit words, anything else is not a valid module
+    if(fstat(fileHandle, &fileStats) != 0 || fileStats.st_size == 0 || (fileStats.st_size % sizeof(uint32_t)) != 0)
+    {
+        close(fileHandle);
+        return false;
+    }
     
-    if (!file.is_open())
+    const size_t fileSize = static_cast<size_t>(fileStats.st_size);
+    void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileHandle, 0);
+    
+    // the mapping keeps its own reference to the file
+    close(fileHandle);
+    
+    if(mapped == MAP_FAILED)
         return false;
     
-    size_t fileSize = (size_t) file.tellg();
-    myFileBuffer.resize(fileSize);
+    m_Code = static_cast<const uint32_t*>(mapped);
+    m_CodeSize = fileSize;
+    
+    return true;
+}
 
-    file.seekg(0);
-    file.read(myFileBuffer.data(), fileSize);
+void VulkanShader::UnloadFile()
+{
+    if(!m_Code)
+        return;
+    
+    munmap(const_cast<uint32_t*>(m_Code), m_CodeSize);
+    
+    m_Code = nullptr;
+    m_CodeSize = 0;
+}
+
+bool VulkanShader::Reflect()
+{
+    const size_t wordCount = m_CodeSize / sizeof(uint32_t);
+    
+    if(wordCount < SPV_HEADER_WORDS || m_Code[0] != SPV_MAGIC)
+        return false;
+    
+    std::vector<SpvId> ids(m_Code[3]);
+    std::vector<uint32_t> variables;
+    bool foundEntryPoint = false;
+    
+    m_Reflection = ShaderReflection();
     
-    file.close();
+    for (size_t offset = SPV_HEADER_WORDS; offset < wordCount;)
+    {
+        const uint32_t* op = m_Code + offset;
+        const uint32_t opcode = op[0] & 0xffff;
+        const uint32_t opWords = op[0] >> 16;
+        
+        if(opWords == 0 || offset + opWords > wordCount)
+            return false;
+        
+        // every id we look at is range checked once here rather than per case
+        const uint32_t resultID = opWords > 1 ? op[1] : 0;
+        const uint32_t secondID = opWords > 2 ? op[2] : 0;
+        
+        if(resultID >= ids.size() && opcode != SPV_OP_ENTRY_POINT)
+        {
+            offset += opWords;
+            continue;
+        }
+        
+        switch (opcode)
+        {
+            case SPV_OP_ENTRY_POINT:
+            {
+                const char* name = reinterpret_cast<const char*>(op + 3);
+                
+                if(opWords > 3 && strncmp(name, m_EntryPoint.c_str(), (opWords - 3) * sizeof(uint32_t)) == 0)
+                {
+                    switch (op[1])
+                    {
+                        case SPV_EXECUTION_VERTEX: m_Reflection.m_Stage = VK_SHADER_STAGE_VERTEX_BIT; break;
+                        case SPV_EXECUTION_FRAGMENT: m_Reflection.m_Stage = VK_SHADER_STAGE_FRAGMENT_BIT; break;
+                        case SPV_EXECUTION_COMPUTE: m_Reflection.m_Stage = VK_SHADER_STAGE_COMPUTE_BIT; break;
+                        default: return false;
+                    }
+                    
+                    foundEntryPoint = true;
+                }
+                break;
+            }
+            case SPV_OP_TYPE_INT:
+            case SPV_OP_TYPE_FLOAT:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_Width = op[2];
+                ids[resultID].m_Signed = opcode == SPV_OP_TYPE_INT ? op[3] : 1;
+                break;
+            case SPV_OP_TYPE_VECTOR:
+            case SPV_OP_TYPE_MATRIX:
+            case SPV_OP_TYPE_ARRAY:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_TypeID = op[2];
+                ids[resultID].m_Count = op[3];
+                break;
+            case SPV_OP_TYPE_IMAGE:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_TypeID = op[2];
+                ids[resultID].m_ImageDim = op[3];
+                ids[resultID].m_ImageSampled = op[7];
+                break;
+            case SPV_OP_TYPE_SAMPLER:
+                ids[resultID].m_Opcode = opcode;
+                break;
+            case SPV_OP_TYPE_SAMPLED_IMAGE:
+            case SPV_OP_TYPE_RUNTIME_ARRAY:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_TypeID = op[2];
+                break;
+            case SPV_OP_TYPE_STRUCT:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_MemberTypes.assign(op + 2, op + opWords);
+                ids[resultID].m_Members.resize(std::max(ids[resultID].m_Members.size(), ids[resultID].m_MemberTypes.size()));
+                break;
+            case SPV_OP_TYPE_POINTER:
+                ids[resultID].m_Opcode = opcode;
+                ids[resultID].m_StorageClass = op[2];
+                ids[resultID].m_TypeID = op[3];
+                break;
+            case SPV_OP_CONSTANT:
+                // result type comes first for constants
+                if(secondID < ids.size())
+                {
+                    ids[secondID].m_Opcode = opcode;
+                    ids[secondID].m_Value = op[3];
+                }
+                break;
+            case SPV_OP_VARIABLE:
+                if(secondID < ids.size())
+                {
+                    ids[secondID].m_Opcode = opcode;
+                    ids[secondID].m_TypeID = op[1];
+                    ids[secondID].m_StorageClass = op[3];
+                    variables.push_back(secondID);
+                }
+                break;
+            case SPV_OP_DECORATE:
+            {
+                SpvId& target = ids[resultID];
+                
+                switch (op[2])
+                {
+                    case SPV_DECORATION_BLOCK: target.m_Block = true; break;
+                    case SPV_DECORATION_BUFFER_BLOCK: target.m_BufferBlock = true; break;
+                    case SPV_DECORATION_ARRAY_STRIDE: target.m_ArrayStride = op[3]; break;
+                    case SPV_DECORATION_BUILT_IN: target.m_BuiltIn = true; break;
+                    case SPV_DECORATION_LOCATION: target.m_Location = op[3]; target.m_HasLocation = true; break;
+                    case SPV_DECORATION_BINDING: target.m_Binding = op[3]; target.m_HasBinding = true; break;
+                    case SPV_DECORATION_DESCRIPTOR_SET: target.m_Set = op[3]; break;
+                    default: break;
+                }
+                break;
+            }
+            case SPV_OP_MEMBER_DECORATE:
+            {
+                SpvId& target = ids[resultID];
+                const uint32_t memberIndex = op[2];
+                
+                if(opWords < 4 || memberIndex > 0xffff)
+                    break;
+                
+                if(memberIndex >= target.m_Members.size())
+                    target.m_Members.resize(memberIndex + 1);
+                
+                SpvMember& member = target.m_Members[memberIndex];
+                
+                switch (op[3])
+                {
+                    case SPV_DECORATION_OFFSET: member.m_Offset = op[4]; break;
+                    case SPV_DECORATION_MATRIX_STRIDE: member.m_MatrixStride = op[4]; break;
+                    case SPV_DECORATION_BUILT_IN: member.m_BuiltIn = true; break;
+                    default: break;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        
+        offset += opWords;
+    }
+    
+    if(!foundEntryPoint)
+        return false;
+    
+    for (uint32_t variableID : variables)
+    {
+        const SpvId& variable = ids[variableID];
+        const SpvId& pointer = ids[variable.m_TypeID];
+        
+        if(pointer.m_Opcode != SPV_OP_TYPE_POINTER || pointer.m_TypeID >= ids.size())
+            continue;
+        
+        uint32_t typeID = pointer.m_TypeID;
+        
+        if(variable.m_StorageClass == SPV_STORAGE_INPUT)
+        {
+            if(m_Reflection.m_Stage != VK_SHADER_STAGE_VERTEX_BIT || variable.m_BuiltIn || !variable.m_HasLocation)
+                continue;
+            
+            // a matrix input takes one location per column
+            const bool isMatrix = ids[typeID].m_Opcode == SPV_OP_TYPE_MATRIX && ids[typeID].m_TypeID < ids.size();
+            const uint32_t locationCount = isMatrix ? ids[typeID].m_Count : 1;
+            const uint32_t columnTypeID = isMatrix ? ids[typeID].m_TypeID : typeID;
+            
+            for (uint32_t i = 0; i < locationCount; ++i)
+            {
+                ShaderVertexInput input;
+                input.m_Location = variable.m_Location + i;
+                input.m_Format = GetVertexFormat(ids, columnTypeID);
+                
+                m_Reflection.m_VertexInputs.push_back(input);
+            }
+            continue;
+        }
+        
+        if(variable.m_StorageClass == SPV_STORAGE_PUSH_CONSTANT)
+        {
+            m_Reflection.m_PushConstantSize = std::max(m_Reflection.m_PushConstantSize, GetTypeSize(ids, typeID, 0));
+            continue;
+        }
+        
+        if(!variable.m_HasBinding)
+            continue;
+        
+        ShaderBinding binding;
+        binding.m_Set = variable.m_Set;
+        binding.m_Binding = variable.m_Binding;
+        binding.m_Count = 1;
+        
+        // arrays of resources become a binding with a descriptor count
+        if(ids[typeID].m_Opcode == SPV_OP_TYPE_ARRAY && ids[typeID].m_Count < ids.size())
+        {
+            binding.m_Count = ids[ids[typeID].m_Count].m_Value;
+            typeID = ids[typeID].m_TypeID;
+        }
+        else if(ids[typeID].m_Opcode == SPV_OP_TYPE_RUNTIME_ARRAY)
+        {
+            binding.m_Count = 0;
+            typeID = ids[typeID].m_TypeID;
+        }
+        
+        if(typeID >= ids.size() || (ids[typeID].m_Opcode == SPV_OP_TYPE_SAMPLED_IMAGE && ids[typeID].m_TypeID >= ids.size()))
+            continue;
+        
+        if(!GetDescriptorType(ids, variable, typeID, binding.m_Type))
+            continue;
+        
+        m_Reflection.m_Bindings.push_back(binding);
+    }
+    
+    std::sort(m_Reflection.m_Bindings.begin(), m_Reflection.m_Bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b)
+    {
+        return a.m_Set != b.m_Set ? a.m_Set < b.m_Set : a.m_Binding < b.m_Binding;
+    });
+    
+    std::sort(m_Reflection.m_VertexInputs.begin(), m_Reflection.m_VertexInputs.end(), [](const ShaderVertexInput& a, const ShaderVertexInput& b)
+    {
+        return a.m_Location < b.m_Location;
+    });
     
     return true;
 }
 
-bool VulkanShader::CreateShaderModule(VkDevice& aDevice, VkShaderModule& outShaderMod) const
+bool VulkanShader::CreateShaderModule(VkDevice& aDevice)
 {
+    if(m_ShaderModule != VK_NULL_HANDLE)
+        return true;
+    
+    if(!m_Code)
+        return false;
+    
     VkShaderModuleCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = myFileBuffer.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(myFileBuffer.data());
+    createInfo.codeSize = m_CodeSize;
+    createInfo.pCode = m_Code;
     
-    bool success = vkCreateShaderModule(aDevice, &createInfo, nullptr, &outShaderMod) == VK_SUCCESS;
+    bool success = vkCreateShaderModule(aDevice, &createInfo, nullptr, &m_ShaderModule) == VK_SUCCESS;
 
     return success;
 }
 
+void VulkanShader::DestroyShaderModule(VkDevice& aDevice)
+{
+    if(m_ShaderModule == VK_NULL_HANDLE)
+        return;
+    
+    vkDestroyShaderModule(aDevice, m_ShaderModule, nullptr);
+    m_ShaderModule = VK_NULL_HANDLE;
+}
 
+VkPipelineShaderStageCreateInfo VulkanShader::GetStageCreateInfo(VkShaderStageFlagBits aStage) const
+{
+    VkPipelineShaderStageCreateInfo stageInfo = {};
+    stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageInfo.stage = aStage;
+    stageInfo.module = m_ShaderModule;
+    stageInfo.pName = m_EntryPoint.c_str();
+    
+    return stageInfo;
+}
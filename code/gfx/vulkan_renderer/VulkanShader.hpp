@@ -12,18 +12,65 @@
 #include "IShader.hpp"
 #include "VulkanCommon.hpp"
 
+//----------------------------------------------------------------------
+struct ShaderBinding
+{
+    uint32_t            m_Set;
+    uint32_t            m_Binding;
+    VkDescriptorType    m_Type;
+    uint32_t            m_Count;    // 0 for runtime sized arrays
+};
+
+//----------------------------------------------------------------------
+struct ShaderVertexInput
+{
+    uint32_t            m_Location;
+    VkFormat            m_Format;
+};
+
+//----------------------------------------------------------------------
+struct ShaderReflection
+{
+    ShaderReflection();
+    
+    VkShaderStageFlagBits           m_Stage;
+    std::vector<ShaderBinding>      m_Bindings;
+    std::vector<ShaderVertexInput>  m_VertexInputs;
+    uint32_t                        m_PushConstantSize;
+};
+
+//----------------------------------------------------------------------
 class VulkanShader : public IShader
 {
 public:
-    VulkanShader(const char* aShaderFile);
+    VulkanShader(const char* aShaderFile, const char* anEntryPoint = "main");
+    ~VulkanShader();
     
     bool Load() override;
-    bool CreateShaderModule(VkDevice& aDevice, VkShaderModule& outShaderMod) const;
     
+    bool CreateShaderModule(VkDevice& aDevice);
+    void DestroyShaderModule(VkDevice& aDevice);
+    
+    VkPipelineShaderStageCreateInfo GetStageCreateInfo(VkShaderStageFlagBits aStage) const;
+    
+    const VkShaderModule&   GetShaderModule() const { return m_ShaderModule; }
+    const std::string&      GetEntryPoint() const { return m_EntryPoint; }
+    const ShaderReflection& GetReflection() const { return m_Reflection; }
+
 private:
     bool LoadFile();
+    void UnloadFile();
+    bool Reflect();
+    
+    std::string     m_EntryPoint;
+    
+    // spir-v is memory mapped straight from disk and stays mapped for the lifetime of the shader
+    const uint32_t* m_Code;
+    size_t          m_CodeSize;
+    
+    VkShaderModule  m_ShaderModule;
     
-    std::vector<char> myFileBuffer;
+    ShaderReflection m_Reflection;
 };
 
 #endif /* VulkanShader_hpp */
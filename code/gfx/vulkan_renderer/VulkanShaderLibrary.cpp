@@ -0,0 +1,155 @@
+//
+//  VulkanShaderLibrary.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanShaderLibrary.hpp"
+#include "VulkanShader.hpp"
+#include "VulkanRenderer.hpp"
+
+#include "Core_Utils.hpp"
+
+VulkanShaderLibrary::VulkanShaderLibrary()
+{
+}
+
+VulkanShaderLibrary::~VulkanShaderLibrary()
+{
+    Shutdown();
+}
+
+void VulkanShaderLibrary::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(m_ShaderLock);
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    for (ShaderMap::value_type& entry : m_Shaders)
+    {
+        VulkanShader* shader = entry.second;
+        
+        if(renderer)
+            shader->DestroyShaderModule(renderer->GetLogicalDevice());
+        
+        Core_SafeDelete(shader);
+    }
+    
+    m_Shaders.clear();
+}
+
+std::string VulkanShaderLibrary::MakeKey(const std::string& aShaderFile, const std::string& anEntryPoint)
+{
+    return aShaderFile + ":" + anEntryPoint;
+}
+
+VulkanShader* VulkanShaderLibrary::LoadShader(const std::string& aShaderFile, const std::string& anEntryPoint)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer)
+        return nullptr;
+    
+    VulkanShader* shader = new VulkanShader(aShaderFile.c_str(), anEntryPoint.c_str());
+    
+    bool loaded = shader->Load();
+    
+    if(loaded)
+        loaded &= shader->CreateShaderModule(renderer->GetLogicalDevice());
+    
+    if(!loaded)
+    {
+        std::cout << "Failed to load shader: " << aShaderFile << std::endl;
+        Core_SafeDelete(shader);
+    }
+    
+    return shader;
+}
+
+const VulkanShader* VulkanShaderLibrary::GetShader(const char* aShaderFile, const char* anEntryPoint)
+{
+    const std::string key = MakeKey(aShaderFile, anEntryPoint);
+    
+    std::lock_guard<std::mutex> lock(m_ShaderLock);
+    
+    ShaderMap::const_iterator it = m_Shaders.find(key);
+    
+    if(it != m_Shaders.end())
+        return it->second;
+    
+    VulkanShader* shader = LoadShader(aShaderFile, anEntryPoint);
+    
+    if(shader)
+        m_Shaders[key] = shader;
+    
+    return shader;
+}
+
+bool VulkanShaderLibrary::LoadShaders(const std::vector<ShaderRequest>& someRequests)
+{
+    SCOPE_FUNCTION_MILLI();
+    
+    std::vector<const ShaderRequest*> pending;
+    
+    // only hand out the ones we have not already got
+    {
+        std::lock_guard<std::mutex> lock(m_ShaderLock);
+        std::set<std::string> requestedKeys;
+        
+        for (const ShaderRequest& request : someRequests)
+        {
+            const std::string key = MakeKey(request.m_ShaderFile, request.m_EntryPoint);
+            
+            if(m_Shaders.find(key) == m_Shaders.end() && requestedKeys.insert(key).second)
+                pending.push_back(&request);
+        }
+    }
+    
+    if(pending.empty())
+        return true;
+    
+    const size_t pendingCount = pending.size();
+    const size_t threadCount = std::min<size_t>(pendingCount, std::max(1u, std::thread::hardware_concurrency()));
+    
+    std::vector<VulkanShader*> loadedShaders(pendingCount, nullptr);
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    
+    // vkCreateShaderModule needs no external sync on the device so each worker loads a strided slice
+    for (size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+    {
+        workers.emplace_back([this, threadIndex, threadCount, pendingCount, &pending, &loadedShaders]()
+        {
+            for (size_t i = threadIndex; i < pendingCount; i += threadCount)
+            {
+                loadedShaders[i] = LoadShader(pending[i]->m_ShaderFile, pending[i]->m_EntryPoint);
+            }
+        });
+    }
+    
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    
+    bool success = true;
+    
+    std::lock_guard<std::mutex> lock(m_ShaderLock);
+    
+    for (size_t i = 0; i < pendingCount; ++i)
+    {
+        VulkanShader* shader = loadedShaders[i];
+        
+        if(!shader)
+        {
+            success = false;
+            continue;
+        }
+        
+        m_Shaders[MakeKey(pending[i]->m_ShaderFile, pending[i]->m_EntryPoint)] = shader;
+    }
+    
+    return success;
+}
@@ -0,0 +1,52 @@
+//
+//  VulkanShaderLibrary.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanShaderLibrary_hpp
+#define VulkanShaderLibrary_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <mutex>
+#include <string>
+
+class VulkanShader;
+
+// Owns every shader module for the lifetime of the device. Shaders are keyed by
+// file path and entry point so pipeline rebuilds never touch the disk again.
+class VulkanShaderLibrary
+{
+public:
+    struct ShaderRequest
+    {
+        std::string m_ShaderFile;
+        std::string m_EntryPoint;
+    };
+    
+    VulkanShaderLibrary();
+    ~VulkanShaderLibrary();
+    
+    void Shutdown();
+    
+    // returns the cached shader, loading it on first use. nullptr on failure
+    const VulkanShader* GetShader(const char* aShaderFile, const char* anEntryPoint = "main");
+    
+    // loads every request across worker threads, intended for startup
+    bool LoadShaders(const std::vector<ShaderRequest>& someRequests);
+
+private:
+    typedef std::unordered_map<std::string, VulkanShader*> ShaderMap;
+    
+    static std::string MakeKey(const std::string& aShaderFile, const std::string& anEntryPoint);
+    
+    VulkanShader* LoadShader(const std::string& aShaderFile, const std::string& anEntryPoint);
+    
+    ShaderMap   m_Shaders;
+    std::mutex  m_ShaderLock;
+};
+
+#endif /* VulkanShaderLibrary_hpp */
@@ -8,6 +8,7 @@
 
 #include "VulkanTexture.hpp"
 #include "VulkanRenderer.hpp"
+#include "VulkanDeletionQueue.hpp"
 
 #include "VulkanUtils.hpp"
 
@@ -21,12 +22,12 @@ VulkanTexture::VulkanTexture(const char* aTextureFile)
 
 VulkanTexture::~VulkanTexture()
 {
-    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
-    VkDevice& aDevice = renderer->GetLogicalDevice();
+    // frames in flight may still sample it
+    VulkanDeletionQueue* deletionQueue = VulkanRenderer::GetInstance()->GetDeletionQueue();
     
-    vkDestroyImageView(aDevice, m_ImageView, nullptr);
-    vkDestroyImage(aDevice, m_Image, nullptr);
-    vkFreeMemory(aDevice, m_ImageMemory, nullptr);
+    deletionQueue->RetireImageView(m_ImageView);
+    deletionQueue->RetireImage(m_Image);
+    deletionQueue->RetireMemory(m_ImageMemory);
 }
 
 bool VulkanTexture::Load()
@@ -78,6 +79,8 @@ bool VulkanTexture::CreateImage()
     
     stbi_image_free(pixels);
     
+    bool uploaded = false;
+    
     {
         const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
         const VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -85,15 +88,15 @@ bool VulkanTexture::CreateImage()
         const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
         
         VulkanUtils::CreateImage(texWidth, texHeight, m_MipLevels, format, tiling, usage, properties, m_Image, m_ImageMemory);
-        VulkanUtils::TransitionImageLayout(m_Image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
-        VulkanUtils::CopyBufferToImage(stagingBuffer, m_Image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-        VulkanUtils::GenerateMipmaps(m_Image, texWidth, texHeight, m_MipLevels);
+        uploaded = VulkanUtils::TransitionImageLayout(m_Image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels)
+                && VulkanUtils::CopyBufferToImage(stagingBuffer, m_Image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight))
+                && VulkanUtils::GenerateMipmaps(m_Image, texWidth, texHeight, m_MipLevels);
     }
     
     vkDestroyBuffer(aDevice, stagingBuffer, nullptr);
     vkFreeMemory(aDevice, stagingBufferMemory, nullptr);
     
-    return true;
+    return uploaded;
 }
 
 bool VulkanTexture::CreateImageView()
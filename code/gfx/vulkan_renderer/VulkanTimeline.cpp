@@ -0,0 +1,214 @@
+//
+//  VulkanTimeline.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanTimeline.hpp"
+#include "VulkanRenderer.hpp"
+
+#include <algorithm>
+
+VulkanTimeline::VulkanTimeline()
+: m_Queue(VK_NULL_HANDLE)
+, m_Semaphore(VK_NULL_HANDLE)
+, m_LastSubmitted(0)
+, m_Completed(0)
+{
+}
+
+VulkanTimeline::~VulkanTimeline()
+{
+}
+
+bool VulkanTimeline::Init(VkQueue aQueue)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    m_Queue = aQueue;
+    
+    if(!renderer->GetDeviceCapabilities().m_TimelineSemaphore)
+    {
+        std::cout << "Timeline semaphores disabled: VK_KHR_timeline_semaphore not supported, using fences" << std::endl;
+        return true;
+    }
+    
+    VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = 0;
+    
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    
+    return vkCreateSemaphore(renderer->GetLogicalDevice(), &semaphoreInfo, nullptr, &m_Semaphore) == VK_SUCCESS;
+}
+
+void VulkanTimeline::Shutdown()
+{
+    VkDevice device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    if(m_Semaphore != VK_NULL_HANDLE)
+        vkDestroySemaphore(device, m_Semaphore, nullptr);
+    
+    for (const PendingFence& pending : m_PendingFences)
+    {
+        vkDestroyFence(device, pending.m_Fence, nullptr);
+    }
+    
+    for (VkFence fence : m_FreeFences)
+    {
+        vkDestroyFence(device, fence, nullptr);
+    }
+    
+    m_Semaphore = VK_NULL_HANDLE;
+    m_PendingFences.clear();
+    m_FreeFences.clear();
+}
+
+uint64_t VulkanTimeline::Submit(const VkSubmitInfo& aSubmitInfo)
+{
+    if(!UsesTimelineSemaphore())
+        return SubmitWithFence(aSubmitInfo);
+    
+    const uint64_t value = m_LastSubmitted + 1;
+    
+    // the binary semaphores the caller signals keep their place, their values are ignored
+    m_SignalSemaphores.assign(aSubmitInfo.pSignalSemaphores, aSubmitInfo.pSignalSemaphores + aSubmitInfo.signalSemaphoreCount);
+    m_SignalValues.assign(aSubmitInfo.signalSemaphoreCount, 0);
+    m_SignalSemaphores.push_back(m_Semaphore);
+    m_SignalValues.push_back(value);
+    
+    VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timelineInfo.pNext = aSubmitInfo.pNext;
+    timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(m_SignalValues.size());
+    timelineInfo.pSignalSemaphoreValues = m_SignalValues.data();
+    
+    VkSubmitInfo submitInfo = aSubmitInfo;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.signalSemaphoreCount = static_cast<uint32_t>(m_SignalSemaphores.size());
+    submitInfo.pSignalSemaphores = m_SignalSemaphores.data();
+    
+    if(vkQueueSubmit(m_Queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        return 0;
+    
+    m_LastSubmitted = value;
+    return value;
+}
+
+uint64_t VulkanTimeline::SubmitWithFence(const VkSubmitInfo& aSubmitInfo)
+{
+    VkDevice device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    // whatever has signalled since the last look can be used again
+    RetireFences();
+    
+    VkFence fence = VK_NULL_HANDLE;
+    
+    if(!m_FreeFences.empty())
+    {
+        fence = m_FreeFences.back();
+        m_FreeFences.pop_back();
+    }
+    else
+    {
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        
+        if(vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+            return 0;
+    }
+    
+    if(vkQueueSubmit(m_Queue, 1, &aSubmitInfo, fence) != VK_SUCCESS)
+    {
+        m_FreeFences.push_back(fence);
+        return 0;
+    }
+    
+    m_PendingFences.push_back({ ++m_LastSubmitted, fence });
+    return m_LastSubmitted;
+}
+
+uint64_t VulkanTimeline::GetCompletedValue()
+{
+    if(!UsesTimelineSemaphore())
+    {
+        RetireFences();
+        return m_Completed;
+    }
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    uint64_t value = 0;
+    
+    if(renderer->GetDeviceCapabilities().m_GetSemaphoreCounterValue(renderer->GetLogicalDevice(), m_Semaphore, &value) == VK_SUCCESS)
+        m_Completed = std::max(m_Completed, value);
+    
+    return m_Completed;
+}
+
+bool VulkanTimeline::IsComplete(uint64_t aValue)
+{
+    // the cached value answers most asks without going to the device
+    return aValue <= m_Completed || aValue <= GetCompletedValue();
+}
+
+bool VulkanTimeline::Wait(uint64_t aValue, uint64_t aTimeout)
+{
+    if(IsComplete(aValue))
+        return true;
+    
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    VkDevice device = renderer->GetLogicalDevice();
+    
+    if(UsesTimelineSemaphore())
+    {
+        VkSemaphoreWaitInfoKHR waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_Semaphore;
+        waitInfo.pValues = &aValue;
+        
+        if(renderer->GetDeviceCapabilities().m_WaitSemaphores(device, &waitInfo, aTimeout) != VK_SUCCESS)
+            return false;
+        
+        m_Completed = std::max(m_Completed, aValue);
+        return true;
+    }
+    
+    // the fences go in value order, the first one at or past aValue covers it
+    for (const PendingFence& pending : m_PendingFences)
+    {
+        if(pending.m_Value < aValue)
+            continue;
+        
+        if(vkWaitForFences(device, 1, &pending.m_Fence, VK_TRUE, aTimeout) != VK_SUCCESS)
+            return false;
+        
+        break;
+    }
+    
+    RetireFences();
+    return aValue <= m_Completed;
+}
+
+void VulkanTimeline::RetireFences()
+{
+    VkDevice device = VulkanRenderer::GetInstance()->GetLogicalDevice();
+    
+    // the fences signal in submit order, so stop at the first one still running
+    while (!m_PendingFences.empty() && vkGetFenceStatus(device, m_PendingFences.front().m_Fence) == VK_SUCCESS)
+    {
+        const PendingFence& pending = m_PendingFences.front();
+        
+        vkResetFences(device, 1, &pending.m_Fence);
+        m_FreeFences.push_back(pending.m_Fence);
+        m_Completed = pending.m_Value;
+        
+        m_PendingFences.pop_front();
+    }
+}
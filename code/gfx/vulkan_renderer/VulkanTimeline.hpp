@@ -0,0 +1,72 @@
+//
+//  VulkanTimeline.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanTimeline_hpp
+#define VulkanTimeline_hpp
+
+#include "VulkanCommon.hpp"
+
+#include <deque>
+#include <limits>
+
+// One monotonically increasing value per queue, every Submit signals the next one. Anything
+// the gpu uses keeps the value of the last submit that used it, and is free again once the
+// completed value has reached it. Checking that is a compare against a cached number, only
+// a miss asks the device, and nothing has to be reset between uses.
+//
+// Built on VK_KHR_timeline_semaphore. Without it a pool of fences stands in, one per submit,
+// retired in submit order as they signal and reset for reuse, so the values behave the same.
+// Value 0 is never signalled by a submit, it always reads as complete.
+class VulkanTimeline
+{
+public:
+    VulkanTimeline();
+    ~VulkanTimeline();
+    
+    bool Init(VkQueue aQueue);
+    // the queue must be idle
+    void Shutdown();
+    
+    bool UsesTimelineSemaphore() const { return m_Semaphore != VK_NULL_HANDLE; }
+    
+    // aSubmitInfo plus the signal of the next value, 0 when the submit failed
+    uint64_t Submit(const VkSubmitInfo& aSubmitInfo);
+    
+    uint64_t GetLastSubmittedValue() const { return m_LastSubmitted; }
+    
+    // never blocks
+    uint64_t GetCompletedValue();
+    bool IsComplete(uint64_t aValue);
+    
+    // false on timeout or a lost device
+    bool Wait(uint64_t aValue, uint64_t aTimeout = std::numeric_limits<uint64_t>::max());
+
+private:
+    struct PendingFence
+    {
+        uint64_t    m_Value;
+        VkFence     m_Fence;
+    };
+    
+    uint64_t SubmitWithFence(const VkSubmitInfo& aSubmitInfo);
+    void RetireFences();
+    
+    VkQueue                     m_Queue;
+    VkSemaphore                 m_Semaphore;
+    uint64_t                    m_LastSubmitted;
+    uint64_t                    m_Completed;        // as of the last time anything asked
+    
+    // the fallback, oldest submit first
+    std::deque<PendingFence>    m_PendingFences;
+    std::vector<VkFence>        m_FreeFences;
+    
+    std::vector<VkSemaphore>    m_SignalSemaphores;
+    std::vector<uint64_t>       m_SignalValues;
+};
+
+#endif /* VulkanTimeline_hpp */
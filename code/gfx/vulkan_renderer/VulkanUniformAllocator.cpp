@@ -0,0 +1,106 @@
+//
+//  VulkanUniformAllocator.cpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VulkanUniformAllocator.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanUtils.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // alignments from the device limits are always a power of two
+    VkDeviceSize AlignUp(VkDeviceSize aValue, VkDeviceSize anAlignment)
+    {
+        return (aValue + anAlignment - 1) & ~(anAlignment - 1);
+    }
+}
+
+VulkanUniformAllocator::VulkanUniformAllocator()
+: m_Buffer(VK_NULL_HANDLE)
+, m_Memory(VK_NULL_HANDLE)
+, m_Mapped(nullptr)
+, m_Alignment(1)
+, m_FrameSize(0)
+, m_FrameStart(0)
+, m_Offset(0)
+{
+}
+
+VulkanUniformAllocator::~VulkanUniformAllocator()
+{
+    Shutdown();
+}
+
+bool VulkanUniformAllocator::Init(uint32_t aFrameCount, VkDeviceSize aFrameSize)
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    m_Alignment = std::max<VkDeviceSize>(renderer->GetDeviceProperties().limits.minUniformBufferOffsetAlignment, 1);
+    
+    // every region starts aligned so the first allocation of a frame needs no padding
+    m_FrameSize = AlignUp(aFrameSize, m_Alignment);
+    
+    const VkDeviceSize bufferSize = m_FrameSize * aFrameCount;
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    
+    if(!VulkanUtils::CreateBuffer(bufferSize, usage, properties, m_Buffer, m_Memory))
+        return false;
+    
+    void* data = nullptr;
+    
+    // mapped once for the lifetime of the buffer
+    if(vkMapMemory(renderer->GetLogicalDevice(), m_Memory, 0, bufferSize, 0, &data) != VK_SUCCESS)
+        return false;
+    
+    m_Mapped = static_cast<uint8_t*>(data);
+    
+    Begin(0);
+    
+    return true;
+}
+
+void VulkanUniformAllocator::Shutdown()
+{
+    VulkanRenderer* renderer = VulkanRenderer::GetInstance();
+    
+    if(!renderer || m_Buffer == VK_NULL_HANDLE)
+        return;
+    
+    VkDevice& device = renderer->GetLogicalDevice();
+    
+    if(m_Mapped)
+        vkUnmapMemory(device, m_Memory);
+    
+    vkDestroyBuffer(device, m_Buffer, nullptr);
+    vkFreeMemory(device, m_Memory, nullptr);
+    
+    m_Buffer = VK_NULL_HANDLE;
+    m_Memory = VK_NULL_HANDLE;
+    m_Mapped = nullptr;
+}
+
+void VulkanUniformAllocator::Begin(uint32_t aFrameIndex)
+{
+    m_FrameStart = m_FrameSize * aFrameIndex;
+    m_Offset = m_FrameStart;
+}
+
+void* VulkanUniformAllocator::Allocate(VkDeviceSize aSize, uint32_t& outOffset)
+{
+    const VkDeviceSize offset = AlignUp(m_Offset, m_Alignment);
+    
+    if(!m_Mapped || offset + aSize > m_FrameStart + m_FrameSize)
+        return nullptr;
+    
+    m_Offset = offset + aSize;
+    outOffset = static_cast<uint32_t>(offset);
+    
+    return m_Mapped + offset;
+}
@@ -0,0 +1,52 @@
+//
+//  VulkanUniformAllocator.hpp
+//  VulkanGfx
+//
+//  Created by agent on 10/18/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VulkanUniformAllocator_hpp
+#define VulkanUniformAllocator_hpp
+
+#include "VulkanCommon.hpp"
+
+// One persistently mapped uniform buffer cut into a region per frame in flight. An
+// allocation is a pointer bump inside the current frame's region, rounded up to
+// minUniformBufferOffsetAlignment, and the offset it hands back is the dynamic offset
+// for a UNIFORM_BUFFER_DYNAMIC binding of GetBuffer.
+//
+// Nothing is freed on its own, Begin drops everything the frame allocated last time,
+// so it must only be called once that frame's timeline value has been waited on.
+class VulkanUniformAllocator
+{
+public:
+    VulkanUniformAllocator();
+    ~VulkanUniformAllocator();
+    
+    bool Init(uint32_t aFrameCount, VkDeviceSize aFrameSize);
+    void Shutdown();
+    
+    void Begin(uint32_t aFrameIndex);
+    
+    // nullptr once the frame's region is full, coherent memory so there is nothing to flush
+    void* Allocate(VkDeviceSize aSize, uint32_t& outOffset);
+    
+    template<typename T>
+    T* Allocate(uint32_t& outOffset) { return static_cast<T*>(Allocate(sizeof(T), outOffset)); }
+    
+    VkBuffer        GetBuffer() const { return m_Buffer; }
+    VkDeviceSize    GetUsedSize() const { return m_Offset - m_FrameStart; }
+
+private:
+    VkBuffer        m_Buffer;
+    VkDeviceMemory  m_Memory;
+    uint8_t*        m_Mapped;
+    
+    VkDeviceSize    m_Alignment;
+    VkDeviceSize    m_FrameSize;
+    VkDeviceSize    m_FrameStart;
+    VkDeviceSize    m_Offset;
+};
+
+#endif /* VulkanUniformAllocator_hpp */
@@ -12,6 +12,7 @@
 //#include <vulkan/vulkan.h>
 
 #include "VulkanRenderer.hpp"
+#include "VulkanTimeline.hpp"
 
 namespace VulkanUtils
 {
@@ -40,24 +41,35 @@ namespace VulkanUtils
         return commandBuffer;
     }
     
-    void EndSingleTimeCommands(VkCommandBuffer& aCommandBuffer)
+    bool EndSingleTimeCommands(VkCommandBuffer& aCommandBuffer)
     {
         vkEndCommandBuffer(aCommandBuffer);
         
         VulkanRenderer* renderer = VulkanRenderer::GetInstance();
         
         if(!renderer)
-            return;
+            return false;
         
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &aCommandBuffer;
         
-        vkQueueSubmit(renderer->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(renderer->GetGraphicsQueue());
+        // only this submit, frames already in flight on the queue carry on
+        VulkanTimeline* timeline = renderer->GetGraphicsTimeline();
+        const uint64_t submitValue = timeline->Submit(submitInfo);
+        
+        // a failed submit leaves the buffer unused, value 0 would read as already complete
+        const bool completed = submitValue != 0 && timeline->Wait(submitValue);
+        
+        if(!completed)
+            std::cout << "Single time commands failed to " << (submitValue != 0 ? "complete" : "submit") << std::endl;
         
-        vkFreeCommandBuffers(renderer->GetLogicalDevice(), renderer->GetCommandPool(), 1, &aCommandBuffer);
+        // only freed when it is known not to be running any more
+        if(submitValue == 0 || completed)
+            vkFreeCommandBuffers(renderer->GetLogicalDevice(), renderer->GetCommandPool(), 1, &aCommandBuffer);
+        
+        return completed;
     }
     
     uint32_t FindMemoryType(VkPhysicalDevice aPhysicalDevice, uint32_t aTypeFilter, VkMemoryPropertyFlags someProperties)
@@ -81,6 +93,25 @@ namespace VulkanUtils
         return aFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || aFormat == VK_FORMAT_D24_UNORM_S8_UINT;
     }
     
+    VkImageAspectFlags GetAspectFlags(const VkFormat& aFormat)
+    {
+        switch (aFormat)
+        {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+            case VK_FORMAT_S8_UINT:
+                return VK_IMAGE_ASPECT_STENCIL_BIT;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            default:
+                return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+    
     bool CreateBuffer(VkDeviceSize aSize, VkBufferUsageFlags aUsage, VkMemoryPropertyFlags someProperties, VkBuffer& aBuffer, VkDeviceMemory& aBufferMemory)
     {
         VulkanRenderer* renderer = VulkanRenderer::GetInstance();
@@ -121,7 +152,7 @@ namespace VulkanUtils
         return true;
     }
     
-    void CopyBuffer(VkBuffer aSrcBuffer, VkBuffer aDstBuffer, VkDeviceSize aSize)
+    bool CopyBuffer(VkBuffer aSrcBuffer, VkBuffer aDstBuffer, VkDeviceSize aSize)
     {
         VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
         
@@ -129,10 +160,10 @@ namespace VulkanUtils
         copyRegion.size = aSize;
         vkCmdCopyBuffer(commandBuffer, aSrcBuffer, aDstBuffer, 1, &copyRegion);
         
-        EndSingleTimeCommands(commandBuffer);
+        return EndSingleTimeCommands(commandBuffer);
     }
     
-    void CopyBufferToImage(VkBuffer aBuffer, VkImage anImage, uint32_t aWidth, uint32_t aHeight)
+    bool CopyBufferToImage(VkBuffer aBuffer, VkImage anImage, uint32_t aWidth, uint32_t aHeight)
     {
         VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
         
@@ -151,11 +182,11 @@ namespace VulkanUtils
         
         vkCmdCopyBufferToImage(commandBuffer, aBuffer, anImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
         
-        EndSingleTimeCommands(commandBuffer);
+        return EndSingleTimeCommands(commandBuffer);
     }
     
     
-    void GenerateMipmaps(VkImage& anImage, int32_t aTexWidth, int32_t aTexHeight, uint32_t aMipLevels)
+    bool GenerateMipmaps(VkImage& anImage, int32_t aTexWidth, int32_t aTexHeight, uint32_t aMipLevels)
     {
         VkCommandBuffer commandBuffer = VulkanUtils::BeginSingleTimeCommands();
         
@@ -236,11 +267,60 @@ namespace VulkanUtils
                              0, nullptr,
                              1, &barrier);
         
-        VulkanUtils::EndSingleTimeCommands(commandBuffer);
+        return VulkanUtils::EndSingleTimeCommands(commandBuffer);
+    }
+    
+    // the stages and accesses that use an image in a layout, for transitions into or out of it
+    void GetLayoutSync(VkImageLayout aLayout, VkPipelineStageFlags& outStages, VkAccessFlags& outAccess)
+    {
+        switch (aLayout)
+        {
+            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                outAccess = VK_ACCESS_TRANSFER_WRITE_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                outAccess = VK_ACCESS_TRANSFER_READ_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                outAccess = VK_ACCESS_SHADER_READ_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                outAccess = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+                outAccess = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+                outStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+                outAccess = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_GENERAL:
+                outStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                outAccess = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                outStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                outAccess = 0;
+                break;
+            default:
+                // undefined and preinitialized, nothing to wait on
+                outStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                outAccess = 0;
+                break;
+        }
     }
     
     bool TransitionImageLayout(VkImage anImage, VkFormat aFormat, VkImageLayout anOldLayout, VkImageLayout aNewLayout, uint32_t aMipLvl)
     {
+        // nothing can be transitioned into these
+        if(aNewLayout == VK_IMAGE_LAYOUT_UNDEFINED || aNewLayout == VK_IMAGE_LAYOUT_PREINITIALIZED)
+            return false;
+        
         VkCommandBuffer commandBuffer = VulkanUtils::BeginSingleTimeCommands();
         
         VkImageMemoryBarrier barrier = {};
@@ -250,54 +330,20 @@ namespace VulkanUtils
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.image = anImage;
+        barrier.subresourceRange.aspectMask = GetAspectFlags(aFormat);
         barrier.subresourceRange.baseMipLevel = 0;
         barrier.subresourceRange.levelCount = aMipLvl;
         barrier.subresourceRange.baseArrayLayer = 0;
         barrier.subresourceRange.layerCount = 1;
         
-        if (aNewLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-        {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            
-            if (HasStencilComponent(aFormat))
-                barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
-        }
-        else
-        {
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        }
-        
         VkPipelineStageFlags sourceStage;
         VkPipelineStageFlags destinationStage;
         
-        if (anOldLayout == VK_IMAGE_LAYOUT_UNDEFINED && aNewLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (anOldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && aNewLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-        {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else if (anOldLayout == VK_IMAGE_LAYOUT_UNDEFINED && aNewLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        }
-        else
-        {
-            return false;
-        }
+        GetLayoutSync(anOldLayout, sourceStage, barrier.srcAccessMask);
+        GetLayoutSync(aNewLayout, destinationStage, barrier.dstAccessMask);
+        
+        // only writes need making available
+        barrier.srcAccessMask &= VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
         
         vkCmdPipelineBarrier(commandBuffer,
                              sourceStage, destinationStage,
@@ -306,12 +352,10 @@ namespace VulkanUtils
                              0, nullptr,
                              1, &barrier);
         
-        VulkanUtils::EndSingleTimeCommands(commandBuffer);
-        
-        return true;
+        return VulkanUtils::EndSingleTimeCommands(commandBuffer);
     }
     
-    bool CreateImageView(VkImage anImage, VkFormat aFormat, VkImageAspectFlags anAspectFlags, VkImageView& anImageView, uint32_t aMipLvl)
+    bool CreateImageView(VkImage anImage, VkFormat aFormat, VkImageAspectFlags anAspectFlags, VkImageView& anImageView, uint32_t aMipLvl, uint32_t aBaseMipLvl)
     {
         VulkanRenderer* renderer = VulkanRenderer::GetInstance();
         
@@ -326,7 +370,7 @@ namespace VulkanUtils
         viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
         viewInfo.format = aFormat;
         viewInfo.subresourceRange.aspectMask = anAspectFlags;
-        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.baseMipLevel = aBaseMipLvl;
         viewInfo.subresourceRange.levelCount = aMipLvl;
         viewInfo.subresourceRange.baseArrayLayer = 0;
         viewInfo.subresourceRange.layerCount = 1;
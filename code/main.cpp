@@ -9,12 +9,34 @@
 
 #include "Core_Application.hpp"
 
+#ifdef RUN_SCENE_BENCHMARKS
+#include "Scene_Benchmarks.hpp"
+#endif
+
+#ifdef RUN_JOB_BENCHMARKS
+#include "Core_JobBenchmarks.hpp"
+#endif
+
 int main()
 {
+#ifdef RUN_SCENE_BENCHMARKS
+    Scene_Benchmarks::RunBvhBenchmarks();
+    return 0;
+#elif defined(RUN_JOB_BENCHMARKS)
+    Core_JobBenchmarks::RunJobSystemBenchmarks();
+    return 0;
+#else
     Core_Application app(WINDOW_GLFW, RENDER_VULKAN);
     
+#ifdef RUN_BACKGROUND_RENDER
+    app.SetFramePacing(Core_Application::FramePacing::Throughput());
+#else
+    app.SetFramePacing(Core_Application::FramePacing::Interactive());
+#endif
+    
     if(app.Run())
         return 0;
     else
         return -1;
+#endif
 }
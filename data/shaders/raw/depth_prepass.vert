@@ -0,0 +1,28 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// per view, written once a frame into the uniform ring and bound with a dynamic offset
+layout(set = 0, binding = 0) uniform ViewConstants
+{
+    mat4 view;
+    mat4 proj;
+    
+} View;
+
+// PositionVertex, the only stream a depth only pass needs
+layout(location = 0) in vec3 inPosition;
+
+// per instance, see InstanceData
+layout(location = 3) in mat4 inModel;
+
+// must match shader_instanced.vert bit for bit, the main pass tests against this depth with EQUAL
+out gl_PerVertex
+{
+    invariant vec4 gl_Position;
+};
+
+
+void main()
+{
+    gl_Position = View.proj * View.view * inModel * vec4(inPosition, 1.0);
+}
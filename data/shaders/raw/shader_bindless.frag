@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// see VulkanBindlessTable, partially bound so only slots that were written may be read
+layout(set = 1, binding = 0) uniform texture2D textures[4096];
+layout(set = 1, binding = 1) uniform sampler samplers[4];
+
+// per draw, see MaterialConstants
+layout(push_constant) uniform MaterialConstants
+{
+    uint textureIndex;
+    uint samplerIndex;
+    
+} Material;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = texture(sampler2D(textures[Material.textureIndex], samplers[Material.samplerIndex]), fragTexCoord);
+}
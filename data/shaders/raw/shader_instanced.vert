@@ -1,30 +1,34 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(set = 0, binding = 0) uniform ConstantBufferObject
+// per view, written once a frame into the uniform ring and bound with a dynamic offset
+layout(set = 0, binding = 0) uniform ViewConstants
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
     
-} CBO;
+} View;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
+// per instance, see InstanceData
+layout(location = 3) in mat4 inModel;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
+// invariant so the depth pre-pass writes exactly the depth this pass tests against
 out gl_PerVertex
 {
-    vec4 gl_Position;
+    invariant vec4 gl_Position;
 };
 
 
 void main()
 {
-    gl_Position = CBO.proj * CBO.view * CBO.model * vec4(inPosition, 1.0);
+    gl_Position = View.proj * View.view * inModel * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
 }
@@ -1,2 +1,23 @@
-/Users/michaelmackie/coding/vulkansdk/macOS/bin/glslangValidator -V ./data/shaders/raw/shader.vert -o ./data/shaders/compiled/vert.spv
-/Users/michaelmackie/coding/vulkansdk/macOS/bin/glslangValidator -V ./data/shaders/raw/shader.frag -o ./data/shaders/compiled/frag.spv
+#!/bin/bash
+# compiles every shader in data/shaders/raw and checks the output with spirv-val, stops at the first failure
+set -e
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+cd "$DIR/.."
+
+GLSLANG=${GLSLANG:-/Users/michaelmackie/coding/vulkansdk/macOS/bin/glslangValidator}
+SPIRV_VAL=${SPIRV_VAL:-$(dirname "$GLSLANG")/spirv-val}
+
+compile()
+{
+    "$GLSLANG" -V ./data/shaders/raw/$1 -o ./data/shaders/compiled/$2
+    "$SPIRV_VAL" ./data/shaders/compiled/$2
+}
+
+compile shader_instanced.vert vert_instanced.spv
+compile depth_prepass.vert vert_depth_prepass.spv
+compile shader.frag frag.spv
+compile shader_bindless.frag frag_bindless.spv
+compile cull.comp cull.spv
+compile cull_occlusion.comp cull_occlusion.spv
+compile hiz.comp hiz.spv